@@ -0,0 +1,291 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/async_io.h"
+#include "core/async_io_internal.h"
+
+#include "core/allocator.h"
+#include "core/file_internal.h"
+#include "core/futex.h"
+#include "core/log.h"
+#include "core/queue.inl"
+#include "core/thread.h"
+#include "core/utils.h"
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+// Worker threads stop when they pop this.
+#define NJ_AIO_QUIT_REQUEST ((nj_aio_request_t*)NULL)
+
+const nj_file_t* nj_aio_get_file(const nj_aio_t* aio, const nj_aio_request_t* request) {
+  if (request->file_index >= 0)
+    return &aio->registered_files[request->file_index];
+  if (request->file)
+    return request->file;
+  return &request->opened_file;
+}
+
+static void aio_worker_main(void* args) {
+  nj_aio_t* aio = (nj_aio_t*)args;
+  for (;;) {
+    nj_aio_request_t* request;
+    nj_mpmc_pop_wait(&aio->pending_requests, &request, NJ_FUTEX_INFINITE);
+    if (request == NJ_AIO_QUIT_REQUEST)
+      break;
+    request->is_ok = nj_file_pread(nj_aio_get_file(aio, request), request->buffer, request->size, request->offset, &request->bytes_read);
+    nj_mpmc_push(&aio->completed_requests, request);
+  }
+}
+
+static bool aio_init_thread_pool(nj_aio_t* aio, int thread_count) {
+  NJ_CHECK_RETURN_VAL(nj_mpmc_init(&aio->pending_requests, aio->allocator, aio->queue_depth + thread_count, true), false);
+  aio->threads = (nj_thread_t*)aio->allocator->alloc(thread_count * sizeof(nj_thread_t));
+  NJ_CHECK_LOG_RETURN_VAL(aio->threads, false, "Can't allocate the I/O threads");
+  for (int i = 0; i < thread_count; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "nj_aio_%d", i);
+    nj_thread_desc_t desc;
+    desc.name = name;
+    if (!nj_thread_init(&aio->threads[i], aio_worker_main, aio, &desc))
+      break;
+    ++aio->thread_count;
+  }
+  NJ_CHECK_LOG_RETURN_VAL(aio->thread_count, false, "Can't start the I/O threads");
+  return true;
+}
+
+// The request is returned to the caller, close what was opened for it and
+// dispatch the callback.
+static void aio_finish(nj_aio_t* aio, nj_aio_request_t* request) {
+  --aio->in_flight_count;
+  if (request->is_file_opened) {
+    nj_file_close_plat(&request->opened_file);
+    request->is_file_opened = false;
+  }
+  if (request->callback) {
+    nj_job_desc_t desc = {request->callback, request};
+    nj_job_run(&desc, 1, &aio->callback_counter);
+  }
+}
+
+bool nj_aio_init(nj_aio_t* aio, nj_allocator_t* allocator, const nj_aio_desc_t* desc) {
+  nj_aio_desc_t default_desc;
+  if (!desc)
+    desc = &default_desc;
+  memset(aio, 0, sizeof(nj_aio_t));
+  aio->allocator = allocator;
+  aio->queue_depth = (int)nj_queue_round_capacity(desc->queue_depth);
+  NJ_CHECK_RETURN_VAL(nj_mpmc_init(&aio->completed_requests, allocator, aio->queue_depth, true), false);
+  if (desc->backend != NJ_AIO_BACKEND_THREAD_POOL) {
+    if (nj_aio_uring_init(aio)) {
+      aio->backend = NJ_AIO_BACKEND_IO_URING;
+      return true;
+    }
+    if (desc->backend == NJ_AIO_BACKEND_IO_URING) {
+      nj_mpmc_destroy(&aio->completed_requests);
+      NJ_LOGW("io_uring isn't supported");
+      return false;
+    }
+  }
+  aio->backend = NJ_AIO_BACKEND_THREAD_POOL;
+  return aio_init_thread_pool(aio, desc->thread_count > 0 ? desc->thread_count : 1);
+}
+
+void nj_aio_destroy(nj_aio_t* aio) {
+  nj_aio_request_t* completed[64];
+  while (nj_aio_wait(aio, completed, 64)) {
+  }
+  nj_job_wait(&aio->callback_counter);
+  if (aio->backend == NJ_AIO_BACKEND_IO_URING) {
+    nj_aio_uring_destroy(aio);
+  } else if (aio->threads) {
+    for (int i = 0; i < aio->thread_count; ++i)
+      nj_mpmc_push(&aio->pending_requests, NJ_AIO_QUIT_REQUEST);
+    for (int i = 0; i < aio->thread_count; ++i)
+      nj_thread_wait_for(&aio->threads[i]);
+    aio->allocator->free(aio->threads);
+    nj_mpmc_destroy(&aio->pending_requests);
+  }
+  if (aio->registered_files)
+    aio->allocator->free(aio->registered_files);
+  nj_mpmc_destroy(&aio->completed_requests);
+}
+
+bool nj_aio_register_buffers(nj_aio_t* aio, void* const* buffers, const njsp* sizes, int count) {
+  if (aio->backend == NJ_AIO_BACKEND_IO_URING)
+    return nj_aio_uring_register_buffers(aio, buffers, sizes, count);
+  return true;
+}
+
+bool nj_aio_register_files(nj_aio_t* aio, const nj_file_t* files, int count) {
+  NJ_CHECK_LOG_RETURN_VAL(!aio->registered_files, false, "Files are already registered");
+  aio->registered_files = (nj_file_t*)aio->allocator->alloc(count * sizeof(nj_file_t));
+  NJ_CHECK_LOG_RETURN_VAL(aio->registered_files, false, "Can't allocate the registered files");
+  memcpy(aio->registered_files, files, count * sizeof(nj_file_t));
+  aio->registered_file_count = count;
+  if (aio->backend == NJ_AIO_BACKEND_IO_URING)
+    return nj_aio_uring_register_files(aio, files, count);
+  return true;
+}
+
+int nj_aio_submit(nj_aio_t* aio, nj_aio_request_t* requests, int count) {
+  nj_aio_request_t* batch[64];
+  int batch_count = 0;
+  int submitted_count = 0;
+  for (; submitted_count < count && aio->in_flight_count < aio->queue_depth; ++submitted_count) {
+    nj_aio_request_t* request = &requests[submitted_count];
+    request->bytes_read = 0;
+    request->is_ok = false;
+    request->is_file_opened = false;
+    ++aio->in_flight_count;
+    if (request->file_index < 0 && !request->file) {
+      request->is_file_opened = request->path && nj_file_open_plat(&request->opened_file, request->path, NJ_FILE_MODE_READ);
+      if (!request->is_file_opened) {
+        nj_mpmc_push(&aio->completed_requests, request);
+        continue;
+      }
+    }
+    if (aio->backend == NJ_AIO_BACKEND_THREAD_POOL) {
+      nj_mpmc_push(&aio->pending_requests, request);
+      continue;
+    }
+    batch[batch_count++] = request;
+    if (batch_count == (int)nj_static_array_size(batch)) {
+      nj_aio_uring_submit(aio, batch, batch_count);
+      batch_count = 0;
+    }
+  }
+  if (batch_count)
+    nj_aio_uring_submit(aio, batch, batch_count);
+  return submitted_count;
+}
+
+int nj_aio_poll(nj_aio_t* aio, nj_aio_request_t** completed, int max_count) {
+  if (aio->backend == NJ_AIO_BACKEND_IO_URING)
+    nj_aio_uring_reap(aio, false);
+  int count = 0;
+  while (count < max_count && nj_mpmc_pop(&aio->completed_requests, &completed[count])) {
+    aio_finish(aio, completed[count]);
+    ++count;
+  }
+  return count;
+}
+
+int nj_aio_wait(nj_aio_t* aio, nj_aio_request_t** completed, int max_count) {
+  if (!aio->in_flight_count || max_count <= 0)
+    return 0;
+  for (;;) {
+    int count = nj_aio_poll(aio, completed, max_count);
+    if (count)
+      return count;
+    if (aio->backend == NJ_AIO_BACKEND_IO_URING) {
+      // Completions can be short reads that are resubmitted, so this may not
+      // complete anything.
+      nj_aio_uring_reap(aio, true);
+    } else {
+      nj_mpmc_pop_wait(&aio->completed_requests, &completed[0], NJ_FUTEX_INFINITE);
+      aio_finish(aio, completed[0]);
+      return 1 + nj_aio_poll(aio, completed + 1, max_count - 1);
+    }
+  }
+}
+
+// One buffer of nj_aio_stream().
+struct aio_stream_chunk_t {
+  nj_aio_request_t request;
+  // Bytes of the request that are in the stream range.
+  njsp size;
+  bool is_submitted;
+  bool is_done;
+};
+
+static njsp aio_align_up(njsp size) {
+  return (size + NJ_FILE_DIRECT_ALIGNMENT - 1) / NJ_FILE_DIRECT_ALIGNMENT * NJ_FILE_DIRECT_ALIGNMENT;
+}
+
+static void aio_stream_submit(nj_aio_t* aio, aio_stream_chunk_t* chunk, njsp* read_offset, njsp chunk_size, njsp end) {
+  chunk->size = nj_min(chunk_size, end - *read_offset);
+  chunk->request.offset = *read_offset;
+  // Rounded up so direct reads stay aligned.
+  chunk->request.size = aio_align_up(chunk->size);
+  chunk->is_submitted = true;
+  nj_aio_submit(aio, &chunk->request, 1);
+  *read_offset += chunk_size;
+}
+
+bool nj_aio_stream(nj_aio_t* aio, const nj_file_t* file, nj_allocator_t* allocator, const nj_aio_stream_desc_t* desc) {
+  NJ_CHECK_RETURN_VAL(desc->callback && desc->chunk_size > 0, false);
+  NJ_CHECK_RETURN_VAL(desc->buffer_count > 0 && desc->buffer_count <= aio->queue_depth, false);
+  NJ_CHECK_LOG_RETURN_VAL(!aio->in_flight_count, false, "Other requests are in flight");
+  njsp file_size = nj_file_get_size(file);
+  NJ_CHECK_RETURN_VAL(file_size != NJ_FILE_INVALID_SIZE, false);
+  njsp end = desc->size < 0 ? file_size : nj_min(desc->offset + desc->size, file_size);
+  if (desc->offset >= end)
+    return true;
+  njsp chunk_size = aio_align_up(desc->chunk_size);
+  int chunk_count = desc->buffer_count;
+  // Reads start at an aligned offset, the bytes before |desc->offset| are
+  // skipped.
+  njsp read_offset = desc->offset / NJ_FILE_DIRECT_ALIGNMENT * NJ_FILE_DIRECT_ALIGNMENT;
+
+  aio_stream_chunk_t* chunks = (aio_stream_chunk_t*)allocator->alloc(chunk_count * sizeof(aio_stream_chunk_t));
+  NJ_CHECK_LOG_RETURN_VAL(chunks, false, "Can't allocate the stream chunks");
+  bool is_ok = true;
+  int allocated_count = 0;
+  for (; allocated_count < chunk_count; ++allocated_count) {
+    aio_stream_chunk_t* chunk = new (&chunks[allocated_count]) aio_stream_chunk_t();
+    chunk->request.file = (nj_file_t*)file;
+    chunk->request.user_data = chunk;
+    chunk->request.buffer = allocator->aligned_alloc(chunk_size, NJ_FILE_DIRECT_ALIGNMENT);
+    if (!chunk->request.buffer) {
+      NJ_LOGW("Can't allocate the stream buffers");
+      is_ok = false;
+      break;
+    }
+  }
+
+  // Chunk i reads the parts i, i + |chunk_count|... of the range. They can
+  // complete in any order but are consumed in order, the next ones are read
+  // while one is consumed.
+  for (int i = 0; is_ok && i < chunk_count && read_offset < end; ++i)
+    aio_stream_submit(aio, &chunks[i], &read_offset, chunk_size, end);
+  int next_chunk = 0;
+  while (is_ok && chunks[next_chunk].is_submitted) {
+    aio_stream_chunk_t* chunk = &chunks[next_chunk];
+    while (!chunk->is_done) {
+      nj_aio_request_t* completed[64];
+      int count = nj_aio_wait(aio, completed, (int)nj_static_array_size(completed));
+      for (int i = 0; i < count; ++i)
+        ((aio_stream_chunk_t*)completed[i]->user_data)->is_done = true;
+    }
+    chunk->is_submitted = false;
+    chunk->is_done = false;
+    // A direct read past an unaligned end of file fails after the data was
+    // read, so only the size matters.
+    if (chunk->request.bytes_read < chunk->size) {
+      NJ_LOGW("Can't read %zd bytes at %zd", chunk->size, chunk->request.offset);
+      is_ok = false;
+      break;
+    }
+    njsp skip_size = nj_max(desc->offset - chunk->request.offset, (njsp)0);
+    const nju8* data = (const nju8*)chunk->request.buffer + skip_size;
+    if (!desc->callback(desc->user_data, data, chunk->size - skip_size, chunk->request.offset + skip_size))
+      break;
+    if (read_offset < end)
+      aio_stream_submit(aio, chunk, &read_offset, chunk_size, end);
+    next_chunk = (next_chunk + 1) % chunk_count;
+  }
+  // Wait for the reads of a stopped stream.
+  nj_aio_request_t* completed[64];
+  while (nj_aio_wait(aio, completed, (int)nj_static_array_size(completed))) {
+  }
+  for (int i = 0; i < allocated_count; ++i)
+    allocator->free(chunks[i].request.buffer);
+  allocator->free(chunks);
+  return is_ok;
+}
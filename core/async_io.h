@@ -0,0 +1,131 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_ASYNC_IO_H
+#define NJ_CORE_ASYNC_IO_H
+
+#include "core/file.h"
+#include "core/job.h"
+#include "core/njtype.h"
+#include "core/os_string.h"
+#include "core/queue.h"
+
+struct nj_aio_uring_t;
+struct nj_allocator_t;
+struct nj_thread_t;
+
+enum nj_aio_backend_t {
+  // io_uring if the kernel supports it, the thread pool otherwise.
+  NJ_AIO_BACKEND_DEFAULT,
+  NJ_AIO_BACKEND_IO_URING,
+  // Blocking positional reads on a pool of threads. Always available.
+  NJ_AIO_BACKEND_THREAD_POOL,
+};
+
+struct nj_aio_desc_t {
+  nj_aio_backend_t backend = NJ_AIO_BACKEND_DEFAULT;
+  // Max number of requests in flight.
+  int queue_depth = 256;
+  // Only used by the thread pool.
+  int thread_count = 4;
+};
+
+// Must stay alive and unchanged from nj_aio_submit() until it's returned by
+// nj_aio_poll() or nj_aio_wait().
+struct nj_aio_request_t {
+  // What to read from, in order of priority: a file from
+  // nj_aio_register_files(), an opened |file| or a |path| that is opened when
+  // the request is submitted and closed when it completes.
+  int file_index = -1;
+  nj_file_t* file = NULL;
+  const nj_os_char* path = NULL;
+  njsp offset = 0;
+  njsp size = 0;
+  void* buffer = NULL;
+  // If |buffer| is inside a buffer from nj_aio_register_buffers(), its index.
+  int buffer_index = -1;
+  // Run as a job with the request as the argument when it completes.
+  nj_job_func_t callback = NULL;
+  void* user_data = NULL;
+
+  // Results. |bytes_read| is less than |size| if the file ended.
+  njsp bytes_read = 0;
+  bool is_ok = false;
+
+  // Internal.
+  nj_file_t opened_file;
+  bool is_file_opened = false;
+};
+
+// Called with each chunk of a stream in order, |offset| is where |data| is in
+// the file. Return false to stop the stream.
+typedef bool (*nj_aio_stream_func_t)(void* user_data, const nju8* data, njsp size, njsp offset);
+
+struct nj_aio_stream_desc_t {
+  njsp offset = 0;
+  // -1 to read until the end of the file.
+  njsp size = -1;
+  // Rounded up to NJ_FILE_DIRECT_ALIGNMENT.
+  njsp chunk_size = 1024 * 1024;
+  // Chunks being read while one is consumed, 2 for double buffering.
+  int buffer_count = 2;
+  nj_aio_stream_func_t callback = NULL;
+  void* user_data = NULL;
+};
+
+// Requests go through io_uring with one syscall per batch, or through a pool
+// of threads doing blocking reads. Either way completed requests are queued
+// until they are polled. Requests are submitted and polled by one thread.
+struct nj_aio_t {
+  nj_allocator_t* allocator;
+  nj_aio_backend_t backend;
+  int queue_depth;
+  // Submitted but not returned by nj_aio_poll()/nj_aio_wait() yet.
+  int in_flight_count;
+  nj_file_t* registered_files;
+  int registered_file_count;
+  nj_mpmc_queue_t<nj_aio_request_t*> completed_requests;
+  nj_job_counter_t callback_counter;
+  // Thread pool.
+  nj_mpmc_queue_t<nj_aio_request_t*> pending_requests;
+  nj_thread_t* threads;
+  int thread_count;
+  // io_uring.
+  nj_aio_uring_t* uring;
+};
+
+// |desc| can be NULL to use the defaults. Returns false if the requested
+// backend isn't supported.
+bool nj_aio_init(nj_aio_t* aio, nj_allocator_t* allocator, const nj_aio_desc_t* desc = NULL);
+// Waits for the requests in flight and the callbacks.
+void nj_aio_destroy(nj_aio_t* aio);
+
+// Pin |count| buffers so io_uring doesn't map them for every request. Can be
+// called once, requests refer to them by index.
+bool nj_aio_register_buffers(nj_aio_t* aio, void* const* buffers, const njsp* sizes, int count);
+// Same for files, io_uring skips the file table lookup. The files must stay
+// open until nj_aio_destroy().
+bool nj_aio_register_files(nj_aio_t* aio, const nj_file_t* files, int count);
+
+// Queue |count| requests. Returns the number of queued requests, which is less
+// than |count| if the queue is full, poll and submit the rest. A request whose
+// |path| can't be opened completes right away with |is_ok| = false.
+int nj_aio_submit(nj_aio_t* aio, nj_aio_request_t* requests, int count);
+// Return up to |max_count| completed requests in |completed| without
+// blocking. Callbacks of the completed requests are dispatched here.
+int nj_aio_poll(nj_aio_t* aio, nj_aio_request_t** completed, int max_count);
+// Same as nj_aio_poll() but blocks until at least one request completed.
+// Returns 0 if nothing is in flight.
+int nj_aio_wait(nj_aio_t* aio, nj_aio_request_t** completed, int max_count);
+
+// Read a range of |file| in chunks and pass them to |desc->callback| on this
+// thread while the next chunks are read. Memory use is bounded to
+// |buffer_count| * |chunk_size|, allocated from |allocator| and aligned so
+// |file| can be opened with NJ_FILE_MODE_DIRECT. Nothing else can be in
+// flight on |aio|. Returns false if a read failed.
+bool nj_aio_stream(nj_aio_t* aio, const nj_file_t* file, nj_allocator_t* allocator, const nj_aio_stream_desc_t* desc);
+
+#endif // NJ_CORE_ASYNC_IO_H
@@ -0,0 +1,26 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_ASYNC_IO_INTERNAL_H
+#define NJ_CORE_ASYNC_IO_INTERNAL_H
+
+#include "core/async_io.h"
+
+// The file |request| reads from.
+const nj_file_t* nj_aio_get_file(const nj_aio_t* aio, const nj_aio_request_t* request);
+
+// Returns false if io_uring isn't supported.
+bool nj_aio_uring_init(nj_aio_t* aio);
+void nj_aio_uring_destroy(nj_aio_t* aio);
+bool nj_aio_uring_register_buffers(nj_aio_t* aio, void* const* buffers, const njsp* sizes, int count);
+bool nj_aio_uring_register_files(nj_aio_t* aio, const nj_file_t* files, int count);
+// The ring has room for |aio->queue_depth| requests so all of them are queued.
+void nj_aio_uring_submit(nj_aio_t* aio, nj_aio_request_t* const* requests, int count);
+// Move the completed requests to |aio->completed_requests|. Waits for at least
+// one if |is_waiting|.
+void nj_aio_uring_reap(nj_aio_t* aio, bool is_waiting);
+
+#endif // NJ_CORE_ASYNC_IO_INTERNAL_H
@@ -0,0 +1,256 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/async_io.h"
+#include "core/async_io_internal.h"
+
+#include "core/allocator.h"
+#include "core/atomic.h"
+#include "core/log.h"
+#include "core/queue.inl"
+#include "core/utils.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Larger reads are split, the kernel limits a single read to ~2GB anyway.
+#define NJ_AIO_MAX_READ_SIZE (1 << 30)
+
+struct nj_aio_uring_t {
+  int fd;
+  nju32* sq_head;
+  nju32* sq_tail;
+  nju32* sq_array;
+  nju32 sq_mask;
+  io_uring_sqe* sqes;
+  nju32* cq_head;
+  nju32* cq_tail;
+  nju32 cq_mask;
+  io_uring_cqe* cqes;
+  void* sq_ring;
+  njsz sq_ring_size;
+  void* cq_ring;
+  njsz cq_ring_size;
+  njsz sqes_size;
+};
+
+static int aio_uring_setup(unsigned entries, io_uring_params* params) {
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int aio_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int aio_uring_register(int fd, unsigned opcode, const void* args, unsigned arg_num) {
+  return syscall(__NR_io_uring_register, fd, opcode, args, arg_num);
+}
+
+static void aio_uring_unmap(nj_aio_uring_t* uring) {
+  if (uring->sqes)
+    munmap(uring->sqes, uring->sqes_size);
+  if (uring->cq_ring && uring->cq_ring != uring->sq_ring)
+    munmap(uring->cq_ring, uring->cq_ring_size);
+  if (uring->sq_ring)
+    munmap(uring->sq_ring, uring->sq_ring_size);
+}
+
+// IORING_OP_READ needs Linux 5.6, older kernels use the thread pool.
+static bool aio_uring_supports_read(int fd) {
+  nju8 buffer[sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)] = {};
+  io_uring_probe* probe = (io_uring_probe*)buffer;
+  if (aio_uring_register(fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+    return false;
+  return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+}
+
+// Queue the rest of |request| without submitting it.
+static void aio_uring_push(nj_aio_t* aio, nj_aio_request_t* request) {
+  nj_aio_uring_t* uring = aio->uring;
+  nju32 tail = *uring->sq_tail;
+  nju32 index = tail & uring->sq_mask;
+  io_uring_sqe* sqe = &uring->sqes[index];
+  memset(sqe, 0, sizeof(io_uring_sqe));
+  if (request->buffer_index >= 0) {
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->buf_index = request->buffer_index;
+  } else {
+    sqe->opcode = IORING_OP_READ;
+  }
+  if (request->file_index >= 0) {
+    sqe->fd = request->file_index;
+    sqe->flags = IOSQE_FIXED_FILE;
+  } else {
+    sqe->fd = nj_aio_get_file(aio, request)->handle;
+  }
+  sqe->off = request->offset + request->bytes_read;
+  sqe->addr = (nju64)((nju8*)request->buffer + request->bytes_read);
+  sqe->len = nj_min(request->size - request->bytes_read, (njsp)NJ_AIO_MAX_READ_SIZE);
+  sqe->user_data = (nju64)request;
+  uring->sq_array[index] = index;
+  nj_atomic_store(uring->sq_tail, tail + 1, NJ_MEMORY_ORDER_RELEASE);
+}
+
+// Submit the last |count| queued requests. If the kernel refuses them, they are
+// taken back from the ring and complete as failed so they aren't in flight
+// forever.
+static void aio_uring_enter_submit(nj_aio_t* aio, int count) {
+  nj_aio_uring_t* uring = aio->uring;
+  while (count > 0) {
+    int rv = aio_uring_enter(uring->fd, count, 0, 0);
+    if (rv < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+        continue;
+      NJ_LOGF("io_uring_enter failed: %d", errno);
+      nju32 tail = *uring->sq_tail - count;
+      for (int i = 0; i < count; ++i) {
+        const io_uring_sqe* sqe = &uring->sqes[uring->sq_array[(tail + i) & uring->sq_mask]];
+        nj_aio_request_t* request = (nj_aio_request_t*)sqe->user_data;
+        request->is_ok = false;
+        nj_mpmc_push(&aio->completed_requests, request);
+      }
+      nj_atomic_store(uring->sq_tail, tail, NJ_MEMORY_ORDER_RELEASE);
+      return;
+    }
+    count -= rv;
+  }
+}
+
+bool nj_aio_uring_init(nj_aio_t* aio) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = aio_uring_setup(aio->queue_depth, &params);
+  if (fd < 0)
+    return false;
+  if (!aio_uring_supports_read(fd)) {
+    close(fd);
+    return false;
+  }
+  nj_aio_uring_t* uring = (nj_aio_uring_t*)aio->allocator->alloc_zero(sizeof(nj_aio_uring_t));
+  if (!uring) {
+    close(fd);
+    return false;
+  }
+  uring->fd = fd;
+  uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(nju32);
+  uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool is_single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (is_single_mmap)
+    uring->sq_ring_size = uring->cq_ring_size = nj_max(uring->sq_ring_size, uring->cq_ring_size);
+  uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  bool is_ok = uring->sq_ring != MAP_FAILED;
+  if (!is_ok)
+    uring->sq_ring = NULL;
+  if (is_ok && is_single_mmap) {
+    uring->cq_ring = uring->sq_ring;
+  } else if (is_ok) {
+    uring->cq_ring = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    is_ok = uring->cq_ring != MAP_FAILED;
+    if (!is_ok)
+      uring->cq_ring = NULL;
+  }
+  if (is_ok) {
+    uring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    uring->sqes = (io_uring_sqe*)mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    is_ok = uring->sqes != MAP_FAILED;
+    if (!is_ok)
+      uring->sqes = NULL;
+  }
+  if (!is_ok) {
+    aio_uring_unmap(uring);
+    close(fd);
+    aio->allocator->free(uring);
+    NJ_LOGW("Can't map the io_uring rings");
+    return false;
+  }
+  nju8* sq = (nju8*)uring->sq_ring;
+  uring->sq_head = (nju32*)(sq + params.sq_off.head);
+  uring->sq_tail = (nju32*)(sq + params.sq_off.tail);
+  uring->sq_mask = *(nju32*)(sq + params.sq_off.ring_mask);
+  uring->sq_array = (nju32*)(sq + params.sq_off.array);
+  nju8* cq = (nju8*)uring->cq_ring;
+  uring->cq_head = (nju32*)(cq + params.cq_off.head);
+  uring->cq_tail = (nju32*)(cq + params.cq_off.tail);
+  uring->cq_mask = *(nju32*)(cq + params.cq_off.ring_mask);
+  uring->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+  aio->uring = uring;
+  return true;
+}
+
+void nj_aio_uring_destroy(nj_aio_t* aio) {
+  nj_aio_uring_t* uring = aio->uring;
+  aio_uring_unmap(uring);
+  close(uring->fd);
+  aio->allocator->free(uring);
+  aio->uring = NULL;
+}
+
+bool nj_aio_uring_register_buffers(nj_aio_t* aio, void* const* buffers, const njsp* sizes, int count) {
+  iovec* iovs = (iovec*)aio->allocator->alloc(count * sizeof(iovec));
+  NJ_CHECK_LOG_RETURN_VAL(iovs, false, "Can't allocate the buffer list");
+  for (int i = 0; i < count; ++i) {
+    iovs[i].iov_base = buffers[i];
+    iovs[i].iov_len = sizes[i];
+  }
+  int rv = aio_uring_register(aio->uring->fd, IORING_REGISTER_BUFFERS, iovs, count);
+  aio->allocator->free(iovs);
+  NJ_CHECK_LOG_RETURN_VAL(rv == 0, false, "Can't register the buffers: %d", errno);
+  return true;
+}
+
+bool nj_aio_uring_register_files(nj_aio_t* aio, const nj_file_t* files, int count) {
+  int* fds = (int*)aio->allocator->alloc(count * sizeof(int));
+  NJ_CHECK_LOG_RETURN_VAL(fds, false, "Can't allocate the file list");
+  for (int i = 0; i < count; ++i)
+    fds[i] = files[i].handle;
+  int rv = aio_uring_register(aio->uring->fd, IORING_REGISTER_FILES, fds, count);
+  aio->allocator->free(fds);
+  NJ_CHECK_LOG_RETURN_VAL(rv == 0, false, "Can't register the files: %d", errno);
+  return true;
+}
+
+void nj_aio_uring_submit(nj_aio_t* aio, nj_aio_request_t* const* requests, int count) {
+  for (int i = 0; i < count; ++i)
+    aio_uring_push(aio, requests[i]);
+  aio_uring_enter_submit(aio, count);
+}
+
+void nj_aio_uring_reap(nj_aio_t* aio, bool is_waiting) {
+  nj_aio_uring_t* uring = aio->uring;
+  nju32 head = *uring->cq_head;
+  if (is_waiting && head == nj_atomic_load(uring->cq_tail, NJ_MEMORY_ORDER_ACQUIRE)) {
+    while (aio_uring_enter(uring->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno == EINTR) {
+    }
+  }
+  int resubmit_count = 0;
+  nju32 tail = nj_atomic_load(uring->cq_tail, NJ_MEMORY_ORDER_ACQUIRE);
+  for (; head != tail; ++head) {
+    const io_uring_cqe* cqe = &uring->cqes[head & uring->cq_mask];
+    nj_aio_request_t* request = (nj_aio_request_t*)cqe->user_data;
+    if (cqe->res < 0) {
+      request->is_ok = false;
+    } else {
+      request->bytes_read += cqe->res;
+      // Short reads happen when a read is split or interrupted, the file only
+      // ended if nothing was read.
+      if (cqe->res > 0 && request->bytes_read < request->size) {
+        aio_uring_push(aio, request);
+        ++resubmit_count;
+        continue;
+      }
+      request->is_ok = true;
+    }
+    nj_mpmc_push(&aio->completed_requests, request);
+  }
+  nj_atomic_store(uring->cq_head, head, NJ_MEMORY_ORDER_RELEASE);
+  if (resubmit_count)
+    aio_uring_enter_submit(aio, resubmit_count);
+}
@@ -0,0 +1,27 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/async_io.h"
+#include "core/async_io_internal.h"
+
+// Windows always uses the thread pool.
+bool nj_aio_uring_init(nj_aio_t* aio) {
+  return false;
+}
+
+void nj_aio_uring_destroy(nj_aio_t* aio) {}
+
+bool nj_aio_uring_register_buffers(nj_aio_t* aio, void* const* buffers, const njsp* sizes, int count) {
+  return false;
+}
+
+bool nj_aio_uring_register_files(nj_aio_t* aio, const nj_file_t* files, int count) {
+  return false;
+}
+
+void nj_aio_uring_submit(nj_aio_t* aio, nj_aio_request_t* const* requests, int count) {}
+
+void nj_aio_uring_reap(nj_aio_t* aio, bool is_waiting) {}
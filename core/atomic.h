@@ -0,0 +1,100 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_ATOMIC_H
+#define NJ_CORE_ATOMIC_H
+
+#include "core/njtype.h"
+#include "core/os.h"
+
+#if NJ_CPU_X64()
+#  include <immintrin.h>
+#endif
+
+#define NJ_CACHE_LINE_SIZE (64)
+
+// Thin wrappers over the __atomic builtins, which clang supports on every
+// platform we build for. They work on plain integers and pointers.
+enum nj_memory_order {
+  NJ_MEMORY_ORDER_RELAXED = __ATOMIC_RELAXED,
+  NJ_MEMORY_ORDER_ACQUIRE = __ATOMIC_ACQUIRE,
+  NJ_MEMORY_ORDER_RELEASE = __ATOMIC_RELEASE,
+  NJ_MEMORY_ORDER_ACQ_REL = __ATOMIC_ACQ_REL,
+  NJ_MEMORY_ORDER_SEQ_CST = __ATOMIC_SEQ_CST,
+};
+
+template <typename T>
+inline T nj_atomic_load(const T* p, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  return __atomic_load_n(p, order);
+}
+
+template <typename T>
+inline void nj_atomic_store(T* p, T val, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  __atomic_store_n(p, val, order);
+}
+
+template <typename T>
+inline T nj_atomic_exchange(T* p, T val, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  return __atomic_exchange_n(p, val, order);
+}
+
+// Returns the previous value.
+template <typename T>
+inline T nj_atomic_fetch_add(T* p, T val, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  return __atomic_fetch_add(p, val, order);
+}
+
+template <typename T>
+inline T nj_atomic_fetch_sub(T* p, T val, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  return __atomic_fetch_sub(p, val, order);
+}
+
+template <typename T>
+inline T nj_atomic_fetch_or(T* p, T val, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  return __atomic_fetch_or(p, val, order);
+}
+
+template <typename T>
+inline T nj_atomic_fetch_and(T* p, T val, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  return __atomic_fetch_and(p, val, order);
+}
+
+// On failure, |expected| is updated to the current value.
+template <typename T>
+inline bool nj_atomic_cas(T* p, T* expected, T desired, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  nj_memory_order failure_order = order;
+  if (order == NJ_MEMORY_ORDER_ACQ_REL)
+    failure_order = NJ_MEMORY_ORDER_ACQUIRE;
+  else if (order == NJ_MEMORY_ORDER_RELEASE)
+    failure_order = NJ_MEMORY_ORDER_RELAXED;
+  return __atomic_compare_exchange_n(p, expected, desired, false, order, failure_order);
+}
+
+// Same as nj_atomic_cas() but it may fail spuriously, use it in loops.
+template <typename T>
+inline bool nj_atomic_cas_weak(T* p, T* expected, T desired, nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  nj_memory_order failure_order = order;
+  if (order == NJ_MEMORY_ORDER_ACQ_REL)
+    failure_order = NJ_MEMORY_ORDER_ACQUIRE;
+  else if (order == NJ_MEMORY_ORDER_RELEASE)
+    failure_order = NJ_MEMORY_ORDER_RELAXED;
+  return __atomic_compare_exchange_n(p, expected, desired, true, order, failure_order);
+}
+
+inline void nj_atomic_fence(nj_memory_order order = NJ_MEMORY_ORDER_SEQ_CST) {
+  __atomic_thread_fence(order);
+}
+
+// Hint to the CPU that we are spinning.
+inline void nj_cpu_relax() {
+#if NJ_CPU_X64()
+  _mm_pause();
+#elif NJ_CPU_ARM64()
+  __asm__ __volatile__("yield");
+#endif
+}
+
+#endif // NJ_CORE_ATOMIC_H
@@ -6,47 +6,141 @@
 
 #include "core/bit_stream.h"
 
-bool nj_bs_init(nj_bit_stream_t* bs, nju8* data) {
+#include "core/utils.h"
+
+static nju64 reverse_bits(nju64 v, int num_of_bits) {
+  v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+  v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+  v = ((v >> 4) & 0x0f0f0f0f0f0f0f0full) | ((v & 0x0f0f0f0f0f0f0f0full) << 4);
+  v = __builtin_bswap64(v);
+  return num_of_bits ? v >> (64 - num_of_bits) : 0;
+}
+
+// The buffered bits without the bits loaded above them.
+static nju64 bs_buffered_bits(const nj_bit_stream_t* bs) {
+  if (bs->bit_count <= 0)
+    return 0;
+  return bs->bit_count < 64 ? bs->bits & ((1ull << bs->bit_count) - 1) : bs->bits;
+}
+
+bool nj_bs_init(nj_bit_stream_t* bs, const nju8* data, njsp size) {
   bs->data = data;
-  bs->index = 0;
+  bs->end = data + size;
+  bs->p = data;
+  bs->bits = 0;
+  bs->bit_count = 0;
+  nj_bs_refill(bs);
   return true;
 }
 
-nju64 nj_bs_read_lsb(nj_bit_stream_t* bs, njsp num_of_bits) {
-  nju64 result = 0;
-  njsp temp_idx = bs->index;
-  for (njsp i = 0; i < num_of_bits; ++i, temp_idx++) {
-    njsp bytes_num = temp_idx / 8;
-    njsp bit_in_byte = temp_idx % 8;
-    result |= ((bs->data[bytes_num] >> bit_in_byte) & 1) << i;
+void nj_bs_feed(nj_bit_stream_t* bs, const nju8* data, njsp size) {
+  bs->bits = bs_buffered_bits(bs);
+  bs->data = data;
+  bs->end = data + size;
+  bs->p = data;
+}
+
+void nj_bs_give_back_bytes(nj_bit_stream_t* bs) {
+  njsp count = nj_min((njsp)(bs->p - bs->data), (njsp)(bs->bit_count >> 3));
+  if (count <= 0)
+    return;
+  bs->p -= count;
+  bs->bit_count -= (int)count * 8;
+  bs->bits = bs_buffered_bits(bs);
+}
+
+void nj_bs_refill_slow(nj_bit_stream_t* bs) {
+  while (bs->bit_count <= 56 && bs->p < bs->end) {
+    bs->bits |= (nju64)*bs->p++ << bs->bit_count;
+    bs->bit_count += 8;
   }
-  return result;
 }
 
-nju64 nj_bs_read_msb(nj_bit_stream_t* bs, njsp num_of_bits) {
-  nju64 result = 0;
-  njsp temp_idx = bs->index;
-  for (njsp i = 0; i < num_of_bits; ++i, temp_idx++) {
-    njsp bytes_num = temp_idx / 8;
-    njsp bit_in_byte = temp_idx % 8;
-    result |= ((bs->data[bytes_num] >> bit_in_byte) & 1)
-              << (num_of_bits - 1 - i);
+njsp nj_bs_copy_bytes(nj_bit_stream_t* bs, nju8* out, njsp size) {
+  njsp len = 0;
+  for (; bs->bit_count >= 8 && len < size; ++len) {
+    out[len] = (nju8)bs->bits;
+    nj_bs_consume(bs, 8);
   }
-  return result;
+  if (bs->bit_count)
+    return len;
+  // The bits of the byte at |p| may be loaded, they are copied from the data
+  // now.
+  bs->bits = 0;
+  njsp copy_len = nj_min(size - len, (njsp)(bs->end - bs->p));
+  memcpy(out + len, bs->p, copy_len);
+  bs->p += copy_len;
+  return len + copy_len;
+}
+
+nju64 nj_bs_read_lsb(nj_bit_stream_t* bs, int num_of_bits) {
+  nj_bs_refill(bs);
+  return nj_bs_peek(bs, num_of_bits);
+}
+
+nju64 nj_bs_read_msb(nj_bit_stream_t* bs, int num_of_bits) {
+  return reverse_bits(nj_bs_read_lsb(bs, num_of_bits), num_of_bits);
 }
 
 void nj_bs_skip(nj_bit_stream_t* bs, njsp num_of_bits) {
-  bs->index += num_of_bits;
+  if (num_of_bits > bs->bit_count) {
+    // Skip the whole bytes in the data.
+    num_of_bits -= nj_max(bs->bit_count, 0);
+    njsp byte_count = nj_min(num_of_bits >> 3, (njsp)(bs->end - bs->p));
+    bs->p += byte_count;
+    num_of_bits -= byte_count * 8;
+    bs->bits = 0;
+    bs->bit_count = nj_min(bs->bit_count, 0);
+    nj_bs_refill(bs);
+    // Past the end of the data.
+    if (num_of_bits > NJ_BS_MAX_BITS) {
+      bs->bit_count -= (int)nj_min(num_of_bits, (njsp)(1 << 30));
+      bs->bits = 0;
+      return;
+    }
+  }
+  nj_bs_consume(bs, (int)num_of_bits);
 }
 
-nju64 nj_bs_consume_lsb(nj_bit_stream_t* bs, njsp num_of_bits) {
+nju64 nj_bs_consume_lsb(nj_bit_stream_t* bs, int num_of_bits) {
   nju64 result = nj_bs_read_lsb(bs, num_of_bits);
-  nj_bs_skip(bs, num_of_bits);
+  nj_bs_consume(bs, num_of_bits);
   return result;
 }
 
-nju64 nj_bs_consume_msb(nj_bit_stream_t* bs, njsp num_of_bits) {
+nju64 nj_bs_consume_msb(nj_bit_stream_t* bs, int num_of_bits) {
   nju64 result = nj_bs_read_msb(bs, num_of_bits);
-  nj_bs_skip(bs, num_of_bits);
+  nj_bs_consume(bs, num_of_bits);
   return result;
 }
+
+bool nj_bw_init(nj_bit_writer_t* bw, nju8* data, njsp size) {
+  bw->data = data;
+  bw->end = data + size;
+  bw->p = data;
+  bw->bits = 0;
+  bw->bit_count = 0;
+  bw->is_overflow = false;
+  return true;
+}
+
+void nj_bw_flush_slow(nj_bit_writer_t* bw) {
+  while (bw->bit_count >= 8) {
+    if (bw->p < bw->end)
+      *bw->p++ = (nju8)bw->bits;
+    else
+      bw->is_overflow = true;
+    bw->bits >>= 8;
+    bw->bit_count -= 8;
+  }
+}
+
+void nj_bw_write_msb(nj_bit_writer_t* bw, nju64 value, int num_of_bits) {
+  nj_bw_write_lsb(bw, reverse_bits(value, num_of_bits), num_of_bits);
+}
+
+njsp nj_bw_finish(nj_bit_writer_t* bw) {
+  bw->bit_count = (bw->bit_count + 7) & ~7;
+  nj_bw_flush_slow(bw);
+  return bw->is_overflow ? -1 : bw->p - bw->data;
+}
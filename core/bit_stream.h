@@ -9,22 +9,137 @@
 
 #include "core/njtype.h"
 
-// Provide methods to read bits value from a bytes array.
+#include <string.h>
+
+// Bits are read from the least significant bit of each byte. The reader
+// buffers up to 64 bits of the data in |bits|, after nj_bs_refill() at least
+// NJ_BS_MAX_BITS of them can be peeked and consumed without refilling, unless
+// the data ends. A refill is an unaligned 8 bytes load except for the last 8
+// bytes of the data, bits after the end are read as 0.
+//
+// The data can also arrive in pieces: nj_bs_feed() continues with the next
+// piece and keeps the buffered bits, nj_bs_give_back_bytes() returns the whole
+// bytes that were buffered but not consumed.
+#define NJ_BS_MAX_BITS (56)
+
 struct nj_bit_stream_t {
-  nju8* data;
-  njsp index;
+  const nju8* data;
+  const nju8* end;
+  // Next byte that isn't in |bits|.
+  const nju8* p;
+  // The |bit_count| low bits are buffered. A word refill also loads the first
+  // bits of the byte at |p| above them, loading that byte again later doesn't
+  // change them.
+  nju64 bits;
+  // Negative if more bits were consumed than the data has.
+  int bit_count;
 };
 
-bool nj_bs_init(nj_bit_stream_t* bs, nju8* data);
+bool nj_bs_init(nj_bit_stream_t* bs, const nju8* data, njsp size);
+// Continue with |size| bytes of |data| after the current data.
+void nj_bs_feed(nj_bit_stream_t* bs, const nju8* data, njsp size);
+// Move |p| back over the whole bytes that are buffered, at most to the start
+// of the current data.
+void nj_bs_give_back_bytes(nj_bit_stream_t* bs);
+
+void nj_bs_refill_slow(nj_bit_stream_t* bs);
+
+inline void nj_bs_refill(nj_bit_stream_t* bs) {
+  if (bs->end - bs->p >= 8 && bs->bit_count < 64) {
+    nju64 word;
+    memcpy(&word, bs->p, sizeof(word));
+    bs->bits |= word << bs->bit_count;
+    bs->p += (63 - bs->bit_count) >> 3;
+    bs->bit_count |= 56;
+  } else {
+    nj_bs_refill_slow(bs);
+  }
+}
+
+// |num_of_bits| must be at most the bits buffered, NJ_BS_MAX_BITS after a
+// refill.
+inline nju64 nj_bs_peek(const nj_bit_stream_t* bs, int num_of_bits) {
+  return bs->bits & ((1ull << num_of_bits) - 1);
+}
+
+// |num_of_bits| must be at most NJ_BS_MAX_BITS, consuming more bits than
+// buffered is an overflow and only happens at the end of the data.
+inline void nj_bs_consume(nj_bit_stream_t* bs, int num_of_bits) {
+  bs->bits >>= num_of_bits;
+  bs->bit_count -= num_of_bits;
+}
+
+// Number of bits consumed from the start of the current data, negative while
+// bits of the previous data are buffered.
+inline njsp nj_bs_tell(const nj_bit_stream_t* bs) {
+  return (bs->p - bs->data) * 8 - bs->bit_count;
+}
+
+// True if more bits were consumed than the data has.
+inline bool nj_bs_is_overflow(const nj_bit_stream_t* bs) {
+  return bs->bit_count < 0;
+}
+
+// Copy up to |size| bytes from a byte boundary to |out|, the buffered bytes
+// then the data. Returns the number of bytes copied.
+njsp nj_bs_copy_bytes(nj_bit_stream_t* bs, nju8* out, njsp size);
+
+// The functions below refill before reading so they work with any
+// |num_of_bits| up to NJ_BS_MAX_BITS. *_lsb() return the bits in the order they
+// are read from the least significant bit, *_msb() in the reverse order (e.g.
+// Huffman codes in Deflate).
 
 // Get number from |num_of_bits| without moving the bit pointer.
-nju64 nj_bs_read_lsb(nj_bit_stream_t* bs, njsp num_of_bits);
-nju64 nj_bs_read_msb(nj_bit_stream_t* bs, njsp num_of_bits);
+nju64 nj_bs_read_lsb(nj_bit_stream_t* bs, int num_of_bits);
+nju64 nj_bs_read_msb(nj_bit_stream_t* bs, int num_of_bits);
 
 void nj_bs_skip(nj_bit_stream_t* bs, njsp num_of_bits);
 
 // Same as |Read*| but also skip |num_of_bits|.
-nju64 nj_bs_consume_lsb(nj_bit_stream_t* bs, njsp num_of_bits);
-nju64 nj_bs_consume_msb(nj_bit_stream_t* bs, njsp num_of_bits);
+nju64 nj_bs_consume_lsb(nj_bit_stream_t* bs, int num_of_bits);
+nju64 nj_bs_consume_msb(nj_bit_stream_t* bs, int num_of_bits);
+
+// Writes bits in the same order as nj_bit_stream_t reads them. Bits are
+// gathered in |bits| and stored 8 bytes at a time, nothing is written after
+// |end|.
+struct nj_bit_writer_t {
+  nju8* data;
+  nju8* end;
+  nju8* p;
+  nju64 bits;
+  int bit_count;
+  // Set if the bits didn't fit in the data.
+  bool is_overflow;
+};
+
+bool nj_bw_init(nj_bit_writer_t* bw, nju8* data, njsp size);
+
+void nj_bw_flush_slow(nj_bit_writer_t* bw);
+
+// Store the whole bytes of |bits|.
+inline void nj_bw_flush(nj_bit_writer_t* bw) {
+  if (bw->end - bw->p >= 8) {
+    memcpy(bw->p, &bw->bits, sizeof(bw->bits));
+    bw->p += bw->bit_count >> 3;
+    bw->bits = (bw->bit_count & ~7) < 64 ? bw->bits >> (bw->bit_count & ~7) : 0;
+    bw->bit_count &= 7;
+  } else {
+    nj_bw_flush_slow(bw);
+  }
+}
+
+// |value| must fit in |num_of_bits|, which is at most NJ_BS_MAX_BITS.
+inline void nj_bw_write_lsb(nj_bit_writer_t* bw, nju64 value, int num_of_bits) {
+  if (bw->bit_count + num_of_bits >= 64)
+    nj_bw_flush(bw);
+  bw->bits |= value << bw->bit_count;
+  bw->bit_count += num_of_bits;
+}
+
+void nj_bw_write_msb(nj_bit_writer_t* bw, nju64 value, int num_of_bits);
+
+// Pad the last byte with 0 bits and write everything. Returns the number of
+// bytes written, -1 if they didn't fit.
+njsp nj_bw_finish(nj_bit_writer_t* bw);
 
 #endif // NJ_CORE_BIT_STREAM_H
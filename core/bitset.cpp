@@ -0,0 +1,303 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/bitset.h"
+
+#include "core/allocator.h"
+#include "core/log.h"
+#include "core/os.h"
+#include "core/utils.h"
+
+#include <string.h>
+
+#if NJ_CPU_X64()
+#  include <emmintrin.h>
+#endif
+
+enum bitset_op_e {
+  BITSET_OP_AND,
+  BITSET_OP_OR,
+  BITSET_OP_ANDNOT,
+};
+
+static njsp bitset_summary_count(njsp word_count) {
+  return NJ_BITSET_WORD_COUNT(word_count);
+}
+
+// Mask of the bits of |words[w]| that are below |bit_count|.
+static nju64 bitset_valid_mask(const nj_bitset_t* bs, njsp w) {
+  if (w == bs->word_count - 1 && (bs->bit_count & 63))
+    return (1ull << (bs->bit_count & 63)) - 1;
+  return ~0ull;
+}
+
+// Recount the blocks that have words in [|first_word|, |last_word|).
+static void bitset_update_block_counts(nj_bitset_t* bs, njsp first_word, njsp last_word) {
+  if (first_word >= last_word)
+    return;
+  for (njsp s = first_word >> 6; s <= (last_word - 1) >> 6; ++s) {
+    njsp end = nj_min((s + 1) << 6, bs->word_count);
+    nju32 count = 0;
+    for (njsp w = s << 6; w < end; ++w)
+      count += nj_popcount64(bs->words[w]);
+    bs->block_counts[s] = count;
+  }
+}
+
+static void bitset_update_summary(nj_bitset_t* bs, njsp w) {
+  nju64 bit = 1ull << (w & 63);
+  njsp s = w >> 6;
+  nju64 word = bs->words[w];
+  if (word)
+    bs->set_summary[s] |= bit;
+  else
+    bs->set_summary[s] &= ~bit;
+  if (word == bitset_valid_mask(bs, w))
+    bs->full_summary[s] |= bit;
+  else
+    bs->full_summary[s] &= ~bit;
+}
+
+// Returns the first word at or after |first_word| whose summary bit is set in
+// |summary| (or not set if |is_inverted|), NJ_BITSET_NPOS if there is none.
+static njsp bitset_find_word(const nj_bitset_t* bs, const nju64* summary, bool is_inverted, njsp first_word) {
+  if (first_word >= bs->word_count)
+    return NJ_BITSET_NPOS;
+  njsp summary_count = bitset_summary_count(bs->word_count);
+  njsp s = first_word >> 6;
+  nju64 bits = (is_inverted ? ~summary[s] : summary[s]) & (~0ull << (first_word & 63));
+  for (;;) {
+    if (bits) {
+      njsp w = (s << 6) + nj_ctz64(bits);
+      return w < bs->word_count ? w : NJ_BITSET_NPOS;
+    }
+    if (++s >= summary_count)
+      return NJ_BITSET_NPOS;
+    bits = is_inverted ? ~summary[s] : summary[s];
+  }
+}
+
+static bool bitset_alloc(nj_bitset_t* bs, nj_allocator_t* allocator, njsp bit_count) {
+  njsp word_count = NJ_BITSET_WORD_COUNT(bit_count);
+  njsp summary_count = bitset_summary_count(word_count);
+  // The nju32 block counts are stored after the summaries.
+  njsp total = nj_max<njsp>(word_count + 2 * summary_count + (summary_count + 1) / 2, 1);
+  nju64* p = (nju64*)allocator->alloc_zero(total * sizeof(nju64));
+  NJ_CHECK_LOG_RETURN_VAL(p, false, "Can't allocate nj_bitset_t");
+  bs->allocator = allocator;
+  bs->words = p;
+  bs->set_summary = p + word_count;
+  bs->full_summary = p + word_count + summary_count;
+  bs->block_counts = (nju32*)(p + word_count + 2 * summary_count);
+  bs->bit_count = bit_count;
+  bs->word_count = word_count;
+  return true;
+}
+
+bool nj_bitset_init(nj_bitset_t* bs, nj_allocator_t* allocator, njsp bit_count) {
+  return bitset_alloc(bs, allocator, bit_count);
+}
+
+void nj_bitset_destroy(nj_bitset_t* bs) {
+  NJ_CHECK_LOG_RETURN(bs->allocator, "Can't destroy a nj_bitset_t view");
+  bs->allocator->free(bs->words);
+  *bs = {};
+}
+
+bool nj_bitset_resize(nj_bitset_t* bs, njsp bit_count) {
+  NJ_CHECK_LOG_RETURN_VAL(bs->allocator, false, "Can't resize a nj_bitset_t view");
+  nj_bitset_t new_bs;
+  NJ_CHECK_RETURN_VAL(bitset_alloc(&new_bs, bs->allocator, bit_count), false);
+  njsp word_count = nj_min(bs->word_count, new_bs.word_count);
+  memcpy(new_bs.words, bs->words, word_count * sizeof(nju64));
+  if (word_count)
+    new_bs.words[word_count - 1] &= bitset_valid_mask(&new_bs, word_count - 1);
+  for (njsp w = 0; w < word_count; ++w)
+    bitset_update_summary(&new_bs, w);
+  bitset_update_block_counts(&new_bs, 0, word_count);
+  bs->allocator->free(bs->words);
+  *bs = new_bs;
+  return true;
+}
+
+void nj_bitset_set(nj_bitset_t* bs, njsp index) {
+  njsp w = index >> 6;
+  nju64 bit = 1ull << (index & 63);
+  if (bs->words[w] & bit)
+    return;
+  bs->words[w] |= bit;
+  ++bs->block_counts[w >> 6];
+  bs->set_summary[w >> 6] |= 1ull << (w & 63);
+  if (bs->words[w] == bitset_valid_mask(bs, w))
+    bs->full_summary[w >> 6] |= 1ull << (w & 63);
+}
+
+void nj_bitset_clear(nj_bitset_t* bs, njsp index) {
+  njsp w = index >> 6;
+  nju64 bit = 1ull << (index & 63);
+  if (!(bs->words[w] & bit))
+    return;
+  bs->words[w] &= ~bit;
+  --bs->block_counts[w >> 6];
+  bs->full_summary[w >> 6] &= ~(1ull << (w & 63));
+  if (!bs->words[w])
+    bs->set_summary[w >> 6] &= ~(1ull << (w & 63));
+}
+
+void nj_bitset_assign(nj_bitset_t* bs, njsp index, bool val) {
+  if (val)
+    nj_bitset_set(bs, index);
+  else
+    nj_bitset_clear(bs, index);
+}
+
+bool nj_bitset_test(const nj_bitset_t* bs, njsp index) {
+  return (bs->words[index >> 6] >> (index & 63)) & 1;
+}
+
+void nj_bitset_set_all(nj_bitset_t* bs) {
+  for (njsp w = 0; w < bs->word_count; ++w) {
+    bs->words[w] = bitset_valid_mask(bs, w);
+    bitset_update_summary(bs, w);
+  }
+  bitset_update_block_counts(bs, 0, bs->word_count);
+}
+
+void nj_bitset_clear_all(nj_bitset_t* bs) {
+  njsp summary_count = bitset_summary_count(bs->word_count);
+  memset(bs->words, 0, bs->word_count * sizeof(nju64));
+  memset(bs->set_summary, 0, summary_count * sizeof(nju64));
+  memset(bs->full_summary, 0, summary_count * sizeof(nju64));
+  memset(bs->block_counts, 0, summary_count * sizeof(nju32));
+}
+
+bool nj_bitset_any(const nj_bitset_t* bs) {
+  return bitset_find_word(bs, bs->set_summary, false, 0) != NJ_BITSET_NPOS;
+}
+
+njsp nj_bitset_find_next_set(const nj_bitset_t* bs, njsp from) {
+  if (from < 0)
+    from = 0;
+  if (from >= bs->bit_count)
+    return NJ_BITSET_NPOS;
+  njsp w = from >> 6;
+  nju64 bits = bs->words[w] & (~0ull << (from & 63));
+  if (!bits) {
+    w = bitset_find_word(bs, bs->set_summary, false, w + 1);
+    if (w == NJ_BITSET_NPOS)
+      return NJ_BITSET_NPOS;
+    bits = bs->words[w];
+  }
+  return (w << 6) + nj_ctz64(bits);
+}
+
+njsp nj_bitset_find_next_clear(const nj_bitset_t* bs, njsp from) {
+  if (from < 0)
+    from = 0;
+  if (from >= bs->bit_count)
+    return NJ_BITSET_NPOS;
+  njsp w = from >> 6;
+  nju64 bits = ~bs->words[w] & bitset_valid_mask(bs, w) & (~0ull << (from & 63));
+  if (!bits) {
+    w = bitset_find_word(bs, bs->full_summary, true, w + 1);
+    if (w == NJ_BITSET_NPOS)
+      return NJ_BITSET_NPOS;
+    bits = ~bs->words[w] & bitset_valid_mask(bs, w);
+  }
+  return (w << 6) + nj_ctz64(bits);
+}
+
+njsp nj_bitset_count(const nj_bitset_t* bs) {
+  njsp summary_count = bitset_summary_count(bs->word_count);
+  njsp count = 0;
+  for (njsp s = 0; s < summary_count; ++s)
+    count += bs->block_counts[s];
+  return count;
+}
+
+njsp nj_bitset_rank(const nj_bitset_t* bs, njsp index) {
+  if (index <= 0)
+    return 0;
+  if (index > bs->bit_count)
+    index = bs->bit_count;
+  njsp last_word = index >> 6;
+  njsp count = 0;
+  for (njsp s = 0; s < last_word >> 6; ++s)
+    count += bs->block_counts[s];
+  for (njsp w = last_word & ~63; w < last_word; ++w)
+    count += nj_popcount64(bs->words[w]);
+  if (index & 63)
+    count += nj_popcount64(bs->words[last_word] & ((1ull << (index & 63)) - 1));
+  return count;
+}
+
+njsp nj_bitset_select(const nj_bitset_t* bs, njsp nth) {
+  if (nth < 0)
+    return NJ_BITSET_NPOS;
+  njsp summary_count = bitset_summary_count(bs->word_count);
+  njsp s = 0;
+  for (; s < summary_count && nth >= bs->block_counts[s]; ++s)
+    nth -= bs->block_counts[s];
+  if (s == summary_count)
+    return NJ_BITSET_NPOS;
+  for (njsp w = bitset_find_word(bs, bs->set_summary, false, s << 6);; w = bitset_find_word(bs, bs->set_summary, false, w + 1)) {
+    nju64 bits = bs->words[w];
+    njsp count = nj_popcount64(bits);
+    if (nth >= count) {
+      nth -= count;
+      continue;
+    }
+    for (; nth > 0; --nth)
+      bits &= bits - 1;
+    return (w << 6) + nj_ctz64(bits);
+  }
+}
+
+template <int OP>
+static void bitset_apply(nj_bitset_t* dst, const nj_bitset_t* src, njsp first_word, njsp word_num) {
+  NJ_CHECK_LOG_RETURN(first_word >= 0 && first_word + word_num <= dst->word_count && first_word + word_num <= src->word_count, "Word range is out of bounds");
+  nju64* d = dst->words + first_word;
+  const nju64* s = src->words + first_word;
+  njsp i = 0;
+#if NJ_CPU_X64()
+  for (; i + 2 <= word_num; i += 2) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(d + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(s + i));
+    if (OP == BITSET_OP_AND)
+      a = _mm_and_si128(a, b);
+    else if (OP == BITSET_OP_OR)
+      a = _mm_or_si128(a, b);
+    else
+      a = _mm_andnot_si128(b, a);
+    _mm_storeu_si128((__m128i*)(d + i), a);
+  }
+#endif
+  for (; i < word_num; ++i) {
+    if (OP == BITSET_OP_AND)
+      d[i] &= s[i];
+    else if (OP == BITSET_OP_OR)
+      d[i] |= s[i];
+    else
+      d[i] &= ~s[i];
+  }
+  for (njsp w = first_word; w < first_word + word_num; ++w) {
+    dst->words[w] &= bitset_valid_mask(dst, w);
+    bitset_update_summary(dst, w);
+  }
+  bitset_update_block_counts(dst, first_word, first_word + word_num);
+}
+
+void nj_bitset_and(nj_bitset_t* dst, const nj_bitset_t* src, njsp first_word, njsp word_num) {
+  bitset_apply<BITSET_OP_AND>(dst, src, first_word, word_num);
+}
+
+void nj_bitset_or(nj_bitset_t* dst, const nj_bitset_t* src, njsp first_word, njsp word_num) {
+  bitset_apply<BITSET_OP_OR>(dst, src, first_word, word_num);
+}
+
+void nj_bitset_andnot(nj_bitset_t* dst, const nj_bitset_t* src, njsp first_word, njsp word_num) {
+  bitset_apply<BITSET_OP_ANDNOT>(dst, src, first_word, word_num);
+}
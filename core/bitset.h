@@ -0,0 +1,93 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_BITSET_H
+#define NJ_CORE_BITSET_H
+
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+
+#define NJ_BITSET_NPOS (-1)
+#define NJ_BITSET_WORD_COUNT(bit_count) (((bit_count) + 63) / 64)
+
+// Bits are stored in 64-bit |words|. The summary level has one bit per word so
+// searches skip 4096 bits at a time:
+// - |set_summary| bit i is set if |words[i]| has any set bit.
+// - |full_summary| bit i is set if every valid bit of |words[i]| is set.
+// |block_counts| i is the number of set bits in the 64 words covered by
+// |set_summary[i]|, rank and select skip whole blocks with it.
+// A zero-filled bitset is valid, which is what makes nj_fixed_bitset_t work
+// without init. Bits past |bit_count| in the last word are always 0.
+struct nj_bitset_t {
+  nj_allocator_t* allocator;
+  nju64* words;
+  nju64* set_summary;
+  nju64* full_summary;
+  nju32* block_counts;
+  njsp bit_count;
+  njsp word_count;
+};
+
+// Storage for a bitset whose size is known at compile time, use
+// nj_bitset_view() to operate on it.
+template <njsp N>
+struct nj_fixed_bitset_t {
+  static_assert(N > 0, "A nj_fixed_bitset_t needs at least one bit");
+  nju64 words[NJ_BITSET_WORD_COUNT(N)] = {};
+  nju64 set_summary[NJ_BITSET_WORD_COUNT(NJ_BITSET_WORD_COUNT(N))] = {};
+  nju64 full_summary[NJ_BITSET_WORD_COUNT(NJ_BITSET_WORD_COUNT(N))] = {};
+  nju32 block_counts[NJ_BITSET_WORD_COUNT(NJ_BITSET_WORD_COUNT(N))] = {};
+};
+
+// The view is valid as long as |fbs| doesn't move. It can't be resized.
+template <njsp N>
+nj_bitset_t nj_bitset_view(nj_fixed_bitset_t<N>* fbs) {
+  nj_bitset_t bs;
+  bs.allocator = NULL;
+  bs.words = fbs->words;
+  bs.set_summary = fbs->set_summary;
+  bs.full_summary = fbs->full_summary;
+  bs.block_counts = fbs->block_counts;
+  bs.bit_count = N;
+  bs.word_count = NJ_BITSET_WORD_COUNT(N);
+  return bs;
+}
+
+// All bits are cleared.
+bool nj_bitset_init(nj_bitset_t* bs, nj_allocator_t* allocator, njsp bit_count);
+void nj_bitset_destroy(nj_bitset_t* bs);
+// New bits are cleared.
+bool nj_bitset_resize(nj_bitset_t* bs, njsp bit_count);
+
+void nj_bitset_set(nj_bitset_t* bs, njsp index);
+void nj_bitset_clear(nj_bitset_t* bs, njsp index);
+void nj_bitset_assign(nj_bitset_t* bs, njsp index, bool val);
+bool nj_bitset_test(const nj_bitset_t* bs, njsp index);
+void nj_bitset_set_all(nj_bitset_t* bs);
+void nj_bitset_clear_all(nj_bitset_t* bs);
+bool nj_bitset_any(const nj_bitset_t* bs);
+
+// Find the first set/clear bit at or after |from|. Returns NJ_BITSET_NPOS if
+// there is none.
+njsp nj_bitset_find_next_set(const nj_bitset_t* bs, njsp from);
+njsp nj_bitset_find_next_clear(const nj_bitset_t* bs, njsp from);
+
+// Number of set bits. These scan |block_counts| then popcount at most 64
+// words, so they are O(|bit_count| / 4096).
+njsp nj_bitset_count(const nj_bitset_t* bs);
+// Number of set bits in [0, |index|).
+njsp nj_bitset_rank(const nj_bitset_t* bs, njsp index);
+// Index of the |nth| (0-based) set bit or NJ_BITSET_NPOS.
+njsp nj_bitset_select(const nj_bitset_t* bs, njsp nth);
+
+// |dst| op= |src| for the words in [|first_word|, |first_word| + |word_num|).
+// Both bitsets must have at least that many words.
+void nj_bitset_and(nj_bitset_t* dst, const nj_bitset_t* src, njsp first_word, njsp word_num);
+void nj_bitset_or(nj_bitset_t* dst, const nj_bitset_t* src, njsp first_word, njsp word_num);
+void nj_bitset_andnot(nj_bitset_t* dst, const nj_bitset_t* src, njsp first_word, njsp word_num);
+
+#endif // NJ_CORE_BITSET_H
@@ -17,4 +17,14 @@
 
 #define NJ_IS_CLANG() _NJ_COMPILER_CLANG
 
+#if _NJ_COMPILER_MSVC
+#define NJ_NOINLINE __declspec(noinline)
+#define NJ_TARGET(isa)
+#else
+#define NJ_NOINLINE __attribute__((noinline))
+// The function can use the instructions of |isa| (e.g. "avx2") without
+// compiling the whole file for it. MSVC allows any intrinsic anyway.
+#define NJ_TARGET(isa) __attribute__((target(isa)))
+#endif
+
 #endif // NJ_CORE_BUILD_H
@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/cpu_topology.h"
+
+#include "core/log.h"
+#include "core/os.h"
+#include "core/utils.h"
+
+#if NJ_CPU_X64()
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#endif
+
+#if NJ_CPU_X64()
+static void cpu_cpuid(int leaf, int subleaf, nju32 regs[4]) {
+#  if defined(_MSC_VER)
+  int r[4];
+  __cpuidex(r, leaf, subleaf);
+  for (int i = 0; i < 4; ++i)
+    regs[i] = (nju32)r[i];
+#  else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#  endif
+}
+
+static nju64 cpu_xgetbv() {
+#  if defined(_MSC_VER)
+  return _xgetbv(0);
+#  else
+  nju32 eax;
+  nju32 edx;
+  __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (nju64)edx << 32 | eax;
+#  endif
+}
+#endif
+
+void nj_cpu_get_features(nj_cpu_features_t* features) {
+  *features = {};
+#if NJ_CPU_X64()
+  nju32 regs[4];
+  cpu_cpuid(0, 0, regs);
+  nju32 max_leaf = regs[0];
+  cpu_cpuid(1, 0, regs);
+  features->has_sse2 = regs[3] & (1u << 26);
+  features->has_ssse3 = regs[2] & (1u << 9);
+  features->has_sse4_1 = regs[2] & (1u << 19);
+  // AVX registers also need to be saved by the OS (OSXSAVE and the SSE and
+  // AVX state in XCR0).
+  bool has_avx = (regs[2] & (1u << 27)) && (regs[2] & (1u << 28)) && (cpu_xgetbv() & 6) == 6;
+  if (has_avx && max_leaf >= 7) {
+    cpu_cpuid(7, 0, regs);
+    features->has_avx2 = regs[1] & (1u << 5);
+  }
+#endif
+}
+
+void nj_cpu_get_group_set(const nj_cpu_topology_t* topology, nj_cpu_group_t group, int index, nj_cpu_set_t* set) {
+  *set = {};
+  for (int i = 0; i < topology->logical_core_count; ++i) {
+    const nj_cpu_logical_core_t* core = &topology->logical_cores[i];
+    int core_index = -1;
+    switch (group) {
+    case NJ_CPU_GROUP_PHYSICAL_CORE:
+      core_index = core->physical_core;
+      break;
+    case NJ_CPU_GROUP_L2:
+      core_index = core->l2_group;
+      break;
+    case NJ_CPU_GROUP_L3:
+      core_index = core->l3_group;
+      break;
+    case NJ_CPU_GROUP_NUMA_NODE:
+      core_index = core->numa_node;
+      break;
+    }
+    if (core_index == index)
+      nj_cpu_set_add(set, core->id);
+  }
+}
+
+void nj_cpu_set_add(nj_cpu_set_t* set, int id) {
+  NJ_CHECK_RETURN(id >= 0 && id < NJ_CPU_MAX_LOGICAL_CORES);
+  set->masks[id / 64] |= 1ull << (id % 64);
+}
+
+bool nj_cpu_set_has(const nj_cpu_set_t* set, int id) {
+  if (id < 0 || id >= NJ_CPU_MAX_LOGICAL_CORES)
+    return false;
+  return set->masks[id / 64] & (1ull << (id % 64));
+}
+
+int nj_cpu_set_count(const nj_cpu_set_t* set) {
+  int count = 0;
+  for (njsz i = 0; i < nj_static_array_size(set->masks); ++i)
+    count += nj_popcount64(set->masks[i]);
+  return count;
+}
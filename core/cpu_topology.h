@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_CPU_TOPOLOGY_H
+#define NJ_CORE_CPU_TOPOLOGY_H
+
+#include "core/njtype.h"
+
+// CPUs with a higher OS index are ignored.
+#define NJ_CPU_MAX_LOGICAL_CORES (256)
+
+// A set of logical cores indexed by their OS index. On Windows only the
+// processor group of the process is used so indices are less than 64.
+struct nj_cpu_set_t {
+  nju64 masks[NJ_CPU_MAX_LOGICAL_CORES / 64] = {};
+};
+
+enum nj_cpu_group_t {
+  NJ_CPU_GROUP_PHYSICAL_CORE,
+  NJ_CPU_GROUP_L2,
+  NJ_CPU_GROUP_L3,
+  NJ_CPU_GROUP_NUMA_NODE,
+};
+
+struct nj_cpu_logical_core_t {
+  // Index used by the OS.
+  int id;
+  // Indices in [0, count of the group in nj_cpu_topology_t), or -1 if the OS
+  // doesn't report it. Logical cores with the same index share that resource.
+  int physical_core;
+  int l2_group;
+  int l3_group;
+  int numa_node;
+};
+
+struct nj_cpu_topology_t {
+  // Only the logical cores the process is allowed to run on, sorted by id.
+  nj_cpu_logical_core_t logical_cores[NJ_CPU_MAX_LOGICAL_CORES];
+  int logical_core_count;
+  int physical_core_count;
+  int l2_group_count;
+  int l3_group_count;
+  int numa_node_count;
+  // CPU time the process can use per period, rounded up to whole cores. 0 if
+  // there is no quota (cgroup cpu.max on Linux, job object CPU rate on
+  // Windows).
+  int quota_core_count;
+};
+
+bool nj_cpu_get_topology(nj_cpu_topology_t* topology);
+// Doesn't read the whole topology so it's cheap enough to call before sizing
+// a thread pool. 0 if there is no quota.
+int nj_cpu_get_quota_core_count();
+// Logical cores of |topology| whose |group| index is |index|.
+void nj_cpu_get_group_set(const nj_cpu_topology_t* topology, nj_cpu_group_t group, int index, nj_cpu_set_t* set);
+
+// Instruction set extensions that the CPU and the OS support. All false on
+// other CPUs than x64.
+struct nj_cpu_features_t {
+  bool has_sse2;
+  bool has_ssse3;
+  bool has_sse4_1;
+  bool has_avx2;
+};
+
+void nj_cpu_get_features(nj_cpu_features_t* features);
+
+void nj_cpu_set_add(nj_cpu_set_t* set, int id);
+bool nj_cpu_set_has(const nj_cpu_set_t* set, int id);
+int nj_cpu_set_count(const nj_cpu_set_t* set);
+
+#endif // NJ_CORE_CPU_TOPOLOGY_H
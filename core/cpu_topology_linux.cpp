@@ -0,0 +1,191 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/cpu_topology.h"
+
+#include "core/log.h"
+#include "core/utils.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Maps ids read from /sys (the first cpu of a shared list, a node id) to
+// indices in [0, count).
+struct cpu_group_map_t {
+  int keys[NJ_CPU_MAX_LOGICAL_CORES];
+  int count;
+};
+
+static bool cpu_read_file(const char* path, char* buffer, int size) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return false;
+  ssize_t len = read(fd, buffer, size - 1);
+  close(fd);
+  if (len <= 0)
+    return false;
+  buffer[len] = 0;
+  return true;
+}
+
+static bool cpu_read_int(const char* path, int* val) {
+  char buffer[32];
+  if (!cpu_read_file(path, buffer, sizeof(buffer)))
+    return false;
+  *val = atoi(buffer);
+  return true;
+}
+
+// Parses lists like "0-3,8,10-11".
+static bool cpu_read_list(const char* path, nj_cpu_set_t* set) {
+  char buffer[1024];
+  *set = {};
+  if (!cpu_read_file(path, buffer, sizeof(buffer)))
+    return false;
+  char* p = buffer;
+  while (*p >= '0' && *p <= '9') {
+    int first = strtol(p, &p, 10);
+    int last = first;
+    if (*p == '-')
+      last = strtol(p + 1, &p, 10);
+    for (int i = first; i <= last && i < NJ_CPU_MAX_LOGICAL_CORES; ++i)
+      nj_cpu_set_add(set, i);
+    if (*p == ',')
+      ++p;
+  }
+  return true;
+}
+
+static int cpu_get_first(const nj_cpu_set_t* set) {
+  for (njsz i = 0; i < nj_static_array_size(set->masks); ++i) {
+    if (set->masks[i])
+      return i * 64 + nj_ctz64(set->masks[i]);
+  }
+  return -1;
+}
+
+static int cpu_get_group_index(cpu_group_map_t* map, int key) {
+  for (int i = 0; i < map->count; ++i) {
+    if (map->keys[i] == key)
+      return i;
+  }
+  map->keys[map->count] = key;
+  return map->count++;
+}
+
+// Returns the first cpu of the list in |path|, or -1. Cpus sharing a resource
+// read the same list so it identifies the resource.
+static int cpu_read_list_key(const char* path) {
+  nj_cpu_set_t set;
+  if (!cpu_read_list(path, &set))
+    return -1;
+  return cpu_get_first(&set);
+}
+
+bool nj_cpu_get_topology(nj_cpu_topology_t* topology) {
+  memset(topology, 0, sizeof(nj_cpu_topology_t));
+  cpu_set_t affinity;
+  NJ_CHECK_LOG_RETURN_VAL(sched_getaffinity(0, sizeof(affinity), &affinity) == 0, false, "Can't get the CPU affinity");
+
+  cpu_group_map_t physical_map = {};
+  cpu_group_map_t l2_map = {};
+  cpu_group_map_t l3_map = {};
+  char path[128];
+  for (int id = 0; id < NJ_CPU_MAX_LOGICAL_CORES && id < CPU_SETSIZE; ++id) {
+    if (!CPU_ISSET(id, &affinity))
+      continue;
+    nj_cpu_logical_core_t* core = &topology->logical_cores[topology->logical_core_count++];
+    core->id = id;
+    core->l2_group = -1;
+    core->l3_group = -1;
+    core->numa_node = -1;
+
+    // core_cpus_list replaced thread_siblings_list in Linux 5.7.
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_cpus_list", id);
+    int key = cpu_read_list_key(path);
+    if (key == -1) {
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", id);
+      key = cpu_read_list_key(path);
+    }
+    core->physical_core = cpu_get_group_index(&physical_map, key != -1 ? key : id);
+
+    for (int i = 0;; ++i) {
+      int level;
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", id, i);
+      if (!cpu_read_int(path, &level))
+        break;
+      if (level != 2 && level != 3)
+        continue;
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", id, i);
+      key = cpu_read_list_key(path);
+      if (key == -1)
+        continue;
+      if (level == 2)
+        core->l2_group = cpu_get_group_index(&l2_map, key);
+      else
+        core->l3_group = cpu_get_group_index(&l3_map, key);
+    }
+  }
+
+  nj_cpu_set_t nodes;
+  if (cpu_read_list("/sys/devices/system/node/online", &nodes)) {
+    for (int node = 0; node < NJ_CPU_MAX_LOGICAL_CORES; ++node) {
+      if (!nj_cpu_set_has(&nodes, node))
+        continue;
+      nj_cpu_set_t node_cpus;
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+      if (!cpu_read_list(path, &node_cpus))
+        continue;
+      bool is_used = false;
+      for (int i = 0; i < topology->logical_core_count; ++i) {
+        nj_cpu_logical_core_t* core = &topology->logical_cores[i];
+        if (nj_cpu_set_has(&node_cpus, core->id)) {
+          core->numa_node = topology->numa_node_count;
+          is_used = true;
+        }
+      }
+      // Nodes without usable cores (memory only or outside the affinity mask)
+      // don't get an index.
+      if (is_used)
+        ++topology->numa_node_count;
+    }
+  }
+
+  topology->physical_core_count = physical_map.count;
+  topology->l2_group_count = l2_map.count;
+  topology->l3_group_count = l3_map.count;
+  topology->quota_core_count = nj_cpu_get_quota_core_count();
+  return true;
+}
+
+int nj_cpu_get_quota_core_count() {
+  // The root of the mounted hierarchy is the container's own cgroup when it
+  // runs in a cgroup namespace, which is what the container runtimes do.
+  char buffer[64];
+  long quota = -1;
+  long period = 0;
+  if (cpu_read_file("/sys/fs/cgroup/cpu.max", buffer, sizeof(buffer))) {
+    // "max 100000" or "<quota> <period>".
+    if (strncmp(buffer, "max", 3) == 0)
+      return 0;
+    if (sscanf(buffer, "%ld %ld", &quota, &period) != 2)
+      return 0;
+  } else {
+    if (!cpu_read_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", buffer, sizeof(buffer)))
+      return 0;
+    quota = atol(buffer);
+    if (!cpu_read_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us", buffer, sizeof(buffer)))
+      return 0;
+    period = atol(buffer);
+  }
+  if (quota <= 0 || period <= 0)
+    return 0;
+  return (quota + period - 1) / period;
+}
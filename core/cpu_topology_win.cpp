@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/cpu_topology.h"
+
+#include "core/allocator.h"
+#include "core/core_allocators.h"
+#include "core/log.h"
+
+#include <Windows.h>
+#include <string.h>
+
+// Gives the next index of |group| to the logical cores in |mask|, if any of
+// them is usable.
+static void cpu_assign_group(nj_cpu_topology_t* topology, nj_cpu_group_t group, KAFFINITY mask, int* count) {
+  bool is_used = false;
+  for (int i = 0; i < topology->logical_core_count; ++i) {
+    nj_cpu_logical_core_t* core = &topology->logical_cores[i];
+    if (!(mask & ((KAFFINITY)1 << core->id)))
+      continue;
+    is_used = true;
+    switch (group) {
+    case NJ_CPU_GROUP_PHYSICAL_CORE:
+      core->physical_core = *count;
+      break;
+    case NJ_CPU_GROUP_L2:
+      core->l2_group = *count;
+      break;
+    case NJ_CPU_GROUP_L3:
+      core->l3_group = *count;
+      break;
+    case NJ_CPU_GROUP_NUMA_NODE:
+      core->numa_node = *count;
+      break;
+    }
+  }
+  if (is_used)
+    ++*count;
+}
+
+bool nj_cpu_get_topology(nj_cpu_topology_t* topology) {
+  memset(topology, 0, sizeof(nj_cpu_topology_t));
+  GROUP_AFFINITY thread_affinity;
+  NJ_CHECK_LOG_RETURN_VAL(GetThreadGroupAffinity(GetCurrentThread(), &thread_affinity), false, "Can't get the processor group");
+  DWORD_PTR process_mask;
+  DWORD_PTR system_mask;
+  NJ_CHECK_LOG_RETURN_VAL(GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask), false, "Can't get the CPU affinity");
+  for (int id = 0; id < 64; ++id) {
+    if (!(process_mask & ((DWORD_PTR)1 << id)))
+      continue;
+    nj_cpu_logical_core_t* core = &topology->logical_cores[topology->logical_core_count++];
+    core->id = id;
+    core->physical_core = -1;
+    core->l2_group = -1;
+    core->l3_group = -1;
+    core->numa_node = -1;
+  }
+
+  DWORD len = 0;
+  GetLogicalProcessorInformationEx(RelationAll, NULL, &len);
+  nju8* buffer = (nju8*)g_general_allocator->alloc(len);
+  NJ_CHECK_LOG_RETURN_VAL(buffer, false, "Can't allocate the processor information");
+  if (!GetLogicalProcessorInformationEx(RelationAll, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buffer, &len)) {
+    g_general_allocator->free(buffer);
+    NJ_LOGW("Can't get the processor information");
+    return false;
+  }
+  WORD group = thread_affinity.Group;
+  for (DWORD offset = 0; offset < len;) {
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)(buffer + offset);
+    offset += info->Size;
+    if (info->Relationship == RelationProcessorCore) {
+      for (WORD i = 0; i < info->Processor.GroupCount; ++i) {
+        if (info->Processor.GroupMask[i].Group == group)
+          cpu_assign_group(topology, NJ_CPU_GROUP_PHYSICAL_CORE, info->Processor.GroupMask[i].Mask, &topology->physical_core_count);
+      }
+    } else if (info->Relationship == RelationCache) {
+      const CACHE_RELATIONSHIP* cache = &info->Cache;
+      if (cache->Type == CacheInstruction || cache->GroupMask.Group != group)
+        continue;
+      if (cache->Level == 2)
+        cpu_assign_group(topology, NJ_CPU_GROUP_L2, cache->GroupMask.Mask, &topology->l2_group_count);
+      else if (cache->Level == 3)
+        cpu_assign_group(topology, NJ_CPU_GROUP_L3, cache->GroupMask.Mask, &topology->l3_group_count);
+    } else if (info->Relationship == RelationNumaNode) {
+      if (info->NumaNode.GroupMask.Group == group)
+        cpu_assign_group(topology, NJ_CPU_GROUP_NUMA_NODE, info->NumaNode.GroupMask.Mask, &topology->numa_node_count);
+    }
+  }
+  g_general_allocator->free(buffer);
+  topology->quota_core_count = nj_cpu_get_quota_core_count();
+  return true;
+}
+
+int nj_cpu_get_quota_core_count() {
+  // Fails if the process isn't in a job.
+  JOBOBJECT_CPU_RATE_CONTROL_INFORMATION info;
+  if (!QueryInformationJobObject(NULL, JobObjectCpuRateControlInformation, &info, sizeof(info), NULL))
+    return 0;
+  DWORD flags = JOB_OBJECT_CPU_RATE_CONTROL_ENABLE | JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+  if ((info.ControlFlags & flags) != flags)
+    return 0;
+  // |CpuRate| is in 1/100 of a percent of all the processors.
+  njs64 total = (njs64)info.CpuRate * GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+  return (int)((total + 9999) / 10000);
+}
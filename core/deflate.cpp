@@ -0,0 +1,512 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/deflate.h"
+
+#include "core/allocator.h"
+#include "core/log.h"
+#include "core/utils.h"
+
+#include <string.h>
+
+#define NJ_DEFLATE_HASH_LOG (15)
+#define NJ_DEFLATE_MIN_MATCH (3)
+#define NJ_DEFLATE_MAX_MATCH (258)
+// Chain links followed for a match and the length that stops the search and
+// the lazy step, about zlib's default level.
+#define NJ_DEFLATE_MAX_ATTEMPTS (128)
+#define NJ_DEFLATE_NICE_MATCH (128)
+#define NJ_DEFLATE_MAX_STORED (65535)
+// The fixed code has 288 literal/length symbols, 286 and 287 are never used.
+#define NJ_DEFLATE_LIT_COUNT (288)
+#define NJ_DEFLATE_DIST_COUNT (30)
+#define NJ_DEFLATE_CODE_LEN_COUNT (19)
+#define NJ_DEFLATE_MAX_BITS (15)
+#define NJ_DEFLATE_MAX_CODE_LEN_BITS (7)
+
+static const int gc_len_bases[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                   31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+
+static const int gc_len_extra_bits[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                        2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+static const int gc_dist_bases[] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+static const int gc_dist_extra_bits[] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                         6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static const int gc_code_len_order[] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// Extra bits of the code length symbols 16, 17 and 18.
+static const int gc_code_len_extra_bits[] = {2, 3, 7};
+
+// A block's symbol frequencies and the Huffman codes built from them. The
+// codes are bit reversed to be written from the least significant bit.
+struct deflate_block_t {
+  nju32 lit_freqs[NJ_DEFLATE_LIT_COUNT];
+  nju32 dist_freqs[NJ_DEFLATE_DIST_COUNT];
+  nju8 lit_lens[NJ_DEFLATE_LIT_COUNT];
+  nju8 dist_lens[NJ_DEFLATE_DIST_COUNT];
+  nju16 lit_codes[NJ_DEFLATE_LIT_COUNT];
+  nju16 dist_codes[NJ_DEFLATE_DIST_COUNT];
+  // The code lengths of the dynamic header, run length encoded with the code
+  // length symbols and their extra values.
+  int hlit;
+  int hdist;
+  int hclen;
+  nju8 header_symbols[NJ_DEFLATE_LIT_COUNT + NJ_DEFLATE_DIST_COUNT];
+  nju8 header_extras[NJ_DEFLATE_LIT_COUNT + NJ_DEFLATE_DIST_COUNT];
+  int header_count;
+  nju32 code_len_freqs[NJ_DEFLATE_CODE_LEN_COUNT];
+  nju8 code_len_lens[NJ_DEFLATE_CODE_LEN_COUNT];
+  nju16 code_len_codes[NJ_DEFLATE_CODE_LEN_COUNT];
+};
+
+static int deflate_len_code(int len) {
+  if (len == NJ_DEFLATE_MAX_MATCH)
+    return 28;
+  int v = len - 3;
+  if (v < 8)
+    return v;
+  int log2 = 63 - nj_clz64(v);
+  return 4 * (log2 - 1) + ((v >> (log2 - 2)) & 3);
+}
+
+static int deflate_dist_code(int dist) {
+  if (dist <= 4)
+    return dist - 1;
+  int v = dist - 1;
+  int log2 = 63 - nj_clz64(v);
+  return 2 * log2 + ((v >> (log2 - 1)) & 1);
+}
+
+static nju32 deflate_hash(const nju8* p) {
+  nju32 v = p[0] | p[1] << 8 | p[2] << 16;
+  return (v * 2654435761u) >> (32 - NJ_DEFLATE_HASH_LOG);
+}
+
+// Code lengths of at most |max_bits| for the |count| symbols, 0 for the unused
+// ones. Huffman's algorithm on two queues, the sorted leaves and the internal
+// nodes that are made in increasing weight. If the code is too long the
+// frequencies are halved until it fits. At least 2 symbols get a code so it's
+// complete.
+static void deflate_build_lens(const nju32* freqs, int count, int max_bits, nju8* lens) {
+  nju32 weights[2 * NJ_DEFLATE_LIT_COUNT];
+  int parents[2 * NJ_DEFLATE_LIT_COUNT];
+  int depths[2 * NJ_DEFLATE_LIT_COUNT];
+  int leaves[NJ_DEFLATE_LIT_COUNT];
+  nju32 scaled[NJ_DEFLATE_LIT_COUNT];
+  int leaf_count = 0;
+  for (int i = 0; i < count; ++i) {
+    scaled[i] = freqs[i];
+    if (freqs[i])
+      leaves[leaf_count++] = i;
+  }
+  for (int i = 0; leaf_count < 2; ++i) {
+    if (!scaled[i]) {
+      scaled[i] = 1;
+      leaves[leaf_count++] = i;
+    }
+  }
+  for (;;) {
+    // Insertion sort, stable so equal frequencies keep the symbol order.
+    for (int i = 1; i < leaf_count; ++i) {
+      int leaf = leaves[i];
+      int j = i;
+      for (; j > 0 && scaled[leaves[j - 1]] > scaled[leaf]; --j)
+        leaves[j] = leaves[j - 1];
+      leaves[j] = leaf;
+    }
+    for (int i = 0; i < leaf_count; ++i)
+      weights[i] = scaled[leaves[i]];
+    int next_leaf = 0;
+    int next_node = leaf_count;
+    int node_count = 2 * leaf_count - 1;
+    for (int node = leaf_count; node < node_count; ++node) {
+      weights[node] = 0;
+      for (int j = 0; j < 2; ++j) {
+        int child = next_leaf < leaf_count && (next_node == node || weights[next_leaf] <= weights[next_node]) ? next_leaf++ : next_node++;
+        parents[child] = node;
+        weights[node] += weights[child];
+      }
+    }
+    // Parents are made after their children.
+    int max_depth = 0;
+    depths[node_count - 1] = 0;
+    for (int i = node_count - 2; i >= 0; --i) {
+      depths[i] = depths[parents[i]] + 1;
+      max_depth = nj_max(max_depth, depths[i]);
+    }
+    if (max_depth <= max_bits)
+      break;
+    for (int i = 0; i < leaf_count; ++i)
+      scaled[leaves[i]] = (scaled[leaves[i]] + 1) / 2;
+  }
+  memset(lens, 0, count);
+  for (int i = 0; i < leaf_count; ++i)
+    lens[leaves[i]] = (nju8)depths[i];
+}
+
+// Canonical codes of RFC 1951 3.2.2, bit reversed.
+static void deflate_build_codes(const nju8* lens, int count, nju16* codes) {
+  int len_counts[NJ_DEFLATE_MAX_BITS + 1] = {};
+  for (int i = 0; i < count; ++i)
+    ++len_counts[lens[i]];
+  len_counts[0] = 0;
+  int next_codes[NJ_DEFLATE_MAX_BITS + 1];
+  int code = 0;
+  for (int bits = 1; bits <= NJ_DEFLATE_MAX_BITS; ++bits) {
+    code = (code + len_counts[bits - 1]) << 1;
+    next_codes[bits] = code;
+  }
+  for (int i = 0; i < count; ++i) {
+    if (!lens[i])
+      continue;
+    int v = next_codes[lens[i]]++;
+    int reversed = 0;
+    for (int j = 0; j < lens[i]; ++j)
+      reversed |= ((v >> j) & 1) << (lens[i] - 1 - j);
+    codes[i] = (nju16)reversed;
+  }
+}
+
+static void deflate_add_header_symbol(deflate_block_t* block, int symbol, int extra) {
+  block->header_symbols[block->header_count] = (nju8)symbol;
+  block->header_extras[block->header_count] = (nju8)extra;
+  ++block->header_count;
+  ++block->code_len_freqs[symbol];
+}
+
+// Run length encode the code lengths: 16 repeats the previous length 3-6
+// times, 17 and 18 repeat 0 3-10 and 11-138 times.
+static void deflate_build_header(deflate_block_t* block) {
+  block->hlit = 286;
+  while (block->hlit > 257 && !block->lit_lens[block->hlit - 1])
+    --block->hlit;
+  block->hdist = NJ_DEFLATE_DIST_COUNT;
+  while (block->hdist > 1 && !block->dist_lens[block->hdist - 1])
+    --block->hdist;
+  nju8 lens[NJ_DEFLATE_LIT_COUNT + NJ_DEFLATE_DIST_COUNT];
+  memcpy(lens, block->lit_lens, block->hlit);
+  memcpy(lens + block->hlit, block->dist_lens, block->hdist);
+  int count = block->hlit + block->hdist;
+  block->header_count = 0;
+  memset(block->code_len_freqs, 0, sizeof(block->code_len_freqs));
+  for (int i = 0; i < count;) {
+    int len = lens[i];
+    int run = 1;
+    while (i + run < count && lens[i + run] == len)
+      ++run;
+    i += run;
+    if (!len) {
+      for (; run >= 11; run -= nj_min(run, 138))
+        deflate_add_header_symbol(block, 18, nj_min(run, 138) - 11);
+      if (run >= 3) {
+        deflate_add_header_symbol(block, 17, run - 3);
+        run = 0;
+      }
+    } else {
+      deflate_add_header_symbol(block, len, 0);
+      for (--run; run >= 3; run -= nj_min(run, 6))
+        deflate_add_header_symbol(block, 16, nj_min(run, 6) - 3);
+    }
+    for (; run > 0; --run)
+      deflate_add_header_symbol(block, len, 0);
+  }
+  deflate_build_lens(block->code_len_freqs, NJ_DEFLATE_CODE_LEN_COUNT, NJ_DEFLATE_MAX_CODE_LEN_BITS, block->code_len_lens);
+  deflate_build_codes(block->code_len_lens, NJ_DEFLATE_CODE_LEN_COUNT, block->code_len_codes);
+  block->hclen = NJ_DEFLATE_CODE_LEN_COUNT;
+  while (block->hclen > 4 && !block->code_len_lens[gc_code_len_order[block->hclen - 1]])
+    --block->hclen;
+}
+
+static njsp deflate_get_header_cost(const deflate_block_t* block) {
+  njsp cost = 5 + 5 + 4 + 3 * block->hclen;
+  for (int i = 0; i < NJ_DEFLATE_CODE_LEN_COUNT; ++i)
+    cost += block->code_len_freqs[i] * (block->code_len_lens[i] + (i >= 16 ? gc_code_len_extra_bits[i - 16] : 0));
+  return cost;
+}
+
+static njsp deflate_get_codes_cost(const deflate_block_t* block, const nju8* lit_lens, const nju8* dist_lens) {
+  njsp cost = 0;
+  for (int i = 0; i < 286; ++i)
+    cost += block->lit_freqs[i] * (lit_lens[i] + (i > 256 ? gc_len_extra_bits[i - 257] : 0));
+  for (int i = 0; i < NJ_DEFLATE_DIST_COUNT; ++i)
+    cost += block->dist_freqs[i] * (dist_lens[i] + gc_dist_extra_bits[i]);
+  return cost;
+}
+
+static void deflate_get_fixed_lens(nju8* lit_lens, nju8* dist_lens) {
+  for (int i = 0; i < NJ_DEFLATE_LIT_COUNT; ++i)
+    lit_lens[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+  memset(dist_lens, 5, NJ_DEFLATE_DIST_COUNT);
+}
+
+static void deflate_align(nj_bit_writer_t* bw) {
+  nj_bw_write_lsb(bw, 0, (8 - (bw->bit_count & 7)) & 7);
+}
+
+// In chunks of at most NJ_DEFLATE_MAX_STORED bytes, an empty block if |size|
+// is 0.
+static void deflate_write_stored(nj_deflate_t* deflate, const nju8* data, njsp size, bool is_final) {
+  nj_bit_writer_t* bw = &deflate->bw;
+  do {
+    njsp len = nj_min(size, (njsp)NJ_DEFLATE_MAX_STORED);
+    nj_bw_write_lsb(bw, is_final && len == size, 1);
+    nj_bw_write_lsb(bw, 0, 2);
+    deflate_align(bw);
+    nj_bw_write_lsb(bw, len, 16);
+    nj_bw_write_lsb(bw, len ^ 0xffff, 16);
+    // Aligned, so every bit is written out.
+    nj_bw_flush_slow(bw);
+    if (bw->end - bw->p < len) {
+      bw->is_overflow = true;
+    } else if (len) {
+      memcpy(bw->p, data, len);
+      bw->p += len;
+    }
+    data += len;
+    size -= len;
+  } while (size);
+}
+
+static njsp deflate_get_stored_cost(const nj_deflate_t* deflate, njsp size) {
+  njsp chunk_count = nj_max((size + NJ_DEFLATE_MAX_STORED - 1) / NJ_DEFLATE_MAX_STORED, (njsp)1);
+  // The first chunk is aligned after its 3 bits, the next ones start aligned
+  // and have 5 bits of padding.
+  njsp padding = (8 - ((deflate->bw.bit_count + 3) & 7)) & 7;
+  return chunk_count * (3 + 32) + padding + 5 * (chunk_count - 1) + 8 * size;
+}
+
+static void deflate_write_symbols(nj_deflate_t* deflate, const nju8* lit_lens, const nju16* lit_codes, const nju8* dist_lens, const nju16* dist_codes) {
+  nj_bit_writer_t* bw = &deflate->bw;
+  for (int i = 0; i < deflate->symbol_count; ++i) {
+    nju32 symbol = deflate->symbols[i];
+    int dist = symbol >> 16;
+    int len = symbol & 0xffff;
+    if (!dist) {
+      nj_bw_write_lsb(bw, lit_codes[len], lit_lens[len]);
+      continue;
+    }
+    int code = deflate_len_code(len);
+    nj_bw_write_lsb(bw, lit_codes[257 + code], lit_lens[257 + code]);
+    nj_bw_write_lsb(bw, len - gc_len_bases[code], gc_len_extra_bits[code]);
+    code = deflate_dist_code(dist);
+    nj_bw_write_lsb(bw, dist_codes[code], dist_lens[code]);
+    nj_bw_write_lsb(bw, dist - gc_dist_bases[code], gc_dist_extra_bits[code]);
+  }
+  nj_bw_write_lsb(bw, lit_codes[256], lit_lens[256]);
+}
+
+// Write the symbols of the block, which are the |size| bytes of |data|, with
+// the cheapest of the three block types.
+static void deflate_write_block(nj_deflate_t* deflate, const nju8* data, njsp size, bool is_final) {
+  deflate_block_t block;
+  memset(block.lit_freqs, 0, sizeof(block.lit_freqs));
+  memset(block.dist_freqs, 0, sizeof(block.dist_freqs));
+  for (int i = 0; i < deflate->symbol_count; ++i) {
+    nju32 symbol = deflate->symbols[i];
+    int dist = symbol >> 16;
+    int len = symbol & 0xffff;
+    if (!dist) {
+      ++block.lit_freqs[len];
+    } else {
+      ++block.lit_freqs[257 + deflate_len_code(len)];
+      ++block.dist_freqs[deflate_dist_code(dist)];
+    }
+  }
+  block.lit_freqs[256] = 1;
+  deflate_build_lens(block.lit_freqs, 286, NJ_DEFLATE_MAX_BITS, block.lit_lens);
+  block.lit_lens[286] = block.lit_lens[287] = 0;
+  deflate_build_lens(block.dist_freqs, NJ_DEFLATE_DIST_COUNT, NJ_DEFLATE_MAX_BITS, block.dist_lens);
+  deflate_build_header(&block);
+  nju8 fixed_lit_lens[NJ_DEFLATE_LIT_COUNT];
+  nju8 fixed_dist_lens[NJ_DEFLATE_DIST_COUNT];
+  deflate_get_fixed_lens(fixed_lit_lens, fixed_dist_lens);
+
+  njsp dynamic_cost = 3 + deflate_get_header_cost(&block) + deflate_get_codes_cost(&block, block.lit_lens, block.dist_lens);
+  njsp fixed_cost = 3 + deflate_get_codes_cost(&block, fixed_lit_lens, fixed_dist_lens);
+  nj_bit_writer_t* bw = &deflate->bw;
+  if (deflate_get_stored_cost(deflate, size) <= nj_min(dynamic_cost, fixed_cost)) {
+    deflate_write_stored(deflate, data, size, is_final);
+  } else if (fixed_cost <= dynamic_cost) {
+    nju16 fixed_lit_codes[NJ_DEFLATE_LIT_COUNT];
+    nju16 fixed_dist_codes[NJ_DEFLATE_DIST_COUNT];
+    deflate_build_codes(fixed_lit_lens, NJ_DEFLATE_LIT_COUNT, fixed_lit_codes);
+    deflate_build_codes(fixed_dist_lens, NJ_DEFLATE_DIST_COUNT, fixed_dist_codes);
+    nj_bw_write_lsb(bw, is_final, 1);
+    nj_bw_write_lsb(bw, 1, 2);
+    deflate_write_symbols(deflate, fixed_lit_lens, fixed_lit_codes, fixed_dist_lens, fixed_dist_codes);
+  } else {
+    deflate_build_codes(block.lit_lens, NJ_DEFLATE_LIT_COUNT, block.lit_codes);
+    deflate_build_codes(block.dist_lens, NJ_DEFLATE_DIST_COUNT, block.dist_codes);
+    nj_bw_write_lsb(bw, is_final, 1);
+    nj_bw_write_lsb(bw, 2, 2);
+    nj_bw_write_lsb(bw, block.hlit - 257, 5);
+    nj_bw_write_lsb(bw, block.hdist - 1, 5);
+    nj_bw_write_lsb(bw, block.hclen - 4, 4);
+    for (int i = 0; i < block.hclen; ++i)
+      nj_bw_write_lsb(bw, block.code_len_lens[gc_code_len_order[i]], 3);
+    for (int i = 0; i < block.header_count; ++i) {
+      int symbol = block.header_symbols[i];
+      nj_bw_write_lsb(bw, block.code_len_codes[symbol], block.code_len_lens[symbol]);
+      if (symbol >= 16)
+        nj_bw_write_lsb(bw, block.header_extras[i], gc_code_len_extra_bits[symbol - 16]);
+    }
+    deflate_write_symbols(deflate, block.lit_lens, block.lit_codes, block.dist_lens, block.dist_codes);
+  }
+  deflate->symbol_count = 0;
+}
+
+// |pos| + NJ_DEFLATE_MIN_MATCH must be at most |size|.
+static void deflate_insert(nj_deflate_t* deflate, const nju8* data, njsp pos) {
+  nju32 h = deflate_hash(data + pos);
+  deflate->chain[pos & (NJ_INFLATE_HISTORY_SIZE - 1)] = deflate->head[h];
+  deflate->head[h] = (njs32)pos;
+}
+
+// The longest match at |pos| with the positions before it, |*len| is 0 if
+// there's none of NJ_DEFLATE_MIN_MATCH bytes. Distances stay under
+// NJ_INFLATE_HISTORY_SIZE so the chain entries of the candidates aren't
+// overwritten yet.
+static void deflate_find_match(const nj_deflate_t* deflate, const nju8* data, njsp size, njsp pos, int* len, int* dist) {
+  *len = 0;
+  *dist = 0;
+  if (pos + NJ_DEFLATE_MIN_MATCH > size)
+    return;
+  int max_len = (int)nj_min(size - pos, (njsp)NJ_DEFLATE_MAX_MATCH);
+  int best_len = NJ_DEFLATE_MIN_MATCH - 1;
+  njs32 candidate = deflate->head[deflate_hash(data + pos)];
+  for (int attempts = NJ_DEFLATE_MAX_ATTEMPTS; candidate >= 0 && pos - candidate < NJ_INFLATE_HISTORY_SIZE && attempts; --attempts) {
+    const nju8* a = data + pos;
+    const nju8* b = data + candidate;
+    if (b[best_len] == a[best_len] && b[0] == a[0]) {
+      int match_len = 0;
+      while (match_len < max_len && a[match_len] == b[match_len])
+        ++match_len;
+      if (match_len > best_len) {
+        best_len = match_len;
+        *len = match_len;
+        *dist = (int)(pos - candidate);
+        if (match_len >= NJ_DEFLATE_NICE_MATCH || match_len == max_len)
+          break;
+      }
+    }
+    njs32 next = deflate->chain[candidate & (NJ_INFLATE_HISTORY_SIZE - 1)];
+    if (next >= candidate)
+      break;
+    candidate = next;
+  }
+}
+
+static void deflate_add_symbol(nj_deflate_t* deflate, int len, int dist) {
+  deflate->symbols[deflate->symbol_count++] = (nju32)dist << 16 | (nju32)len;
+}
+
+bool nj_deflate_init(nj_deflate_t* deflate, nj_allocator_t* allocator, nj_inflate_format_t format, nju8* dst, njsp dst_capacity) {
+  deflate->allocator = allocator;
+  deflate->format = format;
+  njsp head_size = sizeof(njs32) << NJ_DEFLATE_HASH_LOG;
+  njsp chain_size = sizeof(njs32) * NJ_INFLATE_HISTORY_SIZE;
+  nju8* tables = (nju8*)allocator->alloc(head_size + chain_size + sizeof(nju32) * NJ_DEFLATE_BLOCK_SYMBOLS);
+  NJ_CHECK_LOG_RETURN_VAL(tables, false, "Can't allocate the deflate tables");
+  deflate->head = (njs32*)tables;
+  deflate->chain = (njs32*)(tables + head_size);
+  deflate->symbols = (nju32*)(tables + head_size + chain_size);
+  deflate->symbol_count = 0;
+  deflate->checksum = format == NJ_INFLATE_FORMAT_GZIP ? 0 : 1;
+  deflate->total_in = 0;
+  deflate->is_done = false;
+  nj_bw_init(&deflate->bw, dst, dst_capacity);
+  if (format == NJ_INFLATE_FORMAT_ZLIB) {
+    // 32 KB window, default level, the FCHECK bits make it a multiple of 31.
+    nj_bw_write_lsb(&deflate->bw, 0x78, 8);
+    nj_bw_write_lsb(&deflate->bw, 0x9c, 8);
+  } else if (format == NJ_INFLATE_FORMAT_GZIP) {
+    // No flags, no time, unknown OS.
+    const nju8 header[] = {31, 139, 8, 0, 0, 0, 0, 0, 0, 255};
+    for (nju8 byte : header)
+      nj_bw_write_lsb(&deflate->bw, byte, 8);
+  }
+  return true;
+}
+
+void nj_deflate_destroy(nj_deflate_t* deflate) {
+  deflate->allocator->free(deflate->head);
+}
+
+njsp nj_deflate_compress_bound(njsp size, int segment_count) {
+  // Every block can be stored, 5 bytes for each NJ_DEFLATE_MAX_STORED bytes
+  // and a partial block, a full flush per segment, the header and the trailer.
+  njsp block_count = size / NJ_DEFLATE_BLOCK_SYMBOLS + segment_count;
+  return size + 5 * (block_count + size / NJ_DEFLATE_MAX_STORED + segment_count + 1) + 18;
+}
+
+bool nj_deflate_write_segment(nj_deflate_t* deflate, const nju8* data, njsp size, bool is_last) {
+  NJ_CHECK_RETURN_VAL(!deflate->is_done, false);
+  memset(deflate->head, 0xff, sizeof(njs32) << NJ_DEFLATE_HASH_LOG);
+  njsp block_start = 0;
+  // The lazy step's match at |pos| + 1 is kept for the next position.
+  bool has_next = false;
+  int next_len = 0;
+  int next_dist = 0;
+  for (njsp pos = 0; pos < size;) {
+    int len = next_len;
+    int dist = next_dist;
+    if (!has_next)
+      deflate_find_match(deflate, data, size, pos, &len, &dist);
+    has_next = false;
+    if (pos + NJ_DEFLATE_MIN_MATCH <= size)
+      deflate_insert(deflate, data, pos);
+    if (len && len < NJ_DEFLATE_NICE_MATCH) {
+      deflate_find_match(deflate, data, size, pos + 1, &next_len, &next_dist);
+      has_next = next_len > len;
+    }
+    if (len && !has_next) {
+      deflate_add_symbol(deflate, len, dist);
+      for (njsp i = pos + 1; i < pos + len && i + NJ_DEFLATE_MIN_MATCH <= size; ++i)
+        deflate_insert(deflate, data, i);
+      pos += len;
+    } else {
+      deflate_add_symbol(deflate, data[pos], 0);
+      ++pos;
+    }
+    if (deflate->symbol_count == NJ_DEFLATE_BLOCK_SYMBOLS) {
+      deflate_write_block(deflate, data + block_start, pos - block_start, false);
+      block_start = pos;
+    }
+  }
+
+  if (deflate->format == NJ_INFLATE_FORMAT_GZIP)
+    deflate->checksum = nj_crc32(deflate->checksum, data, size);
+  else
+    deflate->checksum = nj_adler32(deflate->checksum, data, size);
+  deflate->total_in += size;
+  nj_bit_writer_t* bw = &deflate->bw;
+  if (!is_last) {
+    if (deflate->symbol_count)
+      deflate_write_block(deflate, data + block_start, size - block_start, false);
+    deflate_write_stored(deflate, NULL, 0, false);
+    return !bw->is_overflow;
+  }
+  deflate_write_block(deflate, data + block_start, size - block_start, true);
+  deflate_align(bw);
+  if (deflate->format == NJ_INFLATE_FORMAT_ZLIB) {
+    // Adler-32 is big endian.
+    for (int shift = 24; shift >= 0; shift -= 8)
+      nj_bw_write_lsb(bw, (deflate->checksum >> shift) & 0xff, 8);
+  } else if (deflate->format == NJ_INFLATE_FORMAT_GZIP) {
+    nj_bw_write_lsb(bw, deflate->checksum, 32);
+    nj_bw_write_lsb(bw, deflate->total_in & 0xffffffff, 32);
+  }
+  deflate->is_done = true;
+  return nj_bw_finish(bw) >= 0;
+}
+
+njsp nj_deflate_get_size(const nj_deflate_t* deflate) {
+  return deflate->bw.p - deflate->bw.data + (deflate->bw.bit_count + 7) / 8;
+}
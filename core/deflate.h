@@ -0,0 +1,57 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_DEFLATE_H
+#define NJ_CORE_DEFLATE_H
+
+#include "core/bit_stream.h"
+#include "core/inflate.h"
+
+struct nj_allocator_t;
+
+// Deflate (RFC 1951) encoder for the tools, e.g. to write PNG files. Matches
+// are found with hash chains and one step of lazy matching, each block is
+// written with dynamic or fixed Huffman codes or stored, whichever is
+// smallest. The data is compressed in segments that don't reference each
+// other so a decoder can inflate them in parallel.
+
+// Symbols in a block before the block is written.
+#define NJ_DEFLATE_BLOCK_SYMBOLS (16384)
+
+struct nj_deflate_t {
+  nj_allocator_t* allocator;
+  nj_inflate_format_t format;
+  nj_bit_writer_t bw;
+  // Last position of each hash and the previous position with the same hash
+  // for each position in the window.
+  njs32* head;
+  njs32* chain;
+  // Literals and matches of the current block, a match is its distance in the
+  // high 16 bits and its length in the low ones.
+  nju32* symbols;
+  int symbol_count;
+  // Checksum of the whole data for the zlib and gzip trailers.
+  nju32 checksum;
+  njsp total_in;
+  bool is_done;
+};
+
+// Writes the header of |format| to |dst|.
+bool nj_deflate_init(nj_deflate_t* deflate, nj_allocator_t* allocator, nj_inflate_format_t format, nju8* dst, njsp dst_capacity);
+void nj_deflate_destroy(nj_deflate_t* deflate);
+
+// Max compressed size of |size| bytes in |segment_count| segments.
+njsp nj_deflate_compress_bound(njsp size, int segment_count);
+// Compress |size| bytes of |data| as a segment whose matches don't reach into
+// the previous ones. It ends with a full flush (an empty stored block, the
+// next segment starts at a byte boundary) or with the final block and the
+// trailer if |is_last|. Returns false if the output is full.
+bool nj_deflate_write_segment(nj_deflate_t* deflate, const nju8* data, njsp size, bool is_last);
+// Bytes written so far, the start of the next segment. The output is only
+// complete after the last segment.
+njsp nj_deflate_get_size(const nj_deflate_t* deflate);
+
+#endif // NJ_CORE_DEFLATE_H
@@ -0,0 +1,51 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_FIBER_H
+#define NJ_CORE_FIBER_H
+
+#include "core/njtype.h"
+#include "core/os.h"
+
+#if NJ_OS_LINUX() && !NJ_CPU_X64()
+#include <ucontext.h>
+#endif
+
+typedef void (*nj_fiber_func_t)(void* args);
+
+// A user-space execution context with its own stack. On Windows it's a native
+// fiber, on Linux x64 a hand-written context switch that only saves the
+// callee-saved registers, on other Linux CPUs ucontext.
+struct nj_fiber_t {
+#if NJ_OS_WIN()
+  void* handle;
+#elif NJ_CPU_X64()
+  void* sp;
+#else
+  ucontext_t context;
+#endif
+  void* stack;
+  njsp stack_size;
+  nj_fiber_func_t func;
+  void* args;
+};
+
+// Make the calling thread able to switch to fibers, |fiber| is the thread's own
+// context that fibers switch back to.
+bool nj_fiber_init_from_thread(nj_fiber_t* fiber);
+void nj_fiber_destroy_from_thread(nj_fiber_t* fiber);
+
+// |func| must never return. The stack has a guard page at its end where the
+// platform allows it.
+bool nj_fiber_init(nj_fiber_t* fiber, njsp stack_size, nj_fiber_func_t func, void* args);
+void nj_fiber_destroy(nj_fiber_t* fiber);
+
+// Save the current context to |from|, which has to be the running fiber, and
+// continue |to|. Returns when something switches back to |from|, maybe on
+// another thread.
+void nj_fiber_switch(nj_fiber_t* from, nj_fiber_t* to);
+
+#endif // NJ_CORE_FIBER_H
@@ -0,0 +1,130 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/fiber.h"
+
+#include "core/log.h"
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static void fiber_entry(nj_fiber_t* fiber) {
+  fiber->func(fiber->args);
+  NJ_LOGF("A fiber function returned");
+  abort();
+}
+
+#if NJ_CPU_X64()
+// Saves the callee-saved registers, MXCSR and the x87 control word on the
+// current stack, stores the stack pointer to *|from_sp| and does the reverse
+// from |to_sp|. A new fiber's stack is laid out so the final ret lands in
+// fiber_trampoline with r12 = fiber_entry and r13 = the fiber.
+extern "C" void nj_fiber_switch_context(void** from_sp, void* to_sp);
+extern "C" void nj_fiber_trampoline();
+
+__asm__(
+    ".text\n"
+    ".globl nj_fiber_switch_context\n"
+    ".type nj_fiber_switch_context, @function\n"
+    "nj_fiber_switch_context:\n"
+    "  pushq %rbp\n"
+    "  pushq %rbx\n"
+    "  pushq %r12\n"
+    "  pushq %r13\n"
+    "  pushq %r14\n"
+    "  pushq %r15\n"
+    "  subq $8, %rsp\n"
+    "  stmxcsr (%rsp)\n"
+    "  fnstcw 4(%rsp)\n"
+    "  movq %rsp, (%rdi)\n"
+    "  movq %rsi, %rsp\n"
+    "  ldmxcsr (%rsp)\n"
+    "  fldcw 4(%rsp)\n"
+    "  addq $8, %rsp\n"
+    "  popq %r15\n"
+    "  popq %r14\n"
+    "  popq %r13\n"
+    "  popq %r12\n"
+    "  popq %rbx\n"
+    "  popq %rbp\n"
+    "  ret\n"
+    ".size nj_fiber_switch_context, .-nj_fiber_switch_context\n"
+    ".globl nj_fiber_trampoline\n"
+    ".type nj_fiber_trampoline, @function\n"
+    "nj_fiber_trampoline:\n"
+    "  movq %r13, %rdi\n"
+    "  callq *%r12\n"
+    "  ud2\n"
+    ".size nj_fiber_trampoline, .-nj_fiber_trampoline\n");
+
+static void fiber_init_context(nj_fiber_t* fiber) {
+  // The trampoline starts with a 16-byte aligned stack pointer so its call
+  // leaves fiber_entry with the usual alignment.
+  nju64* top = (nju64*)(((njup)fiber->stack + fiber->stack_size) & ~(njup)15);
+  nju64* sp = top - 8;
+  // Default MXCSR and x87 control word.
+  sp[0] = 0x1f80 | ((nju64)0x037f << 32);
+  sp[1] = 0;                               // r15
+  sp[2] = 0;                               // r14
+  sp[3] = (nju64)fiber;                    // r13
+  sp[4] = (nju64)fiber_entry;              // r12
+  sp[5] = 0;                               // rbx
+  sp[6] = 0;                               // rbp
+  sp[7] = (nju64)nj_fiber_trampoline;      // Return address.
+  fiber->sp = sp;
+}
+
+void nj_fiber_switch(nj_fiber_t* from, nj_fiber_t* to) {
+  nj_fiber_switch_context(&from->sp, to->sp);
+}
+#else
+static void fiber_ucontext_entry(int lo, int hi) {
+  fiber_entry((nj_fiber_t*)(((njup)(nju32)hi << 32) | (nju32)lo));
+}
+
+static void fiber_init_context(nj_fiber_t* fiber) {
+  getcontext(&fiber->context);
+  fiber->context.uc_stack.ss_sp = fiber->stack;
+  fiber->context.uc_stack.ss_size = fiber->stack_size;
+  fiber->context.uc_link = NULL;
+  njup p = (njup)fiber;
+  makecontext(&fiber->context, (void (*)())fiber_ucontext_entry, 2, (int)(nju32)p, (int)(nju32)(p >> 32));
+}
+
+void nj_fiber_switch(nj_fiber_t* from, nj_fiber_t* to) {
+  swapcontext(&from->context, &to->context);
+}
+#endif
+
+bool nj_fiber_init_from_thread(nj_fiber_t* fiber) {
+  *fiber = {};
+  return true;
+}
+
+void nj_fiber_destroy_from_thread(nj_fiber_t*) {}
+
+bool nj_fiber_init(nj_fiber_t* fiber, njsp stack_size, nj_fiber_func_t func, void* args) {
+  *fiber = {};
+  njsp page_size = sysconf(_SC_PAGESIZE);
+  stack_size = (stack_size + page_size - 1) & ~(page_size - 1);
+  // One more page at the bottom as the guard page.
+  nju8* p = (nju8*)mmap(NULL, stack_size + page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  NJ_CHECK_LOG_RETURN_VAL(p != MAP_FAILED, false, "Can't allocate a fiber stack");
+  mprotect(p, page_size, PROT_NONE);
+  fiber->stack = p + page_size;
+  fiber->stack_size = stack_size;
+  fiber->func = func;
+  fiber->args = args;
+  fiber_init_context(fiber);
+  return true;
+}
+
+void nj_fiber_destroy(nj_fiber_t* fiber) {
+  njsp page_size = sysconf(_SC_PAGESIZE);
+  munmap((nju8*)fiber->stack - page_size, fiber->stack_size + page_size);
+  fiber->stack = NULL;
+}
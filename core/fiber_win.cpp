@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/fiber.h"
+
+#include "core/log.h"
+
+#include <Windows.h>
+#include <stdlib.h>
+
+static void WINAPI platform_fiber_start(void* args) {
+  nj_fiber_t* fiber = (nj_fiber_t*)args;
+  fiber->func(fiber->args);
+  NJ_LOGF("A fiber function returned");
+  abort();
+}
+
+bool nj_fiber_init_from_thread(nj_fiber_t* fiber) {
+  *fiber = {};
+  fiber->handle = ConvertThreadToFiber(NULL);
+  if (!fiber->handle && GetLastError() == ERROR_ALREADY_FIBER)
+    fiber->handle = GetCurrentFiber();
+  NJ_CHECK_LOG_RETURN_VAL(fiber->handle, false, "Can't convert the thread to a fiber");
+  return true;
+}
+
+void nj_fiber_destroy_from_thread(nj_fiber_t* fiber) {
+  ConvertFiberToThread();
+  fiber->handle = NULL;
+}
+
+bool nj_fiber_init(nj_fiber_t* fiber, njsp stack_size, nj_fiber_func_t func, void* args) {
+  *fiber = {};
+  fiber->stack_size = stack_size;
+  fiber->func = func;
+  fiber->args = args;
+  fiber->handle = CreateFiber(stack_size, platform_fiber_start, fiber);
+  NJ_CHECK_LOG_RETURN_VAL(fiber->handle, false, "Can't create a fiber");
+  return true;
+}
+
+void nj_fiber_destroy(nj_fiber_t* fiber) {
+  DeleteFiber(fiber->handle);
+  fiber->handle = NULL;
+}
+
+void nj_fiber_switch(nj_fiber_t* from, nj_fiber_t* to) {
+  SwitchToFiber(to->handle);
+}
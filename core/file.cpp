@@ -10,189 +10,200 @@
 #include "core/allocator.h"
 #include "core/core_allocators.h"
 #include "core/log.h"
+#include "core/queue.inl"
 #include "core/utils.h"
 
 #include <string.h>
 
-static const int gc_max_buffer = 16;
-static const int gc_max_buffer_size = 8 * 1024;
+// Free buffers are kept in one lock-free queue per power of 2 size so any
+// thread can open and close files without locking. A buffer that doesn't fit
+// in its queue, or bigger than the biggest class, goes back to the OS.
+static const int gc_min_buffer_size_log2 = 12;
+static const int gc_max_buffer_size_log2 = 20;
+static const int gc_buffer_class_count = gc_max_buffer_size_log2 - gc_min_buffer_size_log2 + 1;
+static const int gc_max_free_buffers = 16;
+
+static nj_mpmc_queue_t<nju8*> g_free_buffers[gc_buffer_class_count];
+static bool g_file_inited = false;
+
+static njsp file_round_buffer_size(njsp size) {
+  if (size <= (1 << gc_min_buffer_size_log2))
+    return 1 << gc_min_buffer_size_log2;
+  return (njsp)1 << (64 - nj_clz64(size - 1));
+}
 
-static file_buffer g_buffers[gc_max_buffer];
+// -1 if buffers of |size| aren't pooled.
+static int file_get_buffer_class(njsp size) {
+  if (!g_file_inited || size > (1 << gc_max_buffer_size_log2))
+    return -1;
+  return 63 - nj_clz64(size) - gc_min_buffer_size_log2;
+}
 
+static nju8* file_acquire_buffer(njsp size) {
+  int buffer_class = file_get_buffer_class(size);
+  nju8* buffer;
+  if (buffer_class != -1 && nj_mpmc_pop(&g_free_buffers[buffer_class], &buffer))
+    return buffer;
+  return nj_file_alloc_buffer_plat(size);
+}
 
-bool nj_file_init() {
-  for (int i = 0; i < gc_max_buffer; ++i) {
-    g_buffers[i].buffer = (nju8*)g_persistent_allocator->alloc(gc_max_buffer_size);
-    g_buffers[i].is_in_used = false;
-    if (!g_buffers[i].buffer)
-      return false;
-  }
+static void file_release_buffer(nju8* buffer, njsp size) {
+  int buffer_class = file_get_buffer_class(size);
+  if (buffer_class != -1 && nj_mpmc_push(&g_free_buffers[buffer_class], buffer))
+    return;
+  nj_file_free_buffer_plat(buffer, size);
+}
 
-  return true;
+// Move the OS file position back to the logical position by dropping what
+// was read ahead.
+static void file_drop_read_ahead(nj_file_t* file) {
+  njsp bytes_left = file->buffer_len - file->buffer_offset;
+  if (bytes_left)
+    nj_file_seek_plat(file, NJ_FILE_FROM_CURRENT, -bytes_left);
+  file->buffer_len = 0;
+  file->buffer_offset = 0;
 }
 
-bool nj_file_open(nj_file_t* file, const nj_os_char* path, enum nj_file_mode mode) {
-  bool rv = nj_file_open_plat(file, path, mode);
-  if (!rv)
-    return false;
-  for (int i = 0; i < gc_max_buffer; ++i) {
-    if (!g_buffers[i].is_in_used) {
-      g_buffers[i].len = 0;
-      g_buffers[i].offset = 0;
-      g_buffers[i].is_in_used = true;
-      g_buffers[i].is_writing = false;
-      file->internal_buffer = &g_buffers[i];
-      break;
-    }
-  }
-  NJ_CHECK_LOG_RETURN_VAL(file->internal_buffer, false, "Can't get a file buffer, too many files are being opened");
+bool nj_file_init() {
+  for (int i = 0; i < gc_buffer_class_count; ++i)
+    NJ_CHECK_RETURN_VAL(nj_mpmc_init(&g_free_buffers[i], g_persistent_allocator, gc_max_free_buffers), false);
+  g_file_inited = true;
   return true;
 }
 
+bool nj_file_open(nj_file_t* file, const nj_os_char* path, enum nj_file_mode mode, njsp buffer_size) {
+  file->buffer = NULL;
+  if (mode & NJ_FILE_MODE_DIRECT)
+    buffer_size = NJ_FILE_UNBUFFERED;
+  file->buffer_size = buffer_size > 0 ? file_round_buffer_size(buffer_size) : NJ_FILE_UNBUFFERED;
+  file->buffer_len = 0;
+  file->buffer_offset = 0;
+  file->is_writing = false;
+  return nj_file_open_plat(file, path, mode);
+}
+
 void nj_file_close(nj_file_t* file) {
   nj_file_flush(file);
   nj_file_close_plat(file);
-  if (file->internal_buffer) {
-    for (int i = 0; i < gc_max_buffer; ++i) {
-      if (file->internal_buffer == &g_buffers[i]) {
-        g_buffers[i].is_in_used = false;
-        file->internal_buffer = NULL;
-        break;
-      }
-    }
+  if (file->buffer) {
+    file_release_buffer(file->buffer, file->buffer_size);
+    file->buffer = NULL;
   }
-  NJ_CHECK_RETURN(!file->internal_buffer);
 }
 
 bool nj_file_read(nj_file_t* file, void* out, njsp size, njsp* bytes_read) {
-  NJ_CHECK_RETURN_VAL(size, false)
-  file_buffer* fbuf = file->internal_buffer;
-  NJ_CHECK_RETURN_VAL(fbuf, false)
-
-  njsp bytes_left = fbuf->len - fbuf->offset;
-  njsp total_bytes_read = 0;
-  if (!fbuf->is_writing) {
-    if (bytes_left >= size) {
-      memcpy(out, fbuf->buffer + fbuf->offset, size);
-      fbuf->offset += size;
-      nj_maybe_assign(bytes_read, size);
-      return true;
-    } else if (bytes_left) {
-      // Copy the rest of the file buffer.
-      memcpy(out, fbuf->buffer + fbuf->offset, bytes_left);
-      fbuf->offset = fbuf->len;
-      size -= bytes_left;
-      out = (nju8*)out + bytes_left;
-      total_bytes_read = bytes_left;
-    }
+  NJ_CHECK_RETURN_VAL(size, false);
+  if (file->is_writing) {
+    nj_file_flush(file);
+    file->is_writing = false;
+  }
+  if (!file->buffer && file->buffer_size) {
+    file->buffer = file_acquire_buffer(file->buffer_size);
+    // Keep going unbuffered.
+    if (!file->buffer)
+      file->buffer_size = NJ_FILE_UNBUFFERED;
   }
-  // Update the file buffer.
-  njsp bytes_read_plat;
-  if (size >= gc_max_buffer_size) {
-    // Too big for a file buffer, just read straight into the out buffer.
+  if (!file->buffer)
+    return nj_file_read_plat(file, out, size, bytes_read);
+
+  njsp total_bytes_read = nj_min(file->buffer_len - file->buffer_offset, size);
+  memcpy(out, file->buffer + file->buffer_offset, total_bytes_read);
+  file->buffer_offset += total_bytes_read;
+  size -= total_bytes_read;
+  out = (nju8*)out + total_bytes_read;
+  if (size >= file->buffer_size) {
+    // Too big for the file buffer, read straight into |out|. The buffer was
+    // consumed and must not be seeked into anymore.
+    file->buffer_len = 0;
+    file->buffer_offset = 0;
+    njsp bytes_read_plat = 0;
     nj_file_read_plat(file, out, size, &bytes_read_plat);
     total_bytes_read += bytes_read_plat;
-    nj_maybe_assign(bytes_read, total_bytes_read);
-    return total_bytes_read != 0;
+  } else if (size) {
+    njsp bytes_read_plat = 0;
+    nj_file_read_plat(file, file->buffer, file->buffer_size, &bytes_read_plat);
+    njsp copy_len = nj_min(bytes_read_plat, size);
+    memcpy(out, file->buffer, copy_len);
+    file->buffer_len = bytes_read_plat;
+    file->buffer_offset = copy_len;
+    total_bytes_read += copy_len;
   }
-  if (!nj_file_read_plat(file, fbuf->buffer, gc_max_buffer_size, &bytes_read_plat)) {
-    nj_maybe_assign(bytes_read, total_bytes_read);
-    return total_bytes_read != 0;
-  }
-  fbuf->len = bytes_read_plat;
-  fbuf->is_writing = false;
-  njsp copy_len = nj_min(bytes_read_plat, size);
-  memcpy(out, fbuf->buffer, copy_len);
-  fbuf->offset = copy_len;
-  total_bytes_read += copy_len;
   nj_maybe_assign(bytes_read, total_bytes_read);
-  return true;
+  return total_bytes_read != 0;
 }
 
 bool nj_file_write(nj_file_t* file, const void* in, njsp size, njsp* bytes_written) {
   NJ_CHECK_RETURN_VAL(size, false);
-  file_buffer* fbuf = file->internal_buffer;
-  NJ_CHECK_RETURN_VAL(fbuf, false);
-
-  njsp bytes_left = fbuf->len - fbuf->offset;
-  njsp total_bytes_written = 0;
-  if (fbuf->is_writing) {
-    if (bytes_left >= size) {
-      memcpy(fbuf->buffer + fbuf->offset, in, size);
-      fbuf->offset += size;
-      nj_maybe_assign(bytes_written, size);
-      return true;
-    } else if (bytes_left) {
-      // Copy to the rest of the file buffer.
-      memcpy(fbuf->buffer + fbuf->offset, in, bytes_left);
-      fbuf->offset = fbuf->len;
-      size -= bytes_left;
-      in = (nju8*)in + bytes_left;
-      njsp bytes_written_plat;
-      if (!nj_file_write_plat(file, fbuf->buffer, fbuf->offset, &bytes_written_plat))
-        return false;
-      total_bytes_written = bytes_left;
+  if (!file->is_writing) {
+    file_drop_read_ahead(file);
+    file->is_writing = true;
+  }
+  if (!file->buffer && file->buffer_size) {
+    file->buffer = file_acquire_buffer(file->buffer_size);
+    if (!file->buffer)
+      file->buffer_size = NJ_FILE_UNBUFFERED;
+  }
+  if (!file->buffer)
+    return nj_file_write_plat(file, in, size, bytes_written);
+
+  if (file->buffer_offset + size <= file->buffer_size) {
+    memcpy(file->buffer + file->buffer_offset, in, size);
+    file->buffer_offset += size;
+    nj_maybe_assign(bytes_written, size);
+    return true;
+  }
+  if (file->buffer_offset) {
+    bool rv = nj_file_write_plat(file, file->buffer, file->buffer_offset, NULL);
+    file->buffer_offset = 0;
+    if (!rv) {
+      nj_maybe_assign(bytes_written, (njsp)0);
+      return false;
     }
   }
-  // Update the file buffer.
-  if (size >= gc_max_buffer_size) {
-    // Too big for a file buffer, just read straight into the out buffer.
-    njsp bytes_written_plat;
-    bool rv = nj_file_write_plat(file, in, size, &bytes_written_plat);
-    total_bytes_written += bytes_written_plat;
-    nj_maybe_assign(bytes_written, total_bytes_written);
-    return rv;
+  if (size >= file->buffer_size) {
+    // Too big for the file buffer, write straight from |in|.
+    return nj_file_write_plat(file, in, size, bytes_written);
   }
-  fbuf->len = gc_max_buffer_size;
-  fbuf->is_writing = true;
-  memcpy(fbuf->buffer, in, size);
-  fbuf->offset = size;
-  nj_maybe_assign(bytes_written, total_bytes_written);
+  memcpy(file->buffer, in, size);
+  file->buffer_offset = size;
+  nj_maybe_assign(bytes_written, size);
   return true;
 }
 
-void nj_file_seek(nj_file_t* file, enum nj_file_from from, njsp distance) {
-  file_buffer* fbuf = file->internal_buffer;
-  if (!fbuf) {
-    nj_file_seek_plat(file, from, distance);
-    return;
+bool nj_file_readv(nj_file_t* file, const nj_file_iovec_t* vecs, int count, njsp* bytes_read) {
+  if (file->is_writing) {
+    nj_file_flush(file);
+    file->is_writing = false;
   }
+  file_drop_read_ahead(file);
+  return nj_file_readv_plat(file, vecs, count, bytes_read);
+}
 
-  if (from != NJ_FILE_FROM_CURRENT) {
-    if (fbuf->is_writing)
-      nj_file_flush(file);
-    nj_file_seek_plat(file, from, distance);
-    return;
-  }
-  // from == NJ_FILE_FROM_CURRENT
-  njsp bytes_left = fbuf->len - fbuf->offset;
-  if (distance >= bytes_left) {
-    if (fbuf->is_writing) {
-      nj_file_flush(file);
-      // We are seeking from fbuf->offset after flushing.
-      nj_file_seek_plat(file, from, distance);
-    } else {
-      // We are seeking from the end of the file_buffer.
-      nj_file_seek_plat(file, from, distance - bytes_left);
-    }
-    return;
-  }
+bool nj_file_writev(nj_file_t* file, const nj_file_iovec_t* vecs, int count, njsp* bytes_written) {
+  if (file->is_writing)
+    nj_file_flush(file);
+  else
+    file_drop_read_ahead(file);
+  return nj_file_writev_plat(file, vecs, count, bytes_written);
+}
 
-  // Seeking inside the file buffer.
-  if (fbuf->is_writing) {
-    memset(fbuf->buffer, 0, distance);
+void nj_file_seek(nj_file_t* file, enum nj_file_from from, njsp distance) {
+  if (file->is_writing) {
+    nj_file_flush(file);
+  } else if (from == NJ_FILE_FROM_CURRENT && file->buffer_offset + distance >= 0 && file->buffer_offset + distance <= file->buffer_len) {
+    // Seeking inside what was read ahead.
+    file->buffer_offset += distance;
+    return;
+  } else {
+    file_drop_read_ahead(file);
   }
-  fbuf->offset += distance;
+  nj_file_seek_plat(file, from, distance);
 }
 
 void nj_file_flush(nj_file_t* file) {
-  file_buffer* fbuf = file->internal_buffer;
-  if (fbuf) {
-    if (fbuf->is_writing && fbuf->offset > 0) {
-      NJ_CHECK_RETURN(nj_file_write_plat(file, fbuf->buffer, fbuf->offset, NULL));
-      fbuf->is_writing = false;
-      fbuf->offset = 0;
-      fbuf->len = 0;
-    }
+  if (file->is_writing && file->buffer_offset > 0) {
+    njsp size = file->buffer_offset;
+    file->buffer_offset = 0;
+    NJ_CHECK_RETURN(nj_file_write_plat(file, file->buffer, size, NULL));
   }
 }
@@ -17,12 +17,42 @@
 
 #define NJ_FILE_INVALID_POS (-1)
 #define NJ_FILE_INVALID_SIZE (-1)
+// Buffer size of nj_file_open().
+#define NJ_FILE_DEFAULT_BUFFER_SIZE (64 * 1024)
+// Pass as the buffer size to read and write straight from/to the OS.
+#define NJ_FILE_UNBUFFERED (0)
+// Offsets, sizes and addresses of reads in NJ_FILE_MODE_DIRECT.
+#define NJ_FILE_DIRECT_ALIGNMENT (4096)
 
 enum nj_file_mode {
   // open file if it exists, otherwise, create a new file.
   NJ_FILE_MODE_READ = 1 << 0,
   NJ_FILE_MODE_WRITE = 1 << 1,
   NJ_FILE_MODE_APPEND = 1 << 2,
+  // Read around the OS cache, straight from the device into the buffer, for
+  // big files that are read once. The file is unbuffered and reads must be
+  // aligned to NJ_FILE_DIRECT_ALIGNMENT, see nj_file_pread() and
+  // nj_aio_stream().
+  NJ_FILE_MODE_DIRECT = 1 << 3,
+  // Access pattern hints for the OS cache. The OS reads ahead more for
+  // sequential files and less for random ones.
+  NJ_FILE_MODE_SEQUENTIAL = 1 << 4,
+  NJ_FILE_MODE_RANDOM = 1 << 5,
+};
+
+inline nj_file_mode operator|(nj_file_mode a, nj_file_mode b) {
+  return (nj_file_mode)((int)a | (int)b);
+}
+
+enum nj_file_map_hint {
+  NJ_FILE_MAP_HINT_NONE = 0,
+  // The mapping is read from start to end, the OS reads ahead more.
+  NJ_FILE_MAP_HINT_SEQUENTIAL = 1 << 0,
+  NJ_FILE_MAP_HINT_RANDOM = 1 << 1,
+  // Start reading the whole file in the background.
+  NJ_FILE_MAP_HINT_WILLNEED = 1 << 2,
+  // Read the whole file before nj_file_map() returns.
+  NJ_FILE_MAP_HINT_POPULATE = 1 << 3,
 };
 
 enum nj_file_from {
@@ -31,7 +61,11 @@ enum nj_file_from {
   NJ_FILE_FROM_END
 };
 
-struct file_buffer;
+// A part of the data of nj_file_readv()/nj_file_writev().
+struct nj_file_iovec_t {
+  void* data;
+  njsp size;
+};
 
 struct nj_file_t {
 #if NJ_OS_WIN()
@@ -42,12 +76,37 @@ struct nj_file_t {
 #error "?"
 #endif
   const nj_os_char* path;
-  file_buffer* internal_buffer = NULL;
+  // The buffer is taken from a pool on the first read/write and given back
+  // when the file is closed. In read mode it holds |buffer_len| bytes read
+  // ahead, |buffer_offset| of them were consumed. In write mode it holds
+  // |buffer_offset| bytes that weren't written yet.
+  nju8* buffer = NULL;
+  njsp buffer_size = 0;
+  njsp buffer_len = 0;
+  njsp buffer_offset = 0;
+  bool is_writing = false;
+};
+
+// A read-only view of a whole file. |data| is followed by a zero byte so text
+// can be parsed in place.
+struct nj_file_map_t {
+  const nju8* data;
+  njsp size;
+#if NJ_OS_WIN()
+  // NULL if the file was read into memory instead, which happens when it ends
+  // on a page boundary and there is no room for the zero byte.
+  HANDLE mapping;
+#elif NJ_OS_LINUX()
+  njsp map_size;
+#endif
 };
 
 bool nj_file_init();
 
-bool nj_file_open(nj_file_t* file, const nj_os_char* path, enum nj_file_mode mode);
+// |buffer_size| is rounded up to a power of 2, NJ_FILE_UNBUFFERED disables
+// buffering. Files can be opened, used and closed from any thread, a file
+// can't be used by several threads at the same time.
+bool nj_file_open(nj_file_t* file, const nj_os_char* path, enum nj_file_mode mode, njsp buffer_size = NJ_FILE_DEFAULT_BUFFER_SIZE);
 void nj_file_close(nj_file_t* file);
 
 void nj_file_delete(nj_file_t* file);
@@ -56,6 +115,17 @@ void nj_file_delete_path(const nj_os_char* path);
 bool nj_file_read(nj_file_t* file, void* buffer, njsp size, njsp* bytes_read);
 bool nj_file_read_line(nj_file_t* file, char* buffer, njsp size);
 bool nj_file_write(nj_file_t* file, const void* buffer, njsp size, njsp* bytes_written);
+// Read/write |count| parts at the current position. The file buffer is
+// flushed first and the parts go straight to the OS in one syscall on Linux.
+// Parts are filled in order, nj_file_readv() stops when the file ends.
+bool nj_file_readv(nj_file_t* file, const nj_file_iovec_t* vecs, int count, njsp* bytes_read);
+bool nj_file_writev(nj_file_t* file, const nj_file_iovec_t* vecs, int count, njsp* bytes_written);
+// Read/write at |offset| without using the file buffer or the current
+// position (it may still move on Windows), so threads can share a file.
+// nj_file_pread() reads until |size| bytes are read or the file ends, it
+// returns false only on error.
+bool nj_file_pread(const nj_file_t* file, void* buffer, njsp size, njsp offset, njsp* bytes_read);
+bool nj_file_pwrite(const nj_file_t* file, const void* buffer, njsp size, njsp offset, njsp* bytes_written);
 void nj_file_seek(nj_file_t* file, enum nj_file_from from, njsp distance);
 void nj_file_flush(nj_file_t* file);
 
@@ -63,4 +133,9 @@ bool nj_file_is_valid(const nj_file_t* file);
 
 njsp nj_file_get_size(const nj_file_t* file);
 
+// Map the whole file at |path| without copying it. |hints| is a combination of
+// nj_file_map_hint.
+bool nj_file_map(nj_file_map_t* map, const nj_os_char* path, int hints = NJ_FILE_MAP_HINT_SEQUENTIAL);
+void nj_file_unmap(nj_file_map_t* map);
+
 #endif // NJ_CORE_FILE_H
@@ -5,16 +5,26 @@
 //----------------------------------------------------------------------------//
 
 #include "core/file.h"
+#include "core/file_internal.h"
 
 #include "core/log.h"
+#include "core/utils.h"
 
 #include <errno.h>
 #include <fcntl.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
-bool nj_file_open(nj_file_t* file, const char* path, enum nj_file_mode mode) {
+// Vectors passed to one readv()/writev() call.
+#define NJ_FILE_MAX_IOVECS (64)
+
+// Empty files are "mapped" to this.
+static const nju8 gc_empty_map_data[1] = {};
+
+bool nj_file_open_plat(nj_file_t* file, const char* path, enum nj_file_mode mode) {
   NJ_CHECK_RETURN_VAL(file, false);
   NJ_CHECK_RETURN_VAL(path, false);
 
@@ -25,17 +35,24 @@ bool nj_file_open(nj_file_t* file, const char* path, enum nj_file_mode mode) {
   if (mode & NJ_FILE_MODE_WRITE)
     flags |= O_RDWR | O_CREAT | O_TRUNC;
   if (mode & NJ_FILE_MODE_APPEND)
-    flags |= O_APPEND | O_RDWR;
+    flags |= O_APPEND | O_RDWR | O_CREAT;
+  if (mode & NJ_FILE_MODE_DIRECT)
+    flags |= O_DIRECT;
   int modes = S_IRWXU;
-  file->handle = open(file->path, flags, modes);
-  return nj_file_is_valid(file);
+  file->handle = open(file->path, flags | O_CLOEXEC, modes);
+  NJ_CHECK_LOG_RETURN_VAL(nj_file_is_valid(file), false, "Can't open file %s", path);
+  // Sequential doubles the read ahead window, random disables it.
+  if (mode & NJ_FILE_MODE_SEQUENTIAL)
+    posix_fadvise(file->handle, 0, 0, POSIX_FADV_SEQUENTIAL);
+  if (mode & NJ_FILE_MODE_RANDOM)
+    posix_fadvise(file->handle, 0, 0, POSIX_FADV_RANDOM);
+  return true;
 }
 
-void nj_file_close(nj_file_t* file) {
+void nj_file_close_plat(nj_file_t* file) {
   NJ_CHECK_RETURN(nj_file_is_valid(file));
-  if (!close(file->handle)) {
-    file->handle = -1;
-  }
+  close(file->handle);
+  file->handle = -1;
 }
 
 void nj_file_delete(nj_file_t* file) {
@@ -48,20 +65,124 @@ void nj_file_delete_path(const char* path) {
   unlink(path);
 }
 
-bool nj_file_read(nj_file_t* file, void* buffer, njsp size, njsp* bytes_read) {
+bool nj_file_read_plat(nj_file_t* file, void* buffer, njsp size, njsp* bytes_read) {
   NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), false);
-  njsp rv = read(file->handle, buffer, size);
-  if (bytes_read)
-    *bytes_read = rv;
-  return rv;
+  njsp total = 0;
+  while (total < size) {
+    ssize_t rv = read(file->handle, (nju8*)buffer + total, size - total);
+    if (rv == -1 && errno == EINTR)
+      continue;
+    if (rv <= 0)
+      break;
+    total += rv;
+  }
+  nj_maybe_assign(bytes_read, total);
+  return total;
 }
 
-void nj_file_write(nj_file_t* file, const void* buffer, njsp size) {
-  NJ_CHECK_RETURN(nj_file_is_valid(file));
-  write(file->handle, buffer, size);
+bool nj_file_write_plat(nj_file_t* file, const void* buffer, njsp size, njsp* bytes_written) {
+  NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), false);
+  njsp total = 0;
+  while (total < size) {
+    ssize_t rv = write(file->handle, (const nju8*)buffer + total, size - total);
+    if (rv == -1 && errno == EINTR)
+      continue;
+    if (rv <= 0)
+      break;
+    total += rv;
+  }
+  nj_maybe_assign(bytes_written, total);
+  return total == size;
+}
+
+// Calls readv()/writev() until every vector is done, the file ends or it
+// fails. Returns the number of bytes transferred.
+static njsp file_transfer_vectors(int fd, const nj_file_iovec_t* vecs, int count, bool is_write) {
+  iovec iovs[NJ_FILE_MAX_IOVECS];
+  njsp total = 0;
+  int index = 0;
+  // Bytes of |vecs[index]| already transferred.
+  njsp index_offset = 0;
+  // A call with only empty parts returns 0 as if the file ended, the parts
+  // after a transfer are skipped below.
+  while (index < count && !vecs[index].size)
+    ++index;
+  while (index < count) {
+    int iov_count = nj_min(count - index, NJ_FILE_MAX_IOVECS);
+    for (int i = 0; i < iov_count; ++i) {
+      iovs[i].iov_base = vecs[index + i].data;
+      iovs[i].iov_len = vecs[index + i].size;
+    }
+    iovs[0].iov_base = (nju8*)iovs[0].iov_base + index_offset;
+    iovs[0].iov_len -= index_offset;
+    ssize_t rv = is_write ? writev(fd, iovs, iov_count) : readv(fd, iovs, iov_count);
+    if (rv == -1 && errno == EINTR)
+      continue;
+    if (rv <= 0)
+      break;
+    total += rv;
+    njsp left = rv;
+    while (index < count && left >= vecs[index].size - index_offset) {
+      left -= vecs[index].size - index_offset;
+      index_offset = 0;
+      ++index;
+    }
+    index_offset += left;
+  }
+  return total;
 }
 
-void nj_file_seek(nj_file_t* file, enum nj_file_from from, njsp distance) {
+bool nj_file_readv_plat(nj_file_t* file, const nj_file_iovec_t* vecs, int count, njsp* bytes_read) {
+  NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), false);
+  njsp total = file_transfer_vectors(file->handle, vecs, count, false);
+  nj_maybe_assign(bytes_read, total);
+  return total;
+}
+
+bool nj_file_writev_plat(nj_file_t* file, const nj_file_iovec_t* vecs, int count, njsp* bytes_written) {
+  NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), false);
+  njsp size = 0;
+  for (int i = 0; i < count; ++i)
+    size += vecs[i].size;
+  njsp total = file_transfer_vectors(file->handle, vecs, count, true);
+  nj_maybe_assign(bytes_written, total);
+  return total == size;
+}
+
+bool nj_file_pread(const nj_file_t* file, void* buffer, njsp size, njsp offset, njsp* bytes_read) {
+  NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), false);
+  njsp total = 0;
+  bool is_ok = true;
+  while (total < size) {
+    ssize_t rv = pread(file->handle, (nju8*)buffer + total, size - total, offset + total);
+    if (rv == -1 && errno == EINTR)
+      continue;
+    if (rv <= 0) {
+      is_ok = rv == 0;
+      break;
+    }
+    total += rv;
+  }
+  nj_maybe_assign(bytes_read, total);
+  return is_ok;
+}
+
+bool nj_file_pwrite(const nj_file_t* file, const void* buffer, njsp size, njsp offset, njsp* bytes_written) {
+  NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), false);
+  njsp total = 0;
+  while (total < size) {
+    ssize_t rv = pwrite(file->handle, (const nju8*)buffer + total, size - total, offset + total);
+    if (rv == -1 && errno == EINTR)
+      continue;
+    if (rv <= 0)
+      break;
+    total += rv;
+  }
+  nj_maybe_assign(bytes_written, total);
+  return total == size;
+}
+
+void nj_file_seek_plat(nj_file_t* file, enum nj_file_from from, njsp distance) {
   NJ_CHECK_RETURN(nj_file_is_valid(file));
   int whence;
   switch (from) {
@@ -78,6 +199,15 @@ void nj_file_seek(nj_file_t* file, enum nj_file_from from, njsp distance) {
   lseek(file->handle, distance, whence);
 }
 
+nju8* nj_file_alloc_buffer_plat(njsp size) {
+  void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return p != MAP_FAILED ? (nju8*)p : NULL;
+}
+
+void nj_file_free_buffer_plat(nju8* buffer, njsp size) {
+  munmap(buffer, size);
+}
+
 njsp nj_file_get_pos(const nj_file_t* file) {
   NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), NJ_FILE_INVALID_POS);
   return lseek(file->handle, 0, SEEK_CUR);
@@ -91,6 +221,65 @@ bool nj_file_is_valid(const nj_file_t* file) {
 njsp nj_file_get_size(const nj_file_t* file) {
   NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), NJ_FILE_INVALID_SIZE);
   struct stat st;
-  stat(file->path, &st);
+  NJ_CHECK_RETURN_VAL(fstat(file->handle, &st) == 0, NJ_FILE_INVALID_SIZE);
   return st.st_size;
 }
+
+bool nj_file_map(nj_file_map_t* map, const char* path, int hints) {
+  map->data = NULL;
+  map->size = 0;
+  map->map_size = 0;
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  NJ_CHECK_LOG_RETURN_VAL(fd != -1, false, "Can't open file %s", path);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    NJ_LOGW("Can't get the size of %s", path);
+    return false;
+  }
+  if (!st.st_size) {
+    close(fd);
+    map->data = gc_empty_map_data;
+    return true;
+  }
+  // Reserve one more byte than the file, rounded up to pages, as zero pages
+  // then map the file over them. Past the end of the file, the last page of a
+  // file mapping is zero-filled and the reserved page provides the zero if
+  // the file ends on a page boundary.
+  njsp page_size = sysconf(_SC_PAGESIZE);
+  njsp map_size = (st.st_size + page_size) / page_size * page_size;
+  void* base = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    NJ_LOGW("Can't reserve %zd bytes to map %s", map_size, path);
+    return false;
+  }
+  int flags = MAP_PRIVATE | MAP_FIXED;
+  if (hints & NJ_FILE_MAP_HINT_POPULATE)
+    flags |= MAP_POPULATE;
+  void* p = mmap(base, st.st_size, PROT_READ, flags, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    munmap(base, map_size);
+    NJ_LOGW("Can't map %s", path);
+    return false;
+  }
+  if (hints & NJ_FILE_MAP_HINT_SEQUENTIAL)
+    madvise(base, st.st_size, MADV_SEQUENTIAL);
+  if (hints & NJ_FILE_MAP_HINT_RANDOM)
+    madvise(base, st.st_size, MADV_RANDOM);
+  if (hints & NJ_FILE_MAP_HINT_WILLNEED)
+    madvise(base, st.st_size, MADV_WILLNEED);
+  map->data = (const nju8*)base;
+  map->size = st.st_size;
+  map->map_size = map_size;
+  return true;
+}
+
+void nj_file_unmap(nj_file_map_t* map) {
+  if (map->map_size)
+    munmap((void*)map->data, map->map_size);
+  map->data = NULL;
+  map->size = 0;
+  map->map_size = 0;
+}
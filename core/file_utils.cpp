@@ -18,9 +18,11 @@ nj_dynamic_array_t<nju8> nj_read_whole_file(nj_allocator_t* allocator, const nj_
   NJ_CHECK_RETURN_VAL(nj_file_is_valid(&f), buffer);
   njsp file_size = nj_file_get_size(&f);
   nj_da_init(&buffer, allocator);
-  nj_da_resize(&buffer, file_size);
+  // Keep a zero byte after the content for text parsers.
+  nj_da_resize(&buffer, file_size + 1);
   nj_file_read_plat(&f, &buffer[0], file_size, NULL);
   buffer[file_size] = 0;
+  nj_da_resize(&buffer, file_size);
   nj_file_close(&f);
   if (read_bytes)
     *read_bytes = file_size;
@@ -5,6 +5,7 @@
 //----------------------------------------------------------------------------//
 
 #include "core/file.h"
+#include "core/file_internal.h"
 
 #include "core/log.h"
 #include "core/utils.h"
@@ -34,8 +35,15 @@ bool nj_file_open_plat(nj_file_t* file, const wchar_t* path, enum nj_file_mode m
     create_disposition = CREATE_ALWAYS;
   if (mode & NJ_FILE_MODE_APPEND)
     create_disposition = OPEN_ALWAYS;
+  DWORD flags = 0;
+  if (mode & NJ_FILE_MODE_DIRECT)
+    flags |= FILE_FLAG_NO_BUFFERING;
+  if (mode & NJ_FILE_MODE_SEQUENTIAL)
+    flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+  if (mode & NJ_FILE_MODE_RANDOM)
+    flags |= FILE_FLAG_RANDOM_ACCESS;
   file->handle = CreateFile(
-      file->path, access, share_mode, NULL, create_disposition, 0, NULL);
+      file->path, access, share_mode, NULL, create_disposition, flags, NULL);
   NJ_CHECK_LOG_RETURN_VAL(nj_file_is_valid(file), false, "Can't open file %ls", path);
   return true;
 }
@@ -73,6 +81,74 @@ bool nj_file_write_plat(nj_file_t* file, const void* buffer, njsp size, njsp* by
   return rv;
 }
 
+// There is no scatter/gather for buffered handles, ReadFileScatter() and
+// WriteFileGather() need unbuffered handles and page sized parts.
+bool nj_file_readv_plat(nj_file_t* file, const nj_file_iovec_t* vecs, int count, njsp* bytes_read) {
+  njsp total = 0;
+  for (int i = 0; i < count; ++i) {
+    njsp read = 0;
+    nj_file_read_plat(file, vecs[i].data, vecs[i].size, &read);
+    total += read;
+    if (read != vecs[i].size)
+      break;
+  }
+  nj_maybe_assign(bytes_read, total);
+  return total;
+}
+
+bool nj_file_writev_plat(nj_file_t* file, const nj_file_iovec_t* vecs, int count, njsp* bytes_written) {
+  njsp total = 0;
+  bool rv = true;
+  for (int i = 0; i < count && rv; ++i) {
+    njsp written = 0;
+    rv = nj_file_write_plat(file, vecs[i].data, vecs[i].size, &written) && written == vecs[i].size;
+    total += written;
+  }
+  nj_maybe_assign(bytes_written, total);
+  return rv;
+}
+
+bool nj_file_pread(const nj_file_t* file, void* buffer, njsp size, njsp offset, njsp* bytes_read) {
+  NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), false);
+  njsp total = 0;
+  bool is_ok = true;
+  while (total < size) {
+    // The offset in OVERLAPPED makes ReadFile() positional on a synchronous
+    // handle, so threads can share it.
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = (DWORD)(offset + total);
+    overlapped.OffsetHigh = (DWORD)((offset + total) >> 32);
+    DWORD to_read = (DWORD)nj_min(size - total, (njsp)0x40000000);
+    DWORD read = 0;
+    if (!ReadFile(file->handle, (nju8*)buffer + total, to_read, &read, &overlapped)) {
+      is_ok = GetLastError() == ERROR_HANDLE_EOF;
+      break;
+    }
+    if (!read)
+      break;
+    total += read;
+  }
+  nj_maybe_assign(bytes_read, total);
+  return is_ok;
+}
+
+bool nj_file_pwrite(const nj_file_t* file, const void* buffer, njsp size, njsp offset, njsp* bytes_written) {
+  NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), false);
+  njsp total = 0;
+  while (total < size) {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = (DWORD)(offset + total);
+    overlapped.OffsetHigh = (DWORD)((offset + total) >> 32);
+    DWORD to_write = (DWORD)nj_min(size - total, (njsp)0x40000000);
+    DWORD written = 0;
+    if (!WriteFile(file->handle, (const nju8*)buffer + total, to_write, &written, &overlapped) || !written)
+      break;
+    total += written;
+  }
+  nj_maybe_assign(bytes_written, total);
+  return total == size;
+}
+
 void nj_file_seek_plat(nj_file_t* file, enum nj_file_from from, njsp distance) {
   NJ_CHECK_RETURN(nj_file_is_valid(file));
   DWORD move_method;
@@ -90,6 +166,14 @@ void nj_file_seek_plat(nj_file_t* file, enum nj_file_from from, njsp distance) {
   SetFilePointer(file->handle, distance, NULL, move_method);
 }
 
+nju8* nj_file_alloc_buffer_plat(njsp size) {
+  return (nju8*)VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void nj_file_free_buffer_plat(nju8* buffer, njsp size) {
+  VirtualFree(buffer, 0, MEM_RELEASE);
+}
+
 njsp nj_file_get_pos(const nj_file_t* file) {
   NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), NJ_FILE_INVALID_POS);
   return SetFilePointer(file->handle, 0, NULL, FILE_CURRENT);
@@ -104,3 +188,82 @@ njsp nj_file_get_size(const nj_file_t* file) {
   NJ_CHECK_RETURN_VAL(nj_file_is_valid(file), NJ_FILE_INVALID_SIZE);
   return GetFileSize(file->handle, NULL);
 }
+
+bool nj_file_map(nj_file_map_t* map, const wchar_t* path, int hints) {
+  static const nju8 empty_map_data[1] = {};
+  map->data = NULL;
+  map->size = 0;
+  map->mapping = NULL;
+  DWORD flags = FILE_ATTRIBUTE_NORMAL;
+  if (hints & NJ_FILE_MAP_HINT_SEQUENTIAL)
+    flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+  if (hints & NJ_FILE_MAP_HINT_RANDOM)
+    flags |= FILE_FLAG_RANDOM_ACCESS;
+  HANDLE handle = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+  NJ_CHECK_LOG_RETURN_VAL(handle != INVALID_HANDLE_VALUE, false, "Can't open file %ls", path);
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(handle, &size)) {
+    CloseHandle(handle);
+    NJ_LOGW("Can't get the size of %ls", path);
+    return false;
+  }
+  if (!size.QuadPart) {
+    CloseHandle(handle);
+    map->data = empty_map_data;
+    return true;
+  }
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  if (size.QuadPart % info.dwPageSize == 0) {
+    // The view would end exactly at the end of the file so there is no zero
+    // byte after it.
+    nju8* data = (nju8*)VirtualAlloc(NULL, size.QuadPart + 1, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    njsp total = 0;
+    while (data && total < size.QuadPart) {
+      DWORD read = 0;
+      DWORD to_read = (DWORD)nj_min(size.QuadPart - total, (njs64)0x40000000);
+      if (!ReadFile(handle, data + total, to_read, &read, NULL) || !read)
+        break;
+      total += read;
+    }
+    CloseHandle(handle);
+    if (total != size.QuadPart) {
+      if (data)
+        VirtualFree(data, 0, MEM_RELEASE);
+      NJ_LOGW("Can't read %ls", path);
+      return false;
+    }
+    map->data = data;
+    map->size = size.QuadPart;
+    return true;
+  }
+  HANDLE mapping = CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(handle);
+  NJ_CHECK_LOG_RETURN_VAL(mapping, false, "Can't create a file mapping for %ls", path);
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(mapping);
+    NJ_LOGW("Can't map %ls", path);
+    return false;
+  }
+  if (hints & (NJ_FILE_MAP_HINT_WILLNEED | NJ_FILE_MAP_HINT_POPULATE)) {
+    WIN32_MEMORY_RANGE_ENTRY range = {data, (SIZE_T)size.QuadPart};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+  }
+  map->data = (const nju8*)data;
+  map->size = size.QuadPart;
+  map->mapping = mapping;
+  return true;
+}
+
+void nj_file_unmap(nj_file_map_t* map) {
+  if (map->mapping) {
+    UnmapViewOfFile(map->data);
+    CloseHandle(map->mapping);
+  } else if (map->size) {
+    VirtualFree((void*)map->data, 0, MEM_RELEASE);
+  }
+  map->data = NULL;
+  map->size = 0;
+  map->mapping = NULL;
+}
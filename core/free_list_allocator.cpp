@@ -315,6 +315,6 @@ void nj_free_list_allocator_t::free(void* p) {
   m_used_size -= freed_size;
   freeblock_t* new_block = (freeblock_t*)header->start;
   new_block->size = freed_size;
-  new_block->size = NULL;
+  new_block->next = NULL;
   add_and_merge_free_block(this, new_block);
 }
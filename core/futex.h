@@ -0,0 +1,22 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_FUTEX_H
+#define NJ_CORE_FUTEX_H
+
+#include "core/njtype.h"
+
+#define NJ_FUTEX_INFINITE (-1)
+
+// Sleep while *|addr| == |expected|, at most |timeout_ns| nanoseconds
+// (NJ_FUTEX_INFINITE to wait forever). Returns false if the wait timed out,
+// the caller has to check *|addr| again anyway because wake ups can be
+// spurious.
+bool nj_futex_wait(nju32* addr, nju32 expected, njs64 timeout_ns);
+void nj_futex_wake_one(nju32* addr);
+void nj_futex_wake_all(nju32* addr);
+
+#endif // NJ_CORE_FUTEX_H
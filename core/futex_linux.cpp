@@ -0,0 +1,34 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/futex.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+bool nj_futex_wait(nju32* addr, nju32 expected, njs64 timeout_ns) {
+  struct timespec ts;
+  struct timespec* pts = NULL;
+  if (timeout_ns >= 0) {
+    ts.tv_sec = timeout_ns / 1000000000;
+    ts.tv_nsec = timeout_ns % 1000000000;
+    pts = &ts;
+  }
+  long rv = syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, pts, NULL, 0);
+  return !(rv == -1 && errno == ETIMEDOUT);
+}
+
+void nj_futex_wake_one(nju32* addr) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void nj_futex_wake_all(nju32* addr) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
@@ -0,0 +1,26 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/futex.h"
+
+#include <Windows.h>
+
+bool nj_futex_wait(nju32* addr, nju32 expected, njs64 timeout_ns) {
+  DWORD ms = INFINITE;
+  if (timeout_ns >= 0)
+    ms = (DWORD)((timeout_ns + 999999) / 1000000);
+  if (WaitOnAddress(addr, &expected, sizeof(expected), ms))
+    return true;
+  return GetLastError() != ERROR_TIMEOUT;
+}
+
+void nj_futex_wake_one(nju32* addr) {
+  WakeByAddressSingle(addr);
+}
+
+void nj_futex_wake_all(nju32* addr) {
+  WakeByAddressAll(addr);
+}
@@ -7,11 +7,18 @@
 #include "core/hash_table.h"
 
 #include "core/allocator.h"
-#include "core/linear_allocator.h"
+#include "core/dynamic_array.inl"
 #include "core/log.h"
+#include "core/utils.h"
 
 #include <string.h>
 
+static const nju8 gc_min_probe_count = 5;
+static const nju8 gc_max_probe_count = 32;
+// Clearing a slot is much cheaper than migrating one.
+static const njsp gc_clears_per_migration = 64;
+static const njf32 gc_incremental_load_ratio = 0.5f;
+
 static nju64 fnv1_hash(const void* p, njsz size) {
   nju64 hash = 0xcbf29ce484222325;
   for (njsz i = 0; i < size; ++i) {
@@ -21,107 +28,289 @@ static nju64 fnv1_hash(const void* p, njsz size) {
   return hash;
 }
 
-static void ht_rehash(nj_hash_table_t* ht) {
-  int key_size = ht->key_size;
-  size_t cap = ht->keys.length;
-  int new_cap = ht->resize_ratio * cap + 2;
-  nj_da_resize(&ht->keys, new_cap);
-  nj_da_resize(&ht->values, new_cap);
-  memset(&ht->keys[0] + cap, 0, (new_cap - cap) * sizeof(ht->keys[0]));
-  nj_linear_allocator_t<> tmp_allocator("ht_resize_tracking_allocator");
-  tmp_allocator.init();
-  // rehash_tracker: 0 means the index not been moved, 1 otherwise
-  nj_dynamic_array_t<char> rehash_tracker;
-  nj_da_init(&rehash_tracker, &tmp_allocator);
-  nj_da_resize(&rehash_tracker, new_cap);
-  memset(&rehash_tracker[0], 0, new_cap);
-  for (int i = 0; i < cap; ++i) {
-    if (ht->keys[i] != NJ_HT_INVALID_KEY)
-      rehash_tracker[i] = 1;
+static void ht_reset_array(nj_dynamic_array_t<njup>* da) {
+  nj_allocator_t* allocator = da->allocator;
+  nj_da_destroy(da);
+  *da = nj_dynamic_array_t<njup>();
+  nj_da_init(da, allocator);
+}
+
+// |keys| and |values| may still share buffers with another table, they are
+// reset without being freed.
+static void ht_alloc_table(nj_hash_table_t* ht, nj_dynamic_array_t<njup>* keys, nj_dynamic_array_t<njup>* values, njsp cap, bool clear) {
+  nj_allocator_t* allocator = ht->keys.allocator;
+  *keys = nj_dynamic_array_t<njup>();
+  *values = nj_dynamic_array_t<njup>();
+  nj_da_init(keys, allocator);
+  nj_da_init(values, allocator);
+  nj_da_resize(keys, cap);
+  nj_da_resize(values, cap);
+  if (clear)
+    memset(&(*keys)[0], 0, cap * sizeof((*keys)[0]));
+}
+
+// Put |key| and |value| in the first free slot of the probing range.
+static njsp ht_place(nj_hash_table_t* ht, njup key, njup value, nju64 hash) {
+  njsp cap = ht->keys.length;
+  njsp idx = hash % cap;
+  for (int i = 0; i < ht->probe_count; ++i) {
+    if (ht->keys[idx] == NJ_HT_INVALID_KEY) {
+      ht->keys[idx] = key;
+      ht->values[idx] = value;
+      return idx;
+    }
+    idx = (idx + 1) % cap;
   }
-  for(int i = 0; i < new_cap; ++i) {
-    if (ht->keys[i] != NJ_HT_INVALID_KEY) {
-      int new_index = fnv1_hash((void*)ht->keys[i], key_size) % new_cap;
-      while (rehash_tracker[new_index % new_cap])
-        ++new_index;
-      // No collision
-      if (new_index <= i) {
-        memcpy(&ht->keys[new_index], &ht->keys[i], sizeof(ht->keys[0]));
-        memcpy(&ht->values[new_index], &ht->values[i], sizeof(ht->values[0]));
-        rehash_tracker[new_index] = 1;
-        continue;
-      }
-      if (ht->keys[new_index] != NJ_HT_INVALID_KEY) {
-        memcpy(&ht->keys[new_index], &ht->keys[i], sizeof(ht->keys[0]));
-        memcpy(&ht->values[new_index], &ht->values[i], sizeof(ht->values[0]));
-        rehash_tracker[new_index] = 1;
-        // We need to check i again.
-        --i;
+  return NJ_HT_INVALID_INDEX;
+}
+
+static njsp ht_find(nj_dynamic_array_t<njup>* keys, njup key, int key_size, nju64 hash, int probe_count) {
+  njsp cap = keys->length;
+  if (!cap)
+    return NJ_HT_INVALID_INDEX;
+  njsp idx = hash % cap;
+  for (int i = 0; i < probe_count; ++i) {
+    if ((*keys)[idx] != NJ_HT_INVALID_KEY && !memcmp((void*)key, (void*)(*keys)[idx], key_size))
+      return idx;
+    idx = (idx + 1) % cap;
+  }
+  return NJ_HT_INVALID_INDEX;
+}
+
+// Linear probing fills up short runs before the load factor is reached.
+// Widening the probing range keeps every stored key reachable, so it's tried
+// before growing the table. A new table starts again from the narrowest range.
+static bool ht_widen_probe(nj_hash_table_t* ht) {
+  if (ht->probe_count >= gc_max_probe_count)
+    return false;
+  ht->probe_count *= 2;
+  if (ht->probe_count > gc_max_probe_count)
+    ht->probe_count = gc_max_probe_count;
+  return true;
+}
+
+// Move every key of |keys| and the unmigrated part of |old_keys| into a new
+// table, widening the probing range then growing the table until all keys fit.
+static void ht_rebuild(nj_hash_table_t* ht, njsp new_cap) {
+  nju8 probe_count = gc_min_probe_count;
+  for (;;) {
+    nj_hash_table_t tmp = *ht;
+    tmp.probe_count = probe_count;
+    ht_alloc_table(ht, &tmp.keys, &tmp.values, new_cap, true);
+    bool fit = true;
+    for (njsp i = 0; i < ht->keys.length && fit; ++i) {
+      if (ht->keys[i] != NJ_HT_INVALID_KEY)
+        fit = ht_place(&tmp, ht->keys[i], ht->values[i], fnv1_hash((void*)ht->keys[i], ht->key_size)) != NJ_HT_INVALID_INDEX;
+    }
+    for (njsp i = ht->migrate_index; i < ht->old_keys.length && fit; ++i) {
+      if (ht->old_keys[i] != NJ_HT_INVALID_KEY)
+        fit = ht_place(&tmp, ht->old_keys[i], ht->old_values[i], fnv1_hash((void*)ht->old_keys[i], ht->key_size)) != NJ_HT_INVALID_INDEX;
+    }
+    if (!fit) {
+      nj_da_destroy(&tmp.keys);
+      nj_da_destroy(&tmp.values);
+      if (ht_widen_probe(&tmp)) {
+        probe_count = tmp.probe_count;
+      } else {
+        probe_count = gc_min_probe_count;
+        new_cap = ht->resize_ratio * new_cap + 2;
       }
+      continue;
     }
+    nj_da_destroy(&ht->keys);
+    nj_da_destroy(&ht->values);
+    ht_reset_array(&ht->next_keys);
+    ht_reset_array(&ht->next_values);
+    ht_reset_array(&ht->old_keys);
+    ht_reset_array(&ht->old_values);
+    ht->keys = tmp.keys;
+    ht->values = tmp.values;
+    ht->probe_count = tmp.probe_count;
+    ht->clear_index = 0;
+    ht->migrate_index = 0;
+    return;
+  }
+}
+
+// Clear |count| slots of |next_keys|. Once all of them are cleared, the next
+// table takes over and the current one starts being migrated.
+static void ht_clear_next(nj_hash_table_t* ht, njsp count) {
+  njsp cap = ht->next_keys.length;
+  count = nj_min(count, cap - ht->clear_index);
+  if (count <= 0)
+    return;
+  memset(&ht->next_keys[ht->clear_index], 0, count * sizeof(ht->next_keys[0]));
+  ht->clear_index += count;
+  if (ht->clear_index < cap)
+    return;
+  ht->old_keys = ht->keys;
+  ht->old_values = ht->values;
+  ht->old_probe_count = ht->probe_count;
+  ht->keys = ht->next_keys;
+  ht->values = ht->next_values;
+  ht->probe_count = gc_min_probe_count;
+  ht->next_keys = nj_dynamic_array_t<njup>();
+  ht->next_values = nj_dynamic_array_t<njup>();
+  nj_da_init(&ht->next_keys, ht->keys.allocator);
+  nj_da_init(&ht->next_values, ht->values.allocator);
+  ht->clear_index = 0;
+  ht->migrate_index = 0;
+}
+
+// Move old slot |i| to the new table. Returns the new index of the key or
+// NJ_HT_INVALID_INDEX if the slot is empty.
+static njsp ht_migrate_slot(nj_hash_table_t* ht, njsp i) {
+  njup key = ht->old_keys[i];
+  if (key == NJ_HT_INVALID_KEY)
+    return NJ_HT_INVALID_INDEX;
+  nju64 hash = fnv1_hash((void*)key, ht->key_size);
+  njsp idx = ht_place(ht, key, ht->old_values[i], hash);
+  while (idx == NJ_HT_INVALID_INDEX && ht_widen_probe(ht))
+    idx = ht_place(ht, key, ht->old_values[i], hash);
+  if (idx != NJ_HT_INVALID_INDEX) {
+    ht->old_keys[i] = NJ_HT_INVALID_KEY;
+    return idx;
   }
-  tmp_allocator.destroy();
+  // The new table is too crowded around |hash|, finish the resize at once.
+  ht_rebuild(ht, ht->resize_ratio * ht->keys.length + 2);
+  return ht_find(&ht->keys, key, ht->key_size, hash, ht->probe_count);
+}
+
+static void ht_migrate(nj_hash_table_t* ht, njsp count) {
+  while (count-- > 0 && ht->migrate_index < ht->old_keys.length) {
+    ht_migrate_slot(ht, ht->migrate_index);
+    // ht_rebuild() resets |migrate_index| when it finishes the resize.
+    if (ht->old_keys.length)
+      ++ht->migrate_index;
+  }
+  if (ht->old_keys.length && ht->migrate_index >= ht->old_keys.length) {
+    ht_reset_array(&ht->old_keys);
+    ht_reset_array(&ht->old_values);
+    ht->migrate_index = 0;
+  }
+}
+
+// Do the incremental resize work of one operation.
+static void ht_step(nj_hash_table_t* ht) {
+  if (ht->next_keys.length)
+    ht_clear_next(ht, ht->migrate_step * gc_clears_per_migration);
+  else if (ht->old_keys.length)
+    ht_migrate(ht, ht->migrate_step);
+}
+
+static void ht_rehash(nj_hash_table_t* ht) {
+  njsp new_cap = ht->resize_ratio * ht->keys.length + 2;
+  if (!ht->migrate_step || nj_ht_is_resizing(ht) || !ht->key_count) {
+    ht_rebuild(ht, new_cap);
+    return;
+  }
+  ht_alloc_table(ht, &ht->next_keys, &ht->next_values, new_cap, false);
+  ht->clear_index = 0;
 }
 
 static njsp ht_get(nj_hash_table_t* ht, njup key, int key_size, nju64 hash) {
   NJ_CHECK_RETURN_VAL(key_size == ht->key_size, NJ_HT_INVALID_INDEX);
-  njsp len = ht->keys.length;
-  njsp idx = hash % len;
-  for (int i = 0; i < ht->probe_count; ++i, ++idx) {
-    if (ht->keys[idx] != NJ_HT_INVALID_KEY && !memcmp((void*)key, (void*)ht->keys[idx], key_size)) {
-      return idx;
-    }
+  ht_step(ht);
+  njsp idx = ht_find(&ht->keys, key, key_size, hash, ht->probe_count);
+  if (idx == NJ_HT_INVALID_INDEX && ht->old_keys.length) {
+    // Move the key now so the returned index is always into |values|.
+    njsp old_idx = ht_find(&ht->old_keys, key, key_size, hash, ht->old_probe_count);
+    if (old_idx != NJ_HT_INVALID_INDEX)
+      idx = ht_migrate_slot(ht, old_idx);
   }
-  return NJ_HT_INVALID_INDEX;
+  return idx;
 }
 
 static njsp ht_insert(nj_hash_table_t* ht, njup key, int key_size, nju64 hash) {
   NJ_CHECK_RETURN_VAL(key_size == ht->key_size, NJ_HT_INVALID_INDEX);
-  njsp cap = ht->keys.length;
-  if (ht->load_factor * cap < ht->key_count + 1) {
+  ht_step(ht);
+  // Long probing runs usually fill up before |load_factor| is reached, so
+  // incremental resizes start early enough to be done by then.
+  njf32 load_factor = ht->migrate_step ? ht->load_factor * gc_incremental_load_ratio : ht->load_factor;
+  if (!nj_ht_is_resizing(ht) && load_factor * ht->keys.length < ht->key_count + 1) {
     ht_rehash(ht);
   }
-  while (true) {
-    cap = ht->keys.length;
-    njsp index = hash % cap;
-    for (int i = 0; i < ht->probe_count; ++i) {
-      if (ht->keys[index] == NJ_HT_INVALID_KEY) {
-        ht->keys[index] = (njup)key;
-        ++ht->key_count;
-        return index;
-      }
-      index = (index + 1) % cap;
+  for (;;) {
+    njsp index = ht_place(ht, key, 0, hash);
+    if (index != NJ_HT_INVALID_INDEX) {
+      ++ht->key_count;
+      return index;
     }
-    ht_rehash(ht);
+    if (ht_widen_probe(ht))
+      continue;
+    if (ht->migrate_step && !ht->old_keys.length) {
+      // Switch to a bigger table without moving every key at once.
+      if (!ht->next_keys.length)
+        ht_rehash(ht);
+      ht_clear_next(ht, ht->next_keys.length);
+      continue;
+    }
+    ht_rebuild(ht, ht->resize_ratio * ht->keys.length + 2);
   }
   return NJ_HT_INVALID_INDEX;
 }
 
 static void ht_remove(nj_hash_table_t* ht, njup key, int key_size, nju64 hash) {
   NJ_CHECK_RETURN(key_size == ht->key_size);
-  njsp len = ht->keys.length;
-  njsp idx = hash % len;
-  for (int i = 0; i < ht->probe_count; ++i, ++idx) {
-    if (ht->keys[idx] != NJ_HT_INVALID_KEY && !memcmp((void*)key, (void*)ht->keys[idx], key_size)) {
-       ht->keys[idx] = NJ_HT_INVALID_KEY;
-    }
+  ht_step(ht);
+  njsp idx = ht_find(&ht->keys, key, key_size, hash, ht->probe_count);
+  if (idx != NJ_HT_INVALID_INDEX) {
+    ht->keys[idx] = NJ_HT_INVALID_KEY;
+    --ht->key_count;
+    return;
+  }
+  idx = ht_find(&ht->old_keys, key, key_size, hash, ht->old_probe_count);
+  if (idx != NJ_HT_INVALID_INDEX) {
+    ht->old_keys[idx] = NJ_HT_INVALID_KEY;
+    --ht->key_count;
   }
 }
 
 bool nj_ht_init(nj_hash_table_t* ht, nj_allocator_t* allocator, int key_size) {
   NJ_CHECK_RETURN_VAL(nj_da_init(&ht->keys, allocator), false);
   NJ_CHECK_RETURN_VAL(nj_da_init(&ht->values, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&ht->next_keys, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&ht->next_values, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&ht->old_keys, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&ht->old_values, allocator), false);
   ht->key_size = key_size;
   ht->key_count = 0;
+  ht->clear_index = 0;
+  ht->migrate_index = 0;
+  ht->migrate_step = 0;
   ht->load_factor = 0.65f;
   ht->resize_ratio = 1.5f;
-  ht->probe_count = 5;
+  ht->probe_count = gc_min_probe_count;
+  ht->old_probe_count = gc_min_probe_count;
   return true;
 }
 
-void nj_ht_destroy_internal(nj_hash_table_t* ht) {
+void nj_ht_destroy(nj_hash_table_t* ht) {
   nj_da_destroy(&ht->keys);
   nj_da_destroy(&ht->values);
+  nj_da_destroy(&ht->next_keys);
+  nj_da_destroy(&ht->next_values);
+  nj_da_destroy(&ht->old_keys);
+  nj_da_destroy(&ht->old_values);
+}
+
+void nj_ht_set_incremental_resize(nj_hash_table_t* ht, njsp slots_per_op) {
+  // A resize has to clear the new table and migrate the old one before the
+  // new table needs to grow again, which takes
+  // (resize_ratio - 1) * load_factor * gc_incremental_load_ratio * old_cap inserts.
+  njf32 inserts_per_slot = (ht->resize_ratio - 1.0f) * ht->load_factor * gc_incremental_load_ratio;
+  njsp min_step = (1.0f + ht->resize_ratio / gc_clears_per_migration) / inserts_per_slot + 1;
+  if (slots_per_op && slots_per_op < min_step)
+    NJ_LOGW("%d slots per operation can't keep up with inserts, some resizes will be done at once", (int)slots_per_op);
+  ht->migrate_step = slots_per_op;
+  if (!slots_per_op) {
+    ht_clear_next(ht, ht->next_keys.length);
+    ht_migrate(ht, ht->old_keys.length);
+  }
+}
+
+bool nj_ht_is_resizing(const nj_hash_table_t* ht) {
+  return ht->next_keys.length || ht->old_keys.length;
 }
 
 njsp nj_ht_get_ptr(nj_hash_table_t* ht, void* key, int key_size) {
@@ -16,16 +16,43 @@
 struct nj_hash_table_t {
   nj_dynamic_array_t<njup> keys;
   nj_dynamic_array_t<njup> values;
+  // An incremental resize has two phases. First |next_keys| is cleared a chunk
+  // per operation while |keys| is still in use. Then |next_keys| and
+  // |next_values| replace |keys| and |values|, and the previous table becomes
+  // |old_keys| and |old_values|, which are migrated a chunk per operation.
+  // Migrated slots are set to NJ_HT_INVALID_KEY.
+  nj_dynamic_array_t<njup> next_keys;
+  nj_dynamic_array_t<njup> next_values;
+  nj_dynamic_array_t<njup> old_keys;
+  nj_dynamic_array_t<njup> old_values;
   njsz key_size;
   njsp key_count;
+  // Number of slots of |next_keys| that have been cleared.
+  njsp clear_index;
+  // Next slot of |old_keys| to be migrated.
+  njsp migrate_index;
+  // Number of old slots migrated per get/insert/remove, 0 means a resize moves
+  // every key at once.
+  njsp migrate_step;
   njf32 load_factor;
   njf32 resize_ratio;
+  // Probing ranges of |keys| and |old_keys|. Each table starts with the
+  // narrowest range and only widens it when a key doesn't fit.
   nju8 probe_count;
+  nju8 old_probe_count;
 };
 
 bool nj_ht_init(nj_hash_table_t* ht, nj_allocator_t* allocator, int key_size);
 void nj_ht_destroy(nj_hash_table_t* ht);
 
+// Spread resizes over the following operations instead of moving every key in
+// one go. Lookups check both tables until the migration is done.
+// With incremental resizes, nj_ht_get_*() also does its share of the resize and
+// moves the key it finds to the new table, so lookups modify the table and
+// can't run concurrently with each other. Without them lookups are read-only.
+void nj_ht_set_incremental_resize(nj_hash_table_t* ht, njsp slots_per_op);
+bool nj_ht_is_resizing(const nj_hash_table_t* ht);
+
 njsp nj_ht_get_ptr(nj_hash_table_t* ht, void* key, int key_size);
 njsp nj_ht_insert_ptr(nj_hash_table_t* ht, void* key, int key_size);
 void nj_ht_remove_ptr(nj_hash_table_t* ht, void* key, int key_size);
@@ -0,0 +1,656 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/inflate.h"
+
+#include "core/log.h"
+#include "core/utils.h"
+
+#include <string.h>
+
+#define NJ_INFLATE_GZIP_FHCRC (1 << 1)
+#define NJ_INFLATE_GZIP_FEXTRA (1 << 2)
+#define NJ_INFLATE_GZIP_FNAME (1 << 3)
+#define NJ_INFLATE_GZIP_FCOMMENT (1 << 4)
+
+static const int gc_len_bases[] = {3,  4,  5,  6,   7,   8,   9,   10,  11, 13,
+                                   15, 17, 19, 23,  27,  31,  35,  43,  51, 59,
+                                   67, 83, 99, 115, 131, 163, 195, 227, 258};
+
+static const int gc_len_extra_bits[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                        1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                        4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+static const int gc_dist_bases[] = {
+    1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+    33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+
+static const int gc_dist_extra_bits[] = {0, 0, 0,  0,  1,  1,  2,  2,  3,  3,
+                                         4, 4, 5,  5,  6,  6,  7,  7,  8,  8,
+                                         9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Order of the code length code lengths in a dynamic block header.
+static const int gc_code_len_order[] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// CRC-32 of each 4 bits value.
+static const nju32 gc_crc32_table[] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+
+nju32 nj_adler32(nju32 adler, const nju8* data, njsp size) {
+  nju32 a = adler & 0xffff;
+  nju32 b = adler >> 16;
+  while (size > 0) {
+    // The largest n such that the sums don't overflow before the modulo.
+    njsp n = nj_min(size, (njsp)5552);
+    size -= n;
+    for (njsp i = 0; i < n; ++i) {
+      a += data[i];
+      b += a;
+    }
+    data += n;
+    a %= 65521;
+    b %= 65521;
+  }
+  return b << 16 | a;
+}
+
+// The second piece adds |size2| times the first piece's a to b, a and b are
+// kept under 2 * 65521 before the last subtractions.
+nju32 nj_adler32_combine(nju32 adler1, nju32 adler2, njsp size2) {
+  nju32 rem = (nju32)(size2 % 65521);
+  nju32 a = adler1 & 0xffff;
+  nju32 b = rem * a % 65521;
+  a += (adler2 & 0xffff) + 65521 - 1;
+  b += (adler1 >> 16) + (adler2 >> 16) + 65521 - rem;
+  if (a >= 65521)
+    a -= 65521;
+  if (a >= 65521)
+    a -= 65521;
+  if (b >= 2 * 65521)
+    b -= 2 * 65521;
+  if (b >= 65521)
+    b -= 65521;
+  return b << 16 | a;
+}
+
+nju32 nj_crc32(nju32 crc, const nju8* data, njsp size) {
+  crc = ~crc;
+  for (njsp i = 0; i < size; ++i) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ gc_crc32_table[crc & 15];
+    crc = (crc >> 4) ^ gc_crc32_table[crc & 15];
+  }
+  return ~crc;
+}
+
+// Table entries are the symbol or the subtable index in the high 16 bits and
+// the code length or the subtable bits in the low 4 bits. 0 is an invalid
+// code.
+#define NJ_INFLATE_ENTRY_SUBTABLE (1 << 4)
+#define NJ_INFLATE_CODE_LEN_TABLE_BITS (7)
+
+// Build the lookup table of the canonical code of |count| symbols from their
+// code lengths. Codes are read from their most significant bit but the bit
+// buffer starts from the least significant one so they are reversed in the
+// table. Incomplete codes are valid, e.g. a block with a single distance code.
+// Returns false if the code is oversubscribed or its subtables don't fit.
+static bool build_huffman(nju32* table, int table_bits, int table_size, const nju8* lens, int count) {
+  nju16 counts[16] = {};
+  for (int i = 0; i < count; ++i)
+    ++counts[lens[i]];
+  counts[0] = 0;
+  int left = 1;
+  int max_len = 0;
+  for (int len = 1; len < 16; ++len) {
+    left = (left << 1) - counts[len];
+    if (left < 0)
+      return false;
+    if (counts[len])
+      max_len = len;
+  }
+  nju16 offsets[16];
+  offsets[1] = 0;
+  for (int len = 1; len < 15; ++len)
+    offsets[len + 1] = offsets[len] + counts[len];
+  nju16 symbols[288];
+  for (int i = 0; i < count; ++i) {
+    if (lens[i])
+      symbols[offsets[lens[i]]++] = (nju16)i;
+  }
+
+  memset(table, 0, sizeof(nju32) << table_bits);
+  nju16 remaining[16];
+  memcpy(remaining, counts, sizeof(counts));
+  nju32 table_mask = (1u << table_bits) - 1;
+  int next_subtable = 1 << table_bits;
+  nju32 prefix = ~0u;
+  int subtable = 0;
+  int subtable_bits = 0;
+  nju32 code = 0;
+  int index = 0;
+  for (int len = 1; len <= max_len; ++len, code <<= 1) {
+    for (int i = 0; i < counts[len]; ++i, ++code, ++index) {
+      nju32 reversed = 0;
+      for (int j = 0; j < len; ++j)
+        reversed |= ((code >> j) & 1) << (len - 1 - j);
+      nju32 entry = (nju32)symbols[index] << 16 | len;
+      if (len <= table_bits) {
+        for (nju32 j = reversed; j <= table_mask; j += 1u << len)
+          table[j] = entry;
+      } else {
+        if ((reversed & table_mask) != prefix) {
+          // Codes with the same first bits are next to each other, the
+          // subtable is as small as the remaining codes allow like zlib does.
+          prefix = reversed & table_mask;
+          subtable_bits = len - table_bits;
+          int subtable_left = 1 << subtable_bits;
+          while (subtable_bits + table_bits < max_len) {
+            subtable_left -= remaining[subtable_bits + table_bits];
+            if (subtable_left <= 0)
+              break;
+            ++subtable_bits;
+            subtable_left <<= 1;
+          }
+          if (next_subtable + (1 << subtable_bits) > table_size)
+            return false;
+          subtable = next_subtable;
+          next_subtable += 1 << subtable_bits;
+          memset(table + subtable, 0, sizeof(nju32) << subtable_bits);
+          table[prefix] = (nju32)subtable << 16 | NJ_INFLATE_ENTRY_SUBTABLE | subtable_bits;
+        }
+        for (nju32 j = reversed >> table_bits; j < (1u << subtable_bits); j += 1u << (len - table_bits))
+          table[subtable + j] = entry;
+      }
+      --remaining[len];
+    }
+  }
+  return true;
+}
+
+// The entry of the code at the start of |bits|, the bits after the code may
+// be garbage.
+static nju32 huffman_lookup(const nju32* table, int table_bits, nju64 bits) {
+  nju32 entry = table[bits & ((1u << table_bits) - 1)];
+  if (entry & NJ_INFLATE_ENTRY_SUBTABLE)
+    entry = table[(entry >> 16) + ((bits >> table_bits) & ((1u << (entry & 15)) - 1))];
+  return entry;
+}
+
+// Returns the symbol of the code at the start of |bits| and its length in
+// |*len|, -1 if more than |bit_count| bits are needed or -2 if the code isn't
+// valid.
+static int decode_symbol(const nju32* table, int table_bits, nju64 bits, int bit_count, int* len) {
+  nju32 entry = huffman_lookup(table, table_bits, bits);
+  if (!entry)
+    return bit_count < 15 ? -1 : -2;
+  *len = entry & 15;
+  if (*len > bit_count)
+    return -1;
+  return entry >> 16;
+}
+
+static void build_fixed_huffman(nj_inflate_t* inflate) {
+  if (inflate->has_fixed_tables)
+    return;
+  nju8* lens = inflate->lens;
+  memset(lens, 8, 144);
+  memset(lens + 144, 9, 256 - 144);
+  memset(lens + 256, 7, 280 - 256);
+  memset(lens + 280, 8, 288 - 280);
+  build_huffman(inflate->lit_table, NJ_INFLATE_LIT_TABLE_BITS, NJ_INFLATE_LIT_TABLE_SIZE, lens, 288);
+  memset(lens, 5, 30);
+  build_huffman(inflate->dist_table, NJ_INFLATE_DIST_TABLE_BITS, NJ_INFLATE_DIST_TABLE_SIZE, lens, 30);
+  inflate->has_fixed_tables = true;
+}
+
+static void inflate_update_checksum(nj_inflate_t* inflate) {
+  const nju8* data = inflate->window + inflate->checksum_len;
+  njsp size = inflate->window_len - inflate->checksum_len;
+  if (inflate->format == NJ_INFLATE_FORMAT_ZLIB)
+    inflate->checksum = nj_adler32(inflate->checksum, data, size);
+  else if (inflate->format == NJ_INFLATE_FORMAT_GZIP)
+    inflate->checksum = nj_crc32(inflate->checksum, data, size);
+  inflate->total_out += size;
+  inflate->checksum_len = inflate->window_len;
+}
+
+// Returns false if the window is full and the output hasn't been taken yet.
+static bool inflate_make_room(nj_inflate_t* inflate) {
+  if (inflate->window_len < inflate->window_size)
+    return true;
+  if (inflate->output_begin < inflate->window_len)
+    return false;
+  inflate_update_checksum(inflate);
+  // Half of a small window is kept, matches that are too far are invalid
+  // then.
+  njsp keep = nj_min(nj_min(inflate->window_len, (njsp)NJ_INFLATE_HISTORY_SIZE), inflate->window_size / 2);
+  memmove(inflate->window, inflate->window + inflate->window_len - keep, keep);
+  inflate->window_len = keep;
+  inflate->output_begin = keep;
+  inflate->checksum_len = keep;
+  return true;
+}
+
+// Logs |message| unless the decoder is quiet.
+static nj_inflate_status_t inflate_fail(nj_inflate_t* inflate, const char* message) {
+  if (!inflate->is_quiet)
+    NJ_LOGF("%s", message);
+  return NJ_INFLATE_STATUS_ERROR;
+}
+
+#define NJ_INFLATE_CHECK(condition, message) \
+  if (!(condition))                          \
+    return inflate_fail(inflate, message);
+
+void nj_inflate_init(nj_inflate_t* inflate, nj_inflate_format_t format, nju8* window, njsp window_size) {
+  memset(inflate, 0, sizeof(nj_inflate_t));
+  inflate->format = format;
+  if (format == NJ_INFLATE_FORMAT_ZLIB)
+    inflate->state = NJ_INFLATE_STATE_ZLIB_HEADER;
+  else if (format == NJ_INFLATE_FORMAT_GZIP)
+    inflate->state = NJ_INFLATE_STATE_GZIP_HEADER;
+  else
+    inflate->state = NJ_INFLATE_STATE_BLOCK_HEADER;
+  inflate->window = window;
+  inflate->window_size = window_size;
+  inflate->checksum = format == NJ_INFLATE_FORMAT_ZLIB ? 1 : 0;
+}
+
+void nj_inflate_take_output(nj_inflate_t* inflate, const nju8** data, njsp* size) {
+  inflate_update_checksum(inflate);
+  *data = inflate->window + inflate->output_begin;
+  *size = inflate->window_len - inflate->output_begin;
+  inflate->output_begin = inflate->window_len;
+}
+
+// The state of the next optional field of a gzip header after |state|.
+static nj_inflate_state_t inflate_next_gzip_state(int flags, nj_inflate_state_t state) {
+  if (state < NJ_INFLATE_STATE_GZIP_EXTRA_LEN && (flags & NJ_INFLATE_GZIP_FEXTRA))
+    return NJ_INFLATE_STATE_GZIP_EXTRA_LEN;
+  if (state < NJ_INFLATE_STATE_GZIP_NAME && (flags & NJ_INFLATE_GZIP_FNAME))
+    return NJ_INFLATE_STATE_GZIP_NAME;
+  if (state < NJ_INFLATE_STATE_GZIP_COMMENT && (flags & NJ_INFLATE_GZIP_FCOMMENT))
+    return NJ_INFLATE_STATE_GZIP_COMMENT;
+  if (state < NJ_INFLATE_STATE_GZIP_HEADER_CRC && (flags & NJ_INFLATE_GZIP_FHCRC))
+    return NJ_INFLATE_STATE_GZIP_HEADER_CRC;
+  return NJ_INFLATE_STATE_BLOCK_HEADER;
+}
+
+// Decode while there are at least 8 bytes of input and room for the longest
+// match, the bit stream is refilled a word at a time and a whole sequence
+// (up to 48 bits) is decoded without checking the input or the output. The
+// state is kept in locals, the output may alias it otherwise. Returns
+// NJ_INFLATE_STATUS_DONE at the end of the block, NJ_INFLATE_STATUS_NEED_INPUT
+// when the slow path has to go on.
+static nj_inflate_status_t inflate_decode_codes_fast(nj_inflate_t* inflate) {
+  nj_bit_stream_t bs = inflate->bs;
+  nju8* window = inflate->window;
+  njsp window_len = inflate->window_len;
+  // 8 bytes more for the match copies.
+  njsp out_limit = inflate->window_size - 258 - 8;
+  const nju32* lit_table = inflate->lit_table;
+  const nju32* dist_table = inflate->dist_table;
+  nj_inflate_status_t status = NJ_INFLATE_STATUS_NEED_INPUT;
+  while (bs.end - bs.p >= 8 && window_len <= out_limit) {
+    nj_bs_refill(&bs);
+    nju32 entry = huffman_lookup(lit_table, NJ_INFLATE_LIT_TABLE_BITS, bs.bits);
+    nju32 symbol = entry >> 16;
+    nj_bs_consume(&bs, entry & 15);
+    if (symbol < 256 && entry) {
+      window[window_len++] = (nju8)symbol;
+      continue;
+    }
+    if (symbol == 256) {
+      inflate->state = inflate->is_final_block ? NJ_INFLATE_STATE_TRAILER : NJ_INFLATE_STATE_BLOCK_HEADER;
+      status = NJ_INFLATE_STATUS_DONE;
+      break;
+    }
+    symbol -= 257;
+    if (!entry || symbol >= 29) {
+      status = inflate_fail(inflate, "Invalid literal/length code");
+      break;
+    }
+    int extra_bits = gc_len_extra_bits[symbol];
+    njsp match_len = gc_len_bases[symbol] + nj_bs_peek(&bs, extra_bits);
+    nj_bs_consume(&bs, extra_bits);
+
+    entry = huffman_lookup(dist_table, NJ_INFLATE_DIST_TABLE_BITS, bs.bits);
+    symbol = entry >> 16;
+    nj_bs_consume(&bs, entry & 15);
+    if (!entry || symbol >= 30) {
+      status = inflate_fail(inflate, "Invalid distance code");
+      break;
+    }
+    extra_bits = gc_dist_extra_bits[symbol];
+    njsp dist = gc_dist_bases[symbol] + nj_bs_peek(&bs, extra_bits);
+    nj_bs_consume(&bs, extra_bits);
+    if (dist > window_len) {
+      status = inflate_fail(inflate, "Invalid match distance");
+      break;
+    }
+    nju8* out = window + window_len;
+    const nju8* match = out - dist;
+    if (dist >= 8) {
+      for (njsp i = 0; i < match_len; i += 8)
+        memcpy(out + i, match + i, 8);
+    } else {
+      for (njsp i = 0; i < match_len; ++i)
+        out[i] = match[i];
+    }
+    window_len += match_len;
+  }
+  inflate->bs = bs;
+  inflate->window_len = window_len;
+  return status;
+}
+
+// Decode literals and matches until the end of the block. In the slow path
+// each symbol is consumed only once it's complete so the decoder can stop
+// between any two.
+static nj_inflate_status_t inflate_decode_codes(nj_inflate_t* inflate) {
+  for (;;) {
+    nj_inflate_status_t status = inflate_decode_codes_fast(inflate);
+    if (status != NJ_INFLATE_STATUS_NEED_INPUT)
+      return status;
+    nj_bs_refill(&inflate->bs);
+    int lit_len;
+    int symbol = decode_symbol(inflate->lit_table, NJ_INFLATE_LIT_TABLE_BITS, inflate->bs.bits, inflate->bs.bit_count, &lit_len);
+    if (symbol == -1)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    NJ_INFLATE_CHECK(symbol >= 0, "Invalid literal/length code");
+    if (symbol < 256) {
+      if (!inflate_make_room(inflate))
+        return NJ_INFLATE_STATUS_OUTPUT_FULL;
+      nj_bs_consume(&inflate->bs, lit_len);
+      inflate->window[inflate->window_len++] = (nju8)symbol;
+      continue;
+    }
+    if (symbol == 256) {
+      nj_bs_consume(&inflate->bs, lit_len);
+      inflate->state = inflate->is_final_block ? NJ_INFLATE_STATE_TRAILER : NJ_INFLATE_STATE_BLOCK_HEADER;
+      return NJ_INFLATE_STATUS_DONE;
+    }
+    symbol -= 257;
+    NJ_INFLATE_CHECK(symbol < 29, "Invalid literal/length code");
+    int used = lit_len;
+    int extra_bits = gc_len_extra_bits[symbol];
+    if (used + extra_bits > inflate->bs.bit_count)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    njsp len = gc_len_bases[symbol] + ((inflate->bs.bits >> used) & ((1u << extra_bits) - 1));
+    used += extra_bits;
+    int dist_len;
+    symbol = decode_symbol(inflate->dist_table, NJ_INFLATE_DIST_TABLE_BITS, inflate->bs.bits >> used, inflate->bs.bit_count - used, &dist_len);
+    if (symbol == -1)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    NJ_INFLATE_CHECK(symbol >= 0 && symbol < 30, "Invalid distance code");
+    used += dist_len;
+    extra_bits = gc_dist_extra_bits[symbol];
+    if (used + extra_bits > inflate->bs.bit_count)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    njsp dist = gc_dist_bases[symbol] + ((inflate->bs.bits >> used) & ((1u << extra_bits) - 1));
+    used += extra_bits;
+    nj_bs_consume(&inflate->bs, used);
+    inflate->copy_len = len;
+    inflate->copy_dist = dist;
+    inflate->state = NJ_INFLATE_STATE_COPY;
+    return NJ_INFLATE_STATUS_DONE;
+  }
+}
+
+// Copy the rest of a stored block from the bit buffer then the input.
+static nj_inflate_status_t inflate_copy_stored(nj_inflate_t* inflate) {
+  while (inflate->remaining) {
+    if (!inflate_make_room(inflate))
+      return NJ_INFLATE_STATUS_OUTPUT_FULL;
+    njsp room = inflate->window_size - inflate->window_len;
+    njsp len = nj_bs_copy_bytes(&inflate->bs, inflate->window + inflate->window_len, nj_min(room, inflate->remaining));
+    if (!len)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    inflate->window_len += len;
+    inflate->remaining -= len;
+  }
+  inflate->state = inflate->is_final_block ? NJ_INFLATE_STATE_TRAILER : NJ_INFLATE_STATE_BLOCK_HEADER;
+  return NJ_INFLATE_STATUS_DONE;
+}
+
+// Returns NJ_INFLATE_STATUS_DONE when the state changed and the decoder should
+// go on.
+static nj_inflate_status_t inflate_step(nj_inflate_t* inflate) {
+  nj_bs_refill(&inflate->bs);
+  switch (inflate->state) {
+  case NJ_INFLATE_STATE_ZLIB_HEADER: {
+    if (inflate->bs.bit_count < 16)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    nju32 cmf = (nju32)nj_bs_peek(&inflate->bs, 8);
+    nju32 flg = (nju32)nj_bs_peek(&inflate->bs, 16) >> 8;
+    nj_bs_consume(&inflate->bs, 16);
+    NJ_INFLATE_CHECK((cmf & 15) == 8 && (cmf >> 4) <= 7, "Invalid zlib compression method");
+    NJ_INFLATE_CHECK((cmf * 256 + flg) % 31 == 0, "Invalid FCHECK bits");
+    NJ_INFLATE_CHECK(!(flg & 0x20), "zlib preset dictionaries aren't supported");
+    inflate->state = NJ_INFLATE_STATE_BLOCK_HEADER;
+    break;
+  }
+  case NJ_INFLATE_STATE_GZIP_HEADER:
+    // ID1, ID2, CM and FLG.
+    if (inflate->bs.bit_count < 32)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    NJ_INFLATE_CHECK((nju32)nj_bs_peek(&inflate->bs, 24) == (31 | 139 << 8 | 8 << 16), "Invalid gzip header");
+    inflate->gzip_flags = (nju32)nj_bs_peek(&inflate->bs, 32) >> 24;
+    NJ_INFLATE_CHECK(!(inflate->gzip_flags & 0xe0), "Invalid gzip flags");
+    nj_bs_consume(&inflate->bs, 32);
+    inflate->state = NJ_INFLATE_STATE_GZIP_MTIME;
+    break;
+  case NJ_INFLATE_STATE_GZIP_MTIME:
+    // MTIME, XFL and OS.
+    if (inflate->bs.bit_count < 48)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    nj_bs_consume(&inflate->bs, 48);
+    inflate->state = inflate_next_gzip_state(inflate->gzip_flags, inflate->state);
+    break;
+  case NJ_INFLATE_STATE_GZIP_EXTRA_LEN:
+    if (inflate->bs.bit_count < 16)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    inflate->remaining = (nju32)nj_bs_peek(&inflate->bs, 16);
+    nj_bs_consume(&inflate->bs, 16);
+    inflate->state = NJ_INFLATE_STATE_GZIP_EXTRA;
+    break;
+  case NJ_INFLATE_STATE_GZIP_EXTRA:
+    // The fields are longer than the bit buffer, it's refilled for each byte.
+    for (; inflate->remaining; --inflate->remaining) {
+      nj_bs_refill(&inflate->bs);
+      if (inflate->bs.bit_count < 8)
+        return NJ_INFLATE_STATUS_NEED_INPUT;
+      nj_bs_consume(&inflate->bs, 8);
+    }
+    inflate->state = inflate_next_gzip_state(inflate->gzip_flags, inflate->state);
+    break;
+  case NJ_INFLATE_STATE_GZIP_NAME:
+  case NJ_INFLATE_STATE_GZIP_COMMENT: {
+    bool is_end = false;
+    while (!is_end) {
+      nj_bs_refill(&inflate->bs);
+      if (inflate->bs.bit_count < 8)
+        return NJ_INFLATE_STATUS_NEED_INPUT;
+      is_end = !nj_bs_peek(&inflate->bs, 8);
+      nj_bs_consume(&inflate->bs, 8);
+    }
+    inflate->state = inflate_next_gzip_state(inflate->gzip_flags, inflate->state);
+    break;
+  }
+  case NJ_INFLATE_STATE_GZIP_HEADER_CRC:
+    if (inflate->bs.bit_count < 16)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    nj_bs_consume(&inflate->bs, 16);
+    inflate->state = NJ_INFLATE_STATE_BLOCK_HEADER;
+    break;
+  case NJ_INFLATE_STATE_BLOCK_HEADER: {
+    if (inflate->bs.bit_count < 3)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    inflate->is_final_block = (nju32)nj_bs_peek(&inflate->bs, 1);
+    nju32 type = (nju32)nj_bs_peek(&inflate->bs, 3) >> 1;
+    nj_bs_consume(&inflate->bs, 3);
+    if (type == 0) {
+      // Stored blocks start at a byte boundary.
+      nj_bs_consume(&inflate->bs, inflate->bs.bit_count & 7);
+      inflate->state = NJ_INFLATE_STATE_STORED_LEN;
+    } else if (type == 1) {
+      build_fixed_huffman(inflate);
+      inflate->state = NJ_INFLATE_STATE_CODES;
+    } else if (type == 2) {
+      inflate->state = NJ_INFLATE_STATE_TABLE;
+    } else {
+      return inflate_fail(inflate, "Invalid deflate block type");
+    }
+    break;
+  }
+  case NJ_INFLATE_STATE_STORED_LEN: {
+    if (inflate->bs.bit_count < 32)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    nju32 len = (nju32)nj_bs_peek(&inflate->bs, 16);
+    nju32 nlen = (nju32)nj_bs_peek(&inflate->bs, 32) >> 16;
+    nj_bs_consume(&inflate->bs, 32);
+    NJ_INFLATE_CHECK(len == (~nlen & 0xffff), "Invalid stored block length");
+    inflate->remaining = len;
+    inflate->state = NJ_INFLATE_STATE_STORED;
+    break;
+  }
+  case NJ_INFLATE_STATE_STORED:
+    return inflate_copy_stored(inflate);
+  case NJ_INFLATE_STATE_TABLE:
+    if (inflate->bs.bit_count < 14)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    inflate->lit_count = (nju32)nj_bs_peek(&inflate->bs, 5) + 257;
+    inflate->dist_count = ((nju32)nj_bs_peek(&inflate->bs, 10) >> 5) + 1;
+    inflate->code_len_count = ((nju32)nj_bs_peek(&inflate->bs, 14) >> 10) + 4;
+    nj_bs_consume(&inflate->bs, 14);
+    NJ_INFLATE_CHECK(inflate->lit_count <= 286 && inflate->dist_count <= 30, "Too many codes in a deflate block");
+    memset(inflate->lens, 0, 19);
+    inflate->lens_index = 0;
+    inflate->state = NJ_INFLATE_STATE_CODE_LENS;
+    break;
+  case NJ_INFLATE_STATE_CODE_LENS:
+    // Up to 57 bits, more than a refill guarantees.
+    for (; inflate->lens_index < inflate->code_len_count; ++inflate->lens_index) {
+      nj_bs_refill(&inflate->bs);
+      if (inflate->bs.bit_count < 3)
+        return NJ_INFLATE_STATUS_NEED_INPUT;
+      inflate->lens[gc_code_len_order[inflate->lens_index]] = (nju8)nj_bs_peek(&inflate->bs, 3);
+      nj_bs_consume(&inflate->bs, 3);
+    }
+    // The code length code is kept in |lit_table| until the literal code is
+    // built.
+    inflate->has_fixed_tables = false;
+    NJ_INFLATE_CHECK(build_huffman(inflate->lit_table, NJ_INFLATE_CODE_LEN_TABLE_BITS, NJ_INFLATE_LIT_TABLE_SIZE, inflate->lens, 19), "Invalid code length code");
+    inflate->lens_index = 0;
+    inflate->state = NJ_INFLATE_STATE_LENS;
+    break;
+  case NJ_INFLATE_STATE_LENS: {
+    int count = inflate->lit_count + inflate->dist_count;
+    while (inflate->lens_index < count) {
+      nj_bs_refill(&inflate->bs);
+      int len;
+      int symbol = decode_symbol(inflate->lit_table, NJ_INFLATE_CODE_LEN_TABLE_BITS, inflate->bs.bits, inflate->bs.bit_count, &len);
+      if (symbol == -1)
+        return NJ_INFLATE_STATUS_NEED_INPUT;
+      NJ_INFLATE_CHECK(symbol >= 0, "Invalid code length code");
+      if (symbol < 16) {
+        nj_bs_consume(&inflate->bs, len);
+        inflate->lens[inflate->lens_index++] = (nju8)symbol;
+        continue;
+      }
+      // 16 repeats the previous length 3-6 times, 17 and 18 repeat 0 3-10 and
+      // 11-138 times.
+      int extra_bits = symbol == 16 ? 2 : symbol == 17 ? 3 : 7;
+      if (len + extra_bits > inflate->bs.bit_count)
+        return NJ_INFLATE_STATUS_NEED_INPUT;
+      int repeat = (symbol == 18 ? 11 : 3) + (int)((inflate->bs.bits >> len) & ((1u << extra_bits) - 1));
+      nj_bs_consume(&inflate->bs, len + extra_bits);
+      NJ_INFLATE_CHECK(symbol != 16 || inflate->lens_index, "No length to repeat");
+      NJ_INFLATE_CHECK(inflate->lens_index + repeat <= count, "Too many code lengths");
+      nju8 value = symbol == 16 ? inflate->lens[inflate->lens_index - 1] : 0;
+      memset(inflate->lens + inflate->lens_index, value, repeat);
+      inflate->lens_index += repeat;
+    }
+    NJ_INFLATE_CHECK(inflate->lens[256], "Symbol 256 can't have length of 0");
+    NJ_INFLATE_CHECK(build_huffman(inflate->lit_table, NJ_INFLATE_LIT_TABLE_BITS, NJ_INFLATE_LIT_TABLE_SIZE, inflate->lens, inflate->lit_count), "Invalid literal/length code");
+    NJ_INFLATE_CHECK(build_huffman(inflate->dist_table, NJ_INFLATE_DIST_TABLE_BITS, NJ_INFLATE_DIST_TABLE_SIZE, inflate->lens + inflate->lit_count, inflate->dist_count), "Invalid distance code");
+    inflate->state = NJ_INFLATE_STATE_CODES;
+    break;
+  }
+  case NJ_INFLATE_STATE_CODES:
+    return inflate_decode_codes(inflate);
+  case NJ_INFLATE_STATE_COPY: {
+    NJ_INFLATE_CHECK(inflate->copy_dist <= inflate->window_len, "Invalid match distance");
+    while (inflate->copy_len) {
+      if (!inflate_make_room(inflate))
+        return NJ_INFLATE_STATUS_OUTPUT_FULL;
+      NJ_INFLATE_CHECK(inflate->copy_dist <= inflate->window_len, "Invalid match distance");
+      njsp len = nj_min(inflate->copy_len, inflate->window_size - inflate->window_len);
+      nju8* out = inflate->window + inflate->window_len;
+      const nju8* match = out - inflate->copy_dist;
+      for (njsp i = 0; i < len; ++i)
+        out[i] = match[i];
+      inflate->window_len += len;
+      inflate->copy_len -= len;
+    }
+    inflate->state = NJ_INFLATE_STATE_CODES;
+    break;
+  }
+  case NJ_INFLATE_STATE_TRAILER: {
+    if (inflate->format == NJ_INFLATE_FORMAT_RAW) {
+      inflate->state = NJ_INFLATE_STATE_DONE;
+      break;
+    }
+    nj_bs_consume(&inflate->bs, inflate->bs.bit_count & 7);
+    // The gzip trailer needs all 64 bits, a word refill stops at 56.
+    nj_bs_refill_slow(&inflate->bs);
+    int trailer_bits = inflate->format == NJ_INFLATE_FORMAT_ZLIB ? 32 : 64;
+    if (inflate->bs.bit_count < trailer_bits)
+      return NJ_INFLATE_STATUS_NEED_INPUT;
+    inflate_update_checksum(inflate);
+    if (inflate->format == NJ_INFLATE_FORMAT_ZLIB) {
+      // Adler-32 is big endian.
+      nju32 adler = (nju32)nj_bs_peek(&inflate->bs, 32);
+      adler = adler >> 24 | (adler >> 8 & 0xff00) | (adler << 8 & 0xff0000) | adler << 24;
+      NJ_INFLATE_CHECK(adler == inflate->checksum, "Invalid Adler-32");
+    } else {
+      NJ_INFLATE_CHECK((nju32)nj_bs_peek(&inflate->bs, 32) == inflate->checksum, "Invalid CRC-32");
+      NJ_INFLATE_CHECK((inflate->bs.bits >> 32 & 0xffffffff) == (inflate->total_out & 0xffffffff), "Invalid gzip size");
+    }
+    nj_bs_consume(&inflate->bs, 32);
+    if (trailer_bits == 64)
+      nj_bs_consume(&inflate->bs, 32);
+    inflate->state = NJ_INFLATE_STATE_DONE;
+    break;
+  }
+  case NJ_INFLATE_STATE_DONE:
+  case NJ_INFLATE_STATE_ERROR:
+    break;
+  }
+  return NJ_INFLATE_STATUS_DONE;
+}
+
+nj_inflate_status_t nj_inflate_decode(nj_inflate_t* inflate, const nju8* in, njsp in_size, njsp* in_used) {
+  nj_bs_feed(&inflate->bs, in, in_size);
+  nj_inflate_status_t status = NJ_INFLATE_STATUS_DONE;
+  while (status == NJ_INFLATE_STATUS_DONE && inflate->state != NJ_INFLATE_STATE_DONE && inflate->state != NJ_INFLATE_STATE_ERROR)
+    status = inflate_step(inflate);
+  if (status == NJ_INFLATE_STATUS_ERROR)
+    inflate->state = NJ_INFLATE_STATE_ERROR;
+  // Give back the whole bytes that were read ahead of the decoder, the caller
+  // passes them again or they are after the end of the stream. Bytes from a
+  // previous call are kept.
+  if (status != NJ_INFLATE_STATUS_NEED_INPUT)
+    nj_bs_give_back_bytes(&inflate->bs);
+  if (inflate->state == NJ_INFLATE_STATE_DONE)
+    status = NJ_INFLATE_STATUS_DONE;
+  else if (inflate->state == NJ_INFLATE_STATE_ERROR)
+    status = NJ_INFLATE_STATUS_ERROR;
+  nj_maybe_assign(in_used, (njsp)(inflate->bs.p - in));
+  return status;
+}
@@ -0,0 +1,125 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_INFLATE_H
+#define NJ_CORE_INFLATE_H
+
+#include "core/bit_stream.h"
+#include "core/njtype.h"
+
+// Deflate (RFC 1951) decoder with zlib (RFC 1950) and gzip (RFC 1952)
+// wrappers. Input can be split anywhere, the decoder stops when it runs out of
+// input or output and continues where it was on the next call.
+
+// Max distance of a match.
+#define NJ_INFLATE_HISTORY_SIZE (32768)
+
+enum nj_inflate_format_t {
+  NJ_INFLATE_FORMAT_RAW,
+  NJ_INFLATE_FORMAT_ZLIB,
+  NJ_INFLATE_FORMAT_GZIP,
+};
+
+enum nj_inflate_status_t {
+  NJ_INFLATE_STATUS_NEED_INPUT,
+  // The window is full, take the output with nj_inflate_take_output() then
+  // call nj_inflate_decode() again.
+  NJ_INFLATE_STATUS_OUTPUT_FULL,
+  NJ_INFLATE_STATUS_DONE,
+  NJ_INFLATE_STATUS_ERROR,
+};
+
+enum nj_inflate_state_t {
+  NJ_INFLATE_STATE_ZLIB_HEADER,
+  NJ_INFLATE_STATE_GZIP_HEADER,
+  NJ_INFLATE_STATE_GZIP_MTIME,
+  NJ_INFLATE_STATE_GZIP_EXTRA_LEN,
+  NJ_INFLATE_STATE_GZIP_EXTRA,
+  NJ_INFLATE_STATE_GZIP_NAME,
+  NJ_INFLATE_STATE_GZIP_COMMENT,
+  NJ_INFLATE_STATE_GZIP_HEADER_CRC,
+  NJ_INFLATE_STATE_BLOCK_HEADER,
+  NJ_INFLATE_STATE_STORED_LEN,
+  NJ_INFLATE_STATE_STORED,
+  NJ_INFLATE_STATE_TABLE,
+  NJ_INFLATE_STATE_CODE_LENS,
+  NJ_INFLATE_STATE_LENS,
+  NJ_INFLATE_STATE_CODES,
+  NJ_INFLATE_STATE_COPY,
+  NJ_INFLATE_STATE_TRAILER,
+  NJ_INFLATE_STATE_DONE,
+  NJ_INFLATE_STATE_ERROR,
+};
+
+// Bits of the first level of the Huffman lookup tables, longer codes are in
+// subtables.
+#define NJ_INFLATE_LIT_TABLE_BITS (10)
+#define NJ_INFLATE_DIST_TABLE_BITS (8)
+// Max size of the tables with their subtables, computed by zlib's enough.c
+// ("enough 288 10 15" and "enough 32 8 15").
+#define NJ_INFLATE_LIT_TABLE_SIZE (1334)
+#define NJ_INFLATE_DIST_TABLE_SIZE (402)
+
+struct nj_inflate_t {
+  nj_inflate_format_t format;
+  nj_inflate_state_t state;
+  // Output is written to the caller's window at |window_len|. Matches look
+  // back in it so it keeps the last NJ_INFLATE_HISTORY_SIZE bytes when it's
+  // full and the output has been taken.
+  nju8* window;
+  njsp window_size;
+  njsp window_len;
+  // Start of the output that hasn't been taken.
+  njsp output_begin;
+  // Input of the current nj_inflate_decode() call, the bits that weren't
+  // consumed stay buffered until the next call.
+  nj_bit_stream_t bs;
+  bool is_final_block;
+  // Bytes left of a stored block or a gzip extra field.
+  njsp remaining;
+  njsp copy_len;
+  njsp copy_dist;
+  int gzip_flags;
+  int lit_count;
+  int dist_count;
+  int code_len_count;
+  int lens_index;
+  nju8 lens[286 + 30];
+  // Adler-32 or CRC-32 of the output up to |checksum_len| in the window.
+  nju32 checksum;
+  njsp checksum_len;
+  nju64 total_out;
+  // The tables are indexed by the next bits of the input, an entry is the
+  // symbol and the code length or the index and bits of a subtable.
+  nju32 lit_table[NJ_INFLATE_LIT_TABLE_SIZE];
+  nju32 dist_table[NJ_INFLATE_DIST_TABLE_SIZE];
+  // The tables are the fixed Huffman codes, they aren't built again for the
+  // next fixed block.
+  bool has_fixed_tables;
+  // Errors aren't logged, for callers that expect invalid streams and report
+  // them. Set after nj_inflate_init().
+  bool is_quiet;
+};
+
+// |window| must be at least NJ_INFLATE_HISTORY_SIZE * 2 bytes to stream an
+// output of any size. If the whole output fits, any size works and the output
+// is in the window when nj_inflate_decode() returns NJ_INFLATE_STATUS_DONE.
+void nj_inflate_init(nj_inflate_t* inflate, nj_inflate_format_t format, nju8* window, njsp window_size);
+// |*in_used| is the number of bytes of |in| consumed. All of it is consumed
+// unless the output is full or the stream ended.
+nj_inflate_status_t nj_inflate_decode(nj_inflate_t* inflate, const nju8* in, njsp in_size, njsp* in_used);
+// The output since the last call, valid until the next nj_inflate_decode().
+void nj_inflate_take_output(nj_inflate_t* inflate, const nju8** data, njsp* size);
+
+// Checksums of the zlib and gzip wrappers, continue from the previous value.
+// Start with 1 for Adler-32 and 0 for CRC-32.
+nju32 nj_adler32(nju32 adler, const nju8* data, njsp size);
+nju32 nj_crc32(nju32 crc, const nju8* data, njsp size);
+// Adler-32 of the data of |adler1| followed by the |size2| bytes of |adler2|,
+// e.g. of pieces checksummed by different threads.
+nju32 nj_adler32_combine(nju32 adler1, nju32 adler2, njsp size2);
+
+#endif // NJ_CORE_INFLATE_H
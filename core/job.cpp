@@ -0,0 +1,505 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/job.h"
+
+#include "core/allocator.h"
+#include "core/atomic.h"
+#include "core/compiler.h"
+#include "core/cpu_topology.h"
+#include "core/fiber.h"
+#include "core/futex.h"
+#include "core/linear_allocator.inl"
+#include "core/log.h"
+#include "core/queue.inl"
+#include "core/sync.h"
+#include "core/thread.h"
+#include "core/utils.h"
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+static const njsp gc_job_deque_capacity = 4096;
+static const njsp gc_job_injected_capacity = 4096;
+// Number of failed tries before a thread goes to sleep.
+static const int gc_job_spin_count = 256;
+// Waiting threads sleep in slices so they can still help with jobs that are
+// queued while they sleep.
+static const njs64 gc_job_wait_slice_ns = 1000000;
+
+struct nj_job_t {
+  nj_job_func_t func;
+  void* args;
+  nj_job_counter_t* counter;
+};
+
+// Chase-Lev deque. The owner pushes and pops at |bottom|, thieves steal at
+// |top|. Jobs are stored by value: a slot can't be overwritten while a thief
+// reads it because the owner can only reuse it after |top| moved, which makes
+// the thief's CAS fail.
+struct nj_job_deque_t {
+  alignas(NJ_CACHE_LINE_SIZE) njsp top;
+  alignas(NJ_CACHE_LINE_SIZE) njsp bottom;
+  alignas(NJ_CACHE_LINE_SIZE) nj_job_t* jobs;
+  njsp mask;
+};
+
+struct nj_job_fiber_t {
+  nj_fiber_t fiber;
+  nj_job_t job;
+  nj_linear_allocator_t<> scratch;
+
+  nj_job_fiber_t() : scratch("job_scratch_allocator") {}
+};
+
+struct nj_job_worker_t {
+  nj_job_deque_t deque;
+  nj_thread_t thread;
+  // The worker thread's own context, fibers switch back to it when they finish
+  // or get suspended.
+  nj_fiber_t thread_fiber;
+  // The fiber running on this worker.
+  nj_job_fiber_t* current_fiber;
+  // Set by a fiber right before it switches back to |thread_fiber|. They're
+  // handled after the switch because until then the fiber's stack is in use
+  // and another worker mustn't resume it.
+  nj_job_fiber_t* finished_fiber;
+  nj_job_fiber_t* waiting_fiber;
+  nj_job_counter_t* waiting_counter;
+  bool is_started;
+  nju32 rng;
+  int index;
+};
+
+struct nj_job_waiting_fiber_t {
+  nj_job_fiber_t* fiber;
+  nj_job_counter_t* counter;
+};
+
+struct nj_job_system_t {
+  nj_allocator_t* allocator;
+  nj_job_worker_t* workers;
+  int worker_count;
+  bool is_quitting;
+  nj_mpmc_queue_t<nj_job_t> injected_jobs;
+  nj_queue_signal_t work_signal;
+
+  bool use_fibers;
+  nj_job_fiber_t* fibers;
+  int fiber_count;
+  nj_mpmc_queue_t<nj_job_fiber_t*> free_fibers;
+  // Fibers whose counter reached 0.
+  nj_mpmc_queue_t<nj_job_fiber_t*> ready_fibers;
+  // Suspended fibers, protected by |waiting_mutex|.
+  nj_job_waiting_fiber_t* waiting_fibers;
+  int waiting_fiber_count;
+  nj_mutex_t waiting_mutex;
+};
+
+static nj_job_system_t g_job_system;
+static thread_local nj_job_worker_t* t_worker = NULL;
+static thread_local nju32 t_rng = 0x9e3779b9;
+
+// Code that runs on a fiber may continue on another thread after a switch, so
+// it must not reuse a thread local address the compiler computed before.
+static NJ_NOINLINE nj_job_worker_t* job_get_worker() {
+  return t_worker;
+}
+
+static bool job_deque_push(nj_job_deque_t* deque, const nj_job_t& job) {
+  njsp bottom = nj_atomic_load(&deque->bottom, NJ_MEMORY_ORDER_RELAXED);
+  njsp top = nj_atomic_load(&deque->top, NJ_MEMORY_ORDER_ACQUIRE);
+  if (bottom - top > deque->mask)
+    return false;
+  deque->jobs[bottom & deque->mask] = job;
+  nj_atomic_store(&deque->bottom, bottom + 1, NJ_MEMORY_ORDER_RELEASE);
+  return true;
+}
+
+static bool job_deque_pop(nj_job_deque_t* deque, nj_job_t* job) {
+  njsp bottom = nj_atomic_load(&deque->bottom, NJ_MEMORY_ORDER_RELAXED) - 1;
+  nj_atomic_store(&deque->bottom, bottom, NJ_MEMORY_ORDER_RELAXED);
+  nj_atomic_fence();
+  njsp top = nj_atomic_load(&deque->top, NJ_MEMORY_ORDER_RELAXED);
+  if (top > bottom) {
+    nj_atomic_store(&deque->bottom, bottom + 1, NJ_MEMORY_ORDER_RELAXED);
+    return false;
+  }
+  *job = deque->jobs[bottom & deque->mask];
+  if (top == bottom) {
+    // Last job, race against the thieves.
+    bool is_won = nj_atomic_cas(&deque->top, &top, top + 1);
+    nj_atomic_store(&deque->bottom, bottom + 1, NJ_MEMORY_ORDER_RELAXED);
+    return is_won;
+  }
+  return true;
+}
+
+static bool job_deque_steal(nj_job_deque_t* deque, nj_job_t* job) {
+  njsp top = nj_atomic_load(&deque->top, NJ_MEMORY_ORDER_ACQUIRE);
+  nj_atomic_fence();
+  njsp bottom = nj_atomic_load(&deque->bottom, NJ_MEMORY_ORDER_ACQUIRE);
+  if (top >= bottom)
+    return false;
+  memcpy(job, &deque->jobs[top & deque->mask], sizeof(nj_job_t));
+  return nj_atomic_cas(&deque->top, &top, top + 1);
+}
+
+static nju32 job_next_rng(nju32* rng) {
+  nju32 x = *rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *rng = x;
+  return x;
+}
+
+static bool job_get(nj_job_t* job) {
+  nj_job_worker_t* worker = job_get_worker();
+  if (worker && job_deque_pop(&worker->deque, job))
+    return true;
+  if (nj_mpmc_pop(&g_job_system.injected_jobs, job))
+    return true;
+  int worker_count = g_job_system.worker_count;
+  nju32* rng = worker ? &worker->rng : &t_rng;
+  int start = job_next_rng(rng) % worker_count;
+  for (int i = 0; i < worker_count; ++i) {
+    nj_job_worker_t* victim = &g_job_system.workers[(start + i) % worker_count];
+    if (victim != worker && job_deque_steal(&victim->deque, job))
+      return true;
+  }
+  return false;
+}
+
+static void job_make_ready(nj_job_fiber_t* fiber) {
+  // Can't fail, the queue can hold all the fibers.
+  nj_mpmc_push(&g_job_system.ready_fibers, fiber);
+}
+
+// Called on the thread fiber after |fiber| switched out of nj_job_wait().
+static void job_park_fiber(nj_job_fiber_t* fiber, nj_job_counter_t* counter) {
+  nj_job_system_t* js = &g_job_system;
+  nj_mutex_lock(&js->waiting_mutex);
+  nju32 value = nj_atomic_fetch_or(&counter->value, NJ_JOB_COUNTER_WAITING_BIT);
+  if (value & ~NJ_JOB_COUNTER_WAITING_BIT)
+    js->waiting_fibers[js->waiting_fiber_count++] = {fiber, counter};
+  else
+    job_make_ready(fiber);
+  nj_mutex_unlock(&js->waiting_mutex);
+  nj_queue_signal_notify(&js->work_signal);
+}
+
+// The address is only compared. If a new counter reuses it, its waiters wake
+// up too early and go back to sleep.
+static void job_wake_fibers(nj_job_counter_t* counter) {
+  nj_job_system_t* js = &g_job_system;
+  bool is_woken = false;
+  nj_mutex_lock(&js->waiting_mutex);
+  for (int i = 0; i < js->waiting_fiber_count;) {
+    if (js->waiting_fibers[i].counter == counter) {
+      job_make_ready(js->waiting_fibers[i].fiber);
+      js->waiting_fibers[i] = js->waiting_fibers[--js->waiting_fiber_count];
+      is_woken = true;
+    } else {
+      ++i;
+    }
+  }
+  nj_mutex_unlock(&js->waiting_mutex);
+  if (is_woken)
+    nj_queue_signal_notify(&js->work_signal);
+}
+
+static void job_execute(const nj_job_t* job) {
+  job->func(job->args);
+  nj_job_counter_t* counter = job->counter;
+  if (counter && nj_atomic_fetch_sub(&counter->value, 1u) == (NJ_JOB_COUNTER_WAITING_BIT | 1)) {
+    nj_futex_wake_all(&counter->value);
+    if (g_job_system.use_fibers)
+      job_wake_fibers(counter);
+  }
+}
+
+static void job_fiber_main(void* args) {
+  nj_job_fiber_t* fiber = (nj_job_fiber_t*)args;
+  for (;;) {
+    job_execute(&fiber->job);
+    nj_job_worker_t* worker = job_get_worker();
+    worker->finished_fiber = fiber;
+    nj_fiber_switch(&fiber->fiber, &worker->thread_fiber);
+  }
+}
+
+// Must be called on |worker|'s thread fiber.
+static void job_run_fiber(nj_job_worker_t* worker, nj_job_fiber_t* fiber) {
+  worker->current_fiber = fiber;
+  nj_fiber_switch(&worker->thread_fiber, &fiber->fiber);
+  worker->current_fiber = NULL;
+  if (worker->finished_fiber) {
+    nj_job_fiber_t* finished_fiber = worker->finished_fiber;
+    worker->finished_fiber = NULL;
+    finished_fiber->scratch.destroy();
+    finished_fiber->scratch.init();
+    nj_mpmc_push(&g_job_system.free_fibers, finished_fiber);
+  }
+  if (worker->waiting_fiber) {
+    nj_job_fiber_t* waiting_fiber = worker->waiting_fiber;
+    worker->waiting_fiber = NULL;
+    job_park_fiber(waiting_fiber, worker->waiting_counter);
+  }
+}
+
+static bool job_try_run_one() {
+  nj_job_worker_t* worker = job_get_worker();
+  bool can_use_fibers = g_job_system.use_fibers && worker && !worker->current_fiber;
+  nj_job_fiber_t* fiber;
+  if (can_use_fibers && nj_mpmc_pop(&g_job_system.ready_fibers, &fiber)) {
+    job_run_fiber(worker, fiber);
+    return true;
+  }
+  nj_job_t job;
+  if (!job_get(&job))
+    return false;
+  if (can_use_fibers && nj_mpmc_pop(&g_job_system.free_fibers, &fiber)) {
+    fiber->job = job;
+    job_run_fiber(worker, fiber);
+  } else {
+    job_execute(&job);
+  }
+  return true;
+}
+
+static void job_worker_main(void* args) {
+  t_worker = (nj_job_worker_t*)args;
+  if (g_job_system.use_fibers)
+    nj_fiber_init_from_thread(&t_worker->thread_fiber);
+  while (!nj_atomic_load(&g_job_system.is_quitting, NJ_MEMORY_ORDER_RELAXED)) {
+    bool is_ran = false;
+    for (int i = 0; i < gc_job_spin_count && !is_ran; ++i) {
+      is_ran = job_try_run_one();
+      if (!is_ran)
+        nj_cpu_relax();
+    }
+    if (is_ran)
+      continue;
+    nju32 seq = nj_queue_signal_prepare_wait(&g_job_system.work_signal);
+    if (job_try_run_one() || nj_atomic_load(&g_job_system.is_quitting)) {
+      nj_queue_signal_cancel_wait(&g_job_system.work_signal);
+      continue;
+    }
+    nj_queue_signal_wait(&g_job_system.work_signal, seq, -1);
+  }
+  if (g_job_system.use_fibers)
+    nj_fiber_destroy_from_thread(&t_worker->thread_fiber);
+}
+
+// |js->fiber_count| only counts the fibers that are fully initialized so
+// job_free() can undo a partial init.
+static bool job_init_fibers(nj_job_system_t* js, const nj_job_system_desc_t* desc) {
+  nj_allocator_t* allocator = js->allocator;
+  NJ_CHECK_RETURN_VAL(nj_mpmc_init(&js->free_fibers, allocator, desc->fiber_count), false);
+  NJ_CHECK_RETURN_VAL(nj_mpmc_init(&js->ready_fibers, allocator, desc->fiber_count), false);
+  js->waiting_fibers = (nj_job_waiting_fiber_t*)allocator->alloc(desc->fiber_count * sizeof(nj_job_waiting_fiber_t));
+  NJ_CHECK_LOG_RETURN_VAL(js->waiting_fibers, false, "Can't allocate the waiting fibers");
+  nj_mutex_init(&js->waiting_mutex);
+  js->fibers = (nj_job_fiber_t*)allocator->alloc(desc->fiber_count * sizeof(nj_job_fiber_t));
+  NJ_CHECK_LOG_RETURN_VAL(js->fibers, false, "Can't allocate the fibers");
+  for (int i = 0; i < desc->fiber_count; ++i) {
+    nj_job_fiber_t* fiber = new (&js->fibers[i]) nj_job_fiber_t();
+    fiber->scratch.init();
+    if (!nj_fiber_init(&fiber->fiber, desc->fiber_stack_size, job_fiber_main, fiber)) {
+      fiber->scratch.destroy();
+      return false;
+    }
+    ++js->fiber_count;
+    nj_mpmc_push(&js->free_fibers, fiber);
+  }
+  NJ_CHECK_RETURN_VAL(nj_fiber_init_from_thread(&js->workers[0].thread_fiber), false);
+  js->use_fibers = true;
+  return true;
+}
+
+static bool job_init(nj_job_system_t* js, const nj_job_system_desc_t* desc, int worker_count) {
+  nj_allocator_t* allocator = js->allocator;
+  NJ_CHECK_RETURN_VAL(nj_mpmc_init(&js->injected_jobs, allocator, gc_job_injected_capacity), false);
+  js->workers = (nj_job_worker_t*)allocator->aligned_alloc(worker_count * sizeof(nj_job_worker_t), NJ_CACHE_LINE_SIZE);
+  NJ_CHECK_LOG_RETURN_VAL(js->workers, false, "Can't allocate the job workers");
+  memset(js->workers, 0, worker_count * sizeof(nj_job_worker_t));
+  js->worker_count = worker_count;
+  for (int i = 0; i < worker_count; ++i) {
+    nj_job_worker_t* worker = &js->workers[i];
+    worker->deque.jobs = (nj_job_t*)allocator->alloc(gc_job_deque_capacity * sizeof(nj_job_t));
+    NJ_CHECK_LOG_RETURN_VAL(worker->deque.jobs, false, "Can't allocate a job deque");
+    worker->deque.mask = gc_job_deque_capacity - 1;
+    worker->rng = 0x9e3779b9 * (i + 1);
+    worker->index = i;
+  }
+  return !desc->use_fibers || job_init_fibers(js, desc);
+}
+
+// Frees what job_init() allocated, the workers' threads must be stopped. It
+// also undoes a partial init.
+static void job_free(nj_job_system_t* js) {
+  nj_allocator_t* allocator = js->allocator;
+  NJ_CHECK_LOG(js->waiting_fiber_count == 0, "%d jobs are still waiting", js->waiting_fiber_count);
+  if (js->use_fibers)
+    nj_fiber_destroy_from_thread(&js->workers[0].thread_fiber);
+  for (int i = 0; i < js->fiber_count; ++i) {
+    nj_fiber_destroy(&js->fibers[i].fiber);
+    js->fibers[i].scratch.destroy();
+  }
+  if (js->fibers)
+    allocator->free(js->fibers);
+  if (js->waiting_fibers)
+    allocator->free(js->waiting_fibers);
+  if (js->ready_fibers.cells)
+    nj_mpmc_destroy(&js->ready_fibers);
+  if (js->free_fibers.cells)
+    nj_mpmc_destroy(&js->free_fibers);
+  for (int i = 0; i < js->worker_count; ++i) {
+    if (js->workers[i].deque.jobs)
+      allocator->free(js->workers[i].deque.jobs);
+  }
+  if (js->workers)
+    allocator->free(js->workers);
+  if (js->injected_jobs.cells)
+    nj_mpmc_destroy(&js->injected_jobs);
+  js->use_fibers = false;
+  js->fibers = NULL;
+  js->fiber_count = 0;
+  js->waiting_fibers = NULL;
+  js->waiting_fiber_count = 0;
+  js->workers = NULL;
+  js->worker_count = 0;
+}
+
+bool nj_job_system_init(nj_allocator_t* allocator, const nj_job_system_desc_t* desc) {
+  NJ_CHECK_LOG_RETURN_VAL(!g_job_system.workers, false, "The job system is already initialized");
+  nj_job_system_desc_t default_desc;
+  if (!desc)
+    desc = &default_desc;
+  int worker_count = desc->worker_count;
+  if (worker_count <= 0)
+    worker_count = nj_thread_get_nums();
+  if (worker_count <= 0)
+    worker_count = 1;
+  nj_job_system_t* js = &g_job_system;
+  js->allocator = allocator;
+  js->is_quitting = false;
+  js->work_signal = {};
+  if (!job_init(js, desc, worker_count)) {
+    job_free(js);
+    return false;
+  }
+  t_worker = &js->workers[0];
+  nj_cpu_topology_t topology;
+  bool is_pinning = desc->pin_workers && nj_cpu_get_topology(&topology) && topology.physical_core_count > 1;
+  // The deque of a worker that failed to start stays empty.
+  for (int i = 1; i < worker_count; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "nj_job_%d", i);
+    nj_cpu_set_t affinity;
+    nj_thread_desc_t thread_desc;
+    thread_desc.name = name;
+    if (is_pinning) {
+      nj_cpu_get_group_set(&topology, NJ_CPU_GROUP_PHYSICAL_CORE, i % topology.physical_core_count, &affinity);
+      thread_desc.affinity = &affinity;
+    }
+    js->workers[i].is_started = nj_thread_init(&js->workers[i].thread, job_worker_main, &js->workers[i], &thread_desc);
+  }
+  return true;
+}
+
+void nj_job_system_destroy() {
+  nj_job_system_t* js = &g_job_system;
+  if (!js->workers)
+    return;
+  // Finish the queued jobs first.
+  while (job_try_run_one()) {
+  }
+  nj_atomic_store(&js->is_quitting, true);
+  nj_atomic_fetch_add(&js->work_signal.seq, 1u);
+  nj_futex_wake_all(&js->work_signal.seq);
+  for (int i = 1; i < js->worker_count; ++i) {
+    if (js->workers[i].is_started)
+      nj_thread_wait_for(&js->workers[i].thread);
+  }
+  job_free(js);
+  t_worker = NULL;
+}
+
+int nj_job_get_worker_count() {
+  return g_job_system.worker_count ? g_job_system.worker_count : 1;
+}
+
+int nj_job_get_worker_index() {
+  nj_job_worker_t* worker = job_get_worker();
+  return worker ? worker->index : -1;
+}
+
+void nj_job_run(const nj_job_desc_t* descs, int count, nj_job_counter_t* counter) {
+  if (counter)
+    nj_atomic_fetch_add(&counter->value, (nju32)count);
+  nj_job_worker_t* worker = job_get_worker();
+  for (int i = 0; i < count; ++i) {
+    nj_job_t job = {descs[i].func, descs[i].args, counter};
+    if (!g_job_system.workers) {
+      job_execute(&job);
+      continue;
+    }
+    if (worker && job_deque_push(&worker->deque, job))
+      continue;
+    if (nj_mpmc_push(&g_job_system.injected_jobs, job))
+      continue;
+    // Everything is full, run it now rather than blocking.
+    job_execute(&job);
+  }
+  if (g_job_system.workers)
+    nj_queue_signal_notify(&g_job_system.work_signal);
+}
+
+void nj_job_wait(nj_job_counter_t* counter) {
+  nj_job_worker_t* worker = job_get_worker();
+  if (worker && worker->current_fiber) {
+    // Suspend, job_park_fiber() puts the fiber back in the ready queue once
+    // |counter| reaches 0.
+    while (!nj_job_is_done(counter)) {
+      nj_job_fiber_t* fiber = worker->current_fiber;
+      worker->waiting_fiber = fiber;
+      worker->waiting_counter = counter;
+      nj_fiber_switch(&fiber->fiber, &worker->thread_fiber);
+      worker = job_get_worker();
+    }
+  } else {
+    int idle_count = 0;
+    while (!nj_job_is_done(counter)) {
+      if (g_job_system.workers && job_try_run_one()) {
+        idle_count = 0;
+        continue;
+      }
+      if (++idle_count < gc_job_spin_count) {
+        nj_cpu_relax();
+        continue;
+      }
+      nju32 value = nj_atomic_fetch_or(&counter->value, NJ_JOB_COUNTER_WAITING_BIT) | NJ_JOB_COUNTER_WAITING_BIT;
+      if (value != NJ_JOB_COUNTER_WAITING_BIT)
+        nj_futex_wait(&counter->value, value, gc_job_wait_slice_ns);
+      idle_count = 0;
+    }
+  }
+  nj_atomic_fetch_and(&counter->value, ~NJ_JOB_COUNTER_WAITING_BIT);
+}
+
+bool nj_job_is_done(const nj_job_counter_t* counter) {
+  return (nj_atomic_load(&counter->value, NJ_MEMORY_ORDER_ACQUIRE) & ~NJ_JOB_COUNTER_WAITING_BIT) == 0;
+}
+
+nj_allocator_t* nj_job_get_scratch_allocator() {
+  nj_job_worker_t* worker = job_get_worker();
+  if (!worker || !worker->current_fiber)
+    return NULL;
+  return &worker->current_fiber->scratch;
+}
@@ -0,0 +1,71 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_JOB_H
+#define NJ_CORE_JOB_H
+
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+
+typedef void (*nj_job_func_t)(void* args);
+
+struct nj_job_desc_t {
+  nj_job_func_t func;
+  void* args;
+};
+
+#define NJ_JOB_COUNTER_WAITING_BIT (0x80000000u)
+
+// Number of jobs that haven't finished, plus NJ_JOB_COUNTER_WAITING_BIT while
+// a thread sleeps on it. Keeping both in one word lets the last job decide to
+// wake without touching the counter again, so a counter on the waiter's stack
+// can go away as soon as the wait returns. Must be zero-initialized.
+struct nj_job_counter_t {
+  nju32 value;
+};
+
+struct nj_job_system_desc_t {
+  // nj_thread_get_nums() if 0.
+  int worker_count = 0;
+  // Run jobs on fibers so a job waiting in nj_job_wait() is suspended and its
+  // worker runs other jobs. The job resumes on whichever worker is free once
+  // the counter reaches 0.
+  bool use_fibers = false;
+  // Max number of jobs that can be started (running or suspended) at the same
+  // time, extra jobs run on the worker's own stack.
+  int fiber_count = 128;
+  njsp fiber_stack_size = 256 * 1024;
+  // Pin worker i to physical core i (modulo the core count) so SMT siblings
+  // don't share the pool. Worker 0 is the calling thread and isn't pinned.
+  bool pin_workers = false;
+};
+
+// The calling thread becomes worker 0, the other workers get their own thread.
+// Each worker has a fixed size work-stealing deque so running jobs doesn't
+// allocate. Until the system is initialized, jobs run inline on the calling
+// thread. |desc| can be NULL to use the defaults.
+bool nj_job_system_init(nj_allocator_t* allocator, const nj_job_system_desc_t* desc = NULL);
+// Must be called from the thread that called nj_job_system_init().
+void nj_job_system_destroy();
+int nj_job_get_worker_count();
+// Returns -1 if the calling thread isn't a worker.
+int nj_job_get_worker_index();
+
+// Queue |count| jobs, |counter| (can be NULL) is incremented by |count| and
+// decremented when each job finishes. Jobs are pushed to the calling worker's
+// deque, or to a shared queue if it isn't a worker.
+void nj_job_run(const nj_job_desc_t* descs, int count, nj_job_counter_t* counter);
+// Run other jobs until |counter| reaches 0.
+void nj_job_wait(nj_job_counter_t* counter);
+bool nj_job_is_done(const nj_job_counter_t* counter);
+
+// Scratch memory of the running job that is freed when the job finishes. It
+// follows the job when it's resumed on another worker, unlike thread local
+// memory. Returns NULL if the job doesn't run on a fiber.
+nj_allocator_t* nj_job_get_scratch_allocator();
+
+#endif // NJ_CORE_JOB_H
@@ -6,7 +6,7 @@
 
 #include "core/loader/dae.h"
 
-#include "core/file_utils.h"
+#include "core/file.h"
 #include "core/linear_allocator.h"
 #include "core/log.h"
 
@@ -160,11 +160,16 @@ nj_xml_node_t* dae_find_node(nj_xml_node_t* node, const char* name) {
 }
 
 bool nj_dae_init(nj_dae_t* dae, nj_allocator_t* allocator, const nj_os_char* path) {
-  nj_linear_allocator_t<> file_allocator("xml_file_allocator");
-  file_allocator.init();
-  nj_dynamic_array_t<nju8> buffer = nj_read_whole_file(&file_allocator, path, NULL);
-  nj_xml_node_t* root = parse_xml(allocator, (char*)buffer.p, (char*)buffer.p + nj_da_len(&buffer), NULL);
-  file_allocator.destroy();
+  nj_file_map_t map;
+  NJ_CHECK_RETURN_VAL(nj_file_map(&map, path), false);
+  bool rv = nj_dae_init(dae, allocator, map.data, map.size);
+  nj_file_unmap(&map);
+  return rv;
+}
+
+bool nj_dae_init(nj_dae_t* dae, nj_allocator_t* allocator, const nju8* data, njsp size) {
+  nj_xml_node_t* root = parse_xml(allocator, (const char*)data, (const char*)data + size, NULL);
+  NJ_CHECK_LOG_RETURN_VAL(root, false, "Can't parse the xml");
 
   nj_xml_node_t* mesh_position = dae_find_node(root, "library_geometries/geometry/mesh/source/float_array");
   int arr_len = atoi(mesh_position->attr_vals[1]);
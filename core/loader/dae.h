@@ -27,6 +27,8 @@ struct nj_dae_t {
 };
 
 bool nj_dae_init(nj_dae_t* dae, nj_allocator_t* allocator, const nj_os_char* path);
+// Parse from memory, e.g. from a nj_file_map_t.
+bool nj_dae_init(nj_dae_t* dae, nj_allocator_t* allocator, const nju8* data, njsp size);
 void nj_dae_destroy(nj_dae_t* dae);
 
 #endif // NJ_CORE_LOADER_DAE_H
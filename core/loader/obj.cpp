@@ -7,7 +7,7 @@
 #include "core/loader/obj.h"
 
 #include "core/dynamic_array.inl"
-#include "core/file_utils.h"
+#include "core/file.h"
 #include "core/linear_allocator.h"
 #include "core/log.h"
 #include "core/math/vec3.h"
@@ -15,17 +15,17 @@
 #include <ctype.h>
 #include <stdlib.h>
 
-static void skip_space(char** p) {
+static void skip_space(const char** p) {
   while (**p == ' ')
     ++(*p);
 }
 
-static void skip_till(char** p, char c) {
+static void skip_till(const char** p, char c) {
   while(**p != c)
     ++(*p);
 }
 
-static void string_to_vec(char** p, int len, float* v) {
+static void string_to_vec(const char** p, int len, float* v) {
   for (int j = 0; j < len; ++j) {
     skip_till(p, ' ');
     skip_space(p);
@@ -42,6 +42,14 @@ static inline int parse_index(int index, int len) {
 }
 
 bool nj_obj_init(nj_obj_t* obj, nj_allocator_t* allocator, const nj_os_char* path) {
+  nj_file_map_t map;
+  NJ_CHECK_RETURN_VAL(nj_file_map(&map, path), false);
+  bool rv = nj_obj_init(obj, allocator, map.data, map.size);
+  nj_file_unmap(&map);
+  return rv;
+}
+
+bool nj_obj_init(nj_obj_t* obj, nj_allocator_t* allocator, const nju8* data, njsp size) {
   nj_scoped_la_allocator_t<> temp_allocator("obj_temp_allocator");
   temp_allocator.init();
 
@@ -49,9 +57,8 @@ bool nj_obj_init(nj_obj_t* obj, nj_allocator_t* allocator, const nj_os_char* pat
   int uvs_count = 0;
   int ns_count = 0;
   int elems_count = 0;
-  nj_dynamic_array_t<nju8> f = nj_read_whole_file(&temp_allocator, path, NULL);
-  char* s = (char*)&f[0];
-  char* e = (char*)f.p + nj_da_len(&f);
+  const char* s = (const char*)data;
+  const char* e = (const char*)data + size;
   for (;;) {
     while(isspace(*s))
       ++s;
@@ -87,7 +94,7 @@ bool nj_obj_init(nj_obj_t* obj, nj_allocator_t* allocator, const nj_os_char* pat
   if (ns_count)
     nj_da_reserve(&ns, elems_count);
 
-  s = (char*)f.p;
+  s = (const char*)data;
   while (s != e) {
     while (isspace(*s))
       ++s;
@@ -21,6 +21,9 @@ struct nj_obj_t {
 };
 
 bool nj_obj_init(nj_obj_t* obj, nj_allocator_t* allocator, const nj_os_char* path);
+// Parse from memory, |data| must be followed by a zero byte like
+// nj_file_map_t::data.
+bool nj_obj_init(nj_obj_t* obj, nj_allocator_t* allocator, const nju8* data, njsp size);
 void nj_obj_destroy(nj_obj_t* obj);
 
 #endif // NJ_CORE_LOADER_OBJ_H
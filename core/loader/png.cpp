@@ -7,14 +7,18 @@
 #include "core/loader/png.h"
 
 #include "core/allocator.h"
-#include "core/bit_stream.h"
-#include "core/dynamic_array.h"
-#include "core/file_utils.h"
+#include "core/atomic.h"
+#include "core/deflate.h"
+#include "core/file.h"
+#include "core/inflate.h"
 #include "core/linear_allocator.h"
+#include "core/loader/png_unfilter.h"
 #include "core/log.h"
 #include "core/os.h"
+#include "core/parallel.inl"
+#include "core/utils.h"
 
-#include <stdlib.h>
+#include <string.h>
 
 #if NJ_OS_WIN()
 #  define bswap32(x) _byteswap_ulong(x)
@@ -25,333 +29,291 @@
 
 #define FOURCC(cc) (cc[0] | cc[1] << 8 | cc[2] << 16 | cc[3] << 24)
 
-// From 0 - 15
-static const int gc_max_code_len = 16;
-static const int gc_max_code = 286 + 30;
 static const int gc_png_sig_len = 8;
 
 static const nju8 gc_png_signature[gc_png_sig_len] = {137, 80, 78, 71, 13, 10, 26, 10};
 
-static const int gc_len_bases[] = {3,  4,  5,  6,   7,   8,   9,   10,  11, 13,
-                                   15, 17, 19, 23,  27,  31,  35,  43,  51, 59,
-                                   67, 83, 99, 115, 131, 163, 195, 227, 258};
-
-static const int gc_len_extra_bits[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
-                                        1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
-                                        4, 4, 4, 4, 5, 5, 5, 5, 0};
-
-static const int gc_dist_bases[] = {
-    1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
-    33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
-    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
-
-static const int gc_dist_extra_bits[] = {0, 0, 0,  0,  1,  1,  2,  2,  3,  3,
-                                         4, 4, 5,  5,  6,  6,  7,  7,  8,  8,
-                                         9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
-
-// Structure saves codes of specific length.
-// |codes| contains codes of that length.
-// |min| is the smallest codes of that length.
-// |count| is the number of codes.
-struct codes_for_len_t {
-  nju16 codes[gc_max_code];
-  nju16 min;
-  nju16 count;
-};
+static nj_png_stats_t g_png_stats;
 
-// |cfl| is a pointer to array of where the index is the length and value is the
-// codes for that length.
-struct alphabet_t {
-  codes_for_len_t* cfl;
-  nju8 min_len;
-  nju8 max_len;
+// Where the image data is in a PNG file.
+struct png_stream_t {
+  const nju8* data;
+  njsp size;
+  // Offset of the chunk after IHDR.
+  njsp chunks_offset;
+  // Size of the data of all the IDAT chunks.
+  njsp idat_size;
+  int segment_count;
+  nj_png_segment_t segments[NJ_PNG_MAX_SEGMENTS];
 };
 
-// Build an alphabet based on lengths of  codes from 0 to |num| - 1.
-static void build_alphabet(nju8* lens, int num, alphabet_t* alphabet) {
-  nju8 len_counts[gc_max_code_len] = {};
-  for (int i = 0; i < num; ++i) {
-    if (lens[i]) {
-      alphabet->cfl[lens[i]].codes[len_counts[lens[i]]] = i;
-      len_counts[lens[i]]++;
-    }
+static nju32 png_read_u32(const nju8* p) {
+  nju32 v;
+  memcpy(&v, p, sizeof(v));
+  return bswap32(v);
+}
+
+// Calls |func|(type, data, size) for each chunk after IHDR until IEND or
+// until it returns false.
+template <typename Func>
+static bool png_for_each_chunk(const png_stream_t* stream, Func func) {
+  for (njsp i = stream->chunks_offset; i + 12 <= stream->size;) {
+    nju32 data_len = png_read_u32(stream->data + i);
+    NJ_CHECK_LOG_RETURN_VAL((njsp)data_len <= stream->size - i - 12, false, "Truncated PNG chunk");
+    nju32 chunk_type;
+    memcpy(&chunk_type, stream->data + i + 4, sizeof(chunk_type));
+    const nju8* p = stream->data + i + 8;
+    i += 12 + data_len;
+    if (chunk_type == FOURCC("IEND"))
+      return true;
+    if (!func(chunk_type, p, data_len))
+      return false;
   }
-  for (int i = 0; i < gc_max_code_len; ++i) {
-    if (len_counts[i]) {
-      alphabet->min_len = i;
-      break;
-    }
+  return true;
+}
+
+static bool png_read_ihdr(nj_png_t* png, const nju8* p, nju32 data_len) {
+  NJ_CHECK_RETURN_VAL(data_len == 13, false);
+  png->width = png_read_u32(p);
+  p += 4;
+  png->height = png_read_u32(p);
+  p += 4;
+  png->bit_depth = *p++;
+  png->color_type = (nj_png_color_type_t)*p++;
+  NJ_CHECK_LOG_RETURN_VAL(png->width && png->height, false, "Empty PNG image");
+  NJ_CHECK_LOG_RETURN_VAL(png->bit_depth == 1 || png->bit_depth == 2 || png->bit_depth == 4 || png->bit_depth == 8 || png->bit_depth == 16, false, "Invalid bit depth");
+  int channel_count = 0;
+  switch (png->color_type) {
+  case NJ_PNG_COLOR_TYPE_GRAY:
+    channel_count = 1;
+    break;
+  case NJ_PNG_COLOR_TYPE_RGB:
+    channel_count = 3;
+    break;
+  case NJ_PNG_COLOR_TYPE_PALETTE:
+    channel_count = 1;
+    break;
+  case NJ_PNG_COLOR_TYPE_GRAY_ALPHA:
+    channel_count = 2;
+    break;
+  case NJ_PNG_COLOR_TYPE_RGBA:
+    channel_count = 4;
+    break;
+  default:
+    NJ_LOGF_RETURN_VAL(false, "Invalid color type");
   }
-  for (nju8 i = gc_max_code_len - 1; i > 0; ++i) {
-    if (len_counts[i]) {
-      alphabet->max_len = i;
-      break;
-    }
+  // Palette indices are at most 8 bits, only gray has less than 8 bits per
+  // channel otherwise.
+  bool is_valid_depth = png->color_type == NJ_PNG_COLOR_TYPE_PALETTE ? png->bit_depth <= 8 : png->color_type == NJ_PNG_COLOR_TYPE_GRAY || png->bit_depth >= 8;
+  NJ_CHECK_LOG_RETURN_VAL(is_valid_depth, false, "Invalid bit depth for the color type");
+  png->bit_per_pixel = channel_count * png->bit_depth;
+  png->row_size = ((njsp)png->width * png->bit_per_pixel + 7) / 8;
+  nju8 compression_method = *p++;
+  NJ_CHECK_LOG_RETURN_VAL(!compression_method, false, "Invalid compression method");
+  nju8 filter_method = *p++;
+  NJ_CHECK_LOG_RETURN_VAL(!filter_method, false, "Invalid filter method");
+  const nju8 interlace_method = *p++;
+  NJ_CHECK_LOG_RETURN_VAL(!interlace_method, false, "Invalid interlace method");
+  return true;
+}
+
+// Segments that don't make sense are ignored, the image is decoded serially
+// then.
+static void png_read_segments(const nj_png_t* png, png_stream_t* stream, const nju8* p, nju32 data_len) {
+  if (data_len < 4)
+    return;
+  nju32 count = png_read_u32(p);
+  if (count < 2 || count > NJ_PNG_MAX_SEGMENTS || data_len != 4 + (count - 1) * 8)
+    return;
+  nju32 prev_row = 0;
+  nju32 prev_offset = 0;
+  for (nju32 i = 1; i < count; ++i) {
+    nj_png_segment_t* segment = &stream->segments[i];
+    segment->row = png_read_u32(p + 4 + (i - 1) * 8);
+    segment->offset = png_read_u32(p + 8 + (i - 1) * 8);
+    if (segment->row <= prev_row || segment->row >= png->height || segment->offset <= prev_offset)
+      return;
+    prev_row = segment->row;
+    prev_offset = segment->offset;
   }
-  int smallest_code = 0;
-  int last_non_zero_count = 0;
-  for (nju8 i = 0; i < 16; ++i) {
-    if (len_counts[i]) {
-      smallest_code = (smallest_code + last_non_zero_count) << 1;
-      alphabet->cfl[i].min = smallest_code;
-      alphabet->cfl[i].count = len_counts[i];
-      last_non_zero_count = len_counts[i];
+  stream->segments[0] = {0, 0};
+  stream->segment_count = count;
+}
+
+static bool png_read_stream(nj_png_t* png, const nju8* data, njsp size, png_stream_t* stream) {
+  NJ_CHECK_LOG_RETURN_VAL(size >= gc_png_sig_len && !memcmp(data, &gc_png_signature[0], gc_png_sig_len), false, "Invalid PNG signature");
+  NJ_CHECK_LOG_RETURN_VAL(size >= gc_png_sig_len + 12 + 13 && png_read_u32(data + gc_png_sig_len) == 13 && !memcmp(data + gc_png_sig_len + 4, "IHDR", 4), false, "PNG doesn't start with IHDR");
+  NJ_CHECK_RETURN_VAL(png_read_ihdr(png, data + gc_png_sig_len + 8, 13), false);
+  stream->data = data;
+  stream->size = size;
+  stream->chunks_offset = gc_png_sig_len + 12 + 13;
+  stream->idat_size = 0;
+  stream->segment_count = 0;
+  const nju8* segment_data = NULL;
+  nju32 segment_data_len = 0;
+  bool rv = png_for_each_chunk(stream, [&](nju32 chunk_type, const nju8* p, nju32 data_len) {
+    if (chunk_type == FOURCC("IDAT")) {
+      stream->idat_size += data_len;
+    } else if (chunk_type == FOURCC("njSG")) {
+      segment_data = p;
+      segment_data_len = data_len;
     }
+    return true;
+  });
+  NJ_CHECK_RETURN_VAL(rv, false);
+  if (segment_data) {
+    png_read_segments(png, stream, segment_data, segment_data_len);
+    if (stream->segment_count && stream->segments[stream->segment_count - 1].offset >= stream->idat_size)
+      stream->segment_count = 0;
   }
+  return true;
+}
+
+static njsp png_get_deflated_size(const nj_png_t* png, nju32 row_count) {
+  // Each row starts with its filter method.
+  return (png->row_size + 1) * row_count;
 }
 
-static int decode(nj_bit_stream_t* bs, const alphabet_t* c_alphabet) {
-  int code = nj_bs_consume_msb(bs, c_alphabet->min_len);
-  for (nju8 i = c_alphabet->min_len; i <= c_alphabet->max_len; ++i) {
-    int delta_to_min = code - c_alphabet->cfl[i].min;
-    if (delta_to_min < c_alphabet->cfl[i].count) {
-      return c_alphabet->cfl[i].codes[delta_to_min];
+static bool png_inflate_serial(const nj_png_t* png, const png_stream_t* stream, nju8* deflated_data) {
+  njsp deflated_size = png_get_deflated_size(png, png->height);
+  nj_inflate_t inflate;
+  nj_inflate_init(&inflate, NJ_INFLATE_FORMAT_ZLIB, deflated_data, deflated_size);
+  bool is_inflated = false;
+  bool rv = png_for_each_chunk(stream, [&](nju32 chunk_type, const nju8* p, nju32 data_len) {
+    // The zlib stream is split across the IDAT chunks.
+    if (chunk_type != FOURCC("IDAT") || is_inflated)
+      return true;
+    nj_inflate_status_t status = nj_inflate_decode(&inflate, p, data_len, NULL);
+    NJ_CHECK_LOG_RETURN_VAL(status != NJ_INFLATE_STATUS_ERROR && status != NJ_INFLATE_STATUS_OUTPUT_FULL, false, "Invalid PNG image data");
+    is_inflated = status == NJ_INFLATE_STATUS_DONE;
+    return true;
+  });
+  NJ_CHECK_RETURN_VAL(rv, false);
+  NJ_CHECK_LOG_RETURN_VAL(is_inflated && inflate.window_len == deflated_size, false, "Incomplete PNG image data");
+  return true;
+}
+
+// Each segment is inflated by a job into its rows. The segments after the
+// first are raw deflate, the Adler-32 of each one is combined and checked
+// against the zlib trailer after the last. A match that reaches into the
+// previous segment is an invalid distance so a file whose segments aren't
+// independent fails and is decoded serially.
+static bool png_inflate_segments(const nj_png_t* png, const png_stream_t* stream, nju8* deflated_data, nj_allocator_t* temp_allocator) {
+  nju8* idat = (nju8*)temp_allocator->alloc(stream->idat_size);
+  NJ_CHECK_LOG_RETURN_VAL(idat, false, "Can't allocate the PNG image data");
+  njsp idat_len = 0;
+  png_for_each_chunk(stream, [&](nju32 chunk_type, const nju8* p, nju32 data_len) {
+    if (chunk_type == FOURCC("IDAT")) {
+      memcpy(idat + idat_len, p, data_len);
+      idat_len += data_len;
     }
-    code = code << 1 | nj_bs_consume_msb(bs, 1);
+    return true;
+  });
+  bool is_ok[NJ_PNG_MAX_SEGMENTS];
+  nju32 adlers[NJ_PNG_MAX_SEGMENTS];
+  njsp window_sizes[NJ_PNG_MAX_SEGMENTS];
+  // Where the trailer is, after the end of the last segment.
+  njsp trailer_offset = idat_len;
+  int count = stream->segment_count;
+  nj_parallel_run_chunks(count, [&](njsp i) {
+    const nj_png_segment_t* segment = &stream->segments[i];
+    nju32 end_row = i + 1 < count ? stream->segments[i + 1].row : png->height;
+    nju8* window = deflated_data + png_get_deflated_size(png, segment->row);
+    window_sizes[i] = png_get_deflated_size(png, end_row - segment->row);
+    nj_inflate_t inflate;
+    nj_inflate_init(&inflate, i ? NJ_INFLATE_FORMAT_RAW : NJ_INFLATE_FORMAT_ZLIB, window, window_sizes[i]);
+    // A failing segment is reported once below.
+    inflate.is_quiet = true;
+    njsp in_used = 0;
+    nj_inflate_status_t status = nj_inflate_decode(&inflate, idat + segment->offset, idat_len - segment->offset, &in_used);
+    // The window is full when the next segment starts.
+    is_ok[i] = (status == NJ_INFLATE_STATUS_DONE || status == NJ_INFLATE_STATUS_OUTPUT_FULL) && inflate.window_len == window_sizes[i];
+    if (is_ok[i])
+      adlers[i] = nj_adler32(1, window, window_sizes[i]);
+    if (i == count - 1)
+      trailer_offset = segment->offset + in_used;
+  });
+  for (int i = 0; i < count; ++i) {
+    if (!is_ok[i]) {
+      NJ_LOGW("PNG segment %d isn't independent, decoding serially", i);
+      return false;
+    }
+  }
+  nju32 adler = adlers[0];
+  for (int i = 1; i < count; ++i)
+    adler = nj_adler32_combine(adler, adlers[i], window_sizes[i]);
+  if (idat_len - trailer_offset < 4 || png_read_u32(idat + trailer_offset) != adler) {
+    NJ_LOGW("PNG segments don't match the Adler-32, decoding serially");
+    return false;
   }
-  NJ_LOGF("Can't decode");
-  return -1;
+  return true;
 }
 
-static void decode_len_and_dist(int len_code, nj_bit_stream_t* bs, const alphabet_t* c_dist_alphabet, nju8** o_deflated) {
-  int len_idx = len_code % 257;
-  int len_base = gc_len_bases[len_idx];
-  int len_extra_bits = gc_len_extra_bits[len_idx];
-  int len = len_base + nj_bs_consume_lsb(bs, len_extra_bits);
-  int dist_idx = c_dist_alphabet ? decode(bs, c_dist_alphabet) : nj_bs_consume_lsb(bs, 5);
-  int dist_base = gc_dist_bases[dist_idx];
-  int dist_extra_bits = gc_dist_extra_bits[dist_idx];
-  int dist = dist_base + nj_bs_consume_lsb(bs, dist_extra_bits);
-  nju8* copy = *o_deflated - dist;
-  for (int i = 0; i < len; ++i)
-    *(*o_deflated)++ = *copy++;
+static bool png_unfilter(const nj_png_t* png, const nju8* deflated_data, const nju8* zero_row, nju8* dst, njsp dst_row_pitch) {
+  nj_png_unfilter_t unfilter;
+  NJ_CHECK_RETURN_VAL(nj_png_unfilter_init(&unfilter, nj_max(png->bit_per_pixel / 8, 1u), NULL), false);
+  // The row above the first one is 0.
+  const nju8* prev = zero_row;
+  for (nju32 r = 0; r < png->height; ++r) {
+    const nju8* src = deflated_data + r * (png->row_size + 1);
+    nju8* row = dst + r * dst_row_pitch;
+    NJ_CHECK_RETURN_VAL(nj_png_unfilter_row(&unfilter, src[0], row, src + 1, prev, png->row_size), false);
+    prev = row;
+  }
+  return true;
 }
 
-static int paeth(int a, int b, int c) {
-  int p = a + b - c;
-  int pa = abs(p - a);
-  int pb = abs(p - b);
-  int pc = abs(p - c);
-  if (pa <= pb && pa <= pc)
-    return a;
-  else if (pb <= pc)
-    return b;
-  return c;
+void nj_png_stats_take(nj_png_stats_t* out) {
+  out->segmented_count = nj_atomic_exchange(&g_png_stats.segmented_count, (nju64)0, NJ_MEMORY_ORDER_RELAXED);
+  out->fallback_count = nj_atomic_exchange(&g_png_stats.fallback_count, (nju64)0, NJ_MEMORY_ORDER_RELAXED);
 }
 
-bool nj_png_init(nj_png_t* png, const nj_os_char* path, nj_allocator_t* allocator) {
-  png->allocator = allocator;
+bool nj_png_read_info(nj_png_t* png, const nju8* data, njsp size) {
+  png_stream_t stream;
+  return png_read_stream(png, data, size, &stream);
+}
 
+bool nj_png_decode(nj_png_t* png, const nju8* data, njsp size, nju8* dst, njsp dst_size, njsp dst_row_pitch) {
   nj_scoped_la_allocator_t<> temp_allocator("png_temp_allocator");
   temp_allocator.init();
-  nj_dynamic_array_t<nju8> data = nj_read_whole_file(&temp_allocator, path, NULL);
-  NJ_CHECK_LOG_RETURN_VAL(!memcmp(data.p, &gc_png_signature[0], gc_png_sig_len), false, "Invalid PNG signature");
-  for (int i = gc_png_sig_len; i < nj_da_len(&data);) {
-    int data_len = bswap32(*((int*)(data.p + i)));
-    i += 4;
-    const nju8* chunk_it = data.p + i;
-    const int chunk_type = *((int*)(data.p + i));
-    i += 4;
-    nju8* p = data.p + i;
-    i += data_len;
-    // nju8* cRC = it;
-    i += 4;
-    switch (chunk_type) {
-    case FOURCC("IHDR"): {
-      NJ_CHECK_RETURN_VAL(data_len == 13, false);
-      png->width = bswap32(*(int*)p);
-      p += 4;
-      png->height = bswap32(*(int*)p);
-      p += 4;
-      png->bit_depth = *p++;
-      nju8 color_type = *p++;
-      switch (color_type) {
-      case 0:
-        png->bit_per_pixel = 1;
-        break;
-      case 2:
-      case 3:
-        png->bit_per_pixel = 3;
-        break;
-      case 4:
-        png->bit_per_pixel = 2;
-      case 6:
-        png->bit_per_pixel = 2;
-        break;
-      default:
-        NJ_LOGF_RETURN_VAL(false, "Invalid color type");
-      }
-      nju8 compression_method = *p++;
-      NJ_CHECK_LOG_RETURN_VAL(!compression_method, false, "Invalid compression method");
-      nju8 filter_method = *p++;
-      NJ_CHECK_LOG_RETURN_VAL(!filter_method, false, "Invalid filter method");
-      const nju8 interlace_method = *p++;
-      NJ_CHECK_LOG_RETURN_VAL(!interlace_method, false, "Invalid interlace method");
-      break;
-    }
-    case FOURCC("PLTE"):
-      break;
-    case FOURCC("IDAT"): {
-      nj_bit_stream_t bs;
-      nj_bs_init(&bs, p);
-      // 2 bytes of zlib header.
-      nju32 zlib_compress_method = nj_bs_consume_lsb(&bs, 4);
-      NJ_CHECK_LOG_RETURN_VAL(zlib_compress_method == 8, false, "Invalid zlib compression method");
-      nju32 zlib_compress_info = nj_bs_consume_lsb(&bs, 4);
-      NJ_CHECK_LOG_RETURN_VAL((p[0] * 256 + p[1]) % 31 == 0, false, "Invalid FCHECK bits");
-      nj_bs_skip(&bs, 5);
-      nju8 fdict = nj_bs_consume_lsb(&bs, 1);
-      nju8 flevel = nj_bs_consume_lsb(&bs, 2);
-
-      // 3 header bits
-      const nju8 bfinal = nj_bs_consume_lsb(&bs, 1);
-      const nju8 ctype = nj_bs_consume_lsb(&bs, 2);
-      nju8* deflated_data = (nju8*)temp_allocator.alloc((png->width + 1) * png->height * png->bit_depth);
-      nju8* deflated_p = deflated_data;
-      if (ctype == 1) {
-        // Fixed Huffman.
-        for (;;) {
-          int code;
-          code = nj_bs_consume_msb(&bs, 7);
-          if (code >= 0 && code <= 23) {
-            code += 256;
-            if (code == 256)
-              break;
-          } else {
-            code = code << 1 | nj_bs_consume_msb(&bs, 1);
-            if (code >= 48 && code <= 191) {
-              *deflated_p++ = code - 48;
-              continue;
-            } else if (code >= 192 && code <= 199) {
-              code += 88;
-            } else {
-              code = code << 1 | nj_bs_consume_msb(&bs, 1);
-              NJ_CHECK_LOG_RETURN_VAL(code >= 400 && code <= 511, false, "Can't decode fixed Huffman");
-              *deflated_p++ = code - 256;
-              continue;
-            }
-          }
-          decode_len_and_dist(code, &bs, NULL, &deflated_p);
-        }
-      } else if (ctype == 2) {
-        // Dynamic Huffman.
-        int hlit = nj_bs_consume_lsb(&bs, 5) + 257;
-        int hdist = nj_bs_consume_lsb(&bs, 5) + 1;
-        int hclen = nj_bs_consume_lsb(&bs, 4) + 4;
-        nju8 len_of_len[19] = {};
-        const int c_len_alphabet[] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
-        for (int j = 0; j < hclen; ++j) {
-          len_of_len[c_len_alphabet[j]] = nj_bs_consume_lsb(&bs, 3);
-        }
-        codes_for_len_t code_lens_cfl[8];
-        alphabet_t code_len_alphabet = {code_lens_cfl, 0, 0};
-        build_alphabet(len_of_len, 19, &code_len_alphabet);
-        int index = 0;
-        nju8 lit_and_dist_lens[gc_max_code];
-        while (index < hlit + hdist) {
-          int code_len = decode(&bs, &code_len_alphabet);
-          if (code_len < 16) {
-            lit_and_dist_lens[index++] = code_len;
-          } else {
-            nju8 repeat_num;
-            nju8 repeated_val = 0;
-            if (code_len == 16) {
-              repeat_num = nj_bs_consume_lsb(&bs, 2) + 3;
-              repeated_val = lit_and_dist_lens[index - 1];
-            } else if (code_len == 17) {
-              repeat_num = nj_bs_consume_lsb(&bs, 3) + 3;
-            } else if (code_len == 18) {
-              repeat_num = nj_bs_consume_lsb(&bs, 7) + 11;
-            }
-            memset(lit_and_dist_lens + index, repeated_val, repeat_num);
-            index += repeat_num;
-          }
-          NJ_CHECK_LOG_RETURN_VAL(index <= hlit + hdist, false, "Can't decode literal and length alphabet, overflowed");
-        }
-        NJ_CHECK_LOG_RETURN_VAL(lit_and_dist_lens[256], false, "Symbol 256 can't have length of 0");
-        codes_for_len_t lit_or_len_cfl[gc_max_code_len];
-        alphabet_t lit_or_len_alphabet = {lit_or_len_cfl, 0, 0};
-        build_alphabet(lit_and_dist_lens, hlit, &lit_or_len_alphabet);
-        codes_for_len_t dist_cfl[gc_max_code_len];
-        alphabet_t dist_alphabet = {dist_cfl, 0, 0};
-        build_alphabet(lit_and_dist_lens + hlit, hdist, &dist_alphabet);
-        for (;;) {
-          int lit_or_len_code = decode(&bs, &lit_or_len_alphabet);
-          if (lit_or_len_code == 256)
-            break;
-          if (lit_or_len_code < 256) {
-            *deflated_p++ = lit_or_len_code;
-            continue;
-          }
-          decode_len_and_dist(lit_or_len_code, &bs, &dist_alphabet, &deflated_p);
-        }
-      }
-      png->data = (nju8*)png->allocator->alloc(png->width * png->height * 4);
-      int bytes_per_deflated_row = 4 * png->width + 1;
-      int bytes_per_data_row = 4 * png->width;
-      for (int r = 0; r < png->height; ++r) {
-        const nju8 filter_method = deflated_data[r * bytes_per_deflated_row];
-        const int data_offset = r * bytes_per_data_row;
-        const int deflated_offset = r * bytes_per_deflated_row + 1;
-        nju8* a = &png->data[r * bytes_per_data_row];
-        nju8* b = NULL;
-        if (r)
-          b = &png->data[(r - 1) * bytes_per_data_row];
-        nju8* c = NULL;
-        if (r)
-          c = &png->data[(r - 1) * bytes_per_data_row];
-        switch (filter_method) {
-        case 0: {
-          memcpy(png->data + data_offset, deflated_data + deflated_offset, bytes_per_data_row);
-        } break;
-        case 1: {
-          for (int j = 0; j < 4; ++j)
-            png->data[data_offset + j] = deflated_data[deflated_offset + j];
-          for (int j = 4; j < bytes_per_data_row; ++j)
-            png->data[data_offset + j] =
-                deflated_data[deflated_offset + j] + *a++;
-        } break;
-        case 2: {
-          if (!r) {
-            for (int j = 0; j < bytes_per_data_row; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j];
-          } else {
-            for (int j = 0; j < bytes_per_data_row; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j] + *b++;
-          }
-        } break;
-        case 3: {
-          if (!r) {
-            for (int j = 0; j < 4; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j];
-            for (int j = 4; j < bytes_per_data_row; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j] + *a++ / 2;
-          } else {
-            for (int j = 0; j < 4; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j] + *b++ / 2;
-            for (int j = 4; j < bytes_per_data_row; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j] + ((int)(*a++) + (int)(*b++)) / 2;
-          }
-        } break;
-        case 4: {
-          if (!r) {
-            for (int j = 0; j < bytes_per_data_row; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j];
-          } else {
-            for (int j = 0; j < 4; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j] + *b++;
-            for (int j = 4; j < bytes_per_data_row; ++j)
-              png->data[data_offset + j] = deflated_data[deflated_offset + j] + paeth(*(a++), *(b++), *(c++));
-          }
-        } break;
-        default:
-          NJ_LOGF_RETURN_VAL(false, "Invalid filter method");
-        }
-      }
-    } break;
-    case FOURCC("IEND"):
-      break;
-    }
+  png_stream_t stream;
+  NJ_CHECK_RETURN_VAL(png_read_stream(png, data, size, &stream), false);
+  if (!dst_row_pitch)
+    dst_row_pitch = png->row_size;
+  NJ_CHECK_LOG_RETURN_VAL(dst_row_pitch >= png->row_size && dst_row_pitch * (png->height - 1) + png->row_size <= dst_size, false, "PNG destination is too small");
+  nju8* deflated_data = (nju8*)temp_allocator.alloc(png_get_deflated_size(png, png->height) + png->row_size);
+  NJ_CHECK_LOG_RETURN_VAL(deflated_data, false, "Can't allocate the PNG image data");
+  nju8* zero_row = deflated_data + png_get_deflated_size(png, png->height);
+  memset(zero_row, 0, png->row_size);
+  bool is_inflated = false;
+  if (stream.segment_count && nj_parallel_get_job_count() > 1) {
+    is_inflated = png_inflate_segments(png, &stream, deflated_data, &temp_allocator);
+    nj_atomic_fetch_add(is_inflated ? &g_png_stats.segmented_count : &g_png_stats.fallback_count, (nju64)1);
+  }
+  if (!is_inflated && !png_inflate_serial(png, &stream, deflated_data))
+    return false;
+  return png_unfilter(png, deflated_data, zero_row, dst, dst_row_pitch);
+}
+
+bool nj_png_init(nj_png_t* png, const nj_os_char* path, nj_allocator_t* allocator) {
+  nj_file_map_t map;
+  NJ_CHECK_RETURN_VAL(nj_file_map(&map, path), false);
+  bool rv = nj_png_init(png, map.data, map.size, allocator);
+  nj_file_unmap(&map);
+  return rv;
+}
+
+bool nj_png_init(nj_png_t* png, const nju8* data, njsp size, nj_allocator_t* allocator) {
+  png->allocator = allocator;
+  png->data = NULL;
+  NJ_CHECK_RETURN_VAL(nj_png_read_info(png, data, size), false);
+  njsp dst_size = png->row_size * png->height;
+  png->data = (nju8*)png->allocator->alloc(dst_size);
+  NJ_CHECK_LOG_RETURN_VAL(png->data, false, "Can't allocate the PNG image");
+  if (!nj_png_decode(png, data, size, png->data, dst_size, 0)) {
+    png->allocator->free(png->data);
+    png->data = NULL;
+    return false;
   }
   return true;
 }
@@ -359,3 +321,152 @@ bool nj_png_init(nj_png_t* png, const nj_os_char* path, nj_allocator_t* allocato
 void nj_png_destroy(nj_png_t* png) {
   png->allocator->free(png->data);
 }
+
+static void png_decode_batch_item(nj_png_batch_item_t* item, nj_png_get_dst_func_t get_dst, void* user_data) {
+  nj_file_map_t map = {};
+  const nju8* data = item->data;
+  njsp size = item->size;
+  if (item->path) {
+    if (!nj_file_map(&map, item->path))
+      return;
+    data = map.data;
+    size = map.size;
+  }
+  item->png.allocator = NULL;
+  item->png.data = NULL;
+  if (nj_png_read_info(&item->png, data, size) && (item->dst || (get_dst && get_dst(user_data, item)))) {
+    item->is_ok = nj_png_decode(&item->png, data, size, item->dst, item->dst_size, item->dst_row_pitch);
+    if (item->is_ok)
+      item->png.data = item->dst;
+  }
+  if (item->path)
+    nj_file_unmap(&map);
+}
+
+bool nj_png_decode_batch(nj_png_batch_item_t* items, int count, nj_png_get_dst_func_t get_dst, void* user_data) {
+  for (int i = 0; i < count; ++i)
+    items[i].is_ok = false;
+  // One image at a time per job, the sizes are uneven.
+  nj_parallel_run_chunks(count, [&](njsp i) {
+    png_decode_batch_item(&items[i], get_dst, user_data);
+  });
+  bool rv = true;
+  for (int i = 0; i < count; ++i)
+    rv &= items[i].is_ok;
+  return rv;
+}
+
+// Size of the IDAT chunks written by nj_png_encode().
+#define NJ_PNG_IDAT_CHUNK_SIZE (256 * 1024)
+
+static nju8* png_write_u32(nju8* p, nju32 v) {
+  v = bswap32(v);
+  memcpy(p, &v, sizeof(v));
+  return p + sizeof(v);
+}
+
+// The data must already be at |p| + 8.
+static nju8* png_write_chunk(nju8* p, const char* type, nju32 data_len) {
+  png_write_u32(p, data_len);
+  memcpy(p + 4, type, 4);
+  // The CRC covers the type and the data.
+  return png_write_u32(p + 8 + data_len, nj_crc32(0, p + 4, 4 + data_len));
+}
+
+// Filters |row| with each filter into |candidates|, |dst| is the filter byte
+// and the filtered row with the smallest sum of absolute values.
+static void png_filter_row(nju8* dst, const nju8* row, const nju8* prev, njsp size, int bpp, nju8* candidates) {
+  nju64 best_sum = 0;
+  int best_filter = 0;
+  for (int filter = 0; filter < NJ_PNG_FILTER_COUNT; ++filter) {
+    nju8* out = candidates + filter * size;
+    nju64 sum = 0;
+    for (njsp i = 0; i < size; ++i) {
+      int a = i >= bpp ? row[i - bpp] : 0;
+      int b = prev[i];
+      int c = i >= bpp ? prev[i - bpp] : 0;
+      int predictor = filter == NJ_PNG_FILTER_SUB ? a : filter == NJ_PNG_FILTER_UP ? b : filter == NJ_PNG_FILTER_AVERAGE ? (a + b) / 2 : filter == NJ_PNG_FILTER_PAETH ? nj_png_paeth(a, b, c) : 0;
+      out[i] = (nju8)(row[i] - predictor);
+      sum += abs((njs8)out[i]);
+    }
+    if (!filter || sum < best_sum) {
+      best_sum = sum;
+      best_filter = filter;
+    }
+  }
+  dst[0] = (nju8)best_filter;
+  memcpy(dst + 1, candidates + best_filter * size, size);
+}
+
+static int png_get_segment_count(const nj_png_t* png, int segment_count) {
+  return (int)nj_min<nju32>(nj_min(nj_max(segment_count, 1), NJ_PNG_MAX_SEGMENTS), png->height);
+}
+
+njsp nj_png_encode_bound(const nj_png_t* png, int segment_count, njsp chunks_size) {
+  segment_count = png_get_segment_count(png, segment_count);
+  njsp deflated_size = nj_deflate_compress_bound(png_get_deflated_size(png, png->height), segment_count);
+  njsp idat_count = deflated_size / NJ_PNG_IDAT_CHUNK_SIZE + 1;
+  // Signature, IHDR, njSG, IDAT and IEND.
+  return gc_png_sig_len + 12 + 13 + chunks_size + 12 + 4 + 8 * (segment_count - 1) + deflated_size + 12 * idat_count + 12;
+}
+
+njsp nj_png_encode(const nj_png_t* png, int segment_count, const nju8* chunks, njsp chunks_size, nju8* dst, njsp dst_capacity) {
+  NJ_CHECK_RETURN_VAL(png->width && png->height, -1);
+  segment_count = png_get_segment_count(png, segment_count);
+  nj_scoped_la_allocator_t<> temp_allocator("png_temp_allocator");
+  temp_allocator.init();
+  njsp filtered_size = png_get_deflated_size(png, png->height);
+  njsp deflated_capacity = nj_deflate_compress_bound(filtered_size, segment_count);
+  nju8* filtered = (nju8*)temp_allocator.alloc(filtered_size + 6 * png->row_size + deflated_capacity);
+  NJ_CHECK_LOG_RETURN_VAL(filtered, -1, "Can't allocate the PNG image data");
+  nju8* zero_row = filtered + filtered_size;
+  nju8* candidates = zero_row + png->row_size;
+  nju8* deflated = candidates + 5 * png->row_size;
+  memset(zero_row, 0, png->row_size);
+  int bpp = nj_max(png->bit_per_pixel / 8, 1u);
+  for (nju32 r = 0; r < png->height; ++r) {
+    const nju8* prev = r ? png->data + (r - 1) * png->row_size : zero_row;
+    png_filter_row(filtered + r * (png->row_size + 1), png->data + r * png->row_size, prev, png->row_size, bpp, candidates);
+  }
+
+  nj_deflate_t deflate;
+  NJ_CHECK_RETURN_VAL(nj_deflate_init(&deflate, &temp_allocator, NJ_INFLATE_FORMAT_ZLIB, deflated, deflated_capacity), -1);
+  nj_png_segment_t segments[NJ_PNG_MAX_SEGMENTS];
+  bool rv = true;
+  for (int i = 0; rv && i < segment_count; ++i) {
+    nju32 row = (nju32)((nju64)png->height * i / segment_count);
+    nju32 end_row = (nju32)((nju64)png->height * (i + 1) / segment_count);
+    segments[i] = {row, (nju32)nj_deflate_get_size(&deflate)};
+    rv = nj_deflate_write_segment(&deflate, filtered + png_get_deflated_size(png, row), png_get_deflated_size(png, end_row - row), i == segment_count - 1);
+  }
+  njsp deflated_size = nj_deflate_get_size(&deflate);
+  nj_deflate_destroy(&deflate);
+  NJ_CHECK_LOG_RETURN_VAL(rv, -1, "Can't compress the PNG image data");
+
+  NJ_CHECK_RETURN_VAL(nj_png_encode_bound(png, segment_count, chunks_size) <= dst_capacity, -1);
+  nju8* p = dst;
+  memcpy(p, gc_png_signature, gc_png_sig_len);
+  p += gc_png_sig_len;
+  nju8* data = png_write_u32(png_write_u32(p + 8, png->width), png->height);
+  nju8 ihdr_tail[] = {(nju8)png->bit_depth, (nju8)png->color_type, 0, 0, 0};
+  memcpy(data, ihdr_tail, sizeof(ihdr_tail));
+  p = png_write_chunk(p, "IHDR", 13);
+  if (chunks_size) {
+    memcpy(p, chunks, chunks_size);
+    p += chunks_size;
+  }
+  if (segment_count > 1) {
+    data = png_write_u32(p + 8, segment_count);
+    for (int i = 1; i < segment_count; ++i)
+      data = png_write_u32(png_write_u32(data, segments[i].row), segments[i].offset);
+    p = png_write_chunk(p, "njSG", 4 + 8 * (segment_count - 1));
+  }
+  for (njsp offset = 0; offset < deflated_size;) {
+    nju32 len = (nju32)nj_min(deflated_size - offset, (njsp)NJ_PNG_IDAT_CHUNK_SIZE);
+    memcpy(p + 8, deflated + offset, len);
+    p = png_write_chunk(p, "IDAT", len);
+    offset += len;
+  }
+  p = png_write_chunk(p, "IEND", 0);
+  return p - dst;
+}
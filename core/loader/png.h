@@ -11,6 +11,17 @@
 
 struct nj_allocator_t;
 
+enum nj_png_color_type_t {
+  NJ_PNG_COLOR_TYPE_GRAY = 0,
+  NJ_PNG_COLOR_TYPE_RGB = 2,
+  NJ_PNG_COLOR_TYPE_PALETTE = 3,
+  NJ_PNG_COLOR_TYPE_GRAY_ALPHA = 4,
+  NJ_PNG_COLOR_TYPE_RGBA = 6,
+};
+
+// |data| is |height| rows of |row_size| bytes with the pixels as they are in
+// the file, e.g. 4 bytes per pixel for 8 bits RGBA. 16 bits samples are big
+// endian and the pixels of a palette image are indices.
 struct nj_png_t {
   nj_allocator_t* allocator;
   nju8* data = NULL;
@@ -18,9 +29,80 @@ struct nj_png_t {
   nju32 height = 0;
   nju32 bit_depth = 0;
   nju32 bit_per_pixel = 0;
+  nj_png_color_type_t color_type = NJ_PNG_COLOR_TYPE_GRAY;
+  njsp row_size = 0;
 };
 
 bool nj_png_init(nj_png_t* png, const nj_os_char* path, nj_allocator_t* allocator);
+// Decode from memory, e.g. from a nj_file_map_t.
+bool nj_png_init(nj_png_t* png, const nju8* data, njsp size, nj_allocator_t* allocator);
 void nj_png_destroy(nj_png_t* png);
 
+// Read the size and the format of the image without decoding it, |png->data|
+// isn't touched.
+bool nj_png_read_info(nj_png_t* png, const nju8* data, njsp size);
+// Decode into the caller's memory, e.g. upload staging memory. Rows are
+// |dst_row_pitch| bytes apart (|png->row_size| if 0). The info is read again
+// into |png|.
+bool nj_png_decode(nj_png_t* png, const nju8* data, njsp size, nju8* dst, njsp dst_size, njsp dst_row_pitch);
+
+// How images with segments (see below) were inflated by nj_png_decode(),
+// counted for the whole process.
+struct nj_png_stats_t {
+  // The segments were inflated by several workers.
+  nju64 segmented_count;
+  // A segment failed and the image was inflated serially.
+  nju64 fallback_count;
+};
+
+// Copy the counters to |out| and zero them, like nj_sync_stats_take().
+void nj_png_stats_take(nj_png_stats_t* out);
+
+// An image can be made of independent deflate segments which are inflated by
+// several workers. The writer starts each segment with an empty window (a full
+// flush) at the start of a row and lists them in a "njSG" chunk before the
+// first IDAT: the segment count then, for each segment after the first, its
+// first row and its offset in the concatenated IDAT data (big endian nju32s).
+// Other decoders ignore the chunk.
+#define NJ_PNG_MAX_SEGMENTS (64)
+
+struct nj_png_segment_t {
+  nju32 row;
+  nju32 offset;
+};
+
+// Max size of a file written by nj_png_encode().
+njsp nj_png_encode_bound(const nj_png_t* png, int segment_count, njsp chunks_size);
+// Encode the image of |png| to |dst| in |segment_count| segments of about the
+// same number of rows, at most one per row. Each row gets the filter whose
+// output has the smallest sum of absolute values. |chunks| are complete
+// chunks (e.g. PLTE and tRNS) written as they are before the image data.
+// Returns the file size, -1 if it doesn't fit.
+njsp nj_png_encode(const nj_png_t* png, int segment_count, const nju8* chunks, njsp chunks_size, nju8* dst, njsp dst_capacity);
+
+struct nj_png_batch_item_t {
+  // The file at |path|, or |data| and |size| if |path| is NULL (e.g. a
+  // nj_file_map_t or a pack entry).
+  const nj_os_char* path = NULL;
+  const nju8* data = NULL;
+  njsp size = 0;
+  // See nj_png_decode(). If |dst| is NULL, it's asked to the batch's
+  // nj_png_get_dst_func_t once |png| has the image info.
+  nju8* dst = NULL;
+  njsp dst_size = 0;
+  njsp dst_row_pitch = 0;
+  // The image info, |png.data| is |dst|. Don't call nj_png_destroy() on it.
+  nj_png_t png;
+  bool is_ok = false;
+};
+
+// Sets |item|'s destination, returns false to skip the image. Called from the
+// workers, possibly at the same time.
+typedef bool (*nj_png_get_dst_func_t)(void* user_data, nj_png_batch_item_t* item);
+
+// Decode |count| images on the job system's workers, images are also split
+// across workers if they have segments. |get_dst| can be NULL if every item
+// has a destination. Returns true if every image was decoded.
+bool nj_png_decode_batch(nj_png_batch_item_t* items, int count, nj_png_get_dst_func_t get_dst, void* user_data);
+
 #endif // NJ_CORE_LOADER_PNG_H
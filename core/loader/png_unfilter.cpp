@@ -0,0 +1,264 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/loader/png_unfilter.h"
+
+#include "core/compiler.h"
+#include "core/cpu_topology.h"
+#include "core/log.h"
+#include "core/os.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if NJ_CPU_X64()
+#  include <immintrin.h>
+#endif
+
+// The scalar kernels start at |begin| so the SIMD ones can finish the row
+// with them.
+
+static void unfilter_up_scalar(nju8* dst, const nju8* src, const nju8* prev, njsp begin, njsp size) {
+  for (njsp i = begin; i < size; ++i)
+    dst[i] = src[i] + prev[i];
+}
+
+template <int BPP>
+static void unfilter_sub_scalar(nju8* dst, const nju8* src, njsp begin, njsp size) {
+  njsp i = begin;
+  for (; i < BPP && i < size; ++i)
+    dst[i] = src[i];
+  for (; i < size; ++i)
+    dst[i] = src[i] + dst[i - BPP];
+}
+
+template <int BPP>
+static void unfilter_average_scalar(nju8* dst, const nju8* src, const nju8* prev, njsp begin, njsp size) {
+  njsp i = begin;
+  for (; i < BPP && i < size; ++i)
+    dst[i] = src[i] + prev[i] / 2;
+  for (; i < size; ++i)
+    dst[i] = src[i] + (dst[i - BPP] + prev[i]) / 2;
+}
+
+template <int BPP>
+static void unfilter_paeth_scalar(nju8* dst, const nju8* src, const nju8* prev, njsp begin, njsp size) {
+  njsp i = begin;
+  // The left and upper left pixels are 0, Paeth picks the upper one.
+  for (; i < BPP && i < size; ++i)
+    dst[i] = src[i] + prev[i];
+  for (; i < size; ++i)
+    dst[i] = src[i] + nj_png_paeth(dst[i - BPP], prev[i], prev[i - BPP]);
+}
+
+static void unfilter_none(nju8* dst, const nju8* src, const nju8*, njsp size) {
+  memcpy(dst, src, size);
+}
+
+static void unfilter_up(nju8* dst, const nju8* src, const nju8* prev, njsp size) {
+  unfilter_up_scalar(dst, src, prev, 0, size);
+}
+
+template <int BPP>
+static void unfilter_sub(nju8* dst, const nju8* src, const nju8*, njsp size) {
+  unfilter_sub_scalar<BPP>(dst, src, 0, size);
+}
+
+template <int BPP>
+static void unfilter_average(nju8* dst, const nju8* src, const nju8* prev, njsp size) {
+  unfilter_average_scalar<BPP>(dst, src, prev, 0, size);
+}
+
+template <int BPP>
+static void unfilter_paeth(nju8* dst, const nju8* src, const nju8* prev, njsp size) {
+  unfilter_paeth_scalar<BPP>(dst, src, prev, 0, size);
+}
+
+#if NJ_CPU_X64()
+static void unfilter_up_sse2(nju8* dst, const nju8* src, const nju8* prev, njsp size) {
+  njsp i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi8(x, b));
+  }
+  unfilter_up_scalar(dst, src, prev, i, size);
+}
+
+NJ_TARGET("avx2") static void unfilter_up_avx2(nju8* dst, const nju8* src, const nju8* prev, njsp size) {
+  njsp i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(prev + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi8(x, b));
+  }
+  unfilter_up_scalar(dst, src, prev, i, size);
+}
+
+// Sub is a prefix sum of the bytes at the same position in the pixels. A
+// vector holds the whole pixels that fit in 16 bytes, its sum is done with
+// shifts by 1, 2, 4 and 8 pixels then the last pixel of the previous vector is
+// added to every pixel.
+template <int BPP>
+NJ_TARGET("ssse3") static void unfilter_sub_ssse3(nju8* dst, const nju8* src, const nju8*, njsp size) {
+  const int step = 16 / BPP * BPP;
+  alignas(16) nju8 last_pixel_bytes[16];
+  for (int j = 0; j < 16; ++j)
+    last_pixel_bytes[j] = (nju8)(step - BPP + j % BPP);
+  __m128i last_pixel_mask = _mm_load_si128((const __m128i*)last_pixel_bytes);
+  __m128i last = _mm_setzero_si128();
+  njsp i = 0;
+  // The bytes after the pixels of a step are written then overwritten by the
+  // next step.
+  for (; i + 16 <= size; i += step) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, BPP));
+    if (2 * BPP < 16)
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 2 * BPP));
+    if (4 * BPP < 16)
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 4 * BPP));
+    if (8 * BPP < 16)
+      x = _mm_add_epi8(x, _mm_slli_si128(x, 8 * BPP));
+    x = _mm_add_epi8(x, last);
+    _mm_storeu_si128((__m128i*)(dst + i), x);
+    last = _mm_shuffle_epi8(x, last_pixel_mask);
+  }
+  unfilter_sub_scalar<BPP>(dst, src, i, size);
+}
+
+// Average and Paeth depend on the pixel on the left so they are vectorized
+// over the bytes of a pixel, a pixel of 3 or 6 bytes is loaded as 4 or 8.
+// The extra byte is garbage that the next pixel overwrites.
+#  define NJ_PNG_PIXEL_LOAD_SIZE(bpp) ((bpp) <= 4 ? 4 : 8)
+
+template <int BPP>
+static __m128i load_pixel(const nju8* p) {
+  if (BPP <= 4) {
+    int v;
+    memcpy(&v, p, sizeof(v));
+    return _mm_cvtsi32_si128(v);
+  }
+  return _mm_loadl_epi64((const __m128i*)p);
+}
+
+template <int BPP>
+static void store_pixel(nju8* p, __m128i v) {
+  if (BPP <= 4) {
+    int i = _mm_cvtsi128_si32(v);
+    memcpy(p, &i, sizeof(i));
+  } else {
+    _mm_storel_epi64((__m128i*)p, v);
+  }
+}
+
+template <int BPP>
+static void unfilter_average_sse2(nju8* dst, const nju8* src, const nju8* prev, njsp size) {
+  const __m128i one = _mm_set1_epi8(1);
+  __m128i a = _mm_setzero_si128();
+  njsp i = 0;
+  for (; i + NJ_PNG_PIXEL_LOAD_SIZE(BPP) <= size; i += BPP) {
+    __m128i b = load_pixel<BPP>(prev + i);
+    __m128i x = load_pixel<BPP>(src + i);
+    // _mm_avg_epu8() rounds up, the filter rounds down.
+    __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+    a = _mm_add_epi8(x, average);
+    store_pixel<BPP>(dst + i, a);
+  }
+  unfilter_average_scalar<BPP>(dst, src, prev, i, size);
+}
+
+static __m128i select_si128(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Same as nj_png_paeth() on 16 bits lanes, p - a = b - c, p - b = a - c and
+// p - c = (b - c) + (a - c).
+template <int BPP>
+NJ_TARGET("ssse3") static void unfilter_paeth_ssse3(nju8* dst, const nju8* src, const nju8* prev, njsp size) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i a = zero;
+  __m128i c = zero;
+  njsp i = 0;
+  for (; i + NJ_PNG_PIXEL_LOAD_SIZE(BPP) <= size; i += BPP) {
+    __m128i b = _mm_unpacklo_epi8(load_pixel<BPP>(prev + i), zero);
+    __m128i x = _mm_unpacklo_epi8(load_pixel<BPP>(src + i), zero);
+    __m128i pa = _mm_sub_epi16(b, c);
+    __m128i pb = _mm_sub_epi16(a, c);
+    __m128i pc = _mm_abs_epi16(_mm_add_epi16(pa, pb));
+    pa = _mm_abs_epi16(pa);
+    pb = _mm_abs_epi16(pb);
+    __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+    __m128i nearest = select_si128(_mm_cmpeq_epi16(smallest, pb), b, c);
+    nearest = select_si128(_mm_cmpeq_epi16(smallest, pa), a, nearest);
+    // The high bytes of the lanes are 0 so the sum wraps like a byte.
+    a = _mm_add_epi8(x, nearest);
+    c = b;
+    store_pixel<BPP>(dst + i, _mm_packus_epi16(a, a));
+  }
+  unfilter_paeth_scalar<BPP>(dst, src, prev, i, size);
+}
+#endif
+
+template <int BPP>
+static void unfilter_set_funcs(nj_png_unfilter_t* unfilter, const nj_cpu_features_t* features) {
+  unfilter->funcs[NJ_PNG_FILTER_NONE] = unfilter_none;
+  unfilter->funcs[NJ_PNG_FILTER_SUB] = unfilter_sub<BPP>;
+  unfilter->funcs[NJ_PNG_FILTER_UP] = unfilter_up;
+  unfilter->funcs[NJ_PNG_FILTER_AVERAGE] = unfilter_average<BPP>;
+  unfilter->funcs[NJ_PNG_FILTER_PAETH] = unfilter_paeth<BPP>;
+#if NJ_CPU_X64()
+  if (features->has_sse2) {
+    unfilter->funcs[NJ_PNG_FILTER_UP] = unfilter_up_sse2;
+    // With 1 or 2 bytes per pixel, there is nothing to do in parallel.
+    if (BPP >= 3)
+      unfilter->funcs[NJ_PNG_FILTER_AVERAGE] = unfilter_average_sse2<BPP>;
+  }
+  if (features->has_ssse3) {
+    unfilter->funcs[NJ_PNG_FILTER_SUB] = unfilter_sub_ssse3<BPP>;
+    if (BPP >= 3)
+      unfilter->funcs[NJ_PNG_FILTER_PAETH] = unfilter_paeth_ssse3<BPP>;
+  }
+  if (features->has_avx2)
+    unfilter->funcs[NJ_PNG_FILTER_UP] = unfilter_up_avx2;
+#endif
+}
+
+bool nj_png_unfilter_init(nj_png_unfilter_t* unfilter, int bytes_per_pixel, const nj_cpu_features_t* features) {
+  nj_cpu_features_t cpu_features;
+  if (!features) {
+    nj_cpu_get_features(&cpu_features);
+    features = &cpu_features;
+  }
+  switch (bytes_per_pixel) {
+  case 1:
+    unfilter_set_funcs<1>(unfilter, features);
+    break;
+  case 2:
+    unfilter_set_funcs<2>(unfilter, features);
+    break;
+  case 3:
+    unfilter_set_funcs<3>(unfilter, features);
+    break;
+  case 4:
+    unfilter_set_funcs<4>(unfilter, features);
+    break;
+  case 6:
+    unfilter_set_funcs<6>(unfilter, features);
+    break;
+  case 8:
+    unfilter_set_funcs<8>(unfilter, features);
+    break;
+  default:
+    NJ_LOGF_RETURN_VAL(false, "Invalid bytes per pixel %d", bytes_per_pixel);
+  }
+  return true;
+}
+
+bool nj_png_unfilter_row(const nj_png_unfilter_t* unfilter, int filter, nju8* dst, const nju8* src, const nju8* prev, njsp size) {
+  NJ_CHECK_LOG_RETURN_VAL(filter >= 0 && filter < NJ_PNG_FILTER_COUNT, false, "Invalid filter type %d", filter);
+  unfilter->funcs[filter](dst, src, prev, size);
+  return true;
+}
@@ -0,0 +1,54 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_LOADER_PNG_UNFILTER_H
+#define NJ_CORE_LOADER_PNG_UNFILTER_H
+
+#include "core/njtype.h"
+
+#include <stdlib.h>
+
+struct nj_cpu_features_t;
+
+// Filter types at the start of each PNG row.
+enum nj_png_filter_t {
+  NJ_PNG_FILTER_NONE,
+  NJ_PNG_FILTER_SUB,
+  NJ_PNG_FILTER_UP,
+  NJ_PNG_FILTER_AVERAGE,
+  NJ_PNG_FILTER_PAETH,
+  NJ_PNG_FILTER_COUNT,
+};
+
+// The left, upper or upper left byte, whichever is closest to their gradient.
+// Written to be compiled to conditional moves, the branches are random on
+// noisy images.
+inline int nj_png_paeth(int a, int b, int c) {
+  int pa = abs(b - c);
+  int pb = abs(a - c);
+  int pc = abs(a + b - 2 * c);
+  int nearest = pb <= pc ? b : c;
+  return (pa <= pb) & (pa <= pc) ? a : nearest;
+}
+
+// Writes |size| unfiltered bytes of a row to |dst| from the filtered |src|.
+// |prev| is the previous unfiltered row, all 0 for the first row. |dst| can't
+// overlap |src| or |prev|.
+typedef void (*nj_png_unfilter_func_t)(nju8* dst, const nju8* src, const nju8* prev, njsp size);
+
+// The kernels for a number of bytes per pixel (1, 2, 3, 4, 6 or 8, bit depths
+// under 8 use 1), picked once per image.
+struct nj_png_unfilter_t {
+  nj_png_unfilter_func_t funcs[NJ_PNG_FILTER_COUNT];
+};
+
+// |features| selects the SIMD kernels, NULL uses the CPU's and a zeroed
+// nj_cpu_features_t the scalar ones. All of them have the same output.
+bool nj_png_unfilter_init(nj_png_unfilter_t* unfilter, int bytes_per_pixel, const nj_cpu_features_t* features);
+// Returns false if |filter| isn't a nj_png_filter_t.
+bool nj_png_unfilter_row(const nj_png_unfilter_t* unfilter, int filter, nju8* dst, const nju8* src, const nju8* prev, njsp size);
+
+#endif // NJ_CORE_LOADER_PNG_UNFILTER_H
@@ -78,7 +78,9 @@ void nj_log_internal(enum nj_log_level level, const char* file, int line, const
 }
 
 bool nj_log_init(const nj_os_char* log_path) {
-  nj_file_open(&g_log_file, log_path, NJ_FILE_MODE_APPEND);
+  // Unbuffered so lines aren't lost on a crash and threads logging at the
+  // same time don't share a buffer.
+  nj_file_open(&g_log_file, log_path, NJ_FILE_MODE_APPEND, NJ_FILE_UNBUFFERED);
   g_log_inited = nj_file_is_valid(&g_log_file);
   return g_log_inited;
 }
@@ -0,0 +1,546 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/lz.h"
+
+#include "core/allocator.h"
+#include "core/log.h"
+#include "core/utils.h"
+
+#include <string.h>
+
+#define NJ_LZ_MIN_MATCH (4)
+// The last bytes of a block are literals, the last match starts before
+// NJ_LZ_MATCH_FIND_LIMIT bytes from the end.
+#define NJ_LZ_LAST_LITERALS (5)
+#define NJ_LZ_MATCH_FIND_LIMIT (12)
+#define NJ_LZ_MAX_OFFSET (65535)
+#define NJ_LZ_RUN_MASK (15)
+#define NJ_LZ_FAST_HASH_LOG (12)
+#define NJ_LZ_HIGH_HASH_LOG (15)
+#define NJ_LZ_HIGH_CHAIN_SIZE (65536)
+#define NJ_LZ_HIGH_MAX_ATTEMPTS (256)
+
+static nju16 lz_read16(const nju8* p) {
+  return (nju16)(p[0] | (p[1] << 8));
+}
+
+static nju32 lz_read32(const nju8* p) {
+  nju32 v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static nju64 lz_read64(const nju8* p) {
+  nju64 v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static nju32 lz_hash(nju32 v, int hash_log) {
+  return (v * 2654435761u) >> (32 - hash_log);
+}
+
+// Number of equal bytes at |a| and |b|, |a| stops at |limit|.
+static njsp lz_count(const nju8* a, const nju8* b, const nju8* limit) {
+  const nju8* start = a;
+  while (a + 8 <= limit) {
+    nju64 diff = lz_read64(a) ^ lz_read64(b);
+    if (diff)
+      return a - start + (nj_ctz64(diff) >> 3);
+    a += 8;
+    b += 8;
+  }
+  while (a < limit && *a == *b) {
+    ++a;
+    ++b;
+  }
+  return a - start;
+}
+
+static nju8* lz_write_length(nju8* op, njsp len) {
+  for (; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = (nju8)len;
+  return op;
+}
+
+// |match_len| is 0 for the last literals.
+static nju8* lz_write_sequence(nju8* op, const nju8* literals, njsp literal_len, njsp offset, njsp match_len) {
+  nju8* token = op++;
+  nju8 t;
+  if (literal_len >= NJ_LZ_RUN_MASK) {
+    t = NJ_LZ_RUN_MASK << 4;
+    op = lz_write_length(op, literal_len - NJ_LZ_RUN_MASK);
+  } else {
+    t = (nju8)(literal_len << 4);
+  }
+  if (match_len) {
+    // Up to 7 bytes more are copied, the offset and the last literals come
+    // after so it stays in the bound.
+    for (njsp i = 0; i < literal_len; i += 8)
+      memcpy(op + i, literals + i, 8);
+  } else {
+    memcpy(op, literals, literal_len);
+  }
+  op += literal_len;
+  if (match_len) {
+    *op++ = (nju8)offset;
+    *op++ = (nju8)(offset >> 8);
+    njsp len = match_len - NJ_LZ_MIN_MATCH;
+    if (len >= NJ_LZ_RUN_MASK) {
+      t |= NJ_LZ_RUN_MASK;
+      op = lz_write_length(op, len - NJ_LZ_RUN_MASK);
+    } else {
+      t |= (nju8)len;
+    }
+  }
+  *token = t;
+  return op;
+}
+
+static njsp lz_compress_fast(nj_lz_encoder_t* encoder, const nju8* src, njsp src_size, nju8* dst) {
+  // The table isn't cleared between blocks, positions that aren't before the
+  // current one are stale and any candidate is checked anyway.
+  nju32* table = encoder->table;
+  const nju8* ip = src;
+  const nju8* anchor = src;
+  const nju8* end = src + src_size;
+  nju8* op = dst;
+  if (src_size > NJ_LZ_MATCH_FIND_LIMIT) {
+    const nju8* find_limit = end - NJ_LZ_MATCH_FIND_LIMIT;
+    const nju8* match_limit = end - NJ_LZ_LAST_LITERALS;
+    table[lz_hash(lz_read32(ip), NJ_LZ_FAST_HASH_LOG)] = 0;
+    ++ip;
+    for (;;) {
+      // The step grows when nothing matches for a while so incompressible data
+      // is skipped quickly.
+      njsp attempts = 1 << 6;
+      nju32 ref_pos;
+      for (;;) {
+        if (ip > find_limit)
+          goto last_literals;
+        nju32 seq = lz_read32(ip);
+        nju32 h = lz_hash(seq, NJ_LZ_FAST_HASH_LOG);
+        nju32 pos = (nju32)(ip - src);
+        ref_pos = table[h];
+        table[h] = pos;
+        if (ref_pos < pos && pos - ref_pos <= NJ_LZ_MAX_OFFSET && lz_read32(src + ref_pos) == seq)
+          break;
+        ip += attempts++ >> 6;
+      }
+      const nju8* ref = src + ref_pos;
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        --ip;
+        --ref;
+      }
+      njsp match_len = NJ_LZ_MIN_MATCH + lz_count(ip + NJ_LZ_MIN_MATCH, ref + NJ_LZ_MIN_MATCH, match_limit);
+      op = lz_write_sequence(op, anchor, ip - anchor, ip - ref, match_len);
+      ip += match_len;
+      anchor = ip;
+      if (ip > find_limit)
+        break;
+      table[lz_hash(lz_read32(ip - 2), NJ_LZ_FAST_HASH_LOG)] = (nju32)(ip - 2 - src);
+    }
+  }
+last_literals:
+  op = lz_write_sequence(op, anchor, end - anchor, 0, 0);
+  return op - dst;
+}
+
+// Link the positions from |*next_pos| to before |pos| in the hash chains.
+static void lz_high_insert(nj_lz_encoder_t* encoder, const nju8* src, nju32* next_pos, nju32 pos) {
+  for (; *next_pos < pos; ++*next_pos) {
+    nju32 h = lz_hash(lz_read32(src + *next_pos), NJ_LZ_HIGH_HASH_LOG);
+    nju32 delta = *next_pos - encoder->table[h];
+    encoder->chain[*next_pos & (NJ_LZ_HIGH_CHAIN_SIZE - 1)] = delta > NJ_LZ_MAX_OFFSET ? 0 : (nju16)delta;
+    encoder->table[h] = *next_pos;
+  }
+}
+
+// Returns the length of the longest match at |ip|, 0 if there is none.
+static njsp lz_high_find(nj_lz_encoder_t* encoder, const nju8* src, nju32* next_pos, const nju8* ip, const nju8* match_limit, nju32* best_pos) {
+  nju32 pos = (nju32)(ip - src);
+  lz_high_insert(encoder, src, next_pos, pos);
+  njsp best_len = NJ_LZ_MIN_MATCH - 1;
+  nju32 seq = lz_read32(ip);
+  nju32 ref_pos = encoder->table[lz_hash(seq, NJ_LZ_HIGH_HASH_LOG)];
+  for (int attempts = NJ_LZ_HIGH_MAX_ATTEMPTS; attempts > 0 && ref_pos < pos && pos - ref_pos <= NJ_LZ_MAX_OFFSET; --attempts) {
+    const nju8* ref = src + ref_pos;
+    // A longer match has to match one more byte than the best one.
+    if (ref[best_len] == ip[best_len] && lz_read32(ref) == seq) {
+      njsp len = NJ_LZ_MIN_MATCH + lz_count(ip + NJ_LZ_MIN_MATCH, ref + NJ_LZ_MIN_MATCH, match_limit);
+      if (len > best_len) {
+        best_len = len;
+        *best_pos = ref_pos;
+      }
+    }
+    nju16 delta = encoder->chain[ref_pos & (NJ_LZ_HIGH_CHAIN_SIZE - 1)];
+    if (!delta)
+      break;
+    ref_pos -= delta;
+  }
+  return best_len >= NJ_LZ_MIN_MATCH ? best_len : 0;
+}
+
+static njsp lz_compress_high(nj_lz_encoder_t* encoder, const nju8* src, njsp src_size, nju8* dst) {
+  const nju8* ip = src;
+  const nju8* anchor = src;
+  const nju8* end = src + src_size;
+  nju8* op = dst;
+  if (src_size > NJ_LZ_MATCH_FIND_LIMIT) {
+    // Chains are only followed from positions of this block, the heads are
+    // cleared so they don't point to another one.
+    memset(encoder->table, 0, sizeof(nju32) << NJ_LZ_HIGH_HASH_LOG);
+    const nju8* find_limit = end - NJ_LZ_MATCH_FIND_LIMIT;
+    const nju8* match_limit = end - NJ_LZ_LAST_LITERALS;
+    nju32 next_pos = 0;
+    // Position 0 is in every empty chain, it's inserted but not searched.
+    ip = src + 1;
+    lz_high_insert(encoder, src, &next_pos, 1);
+    while (ip <= find_limit) {
+      nju32 ref_pos;
+      njsp match_len = lz_high_find(encoder, src, &next_pos, ip, match_limit, &ref_pos);
+      if (!match_len) {
+        ++ip;
+        continue;
+      }
+      // Lazy matching, a literal is worth it if the next position has a
+      // longer match.
+      while (ip + 1 <= find_limit) {
+        nju32 next_ref_pos;
+        njsp next_len = lz_high_find(encoder, src, &next_pos, ip + 1, match_limit, &next_ref_pos);
+        if (next_len <= match_len)
+          break;
+        ++ip;
+        match_len = next_len;
+        ref_pos = next_ref_pos;
+      }
+      op = lz_write_sequence(op, anchor, ip - anchor, ip - (src + ref_pos), match_len);
+      ip += match_len;
+      anchor = ip;
+    }
+  }
+  op = lz_write_sequence(op, anchor, end - anchor, 0, 0);
+  return op - dst;
+}
+
+bool nj_lz_encoder_init(nj_lz_encoder_t* encoder, nj_allocator_t* allocator, nj_lz_level_t level) {
+  encoder->allocator = allocator;
+  encoder->level = level;
+  encoder->chain = NULL;
+  int hash_log = level == NJ_LZ_LEVEL_HIGH ? NJ_LZ_HIGH_HASH_LOG : NJ_LZ_FAST_HASH_LOG;
+  encoder->table = (nju32*)allocator->alloc_zero(sizeof(nju32) << hash_log);
+  NJ_CHECK_LOG_RETURN_VAL(encoder->table, false, "Can't allocate the LZ hash table");
+  if (level == NJ_LZ_LEVEL_HIGH) {
+    encoder->chain = (nju16*)allocator->alloc(sizeof(nju16) * NJ_LZ_HIGH_CHAIN_SIZE);
+    if (!encoder->chain) {
+      allocator->free(encoder->table);
+      NJ_LOGW("Can't allocate the LZ hash chains");
+      return false;
+    }
+  }
+  return true;
+}
+
+void nj_lz_encoder_destroy(nj_lz_encoder_t* encoder) {
+  encoder->allocator->free(encoder->table);
+  if (encoder->chain)
+    encoder->allocator->free(encoder->chain);
+}
+
+njsp nj_lz_compress_bound(njsp size) {
+  return size + size / 255 + 16;
+}
+
+njsp nj_lz_compress(nj_lz_encoder_t* encoder, const nju8* src, njsp src_size, nju8* dst, njsp dst_capacity) {
+  NJ_CHECK_RETURN_VAL(dst_capacity >= nj_lz_compress_bound(src_size), 0);
+  // Positions are 32 bits.
+  NJ_CHECK_RETURN_VAL(src_size <= 0x7fffffff, 0);
+  if (encoder->level == NJ_LZ_LEVEL_HIGH)
+    return lz_compress_high(encoder, src, src_size, dst);
+  return lz_compress_fast(encoder, src, src_size, dst);
+}
+
+// Adds the 255 runs of a length to |*len|.
+static bool lz_read_length(const nju8** ip, const nju8* end, njsp* len) {
+  nju8 b;
+  do {
+    if (*ip >= end)
+      return false;
+    b = *(*ip)++;
+    *len += b;
+  } while (b == 255);
+  return true;
+}
+
+njsp nj_lz_decompress(const nju8* src, njsp src_size, nju8* dst, njsp dst_capacity) {
+  const nju8* ip = src;
+  const nju8* end = src + src_size;
+  nju8* op = dst;
+  nju8* op_end = dst + dst_capacity;
+  for (;;) {
+    if (ip >= end)
+      return -1;
+    nju8 token = *ip++;
+    njsp literal_len = token >> 4;
+    if (literal_len != NJ_LZ_RUN_MASK && end - ip >= 16 && op_end - op >= 32) {
+      // Most sequences have few literals, copy 16 bytes without looking at
+      // the length. It's not the last sequence since there are 2 bytes of
+      // offset after the literals.
+      memcpy(op, ip, 16);
+      ip += literal_len;
+      op += literal_len;
+    } else {
+      if (literal_len == NJ_LZ_RUN_MASK && !lz_read_length(&ip, end, &literal_len))
+        return -1;
+      if (literal_len <= end - ip - 16 && literal_len <= op_end - op - 16) {
+        // Wild copy, it can write up to 15 bytes more than the literals.
+        for (njsp i = 0; i < literal_len; i += 16)
+          memcpy(op + i, ip + i, 16);
+      } else {
+        if (literal_len > end - ip || literal_len > op_end - op)
+          return -1;
+        memcpy(op, ip, literal_len);
+      }
+      ip += literal_len;
+      op += literal_len;
+      // Blocks end with literals.
+      if (ip == end)
+        break;
+      if (end - ip < 2)
+        return -1;
+    }
+
+    njsp offset = lz_read16(ip);
+    ip += 2;
+    if (!offset || offset > op - dst)
+      return -1;
+    njsp match_len = token & NJ_LZ_RUN_MASK;
+    if (match_len == NJ_LZ_RUN_MASK && !lz_read_length(&ip, end, &match_len))
+      return -1;
+    match_len += NJ_LZ_MIN_MATCH;
+    if (match_len > op_end - op)
+      return -1;
+    const nju8* match = op - offset;
+    if (match_len <= op_end - op - 16) {
+      if (offset >= 8) {
+        // Most matches are short, the first 16 bytes are copied without
+        // looking at the length.
+        memcpy(op, match, 8);
+        memcpy(op + 8, match + 8, 8);
+        for (njsp i = 16; i < match_len; i += 8)
+          memcpy(op + i, match + i, 8);
+      } else {
+        // The match overlaps the output. Repeat the pattern until it's long
+        // enough, then copy 8 bytes at a time from a multiple of |offset|
+        // back.
+        njsp distance = offset;
+        while (distance < 8)
+          distance *= 2;
+        for (njsp i = 0; i < distance; ++i)
+          op[i] = match[i];
+        for (njsp i = distance; i < match_len; i += 8)
+          memcpy(op + i, op + i - distance, 8);
+      }
+    } else {
+      for (njsp i = 0; i < match_len; ++i)
+        op[i] = match[i];
+    }
+    op += match_len;
+  }
+  return op - dst;
+}
+
+static void lz_write_u32(nju8* p, nju32 v) {
+  p[0] = (nju8)v;
+  p[1] = (nju8)(v >> 8);
+  p[2] = (nju8)(v >> 16);
+  p[3] = (nju8)(v >> 24);
+}
+
+static nju32 lz_read_u32(const nju8* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((nju32)p[3] << 24);
+}
+
+static bool lz_writer_flush_block(nj_lz_writer_t* writer) {
+  if (!writer->is_ok)
+    return false;
+  njsp size = nj_lz_compress(&writer->encoder, writer->block, writer->block_len, writer->compressed + 4, nj_lz_compress_bound(writer->block_size));
+  nju32 header = (nju32)size;
+  if (size >= writer->block_len) {
+    size = writer->block_len;
+    header = (nju32)size | NJ_LZ_BLOCK_UNCOMPRESSED;
+    memcpy(writer->compressed + 4, writer->block, size);
+  }
+  lz_write_u32(writer->compressed, header);
+  writer->block_len = 0;
+  writer->is_ok = writer->write(writer->user_data, writer->compressed, size + 4);
+  return writer->is_ok;
+}
+
+bool nj_lz_writer_init(nj_lz_writer_t* writer, nj_allocator_t* allocator, nj_lz_level_t level, int block_size_log2, nj_lz_write_func_t write, void* user_data) {
+  NJ_CHECK_LOG_RETURN_VAL(block_size_log2 >= NJ_LZ_MIN_BLOCK_SIZE_LOG2 && block_size_log2 <= NJ_LZ_MAX_BLOCK_SIZE_LOG2, false, "Invalid LZ block size");
+  NJ_CHECK_RETURN_VAL(nj_lz_encoder_init(&writer->encoder, allocator, level), false);
+  writer->write = write;
+  writer->user_data = user_data;
+  writer->block_size = 1 << block_size_log2;
+  writer->block_len = 0;
+  writer->block = (nju8*)allocator->alloc(writer->block_size);
+  writer->compressed = writer->block ? (nju8*)allocator->alloc(4 + nj_lz_compress_bound(writer->block_size)) : NULL;
+  if (!writer->compressed) {
+    if (writer->block)
+      allocator->free(writer->block);
+    nj_lz_encoder_destroy(&writer->encoder);
+    NJ_LOGW("Can't allocate the LZ blocks");
+    return false;
+  }
+  nj_lz_frame_header_t header = {};
+  lz_write_u32((nju8*)&header.magic, NJ_LZ_MAGIC);
+  header.version = NJ_LZ_VERSION;
+  header.block_size_log2 = (nju8)block_size_log2;
+  writer->is_ok = write(user_data, (const nju8*)&header, sizeof(header));
+  return writer->is_ok;
+}
+
+void nj_lz_writer_destroy(nj_lz_writer_t* writer) {
+  nj_allocator_t* allocator = writer->encoder.allocator;
+  allocator->free(writer->block);
+  allocator->free(writer->compressed);
+  nj_lz_encoder_destroy(&writer->encoder);
+}
+
+bool nj_lz_writer_write(nj_lz_writer_t* writer, const void* data, njsp size) {
+  const nju8* p = (const nju8*)data;
+  while (size > 0 && writer->is_ok) {
+    njsp copy_len = nj_min(size, writer->block_size - writer->block_len);
+    memcpy(writer->block + writer->block_len, p, copy_len);
+    writer->block_len += copy_len;
+    p += copy_len;
+    size -= copy_len;
+    if (writer->block_len == writer->block_size)
+      lz_writer_flush_block(writer);
+  }
+  return writer->is_ok;
+}
+
+bool nj_lz_writer_finish(nj_lz_writer_t* writer) {
+  if (writer->block_len)
+    lz_writer_flush_block(writer);
+  if (!writer->is_ok)
+    return false;
+  nju8 end_mark[4] = {};
+  writer->is_ok = writer->write(writer->user_data, end_mark, sizeof(end_mark));
+  return writer->is_ok;
+}
+
+bool nj_lz_reader_init(nj_lz_reader_t* reader, nj_allocator_t* allocator, nj_lz_write_func_t write, void* user_data) {
+  memset(reader, 0, sizeof(nj_lz_reader_t));
+  reader->allocator = allocator;
+  reader->write = write;
+  reader->user_data = user_data;
+  reader->state = NJ_LZ_READER_STATE_HEADER;
+  return true;
+}
+
+void nj_lz_reader_destroy(nj_lz_reader_t* reader) {
+  if (reader->staging)
+    reader->allocator->free(reader->staging);
+  if (reader->block)
+    reader->allocator->free(reader->block);
+}
+
+// Gather the |size| bytes of the header or a block size in |reader->prefix|.
+// Returns true when it's complete.
+static bool lz_reader_gather_prefix(nj_lz_reader_t* reader, const nju8** p, const nju8* end, njsp size) {
+  njsp copy_len = nj_min(size - reader->prefix_len, (njsp)(end - *p));
+  memcpy(reader->prefix + reader->prefix_len, *p, copy_len);
+  reader->prefix_len += copy_len;
+  *p += copy_len;
+  if (reader->prefix_len < size)
+    return false;
+  reader->prefix_len = 0;
+  return true;
+}
+
+static nj_lz_reader_state_t lz_reader_read_header(nj_lz_reader_t* reader) {
+  const nj_lz_frame_header_t* header = (const nj_lz_frame_header_t*)reader->prefix;
+  if (lz_read_u32(reader->prefix) != NJ_LZ_MAGIC || header->version != NJ_LZ_VERSION)
+    return NJ_LZ_READER_STATE_ERROR;
+  if (header->block_size_log2 < NJ_LZ_MIN_BLOCK_SIZE_LOG2 || header->block_size_log2 > NJ_LZ_MAX_BLOCK_SIZE_LOG2)
+    return NJ_LZ_READER_STATE_ERROR;
+  reader->block_size = 1 << header->block_size_log2;
+  reader->staging = (nju8*)reader->allocator->alloc(nj_lz_compress_bound(reader->block_size));
+  reader->block = (nju8*)reader->allocator->alloc(reader->block_size);
+  NJ_CHECK_LOG_RETURN_VAL(reader->staging && reader->block, NJ_LZ_READER_STATE_ERROR, "Can't allocate the LZ blocks");
+  return NJ_LZ_READER_STATE_BLOCK_SIZE;
+}
+
+static nj_lz_reader_state_t lz_reader_read_block_size(nj_lz_reader_t* reader) {
+  reader->block_header = lz_read_u32(reader->prefix);
+  if (!reader->block_header)
+    return NJ_LZ_READER_STATE_DONE;
+  njsp size = reader->block_header & ~NJ_LZ_BLOCK_UNCOMPRESSED;
+  njsp max_size = (reader->block_header & NJ_LZ_BLOCK_UNCOMPRESSED) ? reader->block_size : nj_lz_compress_bound(reader->block_size);
+  if (!size || size > max_size)
+    return NJ_LZ_READER_STATE_ERROR;
+  reader->staging_len = 0;
+  return NJ_LZ_READER_STATE_BLOCK;
+}
+
+static nj_lz_reader_state_t lz_reader_decode_block(nj_lz_reader_t* reader, const nju8* data) {
+  njsp size = reader->block_header & ~NJ_LZ_BLOCK_UNCOMPRESSED;
+  if (!(reader->block_header & NJ_LZ_BLOCK_UNCOMPRESSED)) {
+    size = nj_lz_decompress(data, size, reader->block, reader->block_size);
+    if (size < 0)
+      return NJ_LZ_READER_STATE_ERROR;
+    data = reader->block;
+  }
+  if (!reader->write(reader->user_data, data, size))
+    return NJ_LZ_READER_STATE_ERROR;
+  return NJ_LZ_READER_STATE_BLOCK_SIZE;
+}
+
+bool nj_lz_reader_feed(nj_lz_reader_t* reader, const void* data, njsp size) {
+  const nju8* p = (const nju8*)data;
+  const nju8* end = p + size;
+  while (p < end) {
+    switch (reader->state) {
+    case NJ_LZ_READER_STATE_HEADER:
+      if (lz_reader_gather_prefix(reader, &p, end, sizeof(nj_lz_frame_header_t)))
+        reader->state = lz_reader_read_header(reader);
+      break;
+    case NJ_LZ_READER_STATE_BLOCK_SIZE:
+      if (lz_reader_gather_prefix(reader, &p, end, 4))
+        reader->state = lz_reader_read_block_size(reader);
+      break;
+    case NJ_LZ_READER_STATE_BLOCK: {
+      njsp block_size = reader->block_header & ~NJ_LZ_BLOCK_UNCOMPRESSED;
+      if (!reader->staging_len && end - p >= block_size) {
+        reader->state = lz_reader_decode_block(reader, p);
+        p += block_size;
+        break;
+      }
+      njsp copy_len = nj_min(block_size - reader->staging_len, (njsp)(end - p));
+      memcpy(reader->staging + reader->staging_len, p, copy_len);
+      reader->staging_len += copy_len;
+      p += copy_len;
+      if (reader->staging_len == block_size)
+        reader->state = lz_reader_decode_block(reader, reader->staging);
+      break;
+    }
+    case NJ_LZ_READER_STATE_DONE:
+      return true;
+    case NJ_LZ_READER_STATE_ERROR:
+      return false;
+    }
+  }
+  return reader->state != NJ_LZ_READER_STATE_ERROR;
+}
+
+bool nj_lz_reader_is_done(const nj_lz_reader_t* reader) {
+  return reader->state == NJ_LZ_READER_STATE_DONE;
+}
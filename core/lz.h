@@ -0,0 +1,118 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_LZ_H
+#define NJ_CORE_LZ_H
+
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+
+// Byte oriented LZ77 in the LZ4 block format: a sequence is a token (4 bits of
+// literal length, 4 bits of match length - 4), the literals, a 16 bits offset
+// and the lengths that didn't fit in the token as runs of 255. The last 5
+// bytes are always literals so the decoder can copy 8/16 bytes at a time.
+
+#define NJ_LZ_MAGIC (0x5a4c4a4e) // "NJLZ"
+#define NJ_LZ_VERSION (1)
+#define NJ_LZ_MIN_BLOCK_SIZE_LOG2 (12)
+#define NJ_LZ_MAX_BLOCK_SIZE_LOG2 (22)
+// Set in the size of a frame block stored uncompressed.
+#define NJ_LZ_BLOCK_UNCOMPRESSED (0x80000000u)
+
+enum nj_lz_level_t {
+  // Greedy, a single hash table lookup per position.
+  NJ_LZ_LEVEL_FAST,
+  // Hash chains and lazy matching, ~20x slower to compress, decompresses at
+  // the same speed.
+  NJ_LZ_LEVEL_HIGH,
+};
+
+// Keeps the match finder tables between blocks.
+struct nj_lz_encoder_t {
+  nj_allocator_t* allocator;
+  nj_lz_level_t level;
+  nju32* table;
+  nju16* chain;
+};
+
+bool nj_lz_encoder_init(nj_lz_encoder_t* encoder, nj_allocator_t* allocator, nj_lz_level_t level);
+void nj_lz_encoder_destroy(nj_lz_encoder_t* encoder);
+
+// Max compressed size of |size| bytes.
+njsp nj_lz_compress_bound(njsp size);
+// |dst_capacity| must be at least nj_lz_compress_bound(|src_size|). Returns the
+// compressed size.
+njsp nj_lz_compress(nj_lz_encoder_t* encoder, const nju8* src, njsp src_size, nju8* dst, njsp dst_capacity);
+// Returns the decompressed size, -1 if |src| is invalid or doesn't fit in
+// |dst|. Never reads or writes out of the buffers.
+njsp nj_lz_decompress(const nju8* src, njsp src_size, nju8* dst, njsp dst_capacity);
+
+// The frame format is a header (magic, version, log2 of the max block size)
+// then blocks, each prefixed by its size as a little endian nju32, and a 0
+// size to end. Blocks are independent so memory is bounded to a block.
+typedef bool (*nj_lz_write_func_t)(void* user_data, const nju8* data, njsp size);
+
+struct nj_lz_frame_header_t {
+  nju32 magic;
+  nju8 version;
+  nju8 block_size_log2;
+  nju16 reserved;
+};
+
+struct nj_lz_writer_t {
+  nj_lz_encoder_t encoder;
+  nj_lz_write_func_t write;
+  void* user_data;
+  njsp block_size;
+  nju8* block;
+  njsp block_len;
+  // 4 bytes for the block size then the compressed block.
+  nju8* compressed;
+  bool is_ok;
+};
+
+// Compressed data is passed to |write| as it's produced.
+bool nj_lz_writer_init(nj_lz_writer_t* writer, nj_allocator_t* allocator, nj_lz_level_t level, int block_size_log2, nj_lz_write_func_t write, void* user_data);
+void nj_lz_writer_destroy(nj_lz_writer_t* writer);
+bool nj_lz_writer_write(nj_lz_writer_t* writer, const void* data, njsp size);
+// Write the last block and the end of the frame.
+bool nj_lz_writer_finish(nj_lz_writer_t* writer);
+
+enum nj_lz_reader_state_t {
+  NJ_LZ_READER_STATE_HEADER,
+  NJ_LZ_READER_STATE_BLOCK_SIZE,
+  NJ_LZ_READER_STATE_BLOCK,
+  NJ_LZ_READER_STATE_DONE,
+  NJ_LZ_READER_STATE_ERROR,
+};
+
+// Compressed data can be fed in pieces of any size. A block that is whole in
+// the fed piece is decoded in place, otherwise it's gathered in |staging|.
+struct nj_lz_reader_t {
+  nj_allocator_t* allocator;
+  nj_lz_write_func_t write;
+  void* user_data;
+  nj_lz_reader_state_t state;
+  // Bytes of the header or block size gathered so far.
+  nju8 prefix[sizeof(nj_lz_frame_header_t)];
+  njsp prefix_len;
+  njsp block_size;
+  nju32 block_header;
+  nju8* staging;
+  njsp staging_len;
+  nju8* block;
+};
+
+// Decompressed blocks are passed to |write|.
+bool nj_lz_reader_init(nj_lz_reader_t* reader, nj_allocator_t* allocator, nj_lz_write_func_t write, void* user_data);
+void nj_lz_reader_destroy(nj_lz_reader_t* reader);
+// Returns false if the frame is invalid or |write| failed. Data after the end
+// of the frame is ignored.
+bool nj_lz_reader_feed(nj_lz_reader_t* reader, const void* data, njsp size);
+bool nj_lz_reader_is_done(const nj_lz_reader_t* reader);
+
+#endif // NJ_CORE_LZ_H
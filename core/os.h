@@ -19,4 +19,16 @@
 #define NJ_OS_WIN() NJ_OS_WIN_
 #define NJ_OS_LINUX() NJ_OS_LINUX_
 
+// CPU macros
+#if defined(__x86_64__) || defined(_M_X64)
+#  define NJ_CPU_X64_ 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#  define NJ_CPU_ARM64_ 1
+#endif
+
+#define NJ_CPU_X64() NJ_CPU_X64_
+#define NJ_CPU_ARM64() NJ_CPU_ARM64_
+
 #endif // NJ_CORE_OS_H
@@ -0,0 +1,234 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/pack.h"
+
+#include "core/allocator.h"
+#include "core/log.h"
+#include "core/lz.h"
+#include "core/sort.inl"
+#include "core/utils.h"
+
+#include <string.h>
+
+// The buckets are indexed by 32 bits at most.
+#define NJ_PACK_MAX_BUCKET_BITS (24)
+
+static const nju8 gc_zeros[NJ_PACK_ALIGNMENT] = {};
+
+static char pack_normalize_char(char c) {
+  return c == '\\' ? '/' : c;
+}
+
+static bool pack_name_equals(const char* stored_name, const char* name) {
+  for (; *stored_name && pack_normalize_char(*name) == *stored_name; ++stored_name, ++name) {
+  }
+  return !*stored_name && !*name;
+}
+
+static njsp pack_align_up(njsp size) {
+  return (size + NJ_PACK_ALIGNMENT - 1) / NJ_PACK_ALIGNMENT * NJ_PACK_ALIGNMENT;
+}
+
+static nju32 pack_get_bucket(nju64 hash, nju32 bucket_bits) {
+  return bucket_bits ? (nju32)(hash >> (64 - bucket_bits)) : 0;
+}
+
+static njsp pack_get_toc_size(nju32 entry_count, nju32 bucket_bits, njsp names_size) {
+  return sizeof(nj_pack_header_t) + entry_count * sizeof(nj_pack_entry_t) + ((1ll << bucket_bits) + 1) * sizeof(nju32) + names_size;
+}
+
+nju64 nj_pack_hash(const char* name) {
+  // FNV-1a.
+  nju64 hash = 0xcbf29ce484222325;
+  for (; *name; ++name) {
+    hash ^= (nju8)pack_normalize_char(*name);
+    hash *= 1099511628211;
+  }
+  return hash;
+}
+
+bool nj_pack_open(nj_pack_t* pack, const nj_os_char* path) {
+  NJ_CHECK_RETURN_VAL(nj_file_map(&pack->map, path, NJ_FILE_MAP_HINT_RANDOM), false);
+  const nj_pack_header_t* header = (const nj_pack_header_t*)pack->map.data;
+  bool is_valid = pack->map.size >= (njsp)sizeof(nj_pack_header_t) && header->magic == NJ_PACK_MAGIC && header->version == NJ_PACK_VERSION && header->bucket_bits <= NJ_PACK_MAX_BUCKET_BITS;
+  is_valid = is_valid && (njsp)header->names_size <= pack->map.size && pack_get_toc_size(header->entry_count, header->bucket_bits, header->names_size) <= pack->map.size;
+  if (!is_valid) {
+    nj_file_unmap(&pack->map);
+    NJ_LOGW("Invalid pack " NJ_OS_PCT, path);
+    return false;
+  }
+  pack->header = header;
+  pack->entries = (const nj_pack_entry_t*)(header + 1);
+  pack->buckets = (const nju32*)(pack->entries + header->entry_count);
+  pack->names = (const char*)(pack->buckets + (1ll << header->bucket_bits) + 1);
+  return true;
+}
+
+void nj_pack_close(nj_pack_t* pack) {
+  nj_file_unmap(&pack->map);
+  pack->header = NULL;
+}
+
+const nj_pack_entry_t* nj_pack_find(const nj_pack_t* pack, const char* name) {
+  nju64 hash = nj_pack_hash(name);
+  nju32 bucket = pack_get_bucket(hash, pack->header->bucket_bits);
+  nju32 end = nj_min(pack->buckets[bucket + 1], pack->header->entry_count);
+  for (nju32 i = pack->buckets[bucket]; i < end; ++i) {
+    const nj_pack_entry_t* entry = &pack->entries[i];
+    if (entry->hash == hash && entry->name_offset < pack->header->names_size && pack_name_equals(pack->names + entry->name_offset, name))
+      return entry;
+  }
+  return NULL;
+}
+
+bool nj_pack_get_data(const nj_pack_t* pack, const char* name, const nju8** data, njsp* size) {
+  const nj_pack_entry_t* entry = nj_pack_find(pack, name);
+  NJ_CHECK_LOG_RETURN_VAL(entry, false, "Can't find %s in the pack", name);
+  NJ_CHECK_LOG_RETURN_VAL(entry->codec == NJ_PACK_CODEC_NONE, false, "%s is compressed", name);
+  NJ_CHECK_LOG_RETURN_VAL(entry->offset <= (nju64)pack->map.size && entry->size <= pack->map.size - entry->offset, false, "%s is out of the pack", name);
+  *data = pack->map.data + entry->offset;
+  *size = entry->size;
+  return true;
+}
+
+bool nj_pack_read(const nj_pack_t* pack, const nj_pack_entry_t* entry, nju8* dst, njsp dst_size) {
+  const char* name = pack->names + entry->name_offset;
+  NJ_CHECK_LOG_RETURN_VAL(entry->offset <= (nju64)pack->map.size && entry->size <= pack->map.size - entry->offset, false, "%s is out of the pack", name);
+  NJ_CHECK_LOG_RETURN_VAL(entry->original_size <= (nju64)dst_size, false, "%s doesn't fit", name);
+  const nju8* data = pack->map.data + entry->offset;
+  if (entry->codec == NJ_PACK_CODEC_NONE) {
+    memcpy(dst, data, entry->size);
+    return true;
+  }
+  NJ_CHECK_LOG_RETURN_VAL(entry->codec == NJ_PACK_CODEC_LZ, false, "Unknown codec for %s", name);
+  njsp size = nj_lz_decompress(data, entry->size, dst, entry->original_size);
+  NJ_CHECK_LOG_RETURN_VAL(size == (njsp)entry->original_size, false, "%s is corrupted", name);
+  return true;
+}
+
+// Returns the stored data of an entry, |*compressed| is set if it's smaller
+// with |codec| and must be freed.
+static const nju8* pack_encode_entry(nj_lz_encoder_t* encoder, const nj_pack_input_t* input, const nju8* data, njsp* size, nju8** compressed) {
+  *compressed = NULL;
+  // LZ positions are 32 bits.
+  if (input->codec != NJ_PACK_CODEC_LZ || !*size || *size > 0x7fffffff)
+    return data;
+  njsp capacity = nj_lz_compress_bound(*size);
+  *compressed = (nju8*)encoder->allocator->alloc(capacity);
+  NJ_CHECK_LOG_RETURN_VAL(*compressed, NULL, "Can't allocate the compressed %s", input->name);
+  njsp compressed_size = nj_lz_compress(encoder, data, *size, *compressed, capacity);
+  if (compressed_size >= *size) {
+    encoder->allocator->free(*compressed);
+    *compressed = NULL;
+    return data;
+  }
+  *size = compressed_size;
+  return *compressed;
+}
+
+static bool pack_write_entries(nj_file_t* file, const nj_pack_input_t* inputs, const int* order, nj_pack_entry_t* entries, int count, njsp offset, nj_lz_encoder_t* encoder) {
+  for (int i = 0; i < count; ++i) {
+    const nj_pack_input_t* input = &inputs[order[i]];
+    NJ_CHECK_LOG_RETURN_VAL(input->codec == NJ_PACK_CODEC_NONE || input->codec == NJ_PACK_CODEC_LZ, false, "Unknown codec for %s", input->name);
+    nj_file_map_t map;
+    NJ_CHECK_RETURN_VAL(nj_file_map(&map, input->path), false);
+    njsp original_size = map.size;
+    njsp size = original_size;
+    nju8* compressed;
+    const nju8* data = pack_encode_entry(encoder, input, map.data, &size, &compressed);
+    // At least one zero byte follows each entry.
+    njsp padding = pack_align_up(size + 1) - size;
+    bool rv = data && (!size || nj_file_write(file, data, size, NULL)) && nj_file_write(file, gc_zeros, padding, NULL);
+    if (compressed)
+      encoder->allocator->free(compressed);
+    nj_file_unmap(&map);
+    NJ_CHECK_LOG_RETURN_VAL(rv, false, "Can't write %s to the pack", input->name);
+    entries[i].offset = offset;
+    entries[i].size = size;
+    entries[i].original_size = original_size;
+    entries[i].codec = compressed ? NJ_PACK_CODEC_LZ : NJ_PACK_CODEC_NONE;
+    offset += size + padding;
+  }
+  return true;
+}
+
+bool nj_pack_write(const nj_os_char* path, const nj_pack_input_t* inputs, int count, nj_allocator_t* allocator) {
+  NJ_CHECK_LOG_RETURN_VAL(count > 0, false, "The pack is empty");
+  nju64* hashes = (nju64*)allocator->alloc(count * sizeof(nju64));
+  NJ_CHECK_LOG_RETURN_VAL(hashes, false, "Can't allocate the pack entries");
+  int* order = (int*)allocator->alloc(count * sizeof(int));
+  if (!order) {
+    allocator->free(hashes);
+    NJ_LOGW("Can't allocate the pack entries");
+    return false;
+  }
+  njsp names_size = 0;
+  for (int i = 0; i < count; ++i) {
+    hashes[i] = nj_pack_hash(inputs[i].name);
+    order[i] = i;
+    names_size += strlen(inputs[i].name) + 1;
+  }
+  bool rv = nj_radix_sort(hashes, order, count, allocator);
+  for (int i = 1; rv && i < count; ++i) {
+    rv = hashes[i] != hashes[i - 1] || !pack_name_equals(inputs[order[i - 1]].name, inputs[order[i]].name);
+    NJ_CHECK_LOG(rv, "%s is in the pack twice", inputs[order[i]].name);
+  }
+  nju32 bucket_bits = 0;
+  while (bucket_bits < NJ_PACK_MAX_BUCKET_BITS && (1 << bucket_bits) < count)
+    ++bucket_bits;
+  njsp toc_size = pack_get_toc_size(count, bucket_bits, names_size);
+  nju8* toc = rv ? (nju8*)allocator->alloc_zero(toc_size) : NULL;
+  nj_file_t file;
+  rv = toc && nj_file_open(&file, path, NJ_FILE_MODE_WRITE);
+  if (rv) {
+    nj_pack_header_t* header = (nj_pack_header_t*)toc;
+    nj_pack_entry_t* entries = (nj_pack_entry_t*)(header + 1);
+    nju32* buckets = (nju32*)(entries + count);
+    char* names = (char*)(buckets + (1ll << bucket_bits) + 1);
+    header->magic = NJ_PACK_MAGIC;
+    header->version = NJ_PACK_VERSION;
+    header->entry_count = count;
+    header->bucket_bits = bucket_bits;
+    header->names_size = names_size;
+    njsp name_offset = 0;
+    nju32 bucket = 0;
+    for (int i = 0; i < count; ++i) {
+      entries[i].hash = hashes[i];
+      entries[i].name_offset = (nju32)name_offset;
+      for (const char* c = inputs[order[i]].name; *c; ++c)
+        names[name_offset++] = pack_normalize_char(*c);
+      names[name_offset++] = 0;
+      for (nju32 entry_bucket = pack_get_bucket(hashes[i], bucket_bits); bucket <= entry_bucket; ++bucket)
+        buckets[bucket] = i;
+    }
+    for (; bucket <= (1u << bucket_bits); ++bucket)
+      buckets[bucket] = count;
+
+    // The data goes first so the offsets are known when the table of contents
+    // is written.
+    njsp data_offset = pack_align_up(toc_size);
+    nj_file_seek(&file, NJ_FILE_FROM_BEGIN, data_offset);
+    nj_lz_encoder_t encoder;
+    rv = nj_lz_encoder_init(&encoder, allocator, NJ_LZ_LEVEL_HIGH);
+    if (rv) {
+      rv = pack_write_entries(&file, inputs, order, entries, count, data_offset, &encoder);
+      nj_lz_encoder_destroy(&encoder);
+    }
+    if (rv) {
+      nj_file_seek(&file, NJ_FILE_FROM_BEGIN, 0);
+      rv = nj_file_write(&file, toc, toc_size, NULL);
+    }
+    nj_file_close(&file);
+    if (!rv)
+      nj_file_delete_path(path);
+  }
+  if (toc)
+    allocator->free(toc);
+  allocator->free(hashes);
+  allocator->free(order);
+  return rv;
+}
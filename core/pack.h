@@ -0,0 +1,91 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_PACK_H
+#define NJ_CORE_PACK_H
+
+#include "core/file.h"
+#include "core/njtype.h"
+#include "core/os_string.h"
+
+struct nj_allocator_t;
+
+#define NJ_PACK_MAGIC (0x4b504a4e) // "NJPK"
+#define NJ_PACK_VERSION (1)
+// Entries start at a multiple of it so they can be read with
+// NJ_FILE_MODE_DIRECT.
+#define NJ_PACK_ALIGNMENT (4096)
+
+enum nj_pack_codec_t {
+  NJ_PACK_CODEC_NONE = 0,
+  // A single nj_lz_compress() block. Inputs with it are stored uncompressed if
+  // it doesn't make them smaller.
+  NJ_PACK_CODEC_LZ = 1,
+};
+
+// A pack is a header followed by the table of contents (entries, buckets then
+// names), then the data of each entry. All integers are little endian.
+struct nj_pack_header_t {
+  nju32 magic;
+  nju32 version;
+  nju32 entry_count;
+  // There are 2^bucket_bits buckets.
+  nju32 bucket_bits;
+  nju64 names_size;
+  nju64 reserved;
+};
+
+// Entries are sorted by |hash|. Bucket b is the range of entries whose hash
+// starts with the bits b, stored as the index of its first entry, so a lookup
+// only looks at the entries with the same top bits.
+struct nj_pack_entry_t {
+  nju64 hash;
+  nju64 offset;
+  // Stored size, |original_size| is the size once decompressed.
+  nju64 size;
+  nju64 original_size;
+  // Offset of the NUL-terminated name in the names.
+  nju32 name_offset;
+  nju32 codec;
+};
+
+struct nj_pack_t {
+  nj_file_map_t map;
+  const nj_pack_header_t* header;
+  const nj_pack_entry_t* entries;
+  // 2^bucket_bits + 1 entry indices.
+  const nju32* buckets;
+  const char* names;
+};
+
+struct nj_pack_input_t {
+  // The name to find the entry with, "/" separated.
+  const char* name;
+  const nj_os_char* path;
+  nj_pack_codec_t codec = NJ_PACK_CODEC_NONE;
+};
+
+// Hash of an entry name, "\" and "/" are the same.
+nju64 nj_pack_hash(const char* name);
+
+// Map the pack at |path|, only its table of contents is read.
+bool nj_pack_open(nj_pack_t* pack, const nj_os_char* path);
+void nj_pack_close(nj_pack_t* pack);
+
+// NULL if |name| isn't in the pack.
+const nj_pack_entry_t* nj_pack_find(const nj_pack_t* pack, const char* name);
+// The data of an uncompressed entry, in place in the mapping and followed by
+// a zero byte like nj_file_map(), so it can be passed to the loaders.
+bool nj_pack_get_data(const nj_pack_t* pack, const char* name, const nju8** data, njsp* size);
+// Copy or decompress |entry| to |dst|, |dst_size| must be at least its
+// |original_size|.
+bool nj_pack_read(const nj_pack_t* pack, const nj_pack_entry_t* entry, nju8* dst, njsp dst_size);
+
+// Write a pack of |count| files at |path|. |allocator| is used for temporary
+// memory.
+bool nj_pack_write(const nj_os_char* path, const nj_pack_input_t* inputs, int count, nj_allocator_t* allocator);
+
+#endif // NJ_CORE_PACK_H
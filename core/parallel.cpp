@@ -0,0 +1,17 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/parallel.h"
+
+static bool g_parallel_is_enabled = true;
+
+void nj_parallel_set_enabled(bool is_enabled) {
+  g_parallel_is_enabled = is_enabled;
+}
+
+bool nj_parallel_is_enabled() {
+  return g_parallel_is_enabled;
+}
@@ -0,0 +1,51 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_PARALLEL_H
+#define NJ_CORE_PARALLEL_H
+
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+
+// Data-parallel algorithms that run on the job system's workers. The calling
+// thread takes part through nj_job_wait(). Everything runs serially on the
+// calling thread when parallelism is disabled, there's a single worker or the
+// range is smaller than |grain_size|.
+
+// Turn parallelism off/on at runtime, e.g. to compare against serial runs.
+void nj_parallel_set_enabled(bool is_enabled);
+bool nj_parallel_is_enabled();
+
+// Calls |func|(begin, end) on disjoint sub-ranges covering [|begin|, |end|).
+// Sub-ranges start large and shrink as the range runs out (guided scheduling)
+// so uneven items still balance, but are never smaller than |grain_size|
+// (1 if 0).
+template <typename Func>
+void nj_parallel_for(njsp begin, njsp end, Func func, njsp grain_size = 0);
+
+// |func|(begin, end, identity) returns the reduction of a sub-range, the
+// results are folded with |combine| in range order so the result doesn't
+// depend on the scheduling.
+template <typename T, typename Func, typename Combine>
+T nj_parallel_reduce(njsp begin, njsp end, const T& identity, Func func, Combine combine, njsp grain_size = 0);
+
+// |out|[i] = |in|[0] op ... op |in|[i]. |op| must be associative, |in| and
+// |out| can be the same array.
+template <typename T, typename Op>
+void nj_parallel_inclusive_scan(const T* in, T* out, njsp num, Op op, njsp grain_size = 0);
+
+// |out|[i] = |init| op |in|[0] op ... op |in|[i - 1].
+template <typename T, typename Op>
+void nj_parallel_exclusive_scan(const T* in, T* out, njsp num, const T& init, Op op, njsp grain_size = 0);
+
+// Move the items for which |pred| is true before the others, keeping their
+// relative order. |pred| is called twice per item so it must be pure. Returns
+// the number of true items.
+template <typename T, typename Pred>
+njsp nj_parallel_stable_partition(T* p, njsp num, Pred pred, nj_allocator_t* allocator, njsp grain_size = 0);
+
+#endif // NJ_CORE_PARALLEL_H
@@ -0,0 +1,247 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_PARALLEL_INL
+#define NJ_CORE_PARALLEL_INL
+
+#include "core/parallel.h"
+
+#include "core/allocator.h"
+#include "core/atomic.h"
+#include "core/job.h"
+#include "core/log.h"
+#include "core/utils.h"
+
+#define NJ_PARALLEL_MAX_JOBS (64)
+#define NJ_PARALLEL_MAX_CHUNKS (256)
+
+// Default grain of the chunked algorithms, whose per item work is small.
+static const njsp gc_parallel_default_grain = 4096;
+// Chunks per worker for the chunked algorithms, > 1 to absorb imbalance.
+static const njsp gc_parallel_chunks_per_worker = 4;
+
+template <typename Func>
+struct nj_parallel_for_t {
+  njsp next;
+  njsp end;
+  njsp grain_size;
+  njsp divisor;
+  Func* func;
+};
+
+template <typename Func>
+struct nj_parallel_chunks_t {
+  njsp next_chunk;
+  njsp chunk_count;
+  Func* func;
+};
+
+inline int nj_parallel_get_job_count() {
+  if (!nj_parallel_is_enabled())
+    return 1;
+  return nj_min(nj_job_get_worker_count(), NJ_PARALLEL_MAX_JOBS);
+}
+
+// Number of equal chunks to split |num| items into.
+inline njsp nj_parallel_get_chunk_count(njsp num, njsp grain_size) {
+  int job_count = nj_parallel_get_job_count();
+  if (job_count <= 1)
+    return 1;
+  if (!grain_size)
+    grain_size = gc_parallel_default_grain;
+  njsp chunk_count = nj_min<njsp>(job_count * gc_parallel_chunks_per_worker, NJ_PARALLEL_MAX_CHUNKS);
+  return nj_max<njsp>(1, nj_min(chunk_count, num / grain_size));
+}
+
+inline njsp nj_parallel_chunk_begin(njsp num, njsp chunk_count, njsp chunk) {
+  return num * chunk / chunk_count;
+}
+
+inline void nj_parallel_run_jobs(nj_job_func_t job_func, void* args, int job_count) {
+  nj_job_desc_t descs[NJ_PARALLEL_MAX_JOBS];
+  for (int i = 0; i < job_count; ++i)
+    descs[i] = {job_func, args};
+  nj_job_counter_t counter = {};
+  nj_job_run(descs, job_count, &counter);
+  nj_job_wait(&counter);
+}
+
+template <typename Func>
+void nj_parallel_for_job(void* args) {
+  nj_parallel_for_t<Func>* ctx = (nj_parallel_for_t<Func>*)args;
+  njsp begin = nj_atomic_load(&ctx->next, NJ_MEMORY_ORDER_RELAXED);
+  while (begin < ctx->end) {
+    njsp size = nj_max(ctx->grain_size, (ctx->end - begin) / ctx->divisor);
+    njsp end = nj_min(ctx->end, begin + size);
+    if (nj_atomic_cas_weak(&ctx->next, &begin, end, NJ_MEMORY_ORDER_RELAXED)) {
+      (*ctx->func)(begin, end);
+      begin = nj_atomic_load(&ctx->next, NJ_MEMORY_ORDER_RELAXED);
+    }
+  }
+}
+
+template <typename Func>
+void nj_parallel_chunks_job(void* args) {
+  nj_parallel_chunks_t<Func>* ctx = (nj_parallel_chunks_t<Func>*)args;
+  for (;;) {
+    njsp chunk = nj_atomic_fetch_add(&ctx->next_chunk, (njsp)1, NJ_MEMORY_ORDER_RELAXED);
+    if (chunk >= ctx->chunk_count)
+      return;
+    (*ctx->func)(chunk);
+  }
+}
+
+// Calls |func|(chunk) for each chunk in [0, |chunk_count|).
+template <typename Func>
+void nj_parallel_run_chunks(njsp chunk_count, Func func) {
+  if (chunk_count <= 1) {
+    for (njsp i = 0; i < chunk_count; ++i)
+      func(i);
+    return;
+  }
+  nj_parallel_chunks_t<Func> ctx = {0, chunk_count, &func};
+  int job_count = (int)nj_min<njsp>(nj_parallel_get_job_count(), chunk_count);
+  nj_parallel_run_jobs(nj_parallel_chunks_job<Func>, &ctx, job_count);
+}
+
+template <typename Func>
+void nj_parallel_for(njsp begin, njsp end, Func func, njsp grain_size) {
+  if (!grain_size)
+    grain_size = 1;
+  int job_count = nj_parallel_get_job_count();
+  if (job_count <= 1 || end - begin <= grain_size) {
+    if (begin < end)
+      func(begin, end);
+    return;
+  }
+  job_count = (int)nj_min<njsp>(job_count, (end - begin + grain_size - 1) / grain_size);
+  nj_parallel_for_t<Func> ctx = {begin, end, grain_size, 2 * (njsp)job_count, &func};
+  nj_parallel_run_jobs(nj_parallel_for_job<Func>, &ctx, job_count);
+}
+
+template <typename T, typename Func, typename Combine>
+T nj_parallel_reduce(njsp begin, njsp end, const T& identity, Func func, Combine combine, njsp grain_size) {
+  njsp num = end - begin;
+  if (num <= 0)
+    return identity;
+  njsp chunk_count = nj_parallel_get_chunk_count(num, grain_size);
+  if (chunk_count == 1)
+    return func(begin, end, identity);
+  T results[NJ_PARALLEL_MAX_CHUNKS];
+  nj_parallel_run_chunks(chunk_count, [&](njsp chunk) {
+    njsp chunk_begin = begin + nj_parallel_chunk_begin(num, chunk_count, chunk);
+    njsp chunk_end = begin + nj_parallel_chunk_begin(num, chunk_count, chunk + 1);
+    results[chunk] = func(chunk_begin, chunk_end, identity);
+  });
+  T rv = results[0];
+  for (njsp i = 1; i < chunk_count; ++i)
+    rv = combine(rv, results[i]);
+  return rv;
+}
+
+// Scans each chunk after adding the total of the previous chunks. The chunk
+// totals are computed in a first parallel pass.
+template <typename T, typename Op>
+void nj_parallel_scan_internal(const T* in, T* out, njsp num, const T* init, Op& op, njsp grain_size) {
+  if (num <= 0)
+    return;
+  njsp chunk_count = nj_parallel_get_chunk_count(num, grain_size);
+  T sums[NJ_PARALLEL_MAX_CHUNKS];
+  if (chunk_count > 1) {
+    nj_parallel_run_chunks(chunk_count, [&](njsp chunk) {
+      njsp b = nj_parallel_chunk_begin(num, chunk_count, chunk);
+      njsp e = nj_parallel_chunk_begin(num, chunk_count, chunk + 1);
+      T sum = in[b];
+      for (njsp i = b + 1; i < e; ++i)
+        sum = op(sum, in[i]);
+      sums[chunk] = sum;
+    });
+    // sums[i] becomes the total of chunks [0, i).
+    T running = sums[0];
+    for (njsp i = 1; i < chunk_count; ++i) {
+      T chunk_sum = sums[i];
+      sums[i] = running;
+      running = op(running, chunk_sum);
+    }
+  }
+  nj_parallel_run_chunks(chunk_count, [&](njsp chunk) {
+    njsp b = nj_parallel_chunk_begin(num, chunk_count, chunk);
+    njsp e = nj_parallel_chunk_begin(num, chunk_count, chunk + 1);
+    if (init) {
+      T prefix = chunk > 0 ? op(*init, sums[chunk]) : *init;
+      for (njsp i = b; i < e; ++i) {
+        T val = in[i];
+        out[i] = prefix;
+        prefix = op(prefix, val);
+      }
+    } else {
+      T prefix = chunk > 0 ? op(sums[chunk], in[b]) : in[b];
+      out[b] = prefix;
+      for (njsp i = b + 1; i < e; ++i) {
+        prefix = op(prefix, in[i]);
+        out[i] = prefix;
+      }
+    }
+  });
+}
+
+template <typename T, typename Op>
+void nj_parallel_inclusive_scan(const T* in, T* out, njsp num, Op op, njsp grain_size) {
+  nj_parallel_scan_internal(in, out, num, (const T*)NULL, op, grain_size);
+}
+
+template <typename T, typename Op>
+void nj_parallel_exclusive_scan(const T* in, T* out, njsp num, const T& init, Op op, njsp grain_size) {
+  nj_parallel_scan_internal(in, out, num, &init, op, grain_size);
+}
+
+template <typename T, typename Pred>
+njsp nj_parallel_stable_partition(T* p, njsp num, Pred pred, nj_allocator_t* allocator, njsp grain_size) {
+  if (num <= 0)
+    return 0;
+  njsp chunk_count = nj_parallel_get_chunk_count(num, grain_size);
+  T* tmp = (T*)allocator->alloc(num * sizeof(T));
+  NJ_CHECK_LOG_RETURN_VAL(tmp, 0, "Can't allocate the partition buffer");
+  // Number of true items in each chunk, then where each chunk's true items go.
+  njsp true_offsets[NJ_PARALLEL_MAX_CHUNKS];
+  nj_parallel_run_chunks(chunk_count, [&](njsp chunk) {
+    njsp b = nj_parallel_chunk_begin(num, chunk_count, chunk);
+    njsp e = nj_parallel_chunk_begin(num, chunk_count, chunk + 1);
+    njsp count = 0;
+    for (njsp i = b; i < e; ++i)
+      count += pred(p[i]) ? 1 : 0;
+    true_offsets[chunk] = count;
+  });
+  njsp true_count = 0;
+  for (njsp i = 0; i < chunk_count; ++i) {
+    njsp count = true_offsets[i];
+    true_offsets[i] = true_count;
+    true_count += count;
+  }
+  nj_parallel_run_chunks(chunk_count, [&](njsp chunk) {
+    njsp b = nj_parallel_chunk_begin(num, chunk_count, chunk);
+    njsp e = nj_parallel_chunk_begin(num, chunk_count, chunk + 1);
+    njsp true_dst = true_offsets[chunk];
+    // False items before this chunk = items before it - true items before it.
+    njsp false_dst = true_count + b - true_dst;
+    for (njsp i = b; i < e; ++i) {
+      if (pred(p[i]))
+        tmp[true_dst++] = p[i];
+      else
+        tmp[false_dst++] = p[i];
+    }
+  });
+  nj_parallel_run_chunks(chunk_count, [&](njsp chunk) {
+    njsp b = nj_parallel_chunk_begin(num, chunk_count, chunk);
+    njsp e = nj_parallel_chunk_begin(num, chunk_count, chunk + 1);
+    for (njsp i = b; i < e; ++i)
+      p[i] = tmp[i];
+  });
+  allocator->free(tmp);
+  return true_count;
+}
+
+#endif // NJ_CORE_PARALLEL_INL
@@ -0,0 +1,140 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_QUEUE_H
+#define NJ_CORE_QUEUE_H
+
+#include "core/atomic.h"
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+
+#define NJ_QUEUE_INFINITE (-1)
+
+// Lets one side of a queue sleep until the other side makes progress. |seq| is
+// only bumped when there are |waiters| so queues that are never waited on
+// don't make any syscall.
+struct nj_queue_signal_t {
+  nju32 seq;
+  nju32 waiters;
+};
+
+// Bounded wait-free single producer single consumer ring buffer. |head| and
+// |tail| only grow, the slot is their value & |mask|. Each side caches the
+// other side's counter so it only touches the other cache line when the queue
+// looks full/empty.
+template <typename T>
+struct nj_spsc_queue_t {
+  // Producer.
+  alignas(NJ_CACHE_LINE_SIZE) njsz tail;
+  njsz cached_head;
+  // Consumer.
+  alignas(NJ_CACHE_LINE_SIZE) njsz head;
+  njsz cached_tail;
+  // Shared, read only after init.
+  alignas(NJ_CACHE_LINE_SIZE) nj_allocator_t* allocator;
+  T* items;
+  njsz mask;
+  bool is_blocking;
+  nj_queue_signal_t not_empty;
+  nj_queue_signal_t not_full;
+};
+
+template <typename T>
+struct nj_mpmc_cell_t {
+  njsz seq;
+  T data;
+};
+
+// Bounded lock-free multi producers multi consumers queue (Dmitry Vyukov's).
+// Each cell has a sequence number that tells whether it is ready to be written
+// (seq == pos) or read (seq == pos + 1), so producers and consumers only
+// contend on their own counter.
+template <typename T>
+struct nj_mpmc_queue_t {
+  alignas(NJ_CACHE_LINE_SIZE) njsz enqueue_pos;
+  alignas(NJ_CACHE_LINE_SIZE) njsz dequeue_pos;
+  alignas(NJ_CACHE_LINE_SIZE) nj_allocator_t* allocator;
+  nj_mpmc_cell_t<T>* cells;
+  njsz mask;
+  bool is_blocking;
+  nj_queue_signal_t not_empty;
+  nj_queue_signal_t not_full;
+};
+
+// |capacity| is rounded up to a power of 2. Only queues created with
+// |is_blocking| can be used with the *_wait() functions, the others skip the
+// wake up bookkeeping (a full fence per operation).
+template <typename T>
+bool nj_spsc_init(nj_spsc_queue_t<T>* q, nj_allocator_t* allocator, njsz capacity, bool is_blocking = false);
+
+template <typename T>
+void nj_spsc_destroy(nj_spsc_queue_t<T>* q);
+
+template <typename T>
+njsz nj_spsc_capacity(const nj_spsc_queue_t<T>* q);
+
+// Approximated when called while the other side is running.
+template <typename T>
+njsz nj_spsc_len(const nj_spsc_queue_t<T>* q);
+
+// Returns false if the queue is full.
+template <typename T>
+bool nj_spsc_push(nj_spsc_queue_t<T>* q, const T& val);
+
+// Returns false if the queue is empty.
+template <typename T>
+bool nj_spsc_pop(nj_spsc_queue_t<T>* q, T* out);
+
+// Push/pop as many as possible of |num| items with a single publish. Returns
+// the number of items pushed/popped.
+template <typename T>
+njsz nj_spsc_push_batch(nj_spsc_queue_t<T>* q, const T* vals, njsz num);
+
+template <typename T>
+njsz nj_spsc_pop_batch(nj_spsc_queue_t<T>* q, T* outs, njsz num);
+
+// Block until the item is pushed/popped or |timeout_ns| passed
+// (NJ_QUEUE_INFINITE to wait forever). Returns false on timeout.
+template <typename T>
+bool nj_spsc_push_wait(nj_spsc_queue_t<T>* q, const T& val, njs64 timeout_ns);
+
+template <typename T>
+bool nj_spsc_pop_wait(nj_spsc_queue_t<T>* q, T* out, njs64 timeout_ns);
+
+template <typename T>
+bool nj_mpmc_init(nj_mpmc_queue_t<T>* q, nj_allocator_t* allocator, njsz capacity, bool is_blocking = false);
+
+template <typename T>
+void nj_mpmc_destroy(nj_mpmc_queue_t<T>* q);
+
+template <typename T>
+njsz nj_mpmc_capacity(const nj_mpmc_queue_t<T>* q);
+
+template <typename T>
+njsz nj_mpmc_len(const nj_mpmc_queue_t<T>* q);
+
+template <typename T>
+bool nj_mpmc_push(nj_mpmc_queue_t<T>* q, const T& val);
+
+template <typename T>
+bool nj_mpmc_pop(nj_mpmc_queue_t<T>* q, T* out);
+
+// Items of a batch are claimed one by one so they may interleave with other
+// producers/consumers' items.
+template <typename T>
+njsz nj_mpmc_push_batch(nj_mpmc_queue_t<T>* q, const T* vals, njsz num);
+
+template <typename T>
+njsz nj_mpmc_pop_batch(nj_mpmc_queue_t<T>* q, T* outs, njsz num);
+
+template <typename T>
+bool nj_mpmc_push_wait(nj_mpmc_queue_t<T>* q, const T& val, njs64 timeout_ns);
+
+template <typename T>
+bool nj_mpmc_pop_wait(nj_mpmc_queue_t<T>* q, T* out, njs64 timeout_ns);
+
+#endif // NJ_CORE_QUEUE_H
@@ -0,0 +1,342 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_QUEUE_INL
+#define NJ_CORE_QUEUE_INL
+
+#include "core/queue.h"
+
+#include "core/allocator.h"
+#include "core/futex.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+
+// Number of tries before the *_wait() functions go to sleep.
+static const int gc_queue_spin_count = 64;
+
+inline njsz nj_queue_round_capacity(njsz capacity) {
+  njsz rv = 2;
+  while (rv < capacity)
+    rv <<= 1;
+  return rv;
+}
+
+// Returns the deadline in mono time or -1 if there is none.
+inline njs64 nj_queue_deadline(njs64 timeout_ns) {
+  if (timeout_ns < 0)
+    return -1;
+  return nj_mono_time_now() + nj_s_to_mono_time(timeout_ns / 1000000000.0);
+}
+
+inline void nj_queue_signal_notify(nj_queue_signal_t* s) {
+  // Pairs with the waiters increment in nj_queue_signal_prepare_wait(): either
+  // the waiter sees our item when it tries again or we see it waiting.
+  nj_atomic_fence();
+  if (nj_atomic_load(&s->waiters, NJ_MEMORY_ORDER_RELAXED)) {
+    nj_atomic_fetch_add(&s->seq, 1u);
+    nj_futex_wake_all(&s->seq);
+  }
+}
+
+// The caller must try again after this and before nj_queue_signal_wait() so it
+// can't miss a notification.
+inline nju32 nj_queue_signal_prepare_wait(nj_queue_signal_t* s) {
+  nj_atomic_fetch_add(&s->waiters, 1u);
+  return nj_atomic_load(&s->seq);
+}
+
+inline void nj_queue_signal_cancel_wait(nj_queue_signal_t* s) {
+  nj_atomic_fetch_sub(&s->waiters, 1u);
+}
+
+// Returns false if |deadline| passed without sleeping.
+inline bool nj_queue_signal_wait(nj_queue_signal_t* s, nju32 seq, njs64 deadline) {
+  njs64 timeout_ns = NJ_FUTEX_INFINITE;
+  if (deadline >= 0) {
+    njs64 now = nj_mono_time_now();
+    if (now >= deadline) {
+      nj_queue_signal_cancel_wait(s);
+      return false;
+    }
+    timeout_ns = (njs64)(nj_mono_time_to_us(deadline - now) * 1000.0) + 1;
+  }
+  nj_futex_wait(&s->seq, seq, timeout_ns);
+  nj_queue_signal_cancel_wait(s);
+  return true;
+}
+
+template <typename T>
+bool nj_spsc_init(nj_spsc_queue_t<T>* q, nj_allocator_t* allocator, njsz capacity, bool is_blocking) {
+  njsz cap = nj_queue_round_capacity(capacity);
+  q->items = (T*)allocator->alloc(cap * sizeof(T));
+  NJ_CHECK_LOG_RETURN_VAL(q->items, false, "Can't allocate nj_spsc_queue_t");
+  q->allocator = allocator;
+  q->mask = cap - 1;
+  q->is_blocking = is_blocking;
+  q->tail = 0;
+  q->cached_head = 0;
+  q->head = 0;
+  q->cached_tail = 0;
+  q->not_empty = {};
+  q->not_full = {};
+  return true;
+}
+
+template <typename T>
+void nj_spsc_destroy(nj_spsc_queue_t<T>* q) {
+  q->allocator->free(q->items);
+  q->items = NULL;
+}
+
+template <typename T>
+njsz nj_spsc_capacity(const nj_spsc_queue_t<T>* q) {
+  return q->mask + 1;
+}
+
+template <typename T>
+njsz nj_spsc_len(const nj_spsc_queue_t<T>* q) {
+  njsz head = nj_atomic_load(&q->head, NJ_MEMORY_ORDER_ACQUIRE);
+  njsz tail = nj_atomic_load(&q->tail, NJ_MEMORY_ORDER_ACQUIRE);
+  return tail - head;
+}
+
+template <typename T>
+njsz nj_spsc_push_batch(nj_spsc_queue_t<T>* q, const T* vals, njsz num) {
+  njsz cap = q->mask + 1;
+  njsz tail = q->tail;
+  if (cap - (tail - q->cached_head) < num)
+    q->cached_head = nj_atomic_load(&q->head, NJ_MEMORY_ORDER_ACQUIRE);
+  njsz free_num = cap - (tail - q->cached_head);
+  if (num > free_num)
+    num = free_num;
+  if (!num)
+    return 0;
+  for (njsz i = 0; i < num; ++i)
+    q->items[(tail + i) & q->mask] = vals[i];
+  nj_atomic_store(&q->tail, tail + num, NJ_MEMORY_ORDER_RELEASE);
+  if (q->is_blocking)
+    nj_queue_signal_notify(&q->not_empty);
+  return num;
+}
+
+template <typename T>
+njsz nj_spsc_pop_batch(nj_spsc_queue_t<T>* q, T* outs, njsz num) {
+  njsz head = q->head;
+  if (q->cached_tail - head < num)
+    q->cached_tail = nj_atomic_load(&q->tail, NJ_MEMORY_ORDER_ACQUIRE);
+  njsz available = q->cached_tail - head;
+  if (num > available)
+    num = available;
+  if (!num)
+    return 0;
+  for (njsz i = 0; i < num; ++i)
+    outs[i] = q->items[(head + i) & q->mask];
+  nj_atomic_store(&q->head, head + num, NJ_MEMORY_ORDER_RELEASE);
+  if (q->is_blocking)
+    nj_queue_signal_notify(&q->not_full);
+  return num;
+}
+
+template <typename T>
+bool nj_spsc_push(nj_spsc_queue_t<T>* q, const T& val) {
+  return nj_spsc_push_batch(q, &val, 1) == 1;
+}
+
+template <typename T>
+bool nj_spsc_pop(nj_spsc_queue_t<T>* q, T* out) {
+  return nj_spsc_pop_batch(q, out, 1) == 1;
+}
+
+template <typename T>
+bool nj_spsc_push_wait(nj_spsc_queue_t<T>* q, const T& val, njs64 timeout_ns) {
+  NJ_CHECK_LOG_RETURN_VAL(q->is_blocking, false, "nj_spsc_queue_t isn't blocking");
+  for (int i = 0; i < gc_queue_spin_count; ++i) {
+    if (nj_spsc_push(q, val))
+      return true;
+    nj_cpu_relax();
+  }
+  njs64 deadline = nj_queue_deadline(timeout_ns);
+  for (;;) {
+    nju32 seq = nj_queue_signal_prepare_wait(&q->not_full);
+    if (nj_spsc_push(q, val)) {
+      nj_queue_signal_cancel_wait(&q->not_full);
+      return true;
+    }
+    if (!nj_queue_signal_wait(&q->not_full, seq, deadline))
+      return false;
+  }
+}
+
+template <typename T>
+bool nj_spsc_pop_wait(nj_spsc_queue_t<T>* q, T* out, njs64 timeout_ns) {
+  NJ_CHECK_LOG_RETURN_VAL(q->is_blocking, false, "nj_spsc_queue_t isn't blocking");
+  for (int i = 0; i < gc_queue_spin_count; ++i) {
+    if (nj_spsc_pop(q, out))
+      return true;
+    nj_cpu_relax();
+  }
+  njs64 deadline = nj_queue_deadline(timeout_ns);
+  for (;;) {
+    nju32 seq = nj_queue_signal_prepare_wait(&q->not_empty);
+    if (nj_spsc_pop(q, out)) {
+      nj_queue_signal_cancel_wait(&q->not_empty);
+      return true;
+    }
+    if (!nj_queue_signal_wait(&q->not_empty, seq, deadline))
+      return false;
+  }
+}
+
+template <typename T>
+bool nj_mpmc_init(nj_mpmc_queue_t<T>* q, nj_allocator_t* allocator, njsz capacity, bool is_blocking) {
+  njsz cap = nj_queue_round_capacity(capacity);
+  q->cells = (nj_mpmc_cell_t<T>*)allocator->alloc(cap * sizeof(nj_mpmc_cell_t<T>));
+  NJ_CHECK_LOG_RETURN_VAL(q->cells, false, "Can't allocate nj_mpmc_queue_t");
+  for (njsz i = 0; i < cap; ++i)
+    q->cells[i].seq = i;
+  q->allocator = allocator;
+  q->mask = cap - 1;
+  q->is_blocking = is_blocking;
+  q->enqueue_pos = 0;
+  q->dequeue_pos = 0;
+  q->not_empty = {};
+  q->not_full = {};
+  return true;
+}
+
+template <typename T>
+void nj_mpmc_destroy(nj_mpmc_queue_t<T>* q) {
+  q->allocator->free(q->cells);
+  q->cells = NULL;
+}
+
+template <typename T>
+njsz nj_mpmc_capacity(const nj_mpmc_queue_t<T>* q) {
+  return q->mask + 1;
+}
+
+template <typename T>
+njsz nj_mpmc_len(const nj_mpmc_queue_t<T>* q) {
+  njsz dequeue_pos = nj_atomic_load(&q->dequeue_pos, NJ_MEMORY_ORDER_RELAXED);
+  njsz enqueue_pos = nj_atomic_load(&q->enqueue_pos, NJ_MEMORY_ORDER_RELAXED);
+  return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+template <typename T>
+static bool mpmc_push_no_signal(nj_mpmc_queue_t<T>* q, const T& val) {
+  njsz pos = nj_atomic_load(&q->enqueue_pos, NJ_MEMORY_ORDER_RELAXED);
+  nj_mpmc_cell_t<T>* cell;
+  for (;;) {
+    cell = &q->cells[pos & q->mask];
+    njsz seq = nj_atomic_load(&cell->seq, NJ_MEMORY_ORDER_ACQUIRE);
+    njsp diff = (njsp)seq - (njsp)pos;
+    if (diff == 0) {
+      if (nj_atomic_cas_weak(&q->enqueue_pos, &pos, pos + 1, NJ_MEMORY_ORDER_RELAXED))
+        break;
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = nj_atomic_load(&q->enqueue_pos, NJ_MEMORY_ORDER_RELAXED);
+    }
+  }
+  cell->data = val;
+  nj_atomic_store(&cell->seq, pos + 1, NJ_MEMORY_ORDER_RELEASE);
+  return true;
+}
+
+template <typename T>
+static bool mpmc_pop_no_signal(nj_mpmc_queue_t<T>* q, T* out) {
+  njsz pos = nj_atomic_load(&q->dequeue_pos, NJ_MEMORY_ORDER_RELAXED);
+  nj_mpmc_cell_t<T>* cell;
+  for (;;) {
+    cell = &q->cells[pos & q->mask];
+    njsz seq = nj_atomic_load(&cell->seq, NJ_MEMORY_ORDER_ACQUIRE);
+    njsp diff = (njsp)seq - (njsp)(pos + 1);
+    if (diff == 0) {
+      if (nj_atomic_cas_weak(&q->dequeue_pos, &pos, pos + 1, NJ_MEMORY_ORDER_RELAXED))
+        break;
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = nj_atomic_load(&q->dequeue_pos, NJ_MEMORY_ORDER_RELAXED);
+    }
+  }
+  *out = cell->data;
+  nj_atomic_store(&cell->seq, pos + q->mask + 1, NJ_MEMORY_ORDER_RELEASE);
+  return true;
+}
+
+template <typename T>
+njsz nj_mpmc_push_batch(nj_mpmc_queue_t<T>* q, const T* vals, njsz num) {
+  njsz i = 0;
+  while (i < num && mpmc_push_no_signal(q, vals[i]))
+    ++i;
+  if (i && q->is_blocking)
+    nj_queue_signal_notify(&q->not_empty);
+  return i;
+}
+
+template <typename T>
+njsz nj_mpmc_pop_batch(nj_mpmc_queue_t<T>* q, T* outs, njsz num) {
+  njsz i = 0;
+  while (i < num && mpmc_pop_no_signal(q, &outs[i]))
+    ++i;
+  if (i && q->is_blocking)
+    nj_queue_signal_notify(&q->not_full);
+  return i;
+}
+
+template <typename T>
+bool nj_mpmc_push(nj_mpmc_queue_t<T>* q, const T& val) {
+  return nj_mpmc_push_batch(q, &val, 1) == 1;
+}
+
+template <typename T>
+bool nj_mpmc_pop(nj_mpmc_queue_t<T>* q, T* out) {
+  return nj_mpmc_pop_batch(q, out, 1) == 1;
+}
+
+template <typename T>
+bool nj_mpmc_push_wait(nj_mpmc_queue_t<T>* q, const T& val, njs64 timeout_ns) {
+  NJ_CHECK_LOG_RETURN_VAL(q->is_blocking, false, "nj_mpmc_queue_t isn't blocking");
+  for (int i = 0; i < gc_queue_spin_count; ++i) {
+    if (nj_mpmc_push(q, val))
+      return true;
+    nj_cpu_relax();
+  }
+  njs64 deadline = nj_queue_deadline(timeout_ns);
+  for (;;) {
+    nju32 seq = nj_queue_signal_prepare_wait(&q->not_full);
+    if (nj_mpmc_push(q, val)) {
+      nj_queue_signal_cancel_wait(&q->not_full);
+      return true;
+    }
+    if (!nj_queue_signal_wait(&q->not_full, seq, deadline))
+      return false;
+  }
+}
+
+template <typename T>
+bool nj_mpmc_pop_wait(nj_mpmc_queue_t<T>* q, T* out, njs64 timeout_ns) {
+  NJ_CHECK_LOG_RETURN_VAL(q->is_blocking, false, "nj_mpmc_queue_t isn't blocking");
+  for (int i = 0; i < gc_queue_spin_count; ++i) {
+    if (nj_mpmc_pop(q, out))
+      return true;
+    nj_cpu_relax();
+  }
+  njs64 deadline = nj_queue_deadline(timeout_ns);
+  for (;;) {
+    nju32 seq = nj_queue_signal_prepare_wait(&q->not_empty);
+    if (nj_mpmc_pop(q, out)) {
+      nj_queue_signal_cancel_wait(&q->not_empty);
+      return true;
+    }
+    if (!nj_queue_signal_wait(&q->not_empty, seq, deadline))
+      return false;
+  }
+}
+
+#endif // NJ_CORE_QUEUE_INL
@@ -0,0 +1,77 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_SLOT_MAP_H
+#define NJ_CORE_SLOT_MAP_H
+
+#include "core/dynamic_array.h"
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+
+#define NJ_SM_INVALID_INDEX (0xffffffff)
+
+// A handle stays valid until its value is erased. A zero-initialized handle is
+// never valid.
+struct nj_slot_handle_t {
+  nju32 index;
+  nju32 generation;
+};
+
+// |generation| is odd while the slot holds a value and even while it is free.
+// A used slot's |index| points into the dense arrays, a free slot's |index| is
+// the next free slot.
+struct nj_slot_t {
+  nju32 index;
+  nju32 generation;
+};
+
+// Values are kept packed in |values| so they can be iterated as an array.
+// Erasing moves the last value into the hole so indices into |values| are not
+// stable, handles are.
+template <typename T>
+struct nj_slot_map_t {
+  nj_dynamic_array_t<T> values;
+  // |value_slots[i]| is the slot of |values[i]|.
+  nj_dynamic_array_t<nju32> value_slots;
+  nj_dynamic_array_t<nj_slot_t> slots;
+  nju32 free_head = NJ_SM_INVALID_INDEX;
+};
+
+template <typename T>
+bool nj_sm_init(nj_slot_map_t<T>* sm, nj_allocator_t* allocator);
+
+template <typename T>
+void nj_sm_destroy(nj_slot_map_t<T>* sm);
+
+template <typename T>
+njsp nj_sm_len(const nj_slot_map_t<T>* sm);
+
+template <typename T>
+void nj_sm_reserve(nj_slot_map_t<T>* sm, njsp num);
+
+template <typename T>
+nj_slot_handle_t nj_sm_insert(nj_slot_map_t<T>* sm, const T& val);
+
+// Returns false if |handle| is stale.
+template <typename T>
+bool nj_sm_erase(nj_slot_map_t<T>* sm, nj_slot_handle_t handle);
+
+// Returns NULL if |handle| is stale.
+template <typename T>
+T* nj_sm_get(nj_slot_map_t<T>* sm, nj_slot_handle_t handle);
+
+template <typename T>
+bool nj_sm_is_valid(const nj_slot_map_t<T>* sm, nj_slot_handle_t handle);
+
+// Get the handle of |values[index]|.
+template <typename T>
+nj_slot_handle_t nj_sm_handle_at(nj_slot_map_t<T>* sm, njsp index);
+
+template <typename T>
+void nj_sm_clear(nj_slot_map_t<T>* sm);
+
+#endif // NJ_CORE_SLOT_MAP_H
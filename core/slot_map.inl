@@ -0,0 +1,115 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_SLOT_MAP_INL
+#define NJ_CORE_SLOT_MAP_INL
+
+#include "core/slot_map.h"
+
+#include "core/dynamic_array.inl"
+#include "core/log.h"
+
+template <typename T>
+bool nj_sm_init(nj_slot_map_t<T>* sm, nj_allocator_t* allocator) {
+  NJ_CHECK_RETURN_VAL(nj_da_init(&sm->values, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&sm->value_slots, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&sm->slots, allocator), false);
+  sm->free_head = NJ_SM_INVALID_INDEX;
+  return true;
+}
+
+template <typename T>
+void nj_sm_destroy(nj_slot_map_t<T>* sm) {
+  nj_da_destroy(&sm->slots);
+  nj_da_destroy(&sm->value_slots);
+  nj_da_destroy(&sm->values);
+}
+
+template <typename T>
+njsp nj_sm_len(const nj_slot_map_t<T>* sm) {
+  return sm->values.length;
+}
+
+template <typename T>
+void nj_sm_reserve(nj_slot_map_t<T>* sm, njsp num) {
+  nj_da_reserve(&sm->values, num);
+  nj_da_reserve(&sm->value_slots, num);
+  nj_da_reserve(&sm->slots, num);
+}
+
+template <typename T>
+nj_slot_handle_t nj_sm_insert(nj_slot_map_t<T>* sm, const T& val) {
+  nju32 slot_index = sm->free_head;
+  if (slot_index == NJ_SM_INVALID_INDEX) {
+    NJ_CHECK_LOG_RETURN_VAL(sm->slots.length < NJ_SM_INVALID_INDEX, nj_slot_handle_t(), "Too many slots in nj_slot_map_t");
+    slot_index = sm->slots.length;
+    nj_da_append(&sm->slots, {0, 0});
+  } else {
+    sm->free_head = sm->slots[slot_index].index;
+  }
+  nj_slot_t* slot = &sm->slots[slot_index];
+  slot->index = sm->values.length;
+  slot->generation += 1;
+  nj_da_append(&sm->values, val);
+  nj_da_append(&sm->value_slots, slot_index);
+  return {slot_index, slot->generation};
+}
+
+template <typename T>
+bool nj_sm_erase(nj_slot_map_t<T>* sm, nj_slot_handle_t handle) {
+  if (!nj_sm_is_valid(sm, handle))
+    return false;
+  nj_slot_t* slot = &sm->slots[handle.index];
+  nju32 value_index = slot->index;
+  njsp last = sm->values.length - 1;
+  if (value_index != last) {
+    sm->values[value_index] = sm->values[last];
+    sm->value_slots[value_index] = sm->value_slots[last];
+    sm->slots[sm->value_slots[value_index]].index = value_index;
+  }
+  sm->values.length -= 1;
+  sm->value_slots.length -= 1;
+  slot->generation += 1;
+  slot->index = sm->free_head;
+  sm->free_head = handle.index;
+  return true;
+}
+
+template <typename T>
+T* nj_sm_get(nj_slot_map_t<T>* sm, nj_slot_handle_t handle) {
+  if (!nj_sm_is_valid(sm, handle))
+    return NULL;
+  return &sm->values[sm->slots[handle.index].index];
+}
+
+template <typename T>
+bool nj_sm_is_valid(const nj_slot_map_t<T>* sm, nj_slot_handle_t handle) {
+  if (handle.index >= sm->slots.length)
+    return false;
+  // Free slots have even generations, so they never match a handle.
+  return sm->slots.p[handle.index].generation == handle.generation && (handle.generation & 1);
+}
+
+template <typename T>
+nj_slot_handle_t nj_sm_handle_at(nj_slot_map_t<T>* sm, njsp index) {
+  nju32 slot_index = sm->value_slots[index];
+  return {slot_index, sm->slots[slot_index].generation};
+}
+
+template <typename T>
+void nj_sm_clear(nj_slot_map_t<T>* sm) {
+  for (njsp i = 0; i < sm->values.length; ++i) {
+    nju32 slot_index = sm->value_slots[i];
+    nj_slot_t* slot = &sm->slots[slot_index];
+    slot->generation += 1;
+    slot->index = sm->free_head;
+    sm->free_head = slot_index;
+  }
+  sm->values.length = 0;
+  sm->value_slots.length = 0;
+}
+
+#endif // NJ_CORE_SLOT_MAP_INL
@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_SOA_ARRAY_H
+#define NJ_CORE_SOA_ARRAY_H
+
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+
+#define NJ_SOA_ALIGNMENT (64)
+
+template <typename T>
+struct nj_span_t {
+  T* p;
+  njsp length;
+
+  T& operator[](njsz index) { return p[index]; }
+};
+
+// Get the |I|th type of |Ts|.
+template <int I, typename T, typename... Ts>
+struct nj_soa_field_type {
+  typedef typename nj_soa_field_type<I - 1, Ts...>::type type;
+};
+
+template <typename T, typename... Ts>
+struct nj_soa_field_type<0, T, Ts...> {
+  typedef T type;
+};
+
+// A structure of arrays. All fields live in one allocation that is split into
+// one NJ_SOA_ALIGNMENT aligned stream per field, so a kernel can stream
+// exactly the fields it needs. Like nj_dynamic_array_t, the fields are moved
+// with memcpy.
+template <typename... Fields>
+struct nj_soa_array_t {
+  static const int sc_field_count = sizeof...(Fields);
+
+  nj_allocator_t* allocator = NULL;
+  nju8* p = NULL;
+  nju8* streams[sizeof...(Fields)] = {};
+  njsp length = 0;
+  njsp capacity = 0;
+};
+
+template <typename... Fields>
+bool nj_soa_init(nj_soa_array_t<Fields...>* soa, nj_allocator_t* allocator);
+
+template <typename... Fields>
+void nj_soa_destroy(nj_soa_array_t<Fields...>* soa);
+
+template <typename... Fields>
+njsp nj_soa_len(const nj_soa_array_t<Fields...>* soa);
+
+template <typename... Fields>
+void nj_soa_reserve(nj_soa_array_t<Fields...>* soa, njsp num);
+
+template <typename... Fields>
+void nj_soa_resize(nj_soa_array_t<Fields...>* soa, njsp num);
+
+template <typename... Fields>
+void nj_soa_append(nj_soa_array_t<Fields...>* soa, const Fields&... vals);
+
+// Move the last element into |index|, the order of elements is not kept.
+template <typename... Fields>
+void nj_soa_swap_remove(nj_soa_array_t<Fields...>* soa, njsp index);
+
+template <int I, typename... Fields>
+nj_span_t<typename nj_soa_field_type<I, Fields...>::type> nj_soa_field(nj_soa_array_t<Fields...>* soa);
+
+#endif // NJ_CORE_SOA_ARRAY_H
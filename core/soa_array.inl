@@ -0,0 +1,97 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_SOA_ARRAY_INL
+#define NJ_CORE_SOA_ARRAY_INL
+
+#include "core/soa_array.h"
+
+#include "core/allocator.h"
+#include "core/log.h"
+
+#include <string.h>
+
+static inline njsp soa_stream_size(njsz field_size, njsp num) {
+  return (field_size * num + NJ_SOA_ALIGNMENT - 1) & ~(njsp)(NJ_SOA_ALIGNMENT - 1);
+}
+
+template <typename... Fields>
+bool nj_soa_init(nj_soa_array_t<Fields...>* soa, nj_allocator_t* allocator) {
+  soa->allocator = allocator;
+  return true;
+}
+
+template <typename... Fields>
+void nj_soa_destroy(nj_soa_array_t<Fields...>* soa) {
+  if (soa->p)
+    soa->allocator->free(soa->p);
+}
+
+template <typename... Fields>
+njsp nj_soa_len(const nj_soa_array_t<Fields...>* soa) {
+  return soa->length;
+}
+
+template <typename... Fields>
+void nj_soa_reserve(nj_soa_array_t<Fields...>* soa, njsp num) {
+  if (num <= soa->capacity)
+    return;
+  const njsz field_sizes[] = {sizeof(Fields)...};
+  njsp total_size = 0;
+  for (int i = 0; i < soa->sc_field_count; ++i)
+    total_size += soa_stream_size(field_sizes[i], num);
+  nju8* p = (nju8*)soa->allocator->aligned_alloc(total_size, NJ_SOA_ALIGNMENT);
+  NJ_CHECK_LOG_RETURN(p, "Can't reserve memory for nj_soa_array_t");
+  nju8* stream = p;
+  for (int i = 0; i < soa->sc_field_count; ++i) {
+    if (soa->p)
+      memcpy(stream, soa->streams[i], field_sizes[i] * soa->length);
+    soa->streams[i] = stream;
+    stream += soa_stream_size(field_sizes[i], num);
+  }
+  if (soa->p)
+    soa->allocator->free(soa->p);
+  soa->p = p;
+  soa->capacity = num;
+}
+
+template <typename... Fields>
+void nj_soa_resize(nj_soa_array_t<Fields...>* soa, njsp num) {
+  nj_soa_reserve(soa, num);
+  soa->length = num;
+}
+
+template <typename... Fields>
+void nj_soa_append(nj_soa_array_t<Fields...>* soa, const Fields&... vals) {
+  if (soa->length == soa->capacity) {
+    nj_soa_reserve(soa, (soa->capacity + 1) * 3 / 2);
+  }
+  const njsz field_sizes[] = {sizeof(Fields)...};
+  const void* srcs[] = {&vals...};
+  for (int i = 0; i < soa->sc_field_count; ++i)
+    memcpy(soa->streams[i] + soa->length * field_sizes[i], srcs[i], field_sizes[i]);
+  soa->length += 1;
+}
+
+template <typename... Fields>
+void nj_soa_swap_remove(nj_soa_array_t<Fields...>* soa, njsp index) {
+  NJ_CHECK_LOG_RETURN(index >= 0 && index < soa->length, "Can't remove invalid index %d", (int)index);
+  const njsz field_sizes[] = {sizeof(Fields)...};
+  njsp last = soa->length - 1;
+  if (index != last) {
+    for (int i = 0; i < soa->sc_field_count; ++i)
+      memcpy(soa->streams[i] + index * field_sizes[i], soa->streams[i] + last * field_sizes[i], field_sizes[i]);
+  }
+  soa->length -= 1;
+}
+
+template <int I, typename... Fields>
+nj_span_t<typename nj_soa_field_type<I, Fields...>::type> nj_soa_field(nj_soa_array_t<Fields...>* soa) {
+  typedef typename nj_soa_field_type<I, Fields...>::type field_t;
+  return {(field_t*)soa->streams[I], soa->length};
+}
+
+#endif // NJ_CORE_SOA_ARRAY_INL
@@ -0,0 +1,43 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_SORT_H
+#define NJ_CORE_SORT_H
+
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+
+template <typename T>
+struct nj_less_t {
+  bool operator()(const T& a, const T& b) const { return a < b; }
+};
+
+// Stable insertion sort, it's what the other sorts use for small arrays.
+template <typename T, typename Less = nj_less_t<T>>
+void nj_insertion_sort(T* p, njsp num, Less less = Less());
+
+// Stable LSD radix sort of nju32 or nju64 |keys|, 8 bits per pass. Passes
+// where every key has the same digit are skipped. |allocator| is used for a
+// temporary buffer of the same size as the input.
+template <typename K>
+bool nj_radix_sort(K* keys, njsp num, nj_allocator_t* allocator);
+
+// Same as above, |values[i]| is moved along with |keys[i]|.
+template <typename K, typename V>
+bool nj_radix_sort(K* keys, V* values, njsp num, nj_allocator_t* allocator);
+
+// Stable bottom-up merge sort.
+template <typename T, typename Less = nj_less_t<T>>
+bool nj_merge_sort(T* p, njsp num, nj_allocator_t* allocator, Less less = Less());
+
+// Split |p| into |thread_count| chunks (nj_thread_get_nums() if 0) that are
+// sorted on their own thread, then merge them pairwise in parallel. Stable.
+// |less| is copied to each thread.
+template <typename T, typename Less = nj_less_t<T>>
+bool nj_parallel_merge_sort(T* p, njsp num, nj_allocator_t* allocator, int thread_count = 0, Less less = Less());
+
+#endif // NJ_CORE_SORT_H
@@ -0,0 +1,270 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_SORT_INL
+#define NJ_CORE_SORT_INL
+
+#include "core/sort.h"
+
+#include "core/allocator.h"
+#include "core/log.h"
+#include "core/thread.h"
+#include "core/utils.h"
+
+#include <string.h>
+
+// Arrays smaller than this are insertion sorted, it's also the length of the
+// runs the merge sort starts with.
+static const njsp gc_sort_small_num = 32;
+#define NJ_SORT_MAX_THREADS (64)
+
+template <typename T, typename Less>
+void nj_insertion_sort(T* p, njsp num, Less less) {
+  for (njsp i = 1; i < num; ++i) {
+    T val = p[i];
+    njsp j = i;
+    for (; j > 0 && less(val, p[j - 1]); --j)
+      p[j] = p[j - 1];
+    p[j] = val;
+  }
+}
+
+template <typename K, typename V, bool HAS_VALUES>
+static void sort_insertion_sort_kv(K* keys, V* values, njsp num) {
+  for (njsp i = 1; i < num; ++i) {
+    K key = keys[i];
+    V val;
+    if (HAS_VALUES)
+      val = values[i];
+    njsp j = i;
+    for (; j > 0 && key < keys[j - 1]; --j) {
+      keys[j] = keys[j - 1];
+      if (HAS_VALUES)
+        values[j] = values[j - 1];
+    }
+    keys[j] = key;
+    if (HAS_VALUES)
+      values[j] = val;
+  }
+}
+
+template <typename K, typename V, bool HAS_VALUES>
+static bool sort_radix_sort(K* keys, V* values, njsp num, nj_allocator_t* allocator) {
+  static_assert(sizeof(K) == 4 || sizeof(K) == 8, "Only 32-bit and 64-bit keys are supported");
+  if (num < gc_sort_small_num) {
+    sort_insertion_sort_kv<K, V, HAS_VALUES>(keys, values, num);
+    return true;
+  }
+  const int digit_count = sizeof(K);
+  // One pass to build the histograms of all digits.
+  njsp histograms[digit_count][256] = {};
+  for (njsp i = 0; i < num; ++i) {
+    K key = keys[i];
+    for (int d = 0; d < digit_count; ++d)
+      ++histograms[d][(key >> (d * 8)) & 0xff];
+  }
+
+  K* tmp_keys = (K*)allocator->alloc(num * sizeof(K));
+  NJ_CHECK_LOG_RETURN_VAL(tmp_keys, false, "Can't allocate the radix sort buffer");
+  V* tmp_values = NULL;
+  if (HAS_VALUES) {
+    tmp_values = (V*)allocator->alloc(num * sizeof(V));
+    if (!tmp_values) {
+      allocator->free(tmp_keys);
+      NJ_LOGW("Can't allocate the radix sort buffer");
+      return false;
+    }
+  }
+
+  K* src_keys = keys;
+  K* dst_keys = tmp_keys;
+  V* src_values = values;
+  V* dst_values = tmp_values;
+  for (int d = 0; d < digit_count; ++d) {
+    njsp* histogram = histograms[d];
+    int shift = d * 8;
+    if (histogram[(src_keys[0] >> shift) & 0xff] == num)
+      continue;
+    njsp offset = 0;
+    for (int i = 0; i < 256; ++i) {
+      njsp count = histogram[i];
+      histogram[i] = offset;
+      offset += count;
+    }
+    for (njsp i = 0; i < num; ++i) {
+      K key = src_keys[i];
+      njsp dst = histogram[(key >> shift) & 0xff]++;
+      dst_keys[dst] = key;
+      if (HAS_VALUES)
+        dst_values[dst] = src_values[i];
+    }
+    K* swap_keys = src_keys;
+    src_keys = dst_keys;
+    dst_keys = swap_keys;
+    V* swap_values = src_values;
+    src_values = dst_values;
+    dst_values = swap_values;
+  }
+  if (src_keys != keys) {
+    memcpy(keys, src_keys, num * sizeof(K));
+    if (HAS_VALUES)
+      memcpy(values, src_values, num * sizeof(V));
+  }
+  if (HAS_VALUES)
+    allocator->free(tmp_values);
+  allocator->free(tmp_keys);
+  return true;
+}
+
+template <typename K>
+bool nj_radix_sort(K* keys, njsp num, nj_allocator_t* allocator) {
+  return sort_radix_sort<K, nju8, false>(keys, NULL, num, allocator);
+}
+
+template <typename K, typename V>
+bool nj_radix_sort(K* keys, V* values, njsp num, nj_allocator_t* allocator) {
+  return sort_radix_sort<K, V, true>(keys, values, num, allocator);
+}
+
+// Stable merge of [a, a + a_num) and [b, b + b_num) into |out|.
+template <typename T, typename Less>
+static void sort_merge(const T* a, njsp a_num, const T* b, njsp b_num, T* out, Less& less) {
+  njsp i = 0;
+  njsp j = 0;
+  while (i < a_num && j < b_num) {
+    if (less(b[j], a[i]))
+      *out++ = b[j++];
+    else
+      *out++ = a[i++];
+  }
+  while (i < a_num)
+    *out++ = a[i++];
+  while (j < b_num)
+    *out++ = b[j++];
+}
+
+// Sorts |p| using |tmp| which has the same size.
+template <typename T, typename Less>
+static void sort_merge_sort(T* p, T* tmp, njsp num, Less& less) {
+  for (njsp i = 0; i < num; i += gc_sort_small_num)
+    nj_insertion_sort(p + i, nj_min(gc_sort_small_num, num - i), less);
+  T* src = p;
+  T* dst = tmp;
+  for (njsp width = gc_sort_small_num; width < num; width *= 2) {
+    for (njsp i = 0; i < num; i += 2 * width) {
+      njsp a_num = nj_min(width, num - i);
+      njsp b_num = nj_min(width, num - i - a_num);
+      sort_merge(src + i, a_num, src + i + a_num, b_num, dst + i, less);
+    }
+    T* swap = src;
+    src = dst;
+    dst = swap;
+  }
+  if (src != p)
+    memcpy(p, src, num * sizeof(T));
+}
+
+template <typename T, typename Less>
+bool nj_merge_sort(T* p, njsp num, nj_allocator_t* allocator, Less less) {
+  if (num < gc_sort_small_num) {
+    nj_insertion_sort(p, num, less);
+    return true;
+  }
+  T* tmp = (T*)allocator->alloc(num * sizeof(T));
+  NJ_CHECK_LOG_RETURN_VAL(tmp, false, "Can't allocate the merge sort buffer");
+  sort_merge_sort(p, tmp, num, less);
+  allocator->free(tmp);
+  return true;
+}
+
+template <typename T, typename Less>
+struct nj_sort_job_t {
+  // Sort: sorts [src, src + a_num) using dst as the temporary buffer.
+  // Merge: merges [src, src + a_num) and [src + a_num, src + a_num + b_num)
+  // into dst.
+  T* src;
+  T* dst;
+  njsp a_num;
+  njsp b_num;
+  bool is_merge;
+  Less less;
+};
+
+template <typename T, typename Less>
+static void sort_job_run(void* args) {
+  nj_sort_job_t<T, Less>* job = (nj_sort_job_t<T, Less>*)args;
+  if (job->is_merge)
+    sort_merge(job->src, job->a_num, job->src + job->a_num, job->b_num, job->dst, job->less);
+  else
+    sort_merge_sort(job->src, job->dst, job->a_num, job->less);
+}
+
+// Runs the first job on the calling thread and the others on new threads.
+template <typename T, typename Less>
+static void sort_run_jobs(nj_sort_job_t<T, Less>* jobs, int job_count) {
+  nj_thread_t threads[NJ_SORT_MAX_THREADS];
+  bool is_started[NJ_SORT_MAX_THREADS] = {};
+  for (int i = 1; i < job_count; ++i)
+    is_started[i] = nj_thread_init(&threads[i], sort_job_run<T, Less>, &jobs[i]);
+  sort_job_run<T, Less>(&jobs[0]);
+  for (int i = 1; i < job_count; ++i) {
+    if (is_started[i])
+      nj_thread_wait_for(&threads[i]);
+    else
+      sort_job_run<T, Less>(&jobs[i]);
+  }
+}
+
+template <typename T, typename Less>
+bool nj_parallel_merge_sort(T* p, njsp num, nj_allocator_t* allocator, int thread_count, Less less) {
+  if (thread_count <= 0)
+    thread_count = nj_thread_get_nums();
+  thread_count = nj_min(thread_count, NJ_SORT_MAX_THREADS);
+  // Not worth a thread for less than a few runs.
+  thread_count = (int)nj_min<njsp>(thread_count, num / (gc_sort_small_num * 8));
+  if (thread_count <= 1)
+    return nj_merge_sort(p, num, allocator, less);
+
+  T* tmp = (T*)allocator->alloc(num * sizeof(T));
+  NJ_CHECK_LOG_RETURN_VAL(tmp, false, "Can't allocate the merge sort buffer");
+
+  // Sorted chunks boundaries, chunk i is [bounds[i], bounds[i + 1]).
+  njsp bounds[NJ_SORT_MAX_THREADS + 1];
+  for (int i = 0; i <= thread_count; ++i)
+    bounds[i] = num * i / thread_count;
+  nj_sort_job_t<T, Less> jobs[NJ_SORT_MAX_THREADS];
+  for (int i = 0; i < thread_count; ++i)
+    jobs[i] = {p + bounds[i], tmp + bounds[i], bounds[i + 1] - bounds[i], 0, false, less};
+  sort_run_jobs(jobs, thread_count);
+
+  T* src = p;
+  T* dst = tmp;
+  int chunk_count = thread_count;
+  while (chunk_count > 1) {
+    int job_count = 0;
+    int new_chunk_count = 0;
+    for (int i = 0; i < chunk_count; i += 2) {
+      njsp begin = bounds[i];
+      njsp mid = bounds[i + 1];
+      // An odd chunk out is merged with nothing, which copies it to |dst|.
+      njsp end = i + 1 < chunk_count ? bounds[i + 2] : mid;
+      jobs[job_count++] = {src + begin, dst + begin, mid - begin, end - mid, true, less};
+      bounds[new_chunk_count++] = begin;
+    }
+    bounds[new_chunk_count] = num;
+    sort_run_jobs(jobs, job_count);
+    chunk_count = new_chunk_count;
+    T* swap = src;
+    src = dst;
+    dst = swap;
+  }
+  if (src != p)
+    memcpy(p, src, num * sizeof(T));
+  allocator->free(tmp);
+  return true;
+}
+
+#endif // NJ_CORE_SORT_INL
@@ -0,0 +1,267 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/sync.h"
+
+#include "core/atomic.h"
+#include "core/futex.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+
+static const int gc_sync_spin_count = 128;
+
+// nj_rwlock_t::state bits, the low bits are the reader count.
+static const nju32 gc_rwlock_writer = 0x80000000u;
+static const nju32 gc_rwlock_waiters = 0x40000000u;
+static const nju32 gc_rwlock_writer_pending = 0x20000000u;
+static const nju32 gc_rwlock_readers = 0x1fffffffu;
+
+// nj_event_t::state values.
+static const nju32 gc_event_unset = 0;
+static const nju32 gc_event_unset_with_waiters = 1;
+static const nju32 gc_event_set = 2;
+
+static void sync_add_stats(nj_sync_stats_t* stats, int spin_count, njs64 start_time) {
+  if (!stats)
+    return;
+  nj_atomic_fetch_add(&stats->contended_count, (nju64)1, NJ_MEMORY_ORDER_RELAXED);
+  nj_atomic_fetch_add(&stats->spin_count, (nju64)spin_count, NJ_MEMORY_ORDER_RELAXED);
+  nj_atomic_fetch_add(&stats->wait_time, nj_mono_time_now() - start_time, NJ_MEMORY_ORDER_RELAXED);
+}
+
+void nj_sync_stats_take(nj_sync_stats_t* stats, nj_sync_stats_t* out) {
+  out->contended_count = nj_atomic_exchange(&stats->contended_count, (nju64)0, NJ_MEMORY_ORDER_RELAXED);
+  out->spin_count = nj_atomic_exchange(&stats->spin_count, (nju64)0, NJ_MEMORY_ORDER_RELAXED);
+  out->wait_time = nj_atomic_exchange(&stats->wait_time, (njs64)0, NJ_MEMORY_ORDER_RELAXED);
+}
+
+void nj_sync_stats_dump(nj_sync_stats_t* stats, const char* name) {
+  nj_sync_stats_t taken;
+  nj_sync_stats_take(stats, &taken);
+  NJ_LOGI("%s: contended %llu, spins %llu, waited %.3f ms", name, (unsigned long long)taken.contended_count, (unsigned long long)taken.spin_count, nj_mono_time_to_ms(taken.wait_time));
+}
+
+void nj_mutex_init(nj_mutex_t* mutex) {
+  mutex->state = 0;
+  mutex->stats = NULL;
+}
+
+void nj_mutex_lock(nj_mutex_t* mutex) {
+  nju32 state = 0;
+  if (nj_atomic_cas(&mutex->state, &state, 1u, NJ_MEMORY_ORDER_ACQUIRE))
+    return;
+  njs64 start_time = mutex->stats ? nj_mono_time_now() : 0;
+  int spin_count = 0;
+  for (; spin_count < gc_sync_spin_count; ++spin_count) {
+    nj_cpu_relax();
+    state = nj_atomic_load(&mutex->state, NJ_MEMORY_ORDER_RELAXED);
+    if (state == 0 && nj_atomic_cas(&mutex->state, &state, 1u, NJ_MEMORY_ORDER_ACQUIRE)) {
+      sync_add_stats(mutex->stats, spin_count, start_time);
+      return;
+    }
+    if (state == 2)
+      break;
+  }
+  // We can't know whether other threads sleep, so keep 2 once we own it.
+  while (nj_atomic_exchange(&mutex->state, 2u, NJ_MEMORY_ORDER_ACQUIRE) != 0)
+    nj_futex_wait(&mutex->state, 2, NJ_FUTEX_INFINITE);
+  sync_add_stats(mutex->stats, spin_count, start_time);
+}
+
+bool nj_mutex_try_lock(nj_mutex_t* mutex) {
+  nju32 state = 0;
+  return nj_atomic_cas(&mutex->state, &state, 1u, NJ_MEMORY_ORDER_ACQUIRE);
+}
+
+void nj_mutex_unlock(nj_mutex_t* mutex) {
+  if (nj_atomic_exchange(&mutex->state, 0u, NJ_MEMORY_ORDER_RELEASE) == 2)
+    nj_futex_wake_one(&mutex->state);
+}
+
+void nj_rwlock_init(nj_rwlock_t* rwlock) {
+  rwlock->state = 0;
+  rwlock->stats = NULL;
+}
+
+void nj_rwlock_read_lock(nj_rwlock_t* rwlock) {
+  nju32 state = nj_atomic_load(&rwlock->state, NJ_MEMORY_ORDER_RELAXED);
+  if (!(state & (gc_rwlock_writer | gc_rwlock_writer_pending)) && nj_atomic_cas(&rwlock->state, &state, state + 1, NJ_MEMORY_ORDER_ACQUIRE))
+    return;
+  njs64 start_time = rwlock->stats ? nj_mono_time_now() : 0;
+  int spin_count = 0;
+  for (;;) {
+    state = nj_atomic_load(&rwlock->state, NJ_MEMORY_ORDER_RELAXED);
+    if (!(state & (gc_rwlock_writer | gc_rwlock_writer_pending))) {
+      if (nj_atomic_cas(&rwlock->state, &state, state + 1, NJ_MEMORY_ORDER_ACQUIRE))
+        break;
+      continue;
+    }
+    if (spin_count < gc_sync_spin_count) {
+      ++spin_count;
+      nj_cpu_relax();
+      continue;
+    }
+    if (!(state & gc_rwlock_waiters) && !nj_atomic_cas(&rwlock->state, &state, state | gc_rwlock_waiters))
+      continue;
+    nj_futex_wait(&rwlock->state, state | gc_rwlock_waiters, NJ_FUTEX_INFINITE);
+  }
+  sync_add_stats(rwlock->stats, spin_count, start_time);
+}
+
+void nj_rwlock_read_unlock(nj_rwlock_t* rwlock) {
+  nju32 state = nj_atomic_fetch_sub(&rwlock->state, 1u, NJ_MEMORY_ORDER_RELEASE);
+  if ((state & gc_rwlock_readers) == 1 && (state & gc_rwlock_waiters)) {
+    nj_atomic_fetch_and(&rwlock->state, ~gc_rwlock_waiters);
+    nj_futex_wake_all(&rwlock->state);
+  }
+}
+
+void nj_rwlock_write_lock(nj_rwlock_t* rwlock) {
+  nju32 state = 0;
+  if (nj_atomic_cas(&rwlock->state, &state, gc_rwlock_writer, NJ_MEMORY_ORDER_ACQUIRE))
+    return;
+  njs64 start_time = rwlock->stats ? nj_mono_time_now() : 0;
+  int spin_count = 0;
+  for (;;) {
+    state = nj_atomic_load(&rwlock->state, NJ_MEMORY_ORDER_RELAXED);
+    if (!(state & (gc_rwlock_writer | gc_rwlock_readers))) {
+      // Other pending writers sleep with |gc_rwlock_waiters| set, they set
+      // |gc_rwlock_writer_pending| again when woken.
+      if (nj_atomic_cas(&rwlock->state, &state, gc_rwlock_writer | (state & gc_rwlock_waiters), NJ_MEMORY_ORDER_ACQUIRE))
+        break;
+      continue;
+    }
+    if (spin_count < gc_sync_spin_count) {
+      ++spin_count;
+      nj_cpu_relax();
+      continue;
+    }
+    nju32 new_state = state | gc_rwlock_writer_pending | gc_rwlock_waiters;
+    if (new_state != state && !nj_atomic_cas(&rwlock->state, &state, new_state))
+      continue;
+    nj_futex_wait(&rwlock->state, new_state, NJ_FUTEX_INFINITE);
+  }
+  sync_add_stats(rwlock->stats, spin_count, start_time);
+}
+
+void nj_rwlock_write_unlock(nj_rwlock_t* rwlock) {
+  nju32 state = nj_atomic_exchange(&rwlock->state, 0u, NJ_MEMORY_ORDER_RELEASE);
+  if (state & gc_rwlock_waiters)
+    nj_futex_wake_all(&rwlock->state);
+}
+
+void nj_semaphore_init(nj_semaphore_t* sem, nju32 count) {
+  sem->count = count;
+  sem->waiters = 0;
+}
+
+void nj_semaphore_post(nj_semaphore_t* sem, nju32 count) {
+  nj_atomic_fetch_add(&sem->count, count);
+  if (nj_atomic_load(&sem->waiters)) {
+    if (count == 1)
+      nj_futex_wake_one(&sem->count);
+    else
+      nj_futex_wake_all(&sem->count);
+  }
+}
+
+bool nj_semaphore_try_wait(nj_semaphore_t* sem) {
+  nju32 count = nj_atomic_load(&sem->count, NJ_MEMORY_ORDER_RELAXED);
+  while (count) {
+    if (nj_atomic_cas_weak(&sem->count, &count, count - 1, NJ_MEMORY_ORDER_ACQUIRE))
+      return true;
+  }
+  return false;
+}
+
+bool nj_semaphore_wait_for(nj_semaphore_t* sem, njs64 timeout_ns) {
+  for (int i = 0; i < gc_sync_spin_count; ++i) {
+    if (nj_semaphore_try_wait(sem))
+      return true;
+    nj_cpu_relax();
+  }
+  njs64 deadline = timeout_ns >= 0 ? nj_mono_time_now() + nj_s_to_mono_time(timeout_ns / 1000000000.0) : -1;
+  for (;;) {
+    nj_atomic_fetch_add(&sem->waiters, 1u);
+    if (nj_semaphore_try_wait(sem)) {
+      nj_atomic_fetch_sub(&sem->waiters, 1u);
+      return true;
+    }
+    njs64 remaining_ns = NJ_FUTEX_INFINITE;
+    if (deadline >= 0) {
+      njs64 now = nj_mono_time_now();
+      if (now >= deadline) {
+        nj_atomic_fetch_sub(&sem->waiters, 1u);
+        return false;
+      }
+      remaining_ns = (njs64)(nj_mono_time_to_us(deadline - now) * 1000.0) + 1;
+    }
+    nj_futex_wait(&sem->count, 0, remaining_ns);
+    nj_atomic_fetch_sub(&sem->waiters, 1u);
+  }
+}
+
+void nj_semaphore_wait(nj_semaphore_t* sem) {
+  nj_semaphore_wait_for(sem, NJ_FUTEX_INFINITE);
+}
+
+void nj_event_init(nj_event_t* event) {
+  event->state = gc_event_unset;
+}
+
+void nj_event_set(nj_event_t* event) {
+  if (nj_atomic_exchange(&event->state, gc_event_set, NJ_MEMORY_ORDER_RELEASE) == gc_event_unset_with_waiters)
+    nj_futex_wake_all(&event->state);
+}
+
+bool nj_event_is_set(const nj_event_t* event) {
+  return nj_atomic_load(&event->state, NJ_MEMORY_ORDER_ACQUIRE) == gc_event_set;
+}
+
+void nj_event_wait(nj_event_t* event) {
+  for (int i = 0; i < gc_sync_spin_count; ++i) {
+    if (nj_event_is_set(event))
+      return;
+    nj_cpu_relax();
+  }
+  for (;;) {
+    nju32 state = nj_atomic_load(&event->state, NJ_MEMORY_ORDER_ACQUIRE);
+    if (state == gc_event_set)
+      return;
+    if (state == gc_event_unset && !nj_atomic_cas(&event->state, &state, gc_event_unset_with_waiters))
+      continue;
+    nj_futex_wait(&event->state, gc_event_unset_with_waiters, NJ_FUTEX_INFINITE);
+  }
+}
+
+void nj_seqlock_init(nj_seqlock_t* seqlock) {
+  seqlock->seq = 0;
+}
+
+void nj_seqlock_write_begin(nj_seqlock_t* seqlock) {
+  nju32 seq = nj_atomic_load(&seqlock->seq, NJ_MEMORY_ORDER_RELAXED);
+  nj_atomic_store(&seqlock->seq, seq + 1, NJ_MEMORY_ORDER_RELAXED);
+  nj_atomic_fence(NJ_MEMORY_ORDER_RELEASE);
+}
+
+void nj_seqlock_write_end(nj_seqlock_t* seqlock) {
+  nju32 seq = nj_atomic_load(&seqlock->seq, NJ_MEMORY_ORDER_RELAXED);
+  nj_atomic_store(&seqlock->seq, seq + 1, NJ_MEMORY_ORDER_RELEASE);
+}
+
+nju32 nj_seqlock_read_begin(const nj_seqlock_t* seqlock) {
+  for (;;) {
+    nju32 seq = nj_atomic_load(&seqlock->seq, NJ_MEMORY_ORDER_ACQUIRE);
+    if (!(seq & 1))
+      return seq;
+    nj_cpu_relax();
+  }
+}
+
+bool nj_seqlock_read_retry(const nj_seqlock_t* seqlock, nju32 seq) {
+  nj_atomic_fence(NJ_MEMORY_ORDER_ACQUIRE);
+  return nj_atomic_load(&seqlock->seq, NJ_MEMORY_ORDER_RELAXED) != seq;
+}
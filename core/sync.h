@@ -0,0 +1,97 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_SYNC_H
+#define NJ_CORE_SYNC_H
+
+#include "core/njtype.h"
+
+// Synchronization primitives built on nj_futex_*(). They are all valid when
+// zero-initialized and never allocate.
+
+// Contention counters, only updated on the slow paths. Point a primitive's
+// |stats| to one to collect them, several primitives can share one. While the
+// primitives are in use, read them with nj_sync_stats_take(), e.g. once per
+// frame from a profiler.
+struct nj_sync_stats_t {
+  nju64 contended_count;
+  nju64 spin_count;
+  // In mono time.
+  njs64 wait_time;
+};
+
+// |state| is 0 when unlocked, 1 when locked and 2 when locked and some threads
+// may sleep on it. Spins a bit before sleeping.
+struct nj_mutex_t {
+  nju32 state;
+  nj_sync_stats_t* stats;
+};
+
+// Writers are preferred: once a writer waits, new readers wait too.
+struct nj_rwlock_t {
+  nju32 state;
+  nj_sync_stats_t* stats;
+};
+
+struct nj_semaphore_t {
+  nju32 count;
+  nju32 waiters;
+};
+
+// One-shot, once set it stays set.
+struct nj_event_t {
+  nju32 state;
+};
+
+// For data that is read often and written rarely by a single writer (or
+// writers serialized by a mutex). Readers never block the writer, they retry
+// if a write happened while they were reading. Data read inside the read
+// section must only be copied out, it can be torn until validated.
+struct nj_seqlock_t {
+  nju32 seq;
+};
+
+// Copy |stats| to |out| and zero them. Each counter is swapped atomically so
+// no update is lost between two takes.
+void nj_sync_stats_take(nj_sync_stats_t* stats, nj_sync_stats_t* out);
+// Log the counters taken from |stats| under |name|, like nj_tg_dump().
+void nj_sync_stats_dump(nj_sync_stats_t* stats, const char* name);
+
+void nj_mutex_init(nj_mutex_t* mutex);
+void nj_mutex_lock(nj_mutex_t* mutex);
+bool nj_mutex_try_lock(nj_mutex_t* mutex);
+void nj_mutex_unlock(nj_mutex_t* mutex);
+
+void nj_rwlock_init(nj_rwlock_t* rwlock);
+void nj_rwlock_read_lock(nj_rwlock_t* rwlock);
+void nj_rwlock_read_unlock(nj_rwlock_t* rwlock);
+void nj_rwlock_write_lock(nj_rwlock_t* rwlock);
+void nj_rwlock_write_unlock(nj_rwlock_t* rwlock);
+
+void nj_semaphore_init(nj_semaphore_t* sem, nju32 count);
+void nj_semaphore_post(nj_semaphore_t* sem, nju32 count = 1);
+void nj_semaphore_wait(nj_semaphore_t* sem);
+bool nj_semaphore_try_wait(nj_semaphore_t* sem);
+// Returns false if |timeout_ns| passed.
+bool nj_semaphore_wait_for(nj_semaphore_t* sem, njs64 timeout_ns);
+
+void nj_event_init(nj_event_t* event);
+void nj_event_set(nj_event_t* event);
+bool nj_event_is_set(const nj_event_t* event);
+void nj_event_wait(nj_event_t* event);
+
+void nj_seqlock_init(nj_seqlock_t* seqlock);
+void nj_seqlock_write_begin(nj_seqlock_t* seqlock);
+void nj_seqlock_write_end(nj_seqlock_t* seqlock);
+// Usage:
+//   do {
+//     seq = nj_seqlock_read_begin(&sl);
+//     copy = data;
+//   } while (nj_seqlock_read_retry(&sl, seq));
+nju32 nj_seqlock_read_begin(const nj_seqlock_t* seqlock);
+bool nj_seqlock_read_retry(const nj_seqlock_t* seqlock, nju32 seq);
+
+#endif // NJ_CORE_SYNC_H
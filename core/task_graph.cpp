@@ -0,0 +1,183 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/task_graph.h"
+
+#include "core/atomic.h"
+#include "core/dynamic_array.inl"
+#include "core/linear_allocator.inl"
+#include "core/log.h"
+#include "core/mono_time.h"
+
+// Ready successors are queued in batches of this size.
+#define NJ_TG_READY_BATCH_SIZE (16)
+
+static void tg_run_node(void* args) {
+  nj_task_node_t* node = (nj_task_node_t*)args;
+  nj_task_graph_t* tg = node->graph;
+  node->start_time = nj_mono_time_now();
+  node->func(node->args);
+  node->end_time = nj_mono_time_now();
+
+  // Successors are queued before this job finishes so the graph's counter
+  // can't reach 0 early.
+  nj_job_desc_t ready[NJ_TG_READY_BATCH_SIZE];
+  int ready_count = 0;
+  for (njsp i = 0; i < nj_da_len(&node->successors); ++i) {
+    nj_task_node_t* successor = &tg->nodes[node->successors[i]];
+    if (nj_atomic_fetch_sub(&successor->pending_count, 1u) != 1)
+      continue;
+    ready[ready_count++] = {tg_run_node, successor};
+    if (ready_count == NJ_TG_READY_BATCH_SIZE) {
+      nj_job_run(ready, ready_count, &tg->counter);
+      ready_count = 0;
+    }
+  }
+  if (ready_count)
+    nj_job_run(ready, ready_count, &tg->counter);
+}
+
+static void tg_find_critical_path(nj_task_graph_t* tg) {
+  njsp node_count = nj_da_len(&tg->nodes);
+  nj_scoped_la_allocator_t<> temp_allocator("tg_temp_allocator");
+  temp_allocator.init();
+  // Longest chain ending at each node and the node before it in that chain.
+  nj_dynamic_array_t<njs64> path_times;
+  nj_dynamic_array_t<int> prevs;
+  nj_da_init(&path_times, &temp_allocator);
+  nj_da_init(&prevs, &temp_allocator);
+  nj_da_resize(&path_times, node_count);
+  nj_da_resize(&prevs, node_count);
+  for (njsp i = 0; i < node_count; ++i) {
+    path_times[i] = tg->nodes[i].end_time - tg->nodes[i].start_time;
+    prevs[i] = -1;
+  }
+  int last = -1;
+  for (njsp i = 0; i < node_count; ++i) {
+    int n = tg->order[i];
+    nj_task_node_t* node = &tg->nodes[n];
+    for (njsp j = 0; j < nj_da_len(&node->successors); ++j) {
+      int s = node->successors[j];
+      njs64 time = path_times[n] + (tg->nodes[s].end_time - tg->nodes[s].start_time);
+      if (time > path_times[s]) {
+        path_times[s] = time;
+        prevs[s] = n;
+      }
+    }
+    if (last == -1 || path_times[n] > path_times[last])
+      last = n;
+  }
+  tg->critical_path_time = last == -1 ? 0 : path_times[last];
+  nj_da_resize(&tg->critical_path, 0);
+  for (int n = last; n != -1; n = prevs[n])
+    nj_da_insert_at(&tg->critical_path, 0, n);
+}
+
+bool nj_tg_init(nj_task_graph_t* tg, nj_allocator_t* allocator) {
+  NJ_CHECK_RETURN_VAL(nj_da_init(&tg->nodes, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&tg->order, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&tg->critical_path, allocator), false);
+  tg->is_compiled = false;
+  tg->counter = {};
+  tg->start_time = 0;
+  tg->end_time = 0;
+  tg->critical_path_time = 0;
+  return true;
+}
+
+void nj_tg_destroy(nj_task_graph_t* tg) {
+  for (njsp i = 0; i < nj_da_len(&tg->nodes); ++i)
+    nj_da_destroy(&tg->nodes[i].successors);
+  nj_da_destroy(&tg->critical_path);
+  nj_da_destroy(&tg->order);
+  nj_da_destroy(&tg->nodes);
+}
+
+int nj_tg_add_node(nj_task_graph_t* tg, const char* name, nj_job_func_t func, void* args) {
+  nj_task_node_t node = {};
+  node.name = name;
+  node.func = func;
+  node.args = args;
+  nj_da_init(&node.successors, tg->nodes.allocator);
+  nj_da_append(&tg->nodes, node);
+  tg->is_compiled = false;
+  return nj_da_len(&tg->nodes) - 1;
+}
+
+void nj_tg_add_edge(nj_task_graph_t* tg, int from, int to) {
+  NJ_CHECK_LOG_RETURN(from >= 0 && from < nj_da_len(&tg->nodes) && to >= 0 && to < nj_da_len(&tg->nodes), "Invalid task graph edge %d -> %d", from, to);
+  nj_da_append(&tg->nodes[from].successors, to);
+  ++tg->nodes[to].predecessor_count;
+  tg->is_compiled = false;
+}
+
+bool nj_tg_compile(nj_task_graph_t* tg) {
+  // Kahn's algorithm, |order| doubles as the queue.
+  njsp node_count = nj_da_len(&tg->nodes);
+  nj_da_resize(&tg->order, 0);
+  nj_da_reserve(&tg->order, node_count);
+  for (njsp i = 0; i < node_count; ++i) {
+    tg->nodes[i].pending_count = tg->nodes[i].predecessor_count;
+    if (!tg->nodes[i].predecessor_count)
+      nj_da_append(&tg->order, (int)i);
+  }
+  for (njsp i = 0; i < nj_da_len(&tg->order); ++i) {
+    nj_task_node_t* node = &tg->nodes[tg->order[i]];
+    for (njsp j = 0; j < nj_da_len(&node->successors); ++j) {
+      int s = node->successors[j];
+      if (--tg->nodes[s].pending_count == 0)
+        nj_da_append(&tg->order, s);
+    }
+  }
+  NJ_CHECK_LOG_RETURN_VAL(nj_da_len(&tg->order) == node_count, false, "The task graph has a cycle");
+  tg->is_compiled = true;
+  return true;
+}
+
+bool nj_tg_execute(nj_task_graph_t* tg) {
+  if (!tg->is_compiled && !nj_tg_compile(tg))
+    return false;
+  njsp node_count = nj_da_len(&tg->nodes);
+  nj_job_desc_t roots[NJ_TG_READY_BATCH_SIZE];
+  int root_count = 0;
+  for (njsp i = 0; i < node_count; ++i) {
+    nj_task_node_t* node = &tg->nodes[i];
+    node->graph = tg;
+    node->pending_count = node->predecessor_count;
+    node->start_time = 0;
+    node->end_time = 0;
+  }
+  tg->start_time = nj_mono_time_now();
+  // Roots come first in |order|.
+  for (njsp i = 0; i < node_count; ++i) {
+    nj_task_node_t* node = &tg->nodes[tg->order[i]];
+    if (node->predecessor_count)
+      break;
+    roots[root_count++] = {tg_run_node, node};
+    if (root_count == NJ_TG_READY_BATCH_SIZE) {
+      nj_job_run(roots, root_count, &tg->counter);
+      root_count = 0;
+    }
+  }
+  if (root_count)
+    nj_job_run(roots, root_count, &tg->counter);
+  nj_job_wait(&tg->counter);
+  tg->end_time = nj_mono_time_now();
+  tg_find_critical_path(tg);
+  return true;
+}
+
+void nj_tg_dump(nj_task_graph_t* tg) {
+  NJ_LOGI("Task graph: %d nodes, %.3f ms, critical path %.3f ms", (int)nj_da_len(&tg->nodes), nj_mono_time_to_ms(tg->end_time - tg->start_time), nj_mono_time_to_ms(tg->critical_path_time));
+  for (njsp i = 0; i < nj_da_len(&tg->order); ++i) {
+    int n = tg->order[i];
+    nj_task_node_t* node = &tg->nodes[n];
+    bool is_critical = false;
+    for (njsp j = 0; j < nj_da_len(&tg->critical_path); ++j)
+      is_critical |= tg->critical_path[j] == n;
+    NJ_LOGI("%c %-32s start %8.3f ms, duration %8.3f ms", is_critical ? '*' : ' ', node->name, nj_mono_time_to_ms(node->start_time - tg->start_time), nj_mono_time_to_ms(node->end_time - node->start_time));
+  }
+}
@@ -0,0 +1,64 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_TASK_GRAPH_H
+#define NJ_CORE_TASK_GRAPH_H
+
+#include "core/dynamic_array.h"
+#include "core/job.h"
+#include "core/njtype.h"
+
+struct nj_allocator_t;
+struct nj_task_graph_t;
+
+struct nj_task_node_t {
+  const char* name;
+  nj_job_func_t func;
+  void* args;
+  nj_dynamic_array_t<int> successors;
+  int predecessor_count;
+  // Per execution.
+  nj_task_graph_t* graph;
+  nju32 pending_count;
+  njs64 start_time;
+  njs64 end_time;
+};
+
+// Nodes and edges are declared once, then the graph can be executed many times
+// (e.g. once per frame) on the job system. A node becomes a job as soon as all
+// its predecessors finished.
+struct nj_task_graph_t {
+  nj_dynamic_array_t<nj_task_node_t> nodes;
+  // Topological order, computed by nj_tg_compile().
+  nj_dynamic_array_t<int> order;
+  bool is_compiled;
+  nj_job_counter_t counter;
+  // Results of the last execution, times are in mono time.
+  njs64 start_time;
+  njs64 end_time;
+  // The chain of nodes with the longest total duration, from first to last.
+  nj_dynamic_array_t<int> critical_path;
+  njs64 critical_path_time;
+};
+
+bool nj_tg_init(nj_task_graph_t* tg, nj_allocator_t* allocator);
+void nj_tg_destroy(nj_task_graph_t* tg);
+
+// Returns the node's index. |name| must outlive the graph.
+int nj_tg_add_node(nj_task_graph_t* tg, const char* name, nj_job_func_t func, void* args);
+// |to| runs after |from| finished.
+void nj_tg_add_edge(nj_task_graph_t* tg, int from, int to);
+// Returns false if the graph has a cycle. Called by nj_tg_execute() if needed.
+bool nj_tg_compile(nj_task_graph_t* tg);
+
+// Runs the graph and waits for it to finish, then computes the critical path.
+bool nj_tg_execute(nj_task_graph_t* tg);
+
+// Log each node's start and duration relative to the execution start, the
+// nodes on the critical path are marked with '*'.
+void nj_tg_dump(nj_task_graph_t* tg);
+
+#endif // NJ_CORE_TASK_GRAPH_H
@@ -7,6 +7,7 @@
 #ifndef NJ_CORE_THREAD_H
 #define NJ_CORE_THREAD_H
 
+#include "core/njtype.h"
 #include "core/os.h"
 
 #if NJ_OS_WIN()
@@ -21,16 +22,48 @@ typedef pthread_t nj_thread_handle_t;
 #error "?"
 #endif
 
+struct nj_cpu_set_t;
+
 typedef void (*nj_thread_func_t)(void*);
 
+enum nj_thread_priority_t {
+  NJ_THREAD_PRIORITY_LOW,
+  NJ_THREAD_PRIORITY_NORMAL,
+  NJ_THREAD_PRIORITY_HIGH,
+};
+
+struct nj_thread_desc_t {
+  // Truncated to 15 characters on Linux.
+  const char* name = NULL;
+  // The platform default if 0.
+  njsz stack_size = 0;
+  // Raising the priority needs CAP_SYS_NICE on Linux, the thread still starts
+  // if it can't be set.
+  nj_thread_priority_t priority = NJ_THREAD_PRIORITY_NORMAL;
+  // Logical cores the thread can run on, any core if NULL.
+  const nj_cpu_set_t* affinity = NULL;
+};
+
 struct nj_thread_t {
   nj_thread_handle_t handle;
   nj_thread_func_t start_func;
   void* args;
+  nj_thread_priority_t priority;
+  // Only used on Linux, where the thread names itself: it's named before it
+  // runs and a thread that exits early can't make the naming fail. Empty if
+  // there is no name.
+  char name[16];
 };
 
-bool nj_thread_init(nj_thread_t* thread, nj_thread_func_t start_func, void* args);
-void nj_thread_wait_for(nj_thread_t thread);
+bool nj_thread_init(nj_thread_t* thread, nj_thread_func_t start_func, void* args, const nj_thread_desc_t* desc = NULL);
+void nj_thread_wait_for(nj_thread_t* thread);
+// Number of threads that can run in parallel: the logical cores in the affinity
+// mask of the process, capped by its CPU quota (see cpu_topology.h).
 int nj_thread_get_nums();
 
+// These apply to the calling thread.
+bool nj_thread_set_name(const char* name);
+bool nj_thread_set_priority(nj_thread_priority_t priority);
+bool nj_thread_set_affinity(const nj_cpu_set_t* affinity);
+
 #endif // NJ_CORE_THREAD_H
@@ -6,21 +6,65 @@
 
 #include "core/thread.h"
 
+#include "core/cpu_topology.h"
 #include "core/log.h"
+#include "core/utils.h"
 
 #include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+static void thread_to_cpu_set(const nj_cpu_set_t* affinity, cpu_set_t* set) {
+  CPU_ZERO(set);
+  for (int i = 0; i < NJ_CPU_MAX_LOGICAL_CORES && i < CPU_SETSIZE; ++i) {
+    if (nj_cpu_set_has(affinity, i))
+      CPU_SET(i, set);
+  }
+}
+
 static void* platform_thread_start(void* args) {
   nj_thread_t* thread = (nj_thread_t*)args;
+  // The nice value is per thread on Linux but it can only be set with the
+  // thread id, which is only known here.
+  if (thread->priority != NJ_THREAD_PRIORITY_NORMAL)
+    nj_thread_set_priority(thread->priority);
+  if (thread->name[0])
+    nj_thread_set_name(thread->name);
   thread->start_func(thread->args);
   return NULL;
 }
 
-bool nj_thread_init(nj_thread_t* thread, nj_thread_func_t start_func, void* args) {
+bool nj_thread_init(nj_thread_t* thread, nj_thread_func_t start_func, void* args, const nj_thread_desc_t* desc) {
+  nj_thread_desc_t default_desc;
+  if (!desc)
+    desc = &default_desc;
   thread->start_func = start_func;
   thread->args = args;
-  NJ_CHECK_LOG_RETURN_VAL(pthread_create(&thread->handle, NULL, platform_thread_start, (void*)thread) == 0, false, "Can't create a new thread");
+  thread->priority = desc->priority;
+  thread->name[0] = 0;
+  if (desc->name) {
+    strncpy(thread->name, desc->name, sizeof(thread->name) - 1);
+    thread->name[sizeof(thread->name) - 1] = 0;
+  }
+  pthread_attr_t attr;
+  NJ_CHECK_LOG_RETURN_VAL(pthread_attr_init(&attr) == 0, false, "Can't init the thread attributes");
+  if (desc->stack_size) {
+    njsz stack_size = nj_max(desc->stack_size, (njsz)PTHREAD_STACK_MIN);
+    if (pthread_attr_setstacksize(&attr, stack_size) != 0)
+      NJ_LOGW("Can't set the thread stack size to %zu", stack_size);
+  }
+  if (desc->affinity) {
+    cpu_set_t set;
+    thread_to_cpu_set(desc->affinity, &set);
+    if (pthread_attr_setaffinity_np(&attr, sizeof(set), &set) != 0)
+      NJ_LOGW("Can't set the thread affinity");
+  }
+  int rv = pthread_create(&thread->handle, &attr, platform_thread_start, (void*)thread);
+  pthread_attr_destroy(&attr);
+  NJ_CHECK_LOG_RETURN_VAL(rv == 0, false, "Can't create a new thread");
   return true;
 }
 
@@ -30,5 +74,45 @@ void nj_thread_wait_for(nj_thread_t* thread) {
 }
 
 int nj_thread_get_nums() {
-  return sysconf(_SC_NPROCESSORS_ONLN);
+  cpu_set_t set;
+  int num = sysconf(_SC_NPROCESSORS_ONLN);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    num = CPU_COUNT(&set);
+  int quota = nj_cpu_get_quota_core_count();
+  if (quota > 0)
+    num = nj_min(num, quota);
+  return num;
+}
+
+bool nj_thread_set_name(const char* name) {
+  char short_name[16];
+  strncpy(short_name, name, sizeof(short_name) - 1);
+  short_name[sizeof(short_name) - 1] = 0;
+  NJ_CHECK_LOG_RETURN_VAL(pthread_setname_np(pthread_self(), short_name) == 0, false, "Can't set the thread name to %s", short_name);
+  return true;
+}
+
+bool nj_thread_set_priority(nj_thread_priority_t priority) {
+  int nice_val = 0;
+  switch (priority) {
+  case NJ_THREAD_PRIORITY_LOW:
+    nice_val = 10;
+    break;
+  case NJ_THREAD_PRIORITY_NORMAL:
+    nice_val = 0;
+    break;
+  case NJ_THREAD_PRIORITY_HIGH:
+    nice_val = -10;
+    break;
+  }
+  pid_t tid = syscall(SYS_gettid);
+  NJ_CHECK_LOG_RETURN_VAL(setpriority(PRIO_PROCESS, tid, nice_val) == 0, false, "Can't set the thread priority");
+  return true;
+}
+
+bool nj_thread_set_affinity(const nj_cpu_set_t* affinity) {
+  cpu_set_t set;
+  thread_to_cpu_set(affinity, &set);
+  NJ_CHECK_LOG_RETURN_VAL(pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0, false, "Can't set the thread affinity");
+  return true;
 }
@@ -6,21 +6,70 @@
 
 #include "core/thread.h"
 
+#include "core/cpu_topology.h"
 #include "core/log.h"
+#include "core/utils.h"
 
 #include <Windows.h>
 
+typedef HRESULT (WINAPI *nj_set_thread_description_t)(HANDLE, PCWSTR);
+
 static DWORD platform_thread_start(void* args) {
   nj_thread_t* thread = (nj_thread_t*)args;
   thread->start_func(thread->args);
   return 0;
 }
 
-bool nj_thread_init(nj_thread_t* thread, nj_thread_func_t start_func, void* args) {
+static bool thread_set_name(HANDLE handle, const char* name) {
+  // SetThreadDescription() was added in Windows 10 1607.
+  static nj_set_thread_description_t set_thread_description = (nj_set_thread_description_t)GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription");
+  if (!set_thread_description)
+    return false;
+  wchar_t wname[64];
+  NJ_CHECK_RETURN_VAL(MultiByteToWideChar(CP_UTF8, 0, name, -1, wname, nj_static_array_size(wname)), false);
+  return SUCCEEDED(set_thread_description(handle, wname));
+}
+
+static bool thread_set_priority(HANDLE handle, nj_thread_priority_t priority) {
+  int win_priority = THREAD_PRIORITY_NORMAL;
+  switch (priority) {
+  case NJ_THREAD_PRIORITY_LOW:
+    win_priority = THREAD_PRIORITY_BELOW_NORMAL;
+    break;
+  case NJ_THREAD_PRIORITY_NORMAL:
+    win_priority = THREAD_PRIORITY_NORMAL;
+    break;
+  case NJ_THREAD_PRIORITY_HIGH:
+    win_priority = THREAD_PRIORITY_ABOVE_NORMAL;
+    break;
+  }
+  return SetThreadPriority(handle, win_priority);
+}
+
+static bool thread_set_affinity(HANDLE handle, const nj_cpu_set_t* affinity) {
+  // Only the processor group of the process is supported.
+  return SetThreadAffinityMask(handle, (DWORD_PTR)affinity->masks[0]) != 0;
+}
+
+bool nj_thread_init(nj_thread_t* thread, nj_thread_func_t start_func, void* args, const nj_thread_desc_t* desc) {
+  nj_thread_desc_t default_desc;
+  if (!desc)
+    desc = &default_desc;
   thread->start_func = start_func;
   thread->args = args;
-  thread->handle = CreateThread(NULL, 0, platform_thread_start, (void*)thread, 0, NULL);
+  thread->priority = desc->priority;
+  DWORD flags = CREATE_SUSPENDED;
+  if (desc->stack_size)
+    flags |= STACK_SIZE_PARAM_IS_A_RESERVATION;
+  thread->handle = CreateThread(NULL, desc->stack_size, platform_thread_start, (void*)thread, flags, NULL);
   NJ_CHECK_LOG_RETURN_VAL(thread->handle != NULL, false, "Can't create a new thread");
+  if (desc->name && !thread_set_name(thread->handle, desc->name))
+    NJ_LOGW("Can't set the thread name to %s", desc->name);
+  if (desc->priority != NJ_THREAD_PRIORITY_NORMAL && !thread_set_priority(thread->handle, desc->priority))
+    NJ_LOGW("Can't set the thread priority");
+  if (desc->affinity && !thread_set_affinity(thread->handle, desc->affinity))
+    NJ_LOGW("Can't set the thread affinity");
+  ResumeThread(thread->handle);
   return true;
 }
 
@@ -29,7 +78,33 @@ void nj_thread_wait_for(nj_thread_t* thread) {
 }
 
 int nj_thread_get_nums() {
-  SYSTEM_INFO info;
-  GetSystemInfo(&info);
-  return info.dwNumberOfProcessors;
+  DWORD_PTR process_mask;
+  DWORD_PTR system_mask;
+  int num;
+  if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+    num = nj_popcount64(process_mask);
+  } else {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    num = info.dwNumberOfProcessors;
+  }
+  int quota = nj_cpu_get_quota_core_count();
+  if (quota > 0)
+    num = nj_min(num, quota);
+  return num;
+}
+
+bool nj_thread_set_name(const char* name) {
+  NJ_CHECK_LOG_RETURN_VAL(thread_set_name(GetCurrentThread(), name), false, "Can't set the thread name to %s", name);
+  return true;
+}
+
+bool nj_thread_set_priority(nj_thread_priority_t priority) {
+  NJ_CHECK_LOG_RETURN_VAL(thread_set_priority(GetCurrentThread(), priority), false, "Can't set the thread priority");
+  return true;
+}
+
+bool nj_thread_set_affinity(const nj_cpu_set_t* affinity) {
+  NJ_CHECK_LOG_RETURN_VAL(thread_set_affinity(GetCurrentThread(), affinity), false, "Can't set the thread affinity");
+  return true;
 }
@@ -0,0 +1,250 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#include "core/timer_wheel.h"
+
+#include "core/dynamic_array.inl"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/queue.inl"
+#include "core/utils.h"
+
+#define NJ_TW_SLOT_MASK (NJ_TW_SLOT_COUNT - 1)
+#define NJ_TW_WHEEL_BITS (NJ_TW_SLOT_BITS * NJ_TW_LEVEL_COUNT)
+
+static njs64 tw_get_tick(const nj_timer_wheel_t* tw, njs64 time) {
+  return (time - tw->start_time) / tw->tick_length;
+}
+
+static void tw_link(nj_timer_wheel_t* tw, nju32 index) {
+  nj_timer_t* timer = &tw->timers[index];
+  // The lowest level whose slot range contains the deadline is the one above
+  // the highest slot index that differs from the current tick. New timers are
+  // after the current tick so their slot is ahead of the current one. A timer
+  // that cascades down on its own deadline tick has no differing bit, the |1
+  // puts it in the current slot of level 0, which nj_tw_update() expires
+  // right after the cascade.
+  nju64 diff = (nju64)(timer->deadline ^ tw->current_tick) | 1;
+  int level = (63 - nj_clz64(diff)) / NJ_TW_SLOT_BITS;
+  nju32 list = NJ_TW_OVERFLOW_LIST;
+  if (level < NJ_TW_LEVEL_COUNT) {
+    int slot = (timer->deadline >> (level * NJ_TW_SLOT_BITS)) & NJ_TW_SLOT_MASK;
+    list = level * NJ_TW_SLOT_COUNT + slot;
+    tw->occupied[level] |= 1ull << slot;
+  }
+  timer->list = list;
+  timer->prev = NJ_TW_INVALID_INDEX;
+  timer->next = tw->heads[list];
+  if (timer->next != NJ_TW_INVALID_INDEX)
+    tw->timers[timer->next].prev = index;
+  tw->heads[list] = index;
+}
+
+static void tw_unlink(nj_timer_wheel_t* tw, nju32 index) {
+  nj_timer_t* timer = &tw->timers[index];
+  if (timer->prev != NJ_TW_INVALID_INDEX)
+    tw->timers[timer->prev].next = timer->next;
+  else
+    tw->heads[timer->list] = timer->next;
+  if (timer->next != NJ_TW_INVALID_INDEX)
+    tw->timers[timer->next].prev = timer->prev;
+  if (timer->list != NJ_TW_OVERFLOW_LIST && tw->heads[timer->list] == NJ_TW_INVALID_INDEX)
+    tw->occupied[timer->list / NJ_TW_SLOT_COUNT] &= ~(1ull << (timer->list % NJ_TW_SLOT_COUNT));
+}
+
+static void tw_free(nj_timer_wheel_t* tw, nju32 index) {
+  nj_timer_t* timer = &tw->timers[index];
+  ++timer->generation;
+  timer->next = tw->free_head;
+  tw->free_head = index;
+  --tw->timer_count;
+}
+
+// Moves every timer of |list| to where it belongs now.
+static void tw_relink_list(nj_timer_wheel_t* tw, nju32 list) {
+  nju32 index = tw->heads[list];
+  tw->heads[list] = NJ_TW_INVALID_INDEX;
+  if (list != NJ_TW_OVERFLOW_LIST)
+    tw->occupied[list / NJ_TW_SLOT_COUNT] &= ~(1ull << (list % NJ_TW_SLOT_COUNT));
+  while (index != NJ_TW_INVALID_INDEX) {
+    nju32 next = tw->timers[index].next;
+    tw_link(tw, index);
+    index = next;
+  }
+}
+
+// Called when |tw->current_tick| moves to a multiple of NJ_TW_SLOT_COUNT. The
+// higher levels go first so their timers can move down more than one level.
+static void tw_cascade(nj_timer_wheel_t* tw) {
+  njs64 tick = tw->current_tick;
+  if (!(tick & ((1ll << NJ_TW_WHEEL_BITS) - 1)))
+    tw_relink_list(tw, NJ_TW_OVERFLOW_LIST);
+  for (int level = NJ_TW_LEVEL_COUNT - 1; level > 0; --level) {
+    int shift = level * NJ_TW_SLOT_BITS;
+    if (tick & ((1ll << shift) - 1))
+      continue;
+    int slot = (tick >> shift) & NJ_TW_SLOT_MASK;
+    tw_relink_list(tw, level * NJ_TW_SLOT_COUNT + slot);
+  }
+}
+
+static void tw_expire_slot(nj_timer_wheel_t* tw, int slot, njs64 now_tick) {
+  nju32 index = tw->heads[slot];
+  tw->heads[slot] = NJ_TW_INVALID_INDEX;
+  tw->occupied[0] &= ~(1ull << slot);
+  while (index != NJ_TW_INVALID_INDEX) {
+    nj_timer_t* timer = &tw->timers[index];
+    nju32 next = timer->next;
+    nj_da_append(&tw->expired_jobs, {timer->func, timer->args});
+    if (timer->period) {
+      // Skip the periods that were missed while catching up.
+      timer->deadline += timer->period;
+      if (timer->deadline <= now_tick)
+        timer->deadline += ((now_tick - timer->deadline) / timer->period + 1) * timer->period;
+      tw_link(tw, index);
+    } else {
+      tw_free(tw, index);
+    }
+    index = next;
+  }
+}
+
+// Returns the first tick after the current one that has a timer to expire or
+// to move down, -1 if there is none.
+static njs64 tw_get_next_tick(const nj_timer_wheel_t* tw) {
+  if (!tw->timer_count)
+    return -1;
+  njs64 tick = tw->current_tick;
+  njs64 next_tick = -1;
+  for (int level = 0; level < NJ_TW_LEVEL_COUNT; ++level) {
+    int shift = level * NJ_TW_SLOT_BITS;
+    int slot = (tick >> shift) & NJ_TW_SLOT_MASK;
+    // Only the slots after the current one can be used, 2 << 63 wraps to 0.
+    nju64 mask = tw->occupied[level] & ~((2ull << slot) - 1);
+    if (!mask)
+      continue;
+    njs64 level_base = (tick >> (shift + NJ_TW_SLOT_BITS)) << (shift + NJ_TW_SLOT_BITS);
+    njs64 slot_tick = level_base + ((njs64)nj_ctz64(mask) << shift);
+    if (next_tick == -1 || slot_tick < next_tick)
+      next_tick = slot_tick;
+    // Slots of higher levels start after the current slot of this level ends.
+    break;
+  }
+  if (next_tick == -1 && tw->heads[NJ_TW_OVERFLOW_LIST] != NJ_TW_INVALID_INDEX)
+    next_tick = ((tick >> NJ_TW_WHEEL_BITS) + 1) << NJ_TW_WHEEL_BITS;
+  return next_tick;
+}
+
+bool nj_tw_init(nj_timer_wheel_t* tw, nj_allocator_t* allocator, njs64 tick_length) {
+  NJ_CHECK_LOG_RETURN_VAL(tick_length > 0, false, "Invalid tick length");
+  tw->allocator = allocator;
+  nj_mutex_init(&tw->mutex);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&tw->timers, allocator), false);
+  NJ_CHECK_RETURN_VAL(nj_da_init(&tw->expired_jobs, allocator), false);
+  tw->free_head = NJ_TW_INVALID_INDEX;
+  for (njsz i = 0; i < nj_static_array_size(tw->heads); ++i)
+    tw->heads[i] = NJ_TW_INVALID_INDEX;
+  for (int i = 0; i < NJ_TW_LEVEL_COUNT; ++i)
+    tw->occupied[i] = 0;
+  tw->timer_count = 0;
+  tw->start_time = nj_mono_time_now();
+  tw->tick_length = tick_length;
+  tw->current_tick = 0;
+  tw->signal = {};
+  tw->counter = {};
+  return true;
+}
+
+void nj_tw_destroy(nj_timer_wheel_t* tw) {
+  nj_job_wait(&tw->counter);
+  nj_da_destroy(&tw->timers);
+  nj_da_destroy(&tw->expired_jobs);
+}
+
+nj_timer_handle_t nj_tw_add(nj_timer_wheel_t* tw, njs64 delay, njs64 period, nj_job_func_t func, void* args) {
+  njs64 deadline = tw_get_tick(tw, nj_mono_time_now() + delay + tw->tick_length - 1);
+  nj_mutex_lock(&tw->mutex);
+  nju32 index = tw->free_head;
+  if (index != NJ_TW_INVALID_INDEX) {
+    tw->free_head = tw->timers[index].next;
+  } else {
+    index = nj_da_len(&tw->timers);
+    nj_timer_t timer = {};
+    nj_da_append(&tw->timers, timer);
+  }
+  nj_timer_t* timer = &tw->timers[index];
+  timer->func = func;
+  timer->args = args;
+  timer->deadline = nj_max(deadline, tw->current_tick + 1);
+  timer->period = period > 0 ? nj_max((period + tw->tick_length - 1) / tw->tick_length, (njs64)1) : 0;
+  ++timer->generation;
+  tw_link(tw, index);
+  ++tw->timer_count;
+  nj_timer_handle_t handle = {index, timer->generation};
+  nj_mutex_unlock(&tw->mutex);
+  nj_queue_signal_notify(&tw->signal);
+  return handle;
+}
+
+bool nj_tw_cancel(nj_timer_wheel_t* tw, nj_timer_handle_t handle) {
+  nj_mutex_lock(&tw->mutex);
+  bool is_valid = handle.index < nj_da_len(&tw->timers) && (handle.generation & 1) && tw->timers[handle.index].generation == handle.generation;
+  if (is_valid) {
+    tw_unlink(tw, handle.index);
+    tw_free(tw, handle.index);
+  }
+  nj_mutex_unlock(&tw->mutex);
+  return is_valid;
+}
+
+void nj_tw_update(nj_timer_wheel_t* tw) {
+  njs64 now_tick = tw_get_tick(tw, nj_mono_time_now());
+  nj_da_resize(&tw->expired_jobs, 0);
+  nj_mutex_lock(&tw->mutex);
+  while (tw->current_tick < now_tick) {
+    njs64 next_tick = tw_get_next_tick(tw);
+    if (next_tick == -1 || next_tick > now_tick) {
+      // Nothing to do until |now_tick|. Jumping keeps the timers valid because
+      // no slot boundary with a timer is crossed.
+      tw->current_tick = now_tick;
+      break;
+    }
+    tw->current_tick = next_tick;
+    if (!(next_tick & NJ_TW_SLOT_MASK))
+      tw_cascade(tw);
+    if (tw->occupied[0] & (1ull << (next_tick & NJ_TW_SLOT_MASK)))
+      tw_expire_slot(tw, next_tick & NJ_TW_SLOT_MASK, now_tick);
+  }
+  nj_mutex_unlock(&tw->mutex);
+  // The jobs run inline if the job system isn't running, they can add or
+  // cancel timers.
+  if (nj_da_len(&tw->expired_jobs))
+    nj_job_run(&tw->expired_jobs[0], (int)nj_da_len(&tw->expired_jobs), &tw->counter);
+}
+
+njs64 nj_tw_get_next_deadline(nj_timer_wheel_t* tw) {
+  nj_mutex_lock(&tw->mutex);
+  njs64 next_tick = tw_get_next_tick(tw);
+  nj_mutex_unlock(&tw->mutex);
+  if (next_tick == -1)
+    return -1;
+  return tw->start_time + next_tick * tw->tick_length;
+}
+
+void nj_tw_sleep(nj_timer_wheel_t* tw, njs64 timeout) {
+  nju32 seq = nj_queue_signal_prepare_wait(&tw->signal);
+  njs64 deadline = nj_tw_get_next_deadline(tw);
+  if (timeout >= 0) {
+    njs64 timeout_deadline = nj_mono_time_now() + timeout;
+    if (deadline == -1 || timeout_deadline < deadline)
+      deadline = timeout_deadline;
+  }
+  nj_queue_signal_wait(&tw->signal, seq, deadline);
+}
+
+void nj_tw_wake(nj_timer_wheel_t* tw) {
+  nj_queue_signal_notify(&tw->signal);
+}
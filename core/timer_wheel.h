@@ -0,0 +1,100 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+#ifndef NJ_CORE_TIMER_WHEEL_H
+#define NJ_CORE_TIMER_WHEEL_H
+
+#include "core/dynamic_array.h"
+#include "core/job.h"
+#include "core/njtype.h"
+#include "core/queue.h"
+#include "core/sync.h"
+
+struct nj_allocator_t;
+
+#define NJ_TW_LEVEL_COUNT (4)
+#define NJ_TW_SLOT_BITS (6)
+#define NJ_TW_SLOT_COUNT (1 << NJ_TW_SLOT_BITS)
+// Timers further than NJ_TW_SLOT_COUNT^NJ_TW_LEVEL_COUNT ticks (~4.6 hours with
+// 1 ms ticks) wait in an extra list that is re-sorted once per wheel turn.
+#define NJ_TW_OVERFLOW_LIST (NJ_TW_LEVEL_COUNT * NJ_TW_SLOT_COUNT)
+#define NJ_TW_INVALID_INDEX (0xffffffff)
+
+// A zero-initialized handle is never valid.
+struct nj_timer_handle_t {
+  nju32 index;
+  nju32 generation;
+};
+
+// Timers are linked by index so |timers| can grow. |generation| is odd while
+// the timer is scheduled.
+struct nj_timer_t {
+  nj_job_func_t func;
+  void* args;
+  njs64 deadline;
+  // 0 for one-shot timers. In ticks like |deadline|.
+  njs64 period;
+  nju32 prev;
+  // The next timer in the same list, or the next free timer.
+  nju32 next;
+  nju32 generation;
+  nju32 list;
+};
+
+// Hashed hierarchical timer wheel. Level l has NJ_TW_SLOT_COUNT slots of
+// NJ_TW_SLOT_COUNT^l ticks, a timer goes in the lowest level whose slot range
+// contains its deadline and moves down a level when time reaches its slot.
+// Adding and cancelling a timer are O(1), updating is O(expired timers) plus
+// one step per NJ_TW_SLOT_COUNT ticks.
+// Expired timers are dispatched with nj_job_run(). The wheel can be updated
+// from a frame loop or from a thread that sleeps with nj_tw_sleep().
+struct nj_timer_wheel_t {
+  nj_allocator_t* allocator;
+  nj_mutex_t mutex;
+  nj_dynamic_array_t<nj_timer_t> timers;
+  nju32 free_head;
+  nju32 heads[NJ_TW_OVERFLOW_LIST + 1];
+  // Bit i is set if slot i of the level has a timer.
+  nju64 occupied[NJ_TW_LEVEL_COUNT];
+  njsp timer_count;
+  // In mono time.
+  njs64 start_time;
+  njs64 tick_length;
+  // Timers of this tick and before have been dispatched.
+  njs64 current_tick;
+  // Notified when a timer is added so a sleeping thread can wake up earlier.
+  nj_queue_signal_t signal;
+  nj_job_counter_t counter;
+  // Only used by nj_tw_update().
+  nj_dynamic_array_t<nj_job_desc_t> expired_jobs;
+};
+
+// |tick_length| is the resolution in mono time, deadlines are rounded up to
+// it.
+bool nj_tw_init(nj_timer_wheel_t* tw, nj_allocator_t* allocator, njs64 tick_length);
+// Waits for the dispatched jobs.
+void nj_tw_destroy(nj_timer_wheel_t* tw);
+
+// Run |func| after |delay| (in mono time), then every |period| if it's not 0.
+// Can be called from any thread, including from the timer jobs.
+nj_timer_handle_t nj_tw_add(nj_timer_wheel_t* tw, njs64 delay, njs64 period, nj_job_func_t func, void* args);
+// Returns false if the timer already fired (one-shot) or was cancelled. A job
+// that was already dispatched still runs.
+bool nj_tw_cancel(nj_timer_wheel_t* tw, nj_timer_handle_t handle);
+
+// Dispatch the timers that expired until now. Periodic timers that missed
+// several periods only run once. Only one thread can call it at a time.
+void nj_tw_update(nj_timer_wheel_t* tw);
+// Mono time when nj_tw_update() has work to do next, -1 if there is no timer.
+// The work can be moving timers down a level so it may dispatch nothing.
+njs64 nj_tw_get_next_deadline(nj_timer_wheel_t* tw);
+// Sleep until the next deadline, until a timer is added or until |timeout| (in
+// mono time, -1 for none) passed, whichever comes first.
+void nj_tw_sleep(nj_timer_wheel_t* tw, njs64 timeout);
+// Wake a thread sleeping in nj_tw_sleep(), e.g. to stop it.
+void nj_tw_wake(nj_timer_wheel_t* tw);
+
+#endif // NJ_CORE_TIMER_WHEEL_H
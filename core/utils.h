@@ -7,6 +7,8 @@
 #ifndef NJ_CORE_UTILS_H
 #define NJ_CORE_UTILS_H
 
+#include "core/njtype.h"
+
 template <typename T>
 void nj_maybe_assign(T* t, T v) {
   if (t)
@@ -18,9 +20,27 @@ const T& nj_min(const T& a, const T& b) {
   return a < b ? a : b;
 }
 
+template <typename T>
+const T& nj_max(const T& a, const T& b) {
+  return a < b ? b : a;
+}
+
 template <typename T, njsz N>
 njsz nj_static_array_size(const T(&)[N]) {
   return N;
 }
 
+// |v| must not be 0 for nj_ctz64() and nj_clz64().
+inline int nj_ctz64(nju64 v) {
+  return __builtin_ctzll(v);
+}
+
+inline int nj_clz64(nju64 v) {
+  return __builtin_clzll(v);
+}
+
+inline int nj_popcount64(nju64 v) {
+  return __builtin_popcountll(v);
+}
+
 #endif // NJ_CORE_UTILS_H
@@ -0,0 +1,180 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Read a file in 64 KB pieces in random order, one blocking nj_file_pread() at
+// a time then in batches through each nj_aio_t backend, best of 3 runs. The
+// file is written first and each 8 bytes word is its offset so the reads can
+// be checked. Without -d the file is probably in the OS cache, -d opens it with
+// NJ_FILE_MODE_DIRECT to read from the device.
+// Usage: bench_async_io [-d] [size_in_mb]
+
+#include "core/async_io.h"
+#include "core/core_init.h"
+#include "core/file.h"
+#include "core/free_list_allocator.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NJ_BENCH_READ_SIZE (64 * 1024)
+#define NJ_BENCH_RUN_COUNT (3)
+// Requests per nj_aio_submit().
+#define NJ_BENCH_BATCH_SIZE (64)
+
+enum bench_mode_t {
+  BENCH_MODE_BLOCKING,
+  BENCH_MODE_THREAD_POOL,
+  BENCH_MODE_IO_URING,
+  BENCH_MODE_IO_URING_REGISTERED,
+};
+
+static const nj_os_char* gc_bench_path = NJ_OS_LIT("bench_async_io.bin");
+
+static nju64 bench_xorshift(nju64* state) {
+  nju64 x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+static bool bench_write_file(nju8* buffer, njsp size) {
+  for (njsp i = 0; i < size; i += sizeof(nju64)) {
+    nju64 word = i;
+    memcpy(buffer + i, &word, sizeof(word));
+  }
+  nj_file_t file;
+  NJ_CHECK_RETURN_VAL(nj_file_open(&file, gc_bench_path, NJ_FILE_MODE_WRITE, NJ_FILE_UNBUFFERED), false);
+  njsp bytes_written = 0;
+  bool rv = nj_file_write(&file, buffer, size, &bytes_written) && bytes_written == size;
+  nj_file_close(&file);
+  return rv;
+}
+
+static bool bench_check(const nju8* buffer, njsp size) {
+  for (njsp i = 0; i < size; i += sizeof(nju64)) {
+    nju64 word;
+    memcpy(&word, buffer + i, sizeof(word));
+    if (word != (nju64)i)
+      return false;
+  }
+  return true;
+}
+
+// Reads every piece of |offsets| to the same offset in |buffer|.
+static bool bench_read(bench_mode_t mode, nj_file_t* file, nj_allocator_t* allocator, nju8* buffer, njsp size, const njsp* offsets, nj_aio_request_t* requests, int count) {
+  if (mode == BENCH_MODE_BLOCKING) {
+    for (int i = 0; i < count; ++i) {
+      njsp bytes_read;
+      NJ_CHECK_RETURN_VAL(nj_file_pread(file, buffer + offsets[i], NJ_BENCH_READ_SIZE, offsets[i], &bytes_read), false);
+    }
+    return true;
+  }
+
+  nj_aio_desc_t desc;
+  desc.backend = mode == BENCH_MODE_THREAD_POOL ? NJ_AIO_BACKEND_THREAD_POOL : NJ_AIO_BACKEND_IO_URING;
+  nj_aio_t aio;
+  NJ_CHECK_LOG_RETURN_VAL(nj_aio_init(&aio, allocator, &desc), false, "The backend isn't supported");
+  bool is_registered = mode == BENCH_MODE_IO_URING_REGISTERED;
+  if (is_registered) {
+    void* buffers[] = {buffer};
+    bool rv = nj_aio_register_files(&aio, file, 1) && nj_aio_register_buffers(&aio, buffers, &size, 1);
+    if (!rv) {
+      nj_aio_destroy(&aio);
+      NJ_LOGF_RETURN_VAL(false, "Can't register the file and the buffer");
+    }
+  }
+  for (int i = 0; i < count; ++i) {
+    requests[i] = nj_aio_request_t();
+    requests[i].file_index = is_registered ? 0 : -1;
+    requests[i].file = file;
+    requests[i].offset = offsets[i];
+    requests[i].size = NJ_BENCH_READ_SIZE;
+    requests[i].buffer = buffer + offsets[i];
+    requests[i].buffer_index = is_registered ? 0 : -1;
+  }
+  bool rv = true;
+  int submitted_count = 0;
+  int completed_count = 0;
+  while (completed_count < count) {
+    submitted_count += nj_aio_submit(&aio, requests + submitted_count, nj_min(count - submitted_count, NJ_BENCH_BATCH_SIZE));
+    nj_aio_request_t* completed[NJ_BENCH_BATCH_SIZE];
+    int num = nj_aio_wait(&aio, completed, NJ_BENCH_BATCH_SIZE);
+    for (int i = 0; i < num; ++i)
+      rv &= completed[i]->is_ok && completed[i]->bytes_read == NJ_BENCH_READ_SIZE;
+    completed_count += num;
+  }
+  nj_aio_destroy(&aio);
+  return rv;
+}
+
+static bool bench_run(const char* name, bench_mode_t mode, nj_file_t* file, nj_allocator_t* allocator, nju8* buffer, njsp size, const njsp* offsets, nj_aio_request_t* requests, int count) {
+  njs64 best = 0;
+  bool rv = true;
+  for (int i = 0; rv && i < NJ_BENCH_RUN_COUNT; ++i) {
+    memset(buffer, 0, size);
+    njs64 start = nj_mono_time_now();
+    rv = bench_read(mode, file, allocator, buffer, size, offsets, requests, count);
+    njs64 time = nj_mono_time_now() - start;
+    best = i ? nj_min(best, time) : time;
+  }
+  rv = rv && bench_check(buffer, size);
+  NJ_CHECK_LOG_RETURN_VAL(rv, false, "%s failed", name);
+  printf("%-24s %8.1f MB/s  %7.1f us/read\n", name, size / nj_mono_time_to_us(best), nj_mono_time_to_us(best) / count);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  bool is_direct = argc > 1 && !strcmp(argv[1], "-d");
+  njsp size_mb = argc > 1 + is_direct ? atol(argv[1 + is_direct]) : 128;
+  if (size_mb <= 0) {
+    printf("Usage: bench_async_io [-d] [size_in_mb]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_async_io.log"));
+  njsp size = size_mb * 1024 * 1024;
+  int count = (int)(size / NJ_BENCH_READ_SIZE);
+  nj_free_list_allocator_t allocator("bench_allocator", size + count * (sizeof(njsp) + sizeof(nj_aio_request_t)) + 16 * 1024 * 1024);
+  NJ_CHECK_RETURN_VAL(allocator.init(), 1);
+  nju8* buffer = (nju8*)allocator.aligned_alloc(size, NJ_FILE_DIRECT_ALIGNMENT);
+  njsp* offsets = (njsp*)allocator.alloc(count * sizeof(njsp));
+  nj_aio_request_t* requests = (nj_aio_request_t*)allocator.alloc(count * sizeof(nj_aio_request_t));
+  NJ_CHECK_RETURN_VAL(buffer && offsets && requests, 1);
+  NJ_CHECK_LOG_RETURN_VAL(bench_write_file(buffer, size), 1, "Can't write " NJ_OS_PCT, gc_bench_path);
+  nju64 state = 88172645463325252ull;
+  for (int i = 0; i < count; ++i)
+    offsets[i] = (njsp)i * NJ_BENCH_READ_SIZE;
+  for (int i = count - 1; i > 0; --i) {
+    int j = (int)(bench_xorshift(&state) % (i + 1));
+    njsp tmp = offsets[i];
+    offsets[i] = offsets[j];
+    offsets[j] = tmp;
+  }
+
+  nj_file_t file;
+  nj_file_mode mode = is_direct ? NJ_FILE_MODE_READ | NJ_FILE_MODE_DIRECT : NJ_FILE_MODE_READ | NJ_FILE_MODE_RANDOM;
+  bool rv = nj_file_open(&file, gc_bench_path, mode, NJ_FILE_UNBUFFERED);
+  NJ_CHECK_LOG(rv, "Can't open " NJ_OS_PCT, gc_bench_path);
+  if (rv) {
+    printf("%d random reads of %d KB%s\n", count, NJ_BENCH_READ_SIZE / 1024, is_direct ? ", direct" : "");
+    rv = bench_run("blocking nj_file_pread", BENCH_MODE_BLOCKING, &file, &allocator, buffer, size, offsets, requests, count);
+    rv = bench_run("aio thread pool", BENCH_MODE_THREAD_POOL, &file, &allocator, buffer, size, offsets, requests, count) && rv;
+    // Fails on kernels without io_uring, the thread pool is what they get.
+    rv = bench_run("aio io_uring", BENCH_MODE_IO_URING, &file, &allocator, buffer, size, offsets, requests, count) && rv;
+    rv = bench_run("aio io_uring registered", BENCH_MODE_IO_URING_REGISTERED, &file, &allocator, buffer, size, offsets, requests, count) && rv;
+    nj_file_close(&file);
+  }
+  nj_file_delete_path(gc_bench_path);
+  allocator.free(requests);
+  allocator.free(offsets);
+  allocator.free(buffer);
+  allocator.destroy();
+  return rv ? 0 : 1;
+}
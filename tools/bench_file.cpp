@@ -0,0 +1,103 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Throughput of nj_file_write() then nj_file_read() of a whole file in records
+// of 16 B to 1 MB, unbuffered and with pooled buffers of 4 KB to 256 KB, best
+// of 3 runs. The file is likely in the OS cache when it's read back.
+// Usage: bench_file [size_in_mb]
+
+#include "core/core_init.h"
+#include "core/file.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NJ_BENCH_MAX_RECORD_SIZE (1024 * 1024)
+#define NJ_BENCH_RUN_COUNT (3)
+
+static const nj_os_char* gc_bench_path = NJ_OS_LIT("bench_file.bin");
+
+static bool bench_run(njsp buffer_size, njsp record_size, njsp size, const nju8* data, nju8* read_data, njf64* write_mbps, njf64* read_mbps) {
+  njs64 best_write = 0;
+  njs64 best_read = 0;
+  bool rv = true;
+  for (int i = 0; rv && i < NJ_BENCH_RUN_COUNT; ++i) {
+    nj_file_t file;
+    NJ_CHECK_RETURN_VAL(nj_file_open(&file, gc_bench_path, NJ_FILE_MODE_WRITE, buffer_size), false);
+    njs64 start = nj_mono_time_now();
+    for (njsp offset = 0; rv && offset < size; offset += record_size)
+      rv = nj_file_write(&file, data, record_size, NULL);
+    nj_file_close(&file);
+    njs64 write_time = nj_mono_time_now() - start;
+
+    NJ_CHECK_RETURN_VAL(nj_file_open(&file, gc_bench_path, NJ_FILE_MODE_READ, buffer_size), false);
+    rv = rv && nj_file_get_size(&file) == size;
+    start = nj_mono_time_now();
+    for (njsp offset = 0; rv && offset < size; offset += record_size) {
+      njsp bytes_read = 0;
+      rv = nj_file_read(&file, read_data, record_size, &bytes_read) && bytes_read == record_size;
+    }
+    njs64 read_time = nj_mono_time_now() - start;
+    nj_file_close(&file);
+    // Every record has the same data, the last one is enough to see if the
+    // reads are shifted.
+    rv = rv && !memcmp(read_data, data, record_size);
+    best_write = i ? nj_min(best_write, write_time) : write_time;
+    best_read = i ? nj_min(best_read, read_time) : read_time;
+  }
+  NJ_CHECK_LOG_RETURN_VAL(rv, false, "Records of %ld bytes with a buffer of %ld bytes don't match", (long)record_size, (long)buffer_size);
+  *write_mbps = size / nj_mono_time_to_us(best_write);
+  *read_mbps = size / nj_mono_time_to_us(best_read);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  njsp size_mb = argc > 1 ? atol(argv[1]) : 128;
+  if (size_mb <= 0) {
+    printf("Usage: bench_file [size_in_mb]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_file.log"));
+  njsp size = size_mb * 1024 * 1024;
+  static nju8 data[NJ_BENCH_MAX_RECORD_SIZE];
+  static nju8 read_data[NJ_BENCH_MAX_RECORD_SIZE];
+  for (njsp i = 0; i < NJ_BENCH_MAX_RECORD_SIZE; ++i)
+    data[i] = (nju8)(i * 31 + (i >> 8));
+
+  const njsp buffer_sizes[] = {NJ_FILE_UNBUFFERED, 4 * 1024, NJ_FILE_DEFAULT_BUFFER_SIZE, 256 * 1024};
+  const njsp record_sizes[] = {16, 256, 4096, NJ_BENCH_MAX_RECORD_SIZE};
+  printf("%ld MB, write/read MB/s\n%-9s", (long)size_mb, "record");
+  for (njsp buffer_size : buffer_sizes) {
+    char name[32];
+    if (buffer_size == NJ_FILE_UNBUFFERED)
+      snprintf(name, sizeof(name), "unbuffered");
+    else
+      snprintf(name, sizeof(name), "%ld KB", (long)buffer_size / 1024);
+    printf("  %-13s", name);
+  }
+  printf("\n");
+  bool rv = true;
+  for (njsp record_size : record_sizes) {
+    if (record_size >= 1024)
+      printf("%4ld KB  ", (long)record_size / 1024);
+    else
+      printf("%4ld B   ", (long)record_size);
+    for (njsp buffer_size : buffer_sizes) {
+      njf64 write_mbps = 0;
+      njf64 read_mbps = 0;
+      rv = rv && bench_run(buffer_size, record_size, size, data, read_data, &write_mbps, &read_mbps);
+      printf("  %6.0f/%-6.0f", write_mbps, read_mbps);
+      fflush(stdout);
+    }
+    printf("\n");
+  }
+  nj_file_delete_path(gc_bench_path);
+  return rv ? 0 : 1;
+}
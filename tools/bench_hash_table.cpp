@@ -0,0 +1,87 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Latency of nj_ht_insert_ptr() while the table grows, with a stop-the-world
+// resize and with incremental resizes, then the average get.
+// Usage: bench_hash_table [key_count]
+
+#include "core/core_init.h"
+#include "core/dynamic_array.inl"
+#include "core/free_list_allocator.h"
+#include "core/hash_table.h"
+#include "core/mono_time.h"
+#include "core/sort.inl"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static nju64 bench_xorshift(nju64* state) {
+  nju64 x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+static bool bench_run(nj_allocator_t* allocator, njsp migrate_step, const nju64* keys, nju64* times, njsp count) {
+  nj_hash_table_t ht;
+  NJ_CHECK_RETURN_VAL(nj_ht_init(&ht, allocator, sizeof(nju64)), false);
+  if (migrate_step)
+    nj_ht_set_incremental_resize(&ht, migrate_step);
+  njs64 start = nj_mono_time_now();
+  for (njsp i = 0; i < count; ++i) {
+    njs64 t = nj_mono_time_now();
+    njsp index = nj_ht_insert_ptr(&ht, (void*)&keys[i], sizeof(nju64));
+    times[i] = nj_mono_time_now() - t;
+    ht.values[index] = i;
+  }
+  njs64 insert_time = nj_mono_time_now() - start;
+  start = nj_mono_time_now();
+  bool rv = true;
+  for (njsp i = 0; i < count; ++i) {
+    njsp index = nj_ht_get_ptr(&ht, (void*)&keys[i], sizeof(nju64));
+    rv &= index != NJ_HT_INVALID_INDEX && ht.values[index] == (njup)i;
+  }
+  njs64 get_time = nj_mono_time_now() - start;
+  nj_ht_destroy(&ht);
+  NJ_CHECK_LOG_RETURN_VAL(rv, false, "Lost a key");
+
+  NJ_CHECK_RETURN_VAL(nj_radix_sort(times, count, allocator), false);
+  printf("%-20s insert avg %6.3f us  p99 %6.3f us  p99.9 %7.3f us  max %9.1f us  get avg %6.3f us\n",
+         migrate_step ? "incremental" : "stop-the-world",
+         nj_mono_time_to_us(insert_time) / count,
+         nj_mono_time_to_us(times[count * 99 / 100]),
+         nj_mono_time_to_us(times[count * 999 / 1000]),
+         nj_mono_time_to_us(times[count - 1]),
+         nj_mono_time_to_us(get_time) / count);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  njsp count = argc > 1 ? atol(argv[1]) : 1000000;
+  if (count <= 0) {
+    printf("Usage: bench_hash_table [key_count]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_hash_table.log"));
+  // The table, the tracked latencies and the sort buffer.
+  nj_free_list_allocator_t allocator("bench_allocator", count * 256 + 64 * 1024 * 1024);
+  NJ_CHECK_RETURN_VAL(allocator.init(), 1);
+  nju64* keys = (nju64*)allocator.alloc(count * sizeof(nju64));
+  nju64* times = (nju64*)allocator.alloc(count * sizeof(nju64));
+  NJ_CHECK_RETURN_VAL(keys && times, 1);
+  nju64 state = 88172645463325252ull;
+  for (njsp i = 0; i < count; ++i)
+    keys[i] = bench_xorshift(&state);
+
+  printf("%ld random 8 bytes keys\n", (long)count);
+  bool rv = bench_run(&allocator, 0, keys, times, count);
+  rv = rv && bench_run(&allocator, 8, keys, times, count);
+  allocator.free(times);
+  allocator.free(keys);
+  allocator.destroy();
+  return rv ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Decompression speed of core/inflate.h on a zlib or gzip file, whole in the
+// window and streamed through a 128 KB window in 64 KB pieces of input, then
+// the speed of the checksums on the output. A PNG file is decoded by
+// nj_png_decode() instead, along with the inflate of its image data alone.
+// Best of 5 runs, speeds are of the decompressed data.
+// Usage: bench_inflate <file>
+
+#include "core/core_init.h"
+#include "core/file.h"
+#include "core/free_list_allocator.h"
+#include "core/inflate.h"
+#include "core/loader/png.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/os_string.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define NJ_BENCH_RUN_COUNT (5)
+#define NJ_BENCH_STREAM_WINDOW_SIZE (128 * 1024)
+#define NJ_BENCH_STREAM_PIECE_SIZE (64 * 1024)
+
+// Streams |data| through |window|. The output size and CRC-32, if |crc| isn't
+// NULL, are returned to check the runs against each other.
+static bool bench_stream(nj_inflate_t* inflate, nj_inflate_format_t format, const nju8* data, njsp size, nju8* window, njsp* output_size, nju32* crc) {
+  nj_inflate_init(inflate, format, window, NJ_BENCH_STREAM_WINDOW_SIZE);
+  *output_size = 0;
+  if (crc)
+    *crc = 0;
+  njsp offset = 0;
+  nj_inflate_status_t status;
+  do {
+    njsp used;
+    status = nj_inflate_decode(inflate, data + offset, nj_min(size - offset, (njsp)NJ_BENCH_STREAM_PIECE_SIZE), &used);
+    offset += used;
+    const nju8* output;
+    njsp len;
+    nj_inflate_take_output(inflate, &output, &len);
+    if (crc)
+      *crc = nj_crc32(*crc, output, len);
+    *output_size += len;
+  } while ((status == NJ_INFLATE_STATUS_NEED_INPUT && offset < size) || status == NJ_INFLATE_STATUS_OUTPUT_FULL);
+  return status == NJ_INFLATE_STATUS_DONE;
+}
+
+static nju32 bench_read_u32(const nju8* p) {
+  return ((nju32)p[0] << 24) | ((nju32)p[1] << 16) | ((nju32)p[2] << 8) | p[3];
+}
+
+// The image data of the PNG in |map| is gathered from its IDAT chunks and
+// inflated alone, then the whole file is decoded. Segments aren't inflated in
+// parallel, there is no job system.
+static bool bench_png(const nj_file_map_t* map, const nj_os_char* path) {
+  nj_png_t png;
+  NJ_CHECK_LOG_RETURN_VAL(nj_png_read_info(&png, map->data, map->size), false, "Can't read " NJ_OS_PCT, path);
+  // Each row starts with its filter method.
+  njsp deflated_size = (png.row_size + 1) * png.height;
+  njsp image_size = png.row_size * png.height;
+  nj_free_list_allocator_t allocator("bench_allocator", map->size + deflated_size + image_size + 1024 * 1024);
+  NJ_CHECK_RETURN_VAL(allocator.init(), false);
+  nju8* idat = (nju8*)allocator.alloc(map->size);
+  nju8* window = (nju8*)allocator.alloc(deflated_size);
+  nju8* image = (nju8*)allocator.alloc(image_size);
+  NJ_CHECK_RETURN_VAL(idat && window && image, false);
+  njsp idat_size = 0;
+  for (njsp offset = 8; offset + 12 <= map->size;) {
+    njsp data_len = bench_read_u32(map->data + offset);
+    if (data_len > map->size - offset - 12)
+      break;
+    if (!memcmp(map->data + offset + 4, "IDAT", 4)) {
+      memcpy(idat + idat_size, map->data + offset + 8, data_len);
+      idat_size += data_len;
+    }
+    offset += data_len + 12;
+  }
+  printf(NJ_OS_PCT ", PNG %ux%u, %u bits per pixel, %.1f MB to %.1f MB\n", path, png.width, png.height, png.bit_per_pixel,
+         idat_size / (1024.0 * 1024.0), deflated_size / (1024.0 * 1024.0));
+
+  njs64 best_inflate = 0;
+  njs64 best_decode = 0;
+  bool rv = true;
+  for (int i = 0; rv && i < NJ_BENCH_RUN_COUNT; ++i) {
+    static nj_inflate_t inflate;
+    njs64 start = nj_mono_time_now();
+    nj_inflate_init(&inflate, NJ_INFLATE_FORMAT_ZLIB, window, deflated_size);
+    njsp used;
+    rv = nj_inflate_decode(&inflate, idat, idat_size, &used) == NJ_INFLATE_STATUS_DONE && inflate.window_len == deflated_size;
+    njs64 time = nj_mono_time_now() - start;
+    best_inflate = i ? nj_min(best_inflate, time) : time;
+
+    start = nj_mono_time_now();
+    rv = rv && nj_png_decode(&png, map->data, map->size, image, image_size, 0);
+    time = nj_mono_time_now() - start;
+    best_decode = i ? nj_min(best_decode, time) : time;
+  }
+  NJ_CHECK_LOG(rv, "Can't decode " NJ_OS_PCT, path);
+  if (rv) {
+    printf("inflate IDAT      %8.1f MB/s\n", deflated_size / nj_mono_time_to_us(best_inflate));
+    printf("nj_png_decode     %8.1f MB/s\n", deflated_size / nj_mono_time_to_us(best_decode));
+  }
+
+  allocator.free(image);
+  allocator.free(window);
+  allocator.free(idat);
+  allocator.destroy();
+  return rv;
+}
+
+#if NJ_OS_WIN()
+int wmain(int argc, wchar_t** argv) {
+#else
+int main(int argc, char** argv) {
+#endif
+  if (argc != 2) {
+    printf("Usage: bench_inflate <file>\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_inflate.log"));
+  nj_file_map_t map;
+  NJ_CHECK_LOG_RETURN_VAL(nj_file_map(&map, argv[1]) && map.size > 2, 1, "Can't read " NJ_OS_PCT, argv[1]);
+  static const nju8 sc_png_signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  if (map.size >= 8 && !memcmp(map.data, sc_png_signature, 8)) {
+    bool rv = bench_png(&map, argv[1]);
+    nj_file_unmap(&map);
+    return rv ? 0 : 1;
+  }
+  nj_inflate_format_t format = map.data[0] == 31 && map.data[1] == 139 ? NJ_INFLATE_FORMAT_GZIP : NJ_INFLATE_FORMAT_ZLIB;
+  static nj_inflate_t inflate_state;
+  static nju8 stream_window[NJ_BENCH_STREAM_WINDOW_SIZE];
+  nj_inflate_t* inflate = &inflate_state;
+
+  // A first pass for the output size.
+  njsp output_size;
+  nju32 crc;
+  NJ_CHECK_LOG_RETURN_VAL(bench_stream(inflate, format, map.data, map.size, stream_window, &output_size, &crc), 1,
+                          NJ_OS_PCT " isn't a valid %s stream", argv[1], format == NJ_INFLATE_FORMAT_GZIP ? "gzip" : "zlib");
+  nj_free_list_allocator_t allocator("bench_allocator", output_size + 1024 * 1024);
+  NJ_CHECK_RETURN_VAL(allocator.init(), 1);
+  nju8* window = (nju8*)allocator.alloc(nj_max(output_size, (njsp)1));
+  NJ_CHECK_RETURN_VAL(window, 1);
+  printf(NJ_OS_PCT ", %s, %.1f MB to %.1f MB\n", argv[1], format == NJ_INFLATE_FORMAT_GZIP ? "gzip" : "zlib",
+         map.size / (1024.0 * 1024.0), output_size / (1024.0 * 1024.0));
+
+  njs64 best_whole = 0;
+  njs64 best_stream = 0;
+  bool rv = true;
+  for (int i = 0; rv && i < NJ_BENCH_RUN_COUNT; ++i) {
+    njs64 start = nj_mono_time_now();
+    nj_inflate_init(inflate, format, window, output_size);
+    njsp used;
+    rv = nj_inflate_decode(inflate, map.data, map.size, &used) == NJ_INFLATE_STATUS_DONE;
+    njs64 time = nj_mono_time_now() - start;
+    best_whole = i ? nj_min(best_whole, time) : time;
+    rv = rv && nj_crc32(0, window, output_size) == crc;
+
+    njsp stream_size;
+    start = nj_mono_time_now();
+    rv = rv && bench_stream(inflate, format, map.data, map.size, stream_window, &stream_size, NULL) && stream_size == output_size;
+    time = nj_mono_time_now() - start;
+    best_stream = i ? nj_min(best_stream, time) : time;
+  }
+  NJ_CHECK_LOG(rv, "The runs don't decode to the same output");
+
+  njs64 best_adler = 0;
+  njs64 best_crc = 0;
+  nju32 sum = 0;
+  for (int i = 0; rv && i < NJ_BENCH_RUN_COUNT; ++i) {
+    njs64 start = nj_mono_time_now();
+    sum += nj_adler32(1, window, output_size);
+    njs64 time = nj_mono_time_now() - start;
+    best_adler = i ? nj_min(best_adler, time) : time;
+    start = nj_mono_time_now();
+    sum += nj_crc32(0, window, output_size);
+    time = nj_mono_time_now() - start;
+    best_crc = i ? nj_min(best_crc, time) : time;
+  }
+  if (rv) {
+    printf("inflate whole     %8.1f MB/s\n", output_size / nj_mono_time_to_us(best_whole));
+    printf("inflate streamed  %8.1f MB/s\n", output_size / nj_mono_time_to_us(best_stream));
+    printf("nj_adler32        %8.1f MB/s\n", output_size / nj_mono_time_to_us(best_adler));
+    // |sum| is printed so the checksums aren't optimized out.
+    printf("nj_crc32          %8.1f MB/s  (%08x)\n", output_size / nj_mono_time_to_us(best_crc), sum);
+  }
+
+  allocator.free(window);
+  allocator.destroy();
+  nj_file_unmap(&map);
+  return rv ? 0 : 1;
+}
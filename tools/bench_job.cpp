@@ -0,0 +1,103 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Throughput of the job system with fine (1 us) and coarse (100 us) jobs and
+// the latency of running a single empty job, on threads then on fibers.
+// Usage: bench_job [worker_count]
+
+#include "core/atomic.h"
+#include "core/core_init.h"
+#include "core/free_list_allocator.h"
+#include "core/job.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/sort.inl"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NJ_BENCH_MAX_JOBS (100000)
+// Jobs queued per nj_job_run() call, like a system splitting its work.
+#define NJ_BENCH_JOBS_PER_RUN (1000)
+#define NJ_BENCH_ROUND_TRIP_COUNT (10000)
+
+static nj_free_list_allocator_t g_bench_allocator("bench_allocator", 256 * 1024 * 1024);
+static nju32 g_done_count;
+
+// Spins for |args| microseconds.
+static void bench_spin(void* args) {
+  njs64 end = nj_mono_time_now() + nj_s_to_mono_time((njsp)args / 1000000.0);
+  while (nj_mono_time_now() < end) {
+  }
+  nj_atomic_fetch_add(&g_done_count, 1u);
+}
+
+static bool bench_throughput(njsp job_us, int job_count) {
+  static nj_job_desc_t descs[NJ_BENCH_MAX_JOBS];
+  for (int i = 0; i < job_count; ++i) {
+    descs[i].func = bench_spin;
+    descs[i].args = (void*)job_us;
+  }
+  g_done_count = 0;
+  nj_job_counter_t counter = {};
+  njs64 start = nj_mono_time_now();
+  for (int i = 0; i < job_count; i += NJ_BENCH_JOBS_PER_RUN)
+    nj_job_run(descs + i, nj_min(job_count - i, NJ_BENCH_JOBS_PER_RUN), &counter);
+  nj_job_wait(&counter);
+  njs64 time = nj_mono_time_now() - start;
+  NJ_CHECK_LOG_RETURN_VAL(g_done_count == (nju32)job_count, false, "Lost a job");
+  // The time it would take if the workers only ran the jobs.
+  njf64 ideal_us = (njf64)job_us * job_count / nj_job_get_worker_count();
+  printf("  %6d x %3ld us jobs  %8.3f us/job  %5.1f%% of ideal\n", job_count, (long)job_us,
+         nj_mono_time_to_us(time) / job_count, ideal_us * 100.0 / nj_mono_time_to_us(time));
+  return true;
+}
+
+static bool bench_round_trip() {
+  static nju64 times[NJ_BENCH_ROUND_TRIP_COUNT];
+  for (int i = 0; i < NJ_BENCH_ROUND_TRIP_COUNT; ++i) {
+    nj_job_counter_t counter = {};
+    nj_job_desc_t desc = {bench_spin, (void*)0};
+    njs64 start = nj_mono_time_now();
+    nj_job_run(&desc, 1, &counter);
+    nj_job_wait(&counter);
+    times[i] = nj_mono_time_now() - start;
+  }
+  NJ_CHECK_RETURN_VAL(nj_radix_sort(times, NJ_BENCH_ROUND_TRIP_COUNT, &g_bench_allocator), false);
+  printf("  empty job round trip  p50 %6.2f us  p99 %6.2f us  max %8.2f us\n",
+         nj_mono_time_to_us(times[NJ_BENCH_ROUND_TRIP_COUNT / 2]),
+         nj_mono_time_to_us(times[NJ_BENCH_ROUND_TRIP_COUNT * 99 / 100]),
+         nj_mono_time_to_us(times[NJ_BENCH_ROUND_TRIP_COUNT - 1]));
+  return true;
+}
+
+static bool bench_run(int worker_count, bool use_fibers) {
+  nj_job_system_desc_t desc;
+  desc.worker_count = worker_count;
+  desc.use_fibers = use_fibers;
+  NJ_CHECK_RETURN_VAL(nj_job_system_init(&g_bench_allocator, &desc), false);
+  printf("%d workers on %s\n", nj_job_get_worker_count(), use_fibers ? "fibers" : "threads");
+  bool rv = bench_throughput(1, NJ_BENCH_MAX_JOBS);
+  rv = rv && bench_throughput(100, 2000);
+  rv = rv && bench_round_trip();
+  nj_job_system_destroy();
+  return rv;
+}
+
+int main(int argc, char** argv) {
+  int worker_count = argc > 1 ? atoi(argv[1]) : 0;
+  if (worker_count < 0) {
+    printf("Usage: bench_job [worker_count]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_job.log"));
+  NJ_CHECK_RETURN_VAL(g_bench_allocator.init(), 1);
+  bool rv = bench_run(worker_count, false);
+  rv = rv && bench_run(worker_count, true);
+  g_bench_allocator.destroy();
+  return rv ? 0 : 1;
+}
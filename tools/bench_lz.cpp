@@ -0,0 +1,159 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Compression ratio and speed of core/lz.h at both levels in independent 1 MB
+// blocks, against memcpy(). Best of 3 runs to compress fast, 1 run to compress
+// high and best of 5 runs to decompress. Without a file the input is generated
+// text made of random words.
+// Usage: bench_lz [file]
+
+#include "core/core_init.h"
+#include "core/file.h"
+#include "core/free_list_allocator.h"
+#include "core/log.h"
+#include "core/lz.h"
+#include "core/mono_time.h"
+#include "core/os_string.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define NJ_BENCH_BLOCK_SIZE (1024 * 1024)
+#define NJ_BENCH_GENERATED_SIZE (64 * 1024 * 1024)
+
+static nju64 bench_xorshift(nju64* state) {
+  nju64 x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+static void bench_generate_text(nju8* data, njsp size) {
+  static const char* words[] = {
+      "the",   "a",      "of",      "to",   "and",   "in",     "is",     "for",   "file",  "data",
+      "block", "buffer", "size",    "read", "write", "thread", "job",    "queue", "table", "key",
+      "value", "sort",   "texture", "mesh", "frame", "render", "shader", "pass",  "node",  "count",
+  };
+  nju64 state = 88172645463325252ull;
+  njsp len = 0;
+  while (len < size) {
+    nju64 r = bench_xorshift(&state);
+    char word[32];
+    int word_len;
+    if (r % 16 == 0)
+      word_len = snprintf(word, sizeof(word), "%u", (nju32)(r >> 32) % 100000);
+    else
+      word_len = snprintf(word, sizeof(word), "%s", words[(r >> 8) % (sizeof(words) / sizeof(words[0]))]);
+    word[word_len++] = (r >> 16) % 12 == 0 ? '\n' : ' ';
+    word_len = (int)nj_min((njsp)word_len, size - len);
+    memcpy(data + len, word, word_len);
+    len += word_len;
+  }
+}
+
+// |sizes| gets the compressed size of each block.
+static bool bench_compress(nj_allocator_t* allocator, nj_lz_level_t level, const nju8* data, njsp size, nju8* compressed, njsp* sizes, int run_count, njsp* total, njs64* best) {
+  nj_lz_encoder_t encoder;
+  NJ_CHECK_RETURN_VAL(nj_lz_encoder_init(&encoder, allocator, level), false);
+  for (int i = 0; i < run_count; ++i) {
+    njs64 start = nj_mono_time_now();
+    *total = 0;
+    for (njsp offset = 0, block = 0; offset < size; offset += NJ_BENCH_BLOCK_SIZE, ++block) {
+      njsp block_size = nj_min(size - offset, (njsp)NJ_BENCH_BLOCK_SIZE);
+      sizes[block] = nj_lz_compress(&encoder, data + offset, block_size, compressed + *total, nj_lz_compress_bound(block_size));
+      *total += sizes[block];
+    }
+    njs64 time = nj_mono_time_now() - start;
+    *best = i ? nj_min(*best, time) : time;
+  }
+  nj_lz_encoder_destroy(&encoder);
+  return true;
+}
+
+static bool bench_decompress(const nju8* compressed, const njsp* sizes, nju8* output, njsp size, njs64* best) {
+  for (int i = 0; i < 5; ++i) {
+    njs64 start = nj_mono_time_now();
+    njsp compressed_offset = 0;
+    for (njsp offset = 0, block = 0; offset < size; offset += NJ_BENCH_BLOCK_SIZE, ++block) {
+      njsp block_size = nj_min(size - offset, (njsp)NJ_BENCH_BLOCK_SIZE);
+      if (nj_lz_decompress(compressed + compressed_offset, sizes[block], output + offset, block_size) != block_size)
+        return false;
+      compressed_offset += sizes[block];
+    }
+    njs64 time = nj_mono_time_now() - start;
+    *best = i ? nj_min(*best, time) : time;
+  }
+  return true;
+}
+
+static bool bench_run(nj_allocator_t* allocator, const char* name, nj_lz_level_t level, int run_count, const nju8* data, njsp size, nju8* compressed, njsp* sizes, nju8* output) {
+  njsp total = 0;
+  njs64 compress_time = 0;
+  njs64 decompress_time = 0;
+  NJ_CHECK_RETURN_VAL(bench_compress(allocator, level, data, size, compressed, sizes, run_count, &total, &compress_time), false);
+  memset(output, 0, size);
+  bool rv = bench_decompress(compressed, sizes, output, size, &decompress_time) && !memcmp(output, data, size);
+  NJ_CHECK_LOG_RETURN_VAL(rv, false, "%s doesn't round trip", name);
+  printf("%-6s ratio %6.3f  compress %7.1f MB/s  decompress %7.1f MB/s\n", name, (njf64)size / total,
+         size / nj_mono_time_to_us(compress_time), size / nj_mono_time_to_us(decompress_time));
+  return true;
+}
+
+#if NJ_OS_WIN()
+int wmain(int argc, wchar_t** argv) {
+#else
+int main(int argc, char** argv) {
+#endif
+  if (argc > 2) {
+    printf("Usage: bench_lz [file]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_lz.log"));
+  nj_file_map_t map = {};
+  if (argc > 1)
+    NJ_CHECK_LOG_RETURN_VAL(nj_file_map(&map, argv[1]) && map.size > 0, 1, "Can't read " NJ_OS_PCT, argv[1]);
+  njsp size = argc > 1 ? map.size : NJ_BENCH_GENERATED_SIZE;
+  njsp block_count = (size + NJ_BENCH_BLOCK_SIZE - 1) / NJ_BENCH_BLOCK_SIZE;
+  njsp compressed_size = block_count * nj_lz_compress_bound(NJ_BENCH_BLOCK_SIZE);
+  nj_free_list_allocator_t allocator("bench_allocator", 2 * size + compressed_size + block_count * sizeof(njsp) + 64 * 1024 * 1024);
+  NJ_CHECK_RETURN_VAL(allocator.init(), 1);
+  nju8* generated = argc > 1 ? NULL : (nju8*)allocator.alloc(size);
+  nju8* compressed = (nju8*)allocator.alloc(compressed_size);
+  nju8* output = (nju8*)allocator.alloc(size);
+  njsp* sizes = (njsp*)allocator.alloc(block_count * sizeof(njsp));
+  NJ_CHECK_RETURN_VAL((argc > 1 || generated) && compressed && output && sizes, 1);
+  if (generated)
+    bench_generate_text(generated, size);
+  const nju8* data = argc > 1 ? map.data : generated;
+
+  if (argc > 1)
+    printf(NJ_OS_PCT, argv[1]);
+  else
+    printf("generated text");
+  printf(", %.1f MB in %ld blocks\n", size / (1024.0 * 1024.0), (long)block_count);
+  njs64 best = 0;
+  for (int i = 0; i < 5; ++i) {
+    njs64 start = nj_mono_time_now();
+    memcpy(output, data, size);
+    njs64 time = nj_mono_time_now() - start;
+    best = i ? nj_min(best, time) : time;
+  }
+  printf("memcpy %46.1f MB/s\n", size / nj_mono_time_to_us(best));
+  bool rv = bench_run(&allocator, "fast", NJ_LZ_LEVEL_FAST, 3, data, size, compressed, sizes, output);
+  rv = rv && bench_run(&allocator, "high", NJ_LZ_LEVEL_HIGH, 1, data, size, compressed, sizes, output);
+
+  allocator.free(sizes);
+  allocator.free(output);
+  allocator.free(compressed);
+  if (generated)
+    allocator.free(generated);
+  allocator.destroy();
+  if (argc > 1)
+    nj_file_unmap(&map);
+  return rv ? 0 : 1;
+}
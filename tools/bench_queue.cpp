@@ -0,0 +1,203 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Throughput of nj_spsc_queue_t and nj_mpmc_queue_t between threads pinned to
+// different logical cores, and the round trip latency of an item sent back and
+// forth through two SPSC queues.
+// Usage: bench_queue [items_per_producer]
+
+#include "core/core_allocators.h"
+#include "core/core_init.h"
+#include "core/cpu_topology.h"
+#include "core/mono_time.h"
+#include "core/queue.inl"
+#include "core/sort.inl"
+#include "core/thread.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NJ_BENCH_MAX_THREADS (8)
+#define NJ_BENCH_BATCH_SIZE (32)
+#define NJ_BENCH_CAPACITY (1024)
+
+enum bench_mode_t {
+  BENCH_MODE_SPSC,
+  BENCH_MODE_SPSC_BATCH,
+  BENCH_MODE_MPMC,
+};
+
+struct bench_t {
+  bench_mode_t mode;
+  njsp count;
+  nj_spsc_queue_t<nju64> spsc;
+  nj_spsc_queue_t<nju64> spsc_back;
+  nj_mpmc_queue_t<nju64> mpmc;
+  nju64 sums[NJ_BENCH_MAX_THREADS];
+  nju64* round_trips;
+};
+
+struct bench_thread_t {
+  bench_t* bench;
+  int index;
+  // Items popped by a consumer, the producers' items are split evenly.
+  njsp pop_count;
+};
+
+static nj_cpu_topology_t g_topology;
+
+static void bench_produce(void* args) {
+  bench_thread_t* thread = (bench_thread_t*)args;
+  bench_t* bench = thread->bench;
+  if (bench->mode == BENCH_MODE_SPSC_BATCH) {
+    nju64 batch[NJ_BENCH_BATCH_SIZE];
+    for (njsp i = 0; i < bench->count;) {
+      njsp num = nj_min(bench->count - i, (njsp)NJ_BENCH_BATCH_SIZE);
+      for (njsp j = 0; j < num; ++j)
+        batch[j] = i + j + 1;
+      njsz pushed = nj_spsc_push_batch(&bench->spsc, batch, num);
+      // Sleep on the first item when the queue is full.
+      if (!pushed)
+        pushed = nj_spsc_push_wait(&bench->spsc, batch[0], NJ_QUEUE_INFINITE);
+      i += pushed;
+    }
+    return;
+  }
+  for (njsp i = 1; i <= bench->count; ++i) {
+    if (bench->mode == BENCH_MODE_SPSC)
+      nj_spsc_push_wait(&bench->spsc, (nju64)i, NJ_QUEUE_INFINITE);
+    else
+      nj_mpmc_push_wait(&bench->mpmc, (nju64)i, NJ_QUEUE_INFINITE);
+  }
+}
+
+static void bench_consume(void* args) {
+  bench_thread_t* thread = (bench_thread_t*)args;
+  bench_t* bench = thread->bench;
+  nju64 sum = 0;
+  if (bench->mode == BENCH_MODE_SPSC_BATCH) {
+    nju64 batch[NJ_BENCH_BATCH_SIZE];
+    for (njsp i = 0; i < bench->count;) {
+      njsz popped = nj_spsc_pop_batch(&bench->spsc, batch, NJ_BENCH_BATCH_SIZE);
+      if (!popped)
+        popped = nj_spsc_pop_wait(&bench->spsc, batch, NJ_QUEUE_INFINITE);
+      for (njsz j = 0; j < popped; ++j)
+        sum += batch[j];
+      i += popped;
+    }
+  } else {
+    for (njsp i = 0; i < thread->pop_count; ++i) {
+      nju64 val;
+      if (bench->mode == BENCH_MODE_SPSC)
+        nj_spsc_pop_wait(&bench->spsc, &val, NJ_QUEUE_INFINITE);
+      else
+        nj_mpmc_pop_wait(&bench->mpmc, &val, NJ_QUEUE_INFINITE);
+      sum += val;
+    }
+  }
+  bench->sums[thread->index] = sum;
+}
+
+static void bench_echo(void* args) {
+  bench_t* bench = (bench_t*)args;
+  for (njsp i = 0; i < bench->count; ++i) {
+    nju64 val;
+    nj_spsc_pop_wait(&bench->spsc, &val, NJ_QUEUE_INFINITE);
+    nj_spsc_push_wait(&bench->spsc_back, val, NJ_QUEUE_INFINITE);
+  }
+}
+
+// Threads are spread over the logical cores in order, one per core if there
+// are enough.
+static void bench_start_thread(nj_thread_t* thread, nj_thread_func_t func, void* args, int index, nj_cpu_set_t* affinity) {
+  *affinity = nj_cpu_set_t();
+  nj_cpu_set_add(affinity, g_topology.logical_cores[index % g_topology.logical_core_count].id);
+  nj_thread_desc_t desc;
+  desc.affinity = affinity;
+  nj_thread_init(thread, func, args, &desc);
+}
+
+static bool bench_throughput(bench_t* bench, bench_mode_t mode, int producer_count, int consumer_count) {
+  bench->mode = mode;
+  nj_thread_t threads[NJ_BENCH_MAX_THREADS];
+  bench_thread_t args[NJ_BENCH_MAX_THREADS];
+  nj_cpu_set_t affinities[NJ_BENCH_MAX_THREADS];
+  int thread_count = producer_count + consumer_count;
+  njs64 start = nj_mono_time_now();
+  for (int i = 0; i < thread_count; ++i) {
+    args[i].bench = bench;
+    args[i].index = i;
+    args[i].pop_count = bench->count * producer_count / consumer_count;
+    bench->sums[i] = 0;
+    bench_start_thread(&threads[i], i < producer_count ? bench_produce : bench_consume, &args[i], i, &affinities[i]);
+  }
+  for (int i = 0; i < thread_count; ++i)
+    nj_thread_wait_for(&threads[i]);
+  njs64 time = nj_mono_time_now() - start;
+
+  nju64 sum = 0;
+  for (int i = producer_count; i < thread_count; ++i)
+    sum += bench->sums[i];
+  nju64 count = bench->count;
+  NJ_CHECK_LOG_RETURN_VAL(sum == producer_count * (count * (count + 1) / 2), false, "Lost an item");
+  njsp total = bench->count * producer_count;
+  const char* names[] = {"spsc", "spsc batch", "mpmc"};
+  printf("%-10s %dP/%dC  %6.1f ns/item  %6.1f M items/s\n", names[mode], producer_count, consumer_count,
+         nj_mono_time_to_us(time) * 1000.0 / total, total / nj_mono_time_to_us(time));
+  return true;
+}
+
+static bool bench_round_trip(bench_t* bench) {
+  njsp count = bench->count / 16;
+  bench->count = count;
+  nj_thread_t thread;
+  nj_cpu_set_t affinity;
+  bench_start_thread(&thread, bench_echo, bench, 1, &affinity);
+  for (njsp i = 0; i < count; ++i) {
+    njs64 start = nj_mono_time_now();
+    nju64 val;
+    nj_spsc_push_wait(&bench->spsc, (nju64)i, NJ_QUEUE_INFINITE);
+    nj_spsc_pop_wait(&bench->spsc_back, &val, NJ_QUEUE_INFINITE);
+    bench->round_trips[i] = nj_mono_time_now() - start;
+  }
+  nj_thread_wait_for(&thread);
+  NJ_CHECK_RETURN_VAL(nj_radix_sort(bench->round_trips, count, g_general_allocator), false);
+  printf("spsc round trip  p50 %6.2f us  p99 %6.2f us  max %8.2f us\n",
+         nj_mono_time_to_us(bench->round_trips[count / 2]),
+         nj_mono_time_to_us(bench->round_trips[count * 99 / 100]),
+         nj_mono_time_to_us(bench->round_trips[count - 1]));
+  return true;
+}
+
+int main(int argc, char** argv) {
+  njsp count = argc > 1 ? atol(argv[1]) : 2000000;
+  if (count < 16) {
+    printf("Usage: bench_queue [items_per_producer]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_queue.log"));
+  NJ_CHECK_RETURN_VAL(nj_cpu_get_topology(&g_topology), 1);
+  printf("%d logical cores\n", g_topology.logical_core_count);
+
+  static bench_t bench;
+  bench.count = count;
+  bench.round_trips = (nju64*)malloc(count / 16 * sizeof(nju64));
+  NJ_CHECK_RETURN_VAL(bench.round_trips, 1);
+  bool rv = nj_spsc_init(&bench.spsc, g_general_allocator, NJ_BENCH_CAPACITY, true);
+  rv = rv && nj_spsc_init(&bench.spsc_back, g_general_allocator, NJ_BENCH_CAPACITY, true);
+  rv = rv && nj_mpmc_init(&bench.mpmc, g_general_allocator, NJ_BENCH_CAPACITY, true);
+  rv = rv && bench_throughput(&bench, BENCH_MODE_SPSC, 1, 1);
+  rv = rv && bench_throughput(&bench, BENCH_MODE_SPSC_BATCH, 1, 1);
+  rv = rv && bench_throughput(&bench, BENCH_MODE_MPMC, 1, 1);
+  rv = rv && bench_throughput(&bench, BENCH_MODE_MPMC, 4, 4);
+  rv = rv && bench_round_trip(&bench);
+  nj_mpmc_destroy(&bench.mpmc);
+  nj_spsc_destroy(&bench.spsc_back);
+  nj_spsc_destroy(&bench.spsc);
+  free(bench.round_trips);
+  return rv ? 0 : 1;
+}
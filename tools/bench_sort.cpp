@@ -0,0 +1,186 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// core/sort.h against std::sort and std::stable_sort on random keys, best of 5
+// runs.
+// Usage: bench_sort [key_count]
+
+#include "core/core_init.h"
+#include "core/free_list_allocator.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/sort.inl"
+#include "core/thread.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#define NJ_BENCH_RUN_COUNT (5)
+
+enum bench_sort_t {
+  BENCH_SORT_STD,
+  BENCH_SORT_STD_STABLE,
+  BENCH_SORT_RADIX,
+  BENCH_SORT_RADIX_VALUES,
+  BENCH_SORT_MERGE,
+  BENCH_SORT_PARALLEL_MERGE,
+};
+
+// A key and its index, the payload of the key-value sorts.
+struct bench_record_t {
+  nju64 key;
+  nju32 value;
+};
+
+struct bench_record_less_t {
+  bool operator()(const bench_record_t& a, const bench_record_t& b) const { return a.key < b.key; }
+};
+
+static nj_free_list_allocator_t g_bench_allocator("bench_allocator", 512 * 1024 * 1024);
+
+static nju64 bench_xorshift(nju64* state) {
+  nju64 x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+template <typename T>
+static bool bench_is_sorted(const T* p, njsp count) {
+  for (njsp i = 1; i < count; ++i) {
+    if (p[i] < p[i - 1])
+      return false;
+  }
+  return true;
+}
+
+static bool bench_is_sorted(const bench_record_t* p, njsp count) {
+  for (njsp i = 1; i < count; ++i) {
+    if (p[i].key < p[i - 1].key || (p[i].key == p[i - 1].key && p[i].value < p[i - 1].value))
+      return false;
+  }
+  return true;
+}
+
+// |work| is a copy of |keys| sorted in place.
+template <typename T>
+static bool bench_sort_once(bench_sort_t sort, T* work, njsp count) {
+  switch (sort) {
+  case BENCH_SORT_STD:
+    std::sort(work, work + count);
+    return true;
+  case BENCH_SORT_STD_STABLE:
+    std::stable_sort(work, work + count);
+    return true;
+  case BENCH_SORT_RADIX:
+    return nj_radix_sort(work, count, &g_bench_allocator);
+  case BENCH_SORT_MERGE:
+    return nj_merge_sort(work, count, &g_bench_allocator);
+  case BENCH_SORT_PARALLEL_MERGE:
+    return nj_parallel_merge_sort(work, count, &g_bench_allocator);
+  default:
+    return false;
+  }
+}
+
+template <typename T>
+static bool bench_sort(const char* name, bench_sort_t sort, const T* keys, njsp count) {
+  T* work = (T*)g_bench_allocator.alloc(count * sizeof(T));
+  NJ_CHECK_RETURN_VAL(work, false);
+  njs64 best = 0;
+  bool rv = true;
+  for (int i = 0; rv && i < NJ_BENCH_RUN_COUNT; ++i) {
+    memcpy(work, keys, count * sizeof(T));
+    njs64 start = nj_mono_time_now();
+    rv = bench_sort_once(sort, work, count);
+    njs64 time = nj_mono_time_now() - start;
+    best = i ? nj_min(best, time) : time;
+  }
+  rv = rv && bench_is_sorted(work, count);
+  g_bench_allocator.free(work);
+  NJ_CHECK_LOG_RETURN_VAL(rv, false, "%s failed", name);
+  printf("%-28s %8.2f ms\n", name, nj_mono_time_to_ms(best));
+  return true;
+}
+
+// Records are sorted by key with std::stable_sort and nj_merge_sort, and by
+// radix sorting the keys with the values carried along.
+static bool bench_sort_records(const char* name, bench_sort_t sort, const nju64* keys, njsp count) {
+  bench_record_t* records = (bench_record_t*)g_bench_allocator.alloc(count * sizeof(bench_record_t));
+  nju64* work_keys = (nju64*)g_bench_allocator.alloc(count * sizeof(nju64));
+  nju32* work_values = (nju32*)g_bench_allocator.alloc(count * sizeof(nju32));
+  NJ_CHECK_RETURN_VAL(records && work_keys && work_values, false);
+  njs64 best = 0;
+  bool rv = true;
+  for (int i = 0; rv && i < NJ_BENCH_RUN_COUNT; ++i) {
+    for (njsp j = 0; j < count; ++j) {
+      records[j].key = work_keys[j] = keys[j] >> 40;
+      records[j].value = work_values[j] = (nju32)j;
+    }
+    njs64 start = nj_mono_time_now();
+    if (sort == BENCH_SORT_STD_STABLE)
+      std::stable_sort(records, records + count, bench_record_less_t());
+    else if (sort == BENCH_SORT_MERGE)
+      rv = nj_merge_sort(records, count, &g_bench_allocator, bench_record_less_t());
+    else
+      rv = nj_radix_sort(work_keys, work_values, count, &g_bench_allocator);
+    njs64 time = nj_mono_time_now() - start;
+    best = i ? nj_min(best, time) : time;
+  }
+  if (sort == BENCH_SORT_RADIX_VALUES) {
+    for (njsp j = 0; j < count; ++j) {
+      records[j].key = work_keys[j];
+      records[j].value = work_values[j];
+    }
+  }
+  rv = rv && bench_is_sorted(records, count);
+  g_bench_allocator.free(work_values);
+  g_bench_allocator.free(work_keys);
+  g_bench_allocator.free(records);
+  NJ_CHECK_LOG_RETURN_VAL(rv, false, "%s failed", name);
+  printf("%-28s %8.2f ms\n", name, nj_mono_time_to_ms(best));
+  return true;
+}
+
+int main(int argc, char** argv) {
+  njsp count = argc > 1 ? atol(argv[1]) : 1000000;
+  if (count <= 0) {
+    printf("Usage: bench_sort [key_count]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_sort.log"));
+  NJ_CHECK_RETURN_VAL(g_bench_allocator.init(), 1);
+  nju64* keys64 = (nju64*)g_bench_allocator.alloc(count * sizeof(nju64));
+  nju32* keys32 = (nju32*)g_bench_allocator.alloc(count * sizeof(nju32));
+  NJ_CHECK_RETURN_VAL(keys64 && keys32, 1);
+  nju64 state = 88172645463325252ull;
+  for (njsp i = 0; i < count; ++i) {
+    keys64[i] = bench_xorshift(&state);
+    keys32[i] = (nju32)keys64[i];
+  }
+
+  printf("%ld random keys, %d threads\n", (long)count, nj_thread_get_nums());
+  bool rv = bench_sort("std::sort u32", BENCH_SORT_STD, keys32, count);
+  rv = rv && bench_sort("nj_radix_sort u32", BENCH_SORT_RADIX, keys32, count);
+  rv = rv && bench_sort("std::sort u64", BENCH_SORT_STD, keys64, count);
+  rv = rv && bench_sort("nj_radix_sort u64", BENCH_SORT_RADIX, keys64, count);
+  rv = rv && bench_sort("std::stable_sort u64", BENCH_SORT_STD_STABLE, keys64, count);
+  rv = rv && bench_sort("nj_merge_sort u64", BENCH_SORT_MERGE, keys64, count);
+  rv = rv && bench_sort("nj_parallel_merge_sort u64", BENCH_SORT_PARALLEL_MERGE, keys64, count);
+  // 24 bits keys so there are duplicates and the stability is checked.
+  rv = rv && bench_sort_records("std::stable_sort records", BENCH_SORT_STD_STABLE, keys64, count);
+  rv = rv && bench_sort_records("nj_merge_sort records", BENCH_SORT_MERGE, keys64, count);
+  rv = rv && bench_sort_records("nj_radix_sort key-value", BENCH_SORT_RADIX_VALUES, keys64, count);
+  g_bench_allocator.free(keys32);
+  g_bench_allocator.free(keys64);
+  g_bench_allocator.destroy();
+  return rv ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// nj_mutex_t and nj_rwlock_t against the OS locks (pthread on Linux, critical
+// sections and SRW locks on Windows), uncontended on a single thread and
+// contended by several threads. The rwlock runs do one write every 16
+// operations.
+// Usage: bench_sync [ops_per_thread] [thread_count]
+
+#include "core/core_init.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/os.h"
+#include "core/sync.h"
+#include "core/thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if NJ_OS_WIN()
+#  include <Windows.h>
+#elif NJ_OS_LINUX()
+#  include <pthread.h>
+#endif
+
+#define NJ_BENCH_MAX_THREADS (64)
+#define NJ_BENCH_WRITE_PERIOD (16)
+
+enum bench_lock_t {
+  BENCH_LOCK_NJ_MUTEX,
+  BENCH_LOCK_OS_MUTEX,
+  BENCH_LOCK_NJ_RWLOCK,
+  BENCH_LOCK_OS_RWLOCK,
+};
+
+static const char* gc_lock_names[] = {
+    "nj_mutex_t",
+#if NJ_OS_WIN()
+    "CRITICAL_SECTION",
+#else
+    "pthread_mutex_t",
+#endif
+    "nj_rwlock_t",
+#if NJ_OS_WIN()
+    "SRWLOCK",
+#else
+    "pthread_rwlock_t",
+#endif
+};
+
+static bench_lock_t g_lock;
+static njsp g_op_count;
+static nju64 g_counter;
+static nj_sync_stats_t g_stats;
+static nj_mutex_t g_mutex;
+static nj_rwlock_t g_rwlock;
+#if NJ_OS_WIN()
+static CRITICAL_SECTION g_os_mutex;
+static SRWLOCK g_os_rwlock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t g_os_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t g_os_rwlock = PTHREAD_RWLOCK_INITIALIZER;
+#endif
+
+static void bench_os_mutex_lock() {
+#if NJ_OS_WIN()
+  EnterCriticalSection(&g_os_mutex);
+#else
+  pthread_mutex_lock(&g_os_mutex);
+#endif
+}
+
+static void bench_os_mutex_unlock() {
+#if NJ_OS_WIN()
+  LeaveCriticalSection(&g_os_mutex);
+#else
+  pthread_mutex_unlock(&g_os_mutex);
+#endif
+}
+
+static void bench_os_rwlock_lock(bool is_write) {
+#if NJ_OS_WIN()
+  if (is_write)
+    AcquireSRWLockExclusive(&g_os_rwlock);
+  else
+    AcquireSRWLockShared(&g_os_rwlock);
+#else
+  if (is_write)
+    pthread_rwlock_wrlock(&g_os_rwlock);
+  else
+    pthread_rwlock_rdlock(&g_os_rwlock);
+#endif
+}
+
+static void bench_os_rwlock_unlock(bool is_write) {
+#if NJ_OS_WIN()
+  if (is_write)
+    ReleaseSRWLockExclusive(&g_os_rwlock);
+  else
+    ReleaseSRWLockShared(&g_os_rwlock);
+#else
+  NJ_UNUSED(is_write);
+  pthread_rwlock_unlock(&g_os_rwlock);
+#endif
+}
+
+static void bench_work(void*) {
+  for (njsp i = 0; i < g_op_count; ++i) {
+    bool is_write = i % NJ_BENCH_WRITE_PERIOD == 0;
+    switch (g_lock) {
+    case BENCH_LOCK_NJ_MUTEX:
+      nj_mutex_lock(&g_mutex);
+      ++g_counter;
+      nj_mutex_unlock(&g_mutex);
+      break;
+    case BENCH_LOCK_OS_MUTEX:
+      bench_os_mutex_lock();
+      ++g_counter;
+      bench_os_mutex_unlock();
+      break;
+    case BENCH_LOCK_NJ_RWLOCK:
+      if (is_write) {
+        nj_rwlock_write_lock(&g_rwlock);
+        ++g_counter;
+        nj_rwlock_write_unlock(&g_rwlock);
+      } else {
+        nj_rwlock_read_lock(&g_rwlock);
+        *(volatile nju64*)&g_counter;
+        nj_rwlock_read_unlock(&g_rwlock);
+      }
+      break;
+    case BENCH_LOCK_OS_RWLOCK:
+      bench_os_rwlock_lock(is_write);
+      if (is_write)
+        ++g_counter;
+      else
+        *(volatile nju64*)&g_counter;
+      bench_os_rwlock_unlock(is_write);
+      break;
+    }
+  }
+}
+
+static bool bench_run(bench_lock_t lock, int thread_count) {
+  g_lock = lock;
+  g_counter = 0;
+  // Drop the counts of the previous run.
+  nj_sync_stats_t stats;
+  nj_sync_stats_take(&g_stats, &stats);
+  nj_thread_t threads[NJ_BENCH_MAX_THREADS];
+  njs64 start = nj_mono_time_now();
+  for (int i = 0; i < thread_count; ++i)
+    NJ_CHECK_RETURN_VAL(nj_thread_init(&threads[i], bench_work, NULL), false);
+  for (int i = 0; i < thread_count; ++i)
+    nj_thread_wait_for(&threads[i]);
+  njs64 time = nj_mono_time_now() - start;
+  nj_sync_stats_take(&g_stats, &stats);
+  bool is_rwlock = lock == BENCH_LOCK_NJ_RWLOCK || lock == BENCH_LOCK_OS_RWLOCK;
+  njsp write_count = is_rwlock ? (g_op_count + NJ_BENCH_WRITE_PERIOD - 1) / NJ_BENCH_WRITE_PERIOD : g_op_count;
+  NJ_CHECK_LOG_RETURN_VAL(g_counter == (nju64)(write_count * thread_count), false, "%s didn't exclude the writers", gc_lock_names[lock]);
+  printf("  %-18s %7.1f ns/op", gc_lock_names[lock], nj_mono_time_to_us(time) * 1000.0 / (g_op_count * thread_count));
+  if (lock == BENCH_LOCK_NJ_MUTEX || lock == BENCH_LOCK_NJ_RWLOCK) {
+    printf("  contended %llu, spins %llu, waited %.2f ms", (unsigned long long)stats.contended_count,
+           (unsigned long long)stats.spin_count, nj_mono_time_to_ms(stats.wait_time));
+  }
+  printf("\n");
+  return true;
+}
+
+int main(int argc, char** argv) {
+  g_op_count = argc > 1 ? atol(argv[1]) : 1000000;
+  int thread_count = argc > 2 ? atoi(argv[2]) : 4;
+  if (g_op_count <= 0 || thread_count <= 0 || thread_count > NJ_BENCH_MAX_THREADS) {
+    printf("Usage: bench_sync [ops_per_thread] [thread_count]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_sync.log"));
+#if NJ_OS_WIN()
+  InitializeCriticalSection(&g_os_mutex);
+#endif
+  g_mutex.stats = &g_stats;
+  g_rwlock.stats = &g_stats;
+  bool rv = true;
+  int thread_counts[] = {1, thread_count};
+  for (int i = 0; rv && i < 2; ++i) {
+    printf("%d threads, %ld ops per thread\n", thread_counts[i], (long)g_op_count);
+    for (int lock = BENCH_LOCK_NJ_MUTEX; rv && lock <= BENCH_LOCK_OS_RWLOCK; ++lock)
+      rv = bench_run((bench_lock_t)lock, thread_counts[i]);
+  }
+#if NJ_OS_WIN()
+  DeleteCriticalSection(&g_os_mutex);
+#endif
+  return rv ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Speed of the PNG unfilter kernels of core/loader/png_unfilter.h on an RGB
+// and an RGBA image, every row with the same filter, scalar against the ones
+// picked for the CPU. Best of 5 runs, speeds are of the unfiltered data.
+// Usage: bench_unfilter [width height]
+
+#include "core/core_init.h"
+#include "core/cpu_topology.h"
+#include "core/free_list_allocator.h"
+#include "core/loader/png_unfilter.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NJ_BENCH_RUN_COUNT (5)
+
+static nju64 bench_xorshift(nju64* state) {
+  nju64 x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+static njs64 bench_unfilter_image(const nj_png_unfilter_t* unfilter, int filter, const nju8* src, const nju8* zero_row, nju8* dst, njsp row_size, njsp height) {
+  njs64 best = 0;
+  for (int i = 0; i < NJ_BENCH_RUN_COUNT; ++i) {
+    njs64 start = nj_mono_time_now();
+    for (njsp y = 0; y < height; ++y)
+      nj_png_unfilter_row(unfilter, filter, dst + y * row_size, src + y * row_size, y ? dst + (y - 1) * row_size : zero_row, row_size);
+    njs64 time = nj_mono_time_now() - start;
+    best = i ? nj_min(best, time) : time;
+  }
+  return best;
+}
+
+int main(int argc, char** argv) {
+  njsp width = argc == 3 ? atol(argv[1]) : 4096;
+  njsp height = argc == 3 ? atol(argv[2]) : 4096;
+  if ((argc != 1 && argc != 3) || width <= 0 || height <= 0) {
+    printf("Usage: bench_unfilter [width height]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("bench_unfilter.log"));
+  const int bpps[] = {3, 4};
+  const char* filter_names[NJ_PNG_FILTER_COUNT] = {"none", "sub", "up", "average", "paeth"};
+  njsp max_size = width * 4 * height;
+  nj_free_list_allocator_t allocator("bench_allocator", 3 * max_size + width * 4 + 1024 * 1024);
+  NJ_CHECK_RETURN_VAL(allocator.init(), 1);
+  nju8* src = (nju8*)allocator.alloc(max_size);
+  nju8* expected = (nju8*)allocator.alloc(max_size);
+  nju8* dst = (nju8*)allocator.alloc(max_size);
+  nju8* zero_row = (nju8*)allocator.alloc(width * 4);
+  NJ_CHECK_RETURN_VAL(src && expected && dst && zero_row, 1);
+  // The kernels don't depend on the data, except for the branches of the
+  // scalar Paeth.
+  nju64 state = 88172645463325252ull;
+  for (njsp i = 0; i < max_size; ++i)
+    src[i] = (nju8)bench_xorshift(&state);
+  memset(zero_row, 0, width * 4);
+
+  nj_cpu_features_t features;
+  nj_cpu_get_features(&features);
+  nj_cpu_features_t scalar_features = {};
+  printf("%ldx%ld, sse2 %d, ssse3 %d, avx2 %d\n", (long)width, (long)height, features.has_sse2, features.has_ssse3, features.has_avx2);
+  bool rv = true;
+  for (int bpp : bpps) {
+    nj_png_unfilter_t scalar;
+    nj_png_unfilter_t simd;
+    NJ_CHECK_RETURN_VAL(nj_png_unfilter_init(&scalar, bpp, &scalar_features), 1);
+    NJ_CHECK_RETURN_VAL(nj_png_unfilter_init(&simd, bpp, NULL), 1);
+    njsp row_size = width * bpp;
+    njsp size = row_size * height;
+    printf("%-8s %14s %14s\n", bpp == 3 ? "RGB" : "RGBA", "scalar MB/s", "cpu MB/s");
+    for (int filter = 0; rv && filter < NJ_PNG_FILTER_COUNT; ++filter) {
+      njs64 scalar_time = bench_unfilter_image(&scalar, filter, src, zero_row, expected, row_size, height);
+      njs64 simd_time = bench_unfilter_image(&simd, filter, src, zero_row, dst, row_size, height);
+      rv = !memcmp(expected, dst, size);
+      NJ_CHECK_LOG(rv, "%s with %d bytes per pixel doesn't match the scalar kernel", filter_names[filter], bpp);
+      printf("%-8s %14.1f %14.1f  x%.2f\n", filter_names[filter], size / nj_mono_time_to_us(scalar_time), size / nj_mono_time_to_us(simd_time),
+             (njf64)scalar_time / simd_time);
+    }
+  }
+
+  allocator.free(zero_row);
+  allocator.free(dst);
+  allocator.free(expected);
+  allocator.free(src);
+  allocator.destroy();
+  return rv ? 0 : 1;
+}
@@ -0,0 +1,2475 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Correctness checks of the core containers, threading primitives, file I/O and
+// codecs, each prints ok or the failures. Inputs are generated from a fixed
+// seed so a failure can be reproduced.
+// Usage: check [name...]
+
+#include "core/async_io.h"
+#include "core/atomic.h"
+#include "core/bit_stream.h"
+#include "core/bitset.h"
+#include "core/core_init.h"
+#include "core/cpu_topology.h"
+#include "core/deflate.h"
+#include "core/dynamic_array.inl"
+#include "core/file.h"
+#include "core/free_list_allocator.h"
+#include "core/hash_table.h"
+#include "core/inflate.h"
+#include "core/job.h"
+#include "core/loader/png.h"
+#include "core/loader/png_unfilter.h"
+#include "core/log.h"
+#include "core/lz.h"
+#include "core/mono_time.h"
+#include "core/pack.h"
+#include "core/parallel.inl"
+#include "core/path_utils.h"
+#include "core/queue.inl"
+#include "core/slot_map.inl"
+#include "core/soa_array.inl"
+#include "core/sort.inl"
+#include "core/sync.h"
+#include "core/task_graph.h"
+#include "core/thread.h"
+#include "core/timer_wheel.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Input sizes around the LZ minimum match and last literals, and multiples of
+// the frame block sizes.
+static const njsp gc_lz_sizes[] = {0, 1, 4, 5, 12, 13, 16, 17, 31, 100, 1000, 65536, 70000, 300000};
+
+static nj_free_list_allocator_t g_check_allocator("check_allocator", 256 * 1024 * 1024);
+static nju64 g_check_state = 88172645463325252ull;
+static int g_check_fail_count;
+
+static nju64 check_xorshift() {
+  nju64 x = g_check_state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return g_check_state = x;
+}
+
+static njsp check_random(njsp n) {
+  return n > 0 ? (njsp)(check_xorshift() % (nju64)n) : 0;
+}
+
+#define NJ_EXPECT(cond, ...)                                                                                           \
+  do {                                                                                                                 \
+    if (!(cond)) {                                                                                                     \
+      printf("  failed: " __VA_ARGS__);                                                                                \
+      printf("\n");                                                                                                    \
+      ++g_check_fail_count;                                                                                            \
+    }                                                                                                                  \
+  } while (0)
+
+// Growable output of the frame writer and reader.
+struct check_sink_t {
+  nju8* data;
+  njsp len;
+  njsp capacity;
+};
+
+static bool check_sink_write(void* user_data, const nju8* data, njsp size) {
+  check_sink_t* sink = (check_sink_t*)user_data;
+  if (sink->len + size > sink->capacity)
+    return false;
+  memcpy(sink->data + sink->len, data, size);
+  sink->len += size;
+  return true;
+}
+
+// Random inserts, removes and gets against a model of the keys in the table,
+// with stop-the-world then incremental resizes. The value of a key is its index
+// in |keys|, so a lookup that returns the wrong slot is caught.
+static bool check_hash_table() {
+  const int key_count = 20000;
+  nju64* keys = (nju64*)g_check_allocator.alloc(key_count * sizeof(nju64));
+  bool* is_in = (bool*)g_check_allocator.alloc(key_count * sizeof(bool));
+  NJ_CHECK_RETURN_VAL(keys && is_in, false);
+  int fail_count = g_check_fail_count;
+  const njsp steps[] = {0, 1, 8, 64};
+  for (njsp step : steps) {
+    for (int i = 0; i < key_count; ++i) {
+      keys[i] = check_xorshift();
+      is_in[i] = false;
+    }
+    nj_hash_table_t ht;
+    NJ_CHECK_RETURN_VAL(nj_ht_init(&ht, &g_check_allocator, sizeof(nju64)), false);
+    nj_ht_set_incremental_resize(&ht, step);
+    nju8 min_probe_count = ht.probe_count;
+    njsp cap = ht.keys.length;
+    njsp count = 0;
+    for (int op = 0; op < 200000; ++op) {
+      int i = (int)check_random(key_count);
+      int kind = (int)check_random(4);
+      if (kind < 2 && !is_in[i]) {
+        njsp idx = nj_ht_insert_ptr(&ht, &keys[i], sizeof(nju64));
+        NJ_EXPECT(idx != NJ_HT_INVALID_INDEX, "insert failed, step %ld", (long)step);
+        if (idx != NJ_HT_INVALID_INDEX)
+          ht.values[idx] = i;
+        is_in[i] = true;
+        ++count;
+      } else if (kind == 2) {
+        nj_ht_remove_ptr(&ht, &keys[i], sizeof(nju64));
+        count -= is_in[i];
+        is_in[i] = false;
+      } else {
+        njsp idx = nj_ht_get_ptr(&ht, &keys[i], sizeof(nju64));
+        NJ_EXPECT((idx != NJ_HT_INVALID_INDEX) == is_in[i], "key %d %s, step %ld", i, is_in[i] ? "lost" : "found after removal", (long)step);
+        NJ_EXPECT(idx == NJ_HT_INVALID_INDEX || ht.values[idx] == (njup)i, "key %d has value %ld, step %ld", i, (long)ht.values[idx], (long)step);
+      }
+      // A table that took over incrementally starts with the narrowest probing
+      // range, the previous one may have been widened.
+      if (ht.keys.length != cap && ht.old_keys.length) {
+        NJ_EXPECT(ht.probe_count == min_probe_count, "probing range %d in a new table, step %ld", ht.probe_count, (long)step);
+      }
+      cap = ht.keys.length;
+      if (g_check_fail_count - fail_count > 10)
+        break;
+    }
+    NJ_EXPECT(ht.key_count == count, "%ld keys counted, %ld in the model, step %ld", (long)ht.key_count, (long)count, (long)step);
+    // Turning incremental resizes off finishes the one in progress, if any.
+    nj_ht_set_incremental_resize(&ht, 0);
+    NJ_EXPECT(!nj_ht_is_resizing(&ht) && ht.keys.length, "still resizing into %ld slots, step %ld", (long)ht.keys.length, (long)step);
+    for (int i = 0; i < key_count; ++i) {
+      njsp idx = nj_ht_get_ptr(&ht, &keys[i], sizeof(nju64));
+      NJ_EXPECT((idx != NJ_HT_INVALID_INDEX) == is_in[i], "key %d %s at the end, step %ld", i, is_in[i] ? "lost" : "found", (long)step);
+    }
+    nj_ht_destroy(&ht);
+  }
+  g_check_allocator.free(is_in);
+  g_check_allocator.free(keys);
+  return g_check_fail_count == fail_count;
+}
+
+// Random inserts and erases against a model of the live handles. Erased handles
+// must stay invalid after their slot is reused, and the packed values must map
+// back to their handles.
+static bool check_slot_map() {
+  const int max_count = 4096;
+  nj_slot_handle_t* handles = (nj_slot_handle_t*)g_check_allocator.alloc(max_count * sizeof(nj_slot_handle_t));
+  nj_slot_handle_t* erased = (nj_slot_handle_t*)g_check_allocator.alloc(max_count * sizeof(nj_slot_handle_t));
+  nju64* values = (nju64*)g_check_allocator.alloc(max_count * sizeof(nju64));
+  NJ_CHECK_RETURN_VAL(handles && erased && values, false);
+  int fail_count = g_check_fail_count;
+  nj_slot_map_t<nju64> sm;
+  NJ_CHECK_RETURN_VAL(nj_sm_init(&sm, &g_check_allocator), false);
+  NJ_EXPECT(!nj_sm_is_valid(&sm, nj_slot_handle_t()), "zero handle is valid in an empty map");
+  int count = 0;
+  int erased_count = 0;
+  for (int op = 0; op < 100000 && g_check_fail_count - fail_count < 10; ++op) {
+    if (count < max_count && (!count || check_random(2))) {
+      values[count] = check_xorshift();
+      handles[count] = nj_sm_insert(&sm, values[count]);
+      ++count;
+    } else {
+      int i = (int)check_random(count);
+      NJ_EXPECT(nj_sm_erase(&sm, handles[i]), "erasing live handle %d failed", i);
+      if (erased_count < max_count)
+        erased[erased_count++] = handles[i];
+      else
+        erased[check_random(max_count)] = handles[i];
+      --count;
+      handles[i] = handles[count];
+      values[i] = values[count];
+    }
+    if (op % 97)
+      continue;
+    NJ_EXPECT(nj_sm_len(&sm) == count, "%ld values, %d in the model", (long)nj_sm_len(&sm), count);
+    for (int i = 0; i < count; ++i) {
+      nju64* value = nj_sm_get(&sm, handles[i]);
+      NJ_EXPECT(value && *value == values[i], "live handle %d lost its value", i);
+    }
+    for (int i = 0; i < erased_count; ++i) {
+      NJ_EXPECT(!nj_sm_get(&sm, erased[i]) && !nj_sm_erase(&sm, erased[i]), "stale handle %u:%u is valid", erased[i].index, erased[i].generation);
+    }
+    for (njsp i = 0; i < nj_sm_len(&sm); ++i) {
+      nj_slot_handle_t handle = nj_sm_handle_at(&sm, i);
+      NJ_EXPECT(nj_sm_get(&sm, handle) == &sm.values[i], "value %ld doesn't map back to its handle", (long)i);
+    }
+  }
+  nj_sm_clear(&sm);
+  NJ_EXPECT(!nj_sm_len(&sm), "%ld values after clear", (long)nj_sm_len(&sm));
+  for (int i = 0; i < count; ++i)
+    NJ_EXPECT(!nj_sm_is_valid(&sm, handles[i]), "handle %d valid after clear", i);
+  nj_sm_destroy(&sm);
+  g_check_allocator.free(values);
+  g_check_allocator.free(erased);
+  g_check_allocator.free(handles);
+  return g_check_fail_count == fail_count;
+}
+
+// Random appends, swap removes and resizes of fields of different sizes against
+// one array per field. Each stream must stay aligned and keep its values.
+static bool check_soa_array() {
+  const int max_count = 5000;
+  nju8* bytes = (nju8*)g_check_allocator.alloc(max_count * sizeof(nju8));
+  nju64* words = (nju64*)g_check_allocator.alloc(max_count * sizeof(nju64));
+  nju16* shorts = (nju16*)g_check_allocator.alloc(max_count * sizeof(nju16));
+  NJ_CHECK_RETURN_VAL(bytes && words && shorts, false);
+  int fail_count = g_check_fail_count;
+  nj_soa_array_t<nju8, nju64, nju16> soa;
+  NJ_CHECK_RETURN_VAL(nj_soa_init(&soa, &g_check_allocator), false);
+  int count = 0;
+  for (int op = 0; op < 20000 && g_check_fail_count - fail_count < 10; ++op) {
+    int kind = (int)check_random(32);
+    if (kind < 20 && count < max_count) {
+      nju64 val = check_xorshift();
+      bytes[count] = (nju8)val;
+      words[count] = val;
+      shorts[count] = (nju16)(val >> 16);
+      nj_soa_append(&soa, bytes[count], words[count], shorts[count]);
+      ++count;
+    } else if (kind < 30 && count) {
+      int i = (int)check_random(count);
+      nj_soa_swap_remove(&soa, i);
+      --count;
+      bytes[i] = bytes[count];
+      words[i] = words[count];
+      shorts[i] = shorts[count];
+    } else {
+      // Grow or shrink, new elements are written through the spans.
+      int new_count = nj_min(max_count, nj_max(0, count - 64 + (int)check_random(128)));
+      nj_soa_resize(&soa, new_count);
+      nj_span_t<nju8> b = nj_soa_field<0>(&soa);
+      nj_span_t<nju64> w = nj_soa_field<1>(&soa);
+      nj_span_t<nju16> h = nj_soa_field<2>(&soa);
+      for (int i = count; i < new_count; ++i) {
+        nju64 val = check_xorshift();
+        b[i] = bytes[i] = (nju8)val;
+        w[i] = words[i] = val;
+        h[i] = shorts[i] = (nju16)(val >> 16);
+      }
+      count = new_count;
+    }
+    NJ_EXPECT(nj_soa_len(&soa) == count, "%ld elements, %d in the model", (long)nj_soa_len(&soa), count);
+    nj_span_t<nju8> b = nj_soa_field<0>(&soa);
+    nj_span_t<nju64> w = nj_soa_field<1>(&soa);
+    nj_span_t<nju16> h = nj_soa_field<2>(&soa);
+    NJ_EXPECT(b.length == count && w.length == count && h.length == count, "span lengths %ld %ld %ld, %d elements", (long)b.length, (long)w.length, (long)h.length, count);
+    for (int i = 0; i < soa.sc_field_count && soa.p; ++i)
+      NJ_EXPECT(!((njup)soa.streams[i] % NJ_SOA_ALIGNMENT), "stream %d isn't aligned", i);
+    int i = 0;
+    while (i < count && b[i] == bytes[i] && w[i] == words[i] && h[i] == shorts[i])
+      ++i;
+    NJ_EXPECT(i == count, "element %d of %d differs", i, count);
+  }
+  nj_soa_destroy(&soa);
+  g_check_allocator.free(shorts);
+  g_check_allocator.free(words);
+  g_check_allocator.free(bytes);
+  return g_check_fail_count == fail_count;
+}
+
+#define NJ_CHECK_QUEUE_THREADS (4)
+#define NJ_CHECK_QUEUE_ITEMS (50000)
+
+struct check_queue_t {
+  nj_spsc_queue_t<nju64> spsc;
+  nj_mpmc_queue_t<nju64> mpmc;
+  // Times each item of the MPMC run was popped.
+  nju32* pop_counts;
+  // Items popped out of order by each thread.
+  int disorder_counts[NJ_CHECK_QUEUE_THREADS * 2];
+};
+
+struct check_queue_thread_t {
+  check_queue_t* queue;
+  int index;
+};
+
+// Items are pushed one by one and in batches of up to 7.
+static void check_queue_spsc_produce(void* args) {
+  check_queue_t* queue = (check_queue_t*)args;
+  nju64 batch[7];
+  for (nju64 i = 0; i < NJ_CHECK_QUEUE_ITEMS;) {
+    njsz num = nj_min((njsz)(i % 7 + 1), (njsz)(NJ_CHECK_QUEUE_ITEMS - i));
+    for (njsz j = 0; j < num; ++j)
+      batch[j] = i + j;
+    njsz pushed = nj_spsc_push_batch(&queue->spsc, batch, num);
+    if (!pushed)
+      pushed = nj_spsc_push_wait(&queue->spsc, batch[0], NJ_QUEUE_INFINITE);
+    i += pushed;
+  }
+}
+
+static void check_queue_mpmc_produce(void* args) {
+  check_queue_thread_t* thread = (check_queue_thread_t*)args;
+  for (nju64 i = 0; i < NJ_CHECK_QUEUE_ITEMS; ++i)
+    nj_mpmc_push_wait(&thread->queue->mpmc, (nju64)thread->index << 32 | i, NJ_QUEUE_INFINITE);
+}
+
+// Items of one producer must come out in the order it pushed them.
+static void check_queue_mpmc_consume(void* args) {
+  check_queue_thread_t* thread = (check_queue_thread_t*)args;
+  check_queue_t* queue = thread->queue;
+  nju64 last[NJ_CHECK_QUEUE_THREADS];
+  for (int i = 0; i < NJ_CHECK_QUEUE_THREADS; ++i)
+    last[i] = (nju64)-1;
+  for (int i = 0; i < NJ_CHECK_QUEUE_ITEMS; ++i) {
+    nju64 val;
+    nj_mpmc_pop_wait(&queue->mpmc, &val, NJ_QUEUE_INFINITE);
+    int producer = (int)(val >> 32);
+    nju64 seq = val & 0xffffffff;
+    if (producer >= NJ_CHECK_QUEUE_THREADS || seq >= NJ_CHECK_QUEUE_ITEMS) {
+      ++queue->disorder_counts[thread->index];
+      continue;
+    }
+    queue->disorder_counts[thread->index] += last[producer] != (nju64)-1 && seq <= last[producer];
+    last[producer] = seq;
+    nj_atomic_fetch_add(&queue->pop_counts[producer * NJ_CHECK_QUEUE_ITEMS + seq], 1u);
+  }
+}
+
+// Random pushes and pops of a small queue against a ring of the same capacity,
+// then threaded runs: SPSC must keep the order, MPMC must deliver every item
+// once and keep the order of each producer. Also checks the wait timeouts.
+static bool check_queue() {
+  const njsz capacity = 8;
+  check_queue_t* queue = (check_queue_t*)g_check_allocator.alloc(sizeof(check_queue_t));
+  NJ_CHECK_RETURN_VAL(queue, false);
+  *queue = check_queue_t();
+  queue->pop_counts = (nju32*)g_check_allocator.alloc_zero(NJ_CHECK_QUEUE_THREADS * NJ_CHECK_QUEUE_ITEMS * sizeof(nju32));
+  NJ_CHECK_RETURN_VAL(queue->pop_counts, false);
+  int fail_count = g_check_fail_count;
+  NJ_CHECK_RETURN_VAL(nj_spsc_init(&queue->spsc, &g_check_allocator, capacity, true), false);
+  NJ_CHECK_RETURN_VAL(nj_mpmc_init(&queue->mpmc, &g_check_allocator, capacity, true), false);
+
+  nju64 ring[capacity];
+  nju64 head = 0;
+  nju64 tail = 0;
+  nju64 next = 0;
+  for (int op = 0; op < 20000 && g_check_fail_count - fail_count < 10; ++op) {
+    bool is_mpmc = op % 2;
+    njsz num = 1 + check_random(capacity + 2);
+    nju64 vals[capacity + 2];
+    njsz done;
+    if (check_random(2)) {
+      for (njsz i = 0; i < num; ++i)
+        vals[i] = next + i;
+      if (num == 1)
+        done = is_mpmc ? nj_mpmc_push(&queue->mpmc, vals[0]) : nj_spsc_push(&queue->spsc, vals[0]);
+      else
+        done = is_mpmc ? nj_mpmc_push_batch(&queue->mpmc, vals, num) : nj_spsc_push_batch(&queue->spsc, vals, num);
+      NJ_EXPECT(done == nj_min(num, (njsz)(capacity - (tail - head))), "pushed %ld of %ld with %ld queued", (long)done, (long)num, (long)(tail - head));
+      for (njsz i = 0; i < done; ++i)
+        ring[tail++ % capacity] = next++;
+    } else {
+      if (num == 1)
+        done = is_mpmc ? nj_mpmc_pop(&queue->mpmc, vals) : nj_spsc_pop(&queue->spsc, vals);
+      else
+        done = is_mpmc ? nj_mpmc_pop_batch(&queue->mpmc, vals, num) : nj_spsc_pop_batch(&queue->spsc, vals, num);
+      NJ_EXPECT(done == nj_min(num, (njsz)(tail - head)), "popped %ld of %ld with %ld queued", (long)done, (long)num, (long)(tail - head));
+      for (njsz i = 0; i < done && head < tail; ++i) {
+        nju64 expected = ring[head++ % capacity];
+        NJ_EXPECT(vals[i] == expected, "popped %ld instead of %ld", (long)vals[i], (long)expected);
+      }
+    }
+    // Switch to the other queue once this one is empty.
+    if (head == tail)
+      continue;
+    --op;
+  }
+  NJ_EXPECT(nj_spsc_len(&queue->spsc) == 0 && nj_mpmc_len(&queue->mpmc) == 0, "items left after the model run");
+
+  // The waits time out on an empty and on a full queue.
+  nju64 val = 0;
+  njs64 start = nj_mono_time_now();
+  NJ_EXPECT(!nj_spsc_pop_wait(&queue->spsc, &val, 1000000) && !nj_mpmc_pop_wait(&queue->mpmc, &val, 1000000), "pop from an empty queue");
+  for (njsz i = 0; i < capacity; ++i) {
+    nj_spsc_push(&queue->spsc, i);
+    nj_mpmc_push(&queue->mpmc, i);
+  }
+  NJ_EXPECT(!nj_spsc_push_wait(&queue->spsc, val, 1000000) && !nj_mpmc_push_wait(&queue->mpmc, val, 1000000), "push to a full queue");
+  NJ_EXPECT(nj_mono_time_to_us(nj_mono_time_now() - start) >= 4000.0, "the timeouts returned early");
+  for (njsz i = 0; i < capacity; ++i) {
+    nj_spsc_pop(&queue->spsc, &val);
+    nj_mpmc_pop(&queue->mpmc, &val);
+  }
+
+  nj_thread_t threads[NJ_CHECK_QUEUE_THREADS * 2];
+  check_queue_thread_t args[NJ_CHECK_QUEUE_THREADS * 2];
+  NJ_CHECK_RETURN_VAL(nj_thread_init(&threads[0], check_queue_spsc_produce, queue), false);
+  int disorder_count = 0;
+  for (nju64 i = 0; i < NJ_CHECK_QUEUE_ITEMS; ++i) {
+    nj_spsc_pop_wait(&queue->spsc, &val, NJ_QUEUE_INFINITE);
+    disorder_count += val != i;
+  }
+  nj_thread_wait_for(&threads[0]);
+  NJ_EXPECT(!disorder_count, "%d SPSC items out of order", disorder_count);
+
+  for (int i = 0; i < NJ_CHECK_QUEUE_THREADS * 2; ++i) {
+    args[i].queue = queue;
+    args[i].index = i % NJ_CHECK_QUEUE_THREADS;
+    NJ_CHECK_RETURN_VAL(nj_thread_init(&threads[i], i < NJ_CHECK_QUEUE_THREADS ? check_queue_mpmc_produce : check_queue_mpmc_consume, &args[i]), false);
+  }
+  for (int i = 0; i < NJ_CHECK_QUEUE_THREADS * 2; ++i)
+    nj_thread_wait_for(&threads[i]);
+  disorder_count = 0;
+  for (int i = 0; i < NJ_CHECK_QUEUE_THREADS; ++i)
+    disorder_count += queue->disorder_counts[i];
+  NJ_EXPECT(!disorder_count, "%d MPMC items out of order", disorder_count);
+  int bad_count = 0;
+  for (int i = 0; i < NJ_CHECK_QUEUE_THREADS * NJ_CHECK_QUEUE_ITEMS; ++i)
+    bad_count += queue->pop_counts[i] != 1;
+  NJ_EXPECT(!bad_count, "%d MPMC items not popped exactly once", bad_count);
+
+  nj_mpmc_destroy(&queue->mpmc);
+  nj_spsc_destroy(&queue->spsc);
+  g_check_allocator.free(queue->pop_counts);
+  g_check_allocator.free(queue);
+  return g_check_fail_count == fail_count;
+}
+
+// Compares the model's answers with |bs| at a few random positions.
+static void check_bitset_queries(const nj_bitset_t* bs, const nju8* bits, njsp* ranks, njsp bit_count) {
+  ranks[0] = 0;
+  for (njsp i = 0; i < bit_count; ++i)
+    ranks[i + 1] = ranks[i] + bits[i];
+  NJ_EXPECT(nj_bitset_count(bs) == ranks[bit_count], "%ld bits set, %ld in the model", (long)nj_bitset_count(bs), (long)ranks[bit_count]);
+  NJ_EXPECT(nj_bitset_any(bs) == (ranks[bit_count] > 0), "any() is wrong with %ld bits set", (long)ranks[bit_count]);
+  for (int q = 0; q < 8; ++q) {
+    njsp i = check_random(bit_count + 1);
+    NJ_EXPECT(nj_bitset_rank(bs, i) == ranks[i], "rank(%ld) is %ld instead of %ld", (long)i, (long)nj_bitset_rank(bs, i), (long)ranks[i]);
+    njsp next_set = i;
+    while (next_set < bit_count && !bits[next_set])
+      ++next_set;
+    njsp next_clear = i;
+    while (next_clear < bit_count && bits[next_clear])
+      ++next_clear;
+    njsp found = nj_bitset_find_next_set(bs, i);
+    NJ_EXPECT(found == (next_set < bit_count ? next_set : NJ_BITSET_NPOS), "next set bit from %ld is %ld", (long)i, (long)found);
+    found = nj_bitset_find_next_clear(bs, i);
+    NJ_EXPECT(found == (next_clear < bit_count ? next_clear : NJ_BITSET_NPOS), "next clear bit from %ld is %ld", (long)i, (long)found);
+    if (i < bit_count)
+      NJ_EXPECT(nj_bitset_test(bs, i) == (bits[i] != 0), "bit %ld is wrong", (long)i);
+    // The nth set bit is the one whose rank is nth.
+    njsp nth = check_random(ranks[bit_count] + 2);
+    njsp expected = NJ_BITSET_NPOS;
+    if (nth < ranks[bit_count]) {
+      njsp lo = 0;
+      njsp hi = bit_count - 1;
+      while (lo < hi) {
+        njsp mid = (lo + hi) / 2;
+        if (ranks[mid + 1] > nth)
+          hi = mid;
+        else
+          lo = mid + 1;
+      }
+      expected = lo;
+    }
+    found = nj_bitset_select(bs, nth);
+    NJ_EXPECT(found == expected, "select(%ld) is %ld instead of %ld", (long)nth, (long)found, (long)expected);
+  }
+}
+
+// Random single bit and bulk updates of a dynamic bitset against one byte per
+// bit, sized to span several summary blocks. Then the same on a fixed bitset.
+static bool check_bitset() {
+  const njsp max_count = 3 * 4096 + 100;
+  nju8* bits = (nju8*)g_check_allocator.alloc(max_count);
+  nju8* other_bits = (nju8*)g_check_allocator.alloc(max_count);
+  njsp* ranks = (njsp*)g_check_allocator.alloc((max_count + 1) * sizeof(njsp));
+  NJ_CHECK_RETURN_VAL(bits && other_bits && ranks, false);
+  int fail_count = g_check_fail_count;
+  njsp bit_count = 1 + check_random(max_count);
+  nj_bitset_t bs;
+  nj_bitset_t other;
+  NJ_CHECK_RETURN_VAL(nj_bitset_init(&bs, &g_check_allocator, bit_count), false);
+  NJ_CHECK_RETURN_VAL(nj_bitset_init(&other, &g_check_allocator, max_count), false);
+  memset(bits, 0, max_count);
+  memset(other_bits, 0, max_count);
+  // Ranges of bits are set or cleared with a density that drifts over time, so
+  // both full and empty words and blocks show up.
+  njsp density = 50;
+  for (int op = 0; op < 3000 && g_check_fail_count - fail_count < 10; ++op) {
+    int kind = (int)check_random(64);
+    if (kind < 40) {
+      density = nj_min<njsp>(100, nj_max<njsp>(0, density - 5 + check_random(11)));
+      njsp first = check_random(bit_count);
+      njsp last = nj_min(bit_count, first + 1 + check_random(kind < 20 ? 8 : 600));
+      for (njsp i = first; i < last; ++i) {
+        bool val = check_random(100) < density;
+        if (kind & 1) {
+          nj_bitset_assign(&bs, i, val);
+        } else if (val) {
+          nj_bitset_set(&bs, i);
+        } else {
+          nj_bitset_clear(&bs, i);
+        }
+        bits[i] = val;
+      }
+    } else if (kind < 52) {
+      njsp word_count = NJ_BITSET_WORD_COUNT(bit_count);
+      for (njsp i = 0; i < max_count; ++i) {
+        bool val = check_random(100) < density;
+        nj_bitset_assign(&other, i, val);
+        other_bits[i] = val;
+      }
+      njsp first_word = check_random(word_count);
+      njsp word_num = 1 + check_random(word_count - first_word);
+      njsp last = nj_min(bit_count, (first_word + word_num) * 64);
+      for (njsp i = first_word * 64; i < last; ++i) {
+        if (kind % 3 == 0)
+          bits[i] &= other_bits[i];
+        else if (kind % 3 == 1)
+          bits[i] |= other_bits[i];
+        else
+          bits[i] &= !other_bits[i];
+      }
+      if (kind % 3 == 0)
+        nj_bitset_and(&bs, &other, first_word, word_num);
+      else if (kind % 3 == 1)
+        nj_bitset_or(&bs, &other, first_word, word_num);
+      else
+        nj_bitset_andnot(&bs, &other, first_word, word_num);
+    } else if (kind < 60) {
+      njsp new_count = 1 + check_random(max_count);
+      NJ_CHECK_RETURN_VAL(nj_bitset_resize(&bs, new_count), false);
+      for (njsp i = bit_count; i < new_count; ++i)
+        bits[i] = 0;
+      bit_count = new_count;
+    } else if (kind < 62) {
+      nj_bitset_set_all(&bs);
+      memset(bits, 1, bit_count);
+    } else {
+      nj_bitset_clear_all(&bs);
+      memset(bits, 0, bit_count);
+    }
+    check_bitset_queries(&bs, bits, ranks, bit_count);
+  }
+  nj_bitset_destroy(&other);
+  nj_bitset_destroy(&bs);
+
+  nj_fixed_bitset_t<4096 + 70> fixed;
+  nj_bitset_t view = nj_bitset_view(&fixed);
+  bit_count = view.bit_count;
+  memset(bits, 0, bit_count);
+  for (int op = 0; op < 500 && g_check_fail_count - fail_count < 10; ++op) {
+    njsp i = check_random(bit_count);
+    bool val = check_random(4) != 0;
+    nj_bitset_assign(&view, i, val);
+    bits[i] = val;
+    check_bitset_queries(&view, bits, ranks, bit_count);
+  }
+
+  g_check_allocator.free(ranks);
+  g_check_allocator.free(other_bits);
+  g_check_allocator.free(bits);
+  return g_check_fail_count == fail_count;
+}
+
+struct check_sort_record_t {
+  nju64 key;
+  nju32 index;
+};
+
+struct check_sort_less_t {
+  bool operator()(const check_sort_record_t& a, const check_sort_record_t& b) const { return a.key < b.key; }
+};
+
+// The output is sorted, stable and a permutation of the input if
+// |keys[i]| is |src_keys[indices[i]]|, every index shows up once and equal
+// keys keep their indices increasing.
+template <typename K>
+static bool check_sort_output(const char* name, const nju64* src_keys, const K* keys, const nju32* indices, njsp num, nju8* seen) {
+  memset(seen, 0, num);
+  njsp i = 0;
+  for (; i < num; ++i) {
+    if (indices[i] >= num || seen[indices[i]] || keys[i] != (K)src_keys[indices[i]])
+      break;
+    seen[indices[i]] = 1;
+    if (i && (keys[i] < keys[i - 1] || (keys[i] == keys[i - 1] && indices[i] < indices[i - 1])))
+      break;
+  }
+  NJ_EXPECT(i == num, "%s: element %ld of %ld is out of place", name, (long)i, (long)num);
+  return i == num;
+}
+
+// Every sort on random arrays whose keys are either spread over the whole
+// range, packed in a few values (stability), spread only over the high bits
+// (skipped passes) or all equal. Sizes cover the insertion sort path too.
+static bool check_sort() {
+  const njsp max_num = 100000;
+  nju64* src_keys = (nju64*)g_check_allocator.alloc(max_num * sizeof(nju64));
+  nju64* keys64 = (nju64*)g_check_allocator.alloc(max_num * sizeof(nju64));
+  nju64* sorted_keys = (nju64*)g_check_allocator.alloc(max_num * sizeof(nju64));
+  nju32* keys32 = (nju32*)g_check_allocator.alloc(max_num * sizeof(nju32));
+  nju32* indices = (nju32*)g_check_allocator.alloc(max_num * sizeof(nju32));
+  check_sort_record_t* records = (check_sort_record_t*)g_check_allocator.alloc(max_num * sizeof(check_sort_record_t));
+  nju8* seen = (nju8*)g_check_allocator.alloc(max_num);
+  NJ_CHECK_RETURN_VAL(src_keys && keys64 && sorted_keys && keys32 && indices && records && seen, false);
+  int fail_count = g_check_fail_count;
+  for (int round = 0; round < 60 && g_check_fail_count == fail_count; ++round) {
+    njsp num = round < 3 ? round : (round & 1) ? check_random(64) : check_random(max_num);
+    int spread = (round >> 1) & 3;
+    for (njsp i = 0; i < num; ++i) {
+      nju64 r = check_xorshift();
+      if (spread == 0)
+        src_keys[i] = r;
+      else if (spread == 1)
+        src_keys[i] = r % 7;
+      else if (spread == 2)
+        src_keys[i] = (r >> 60) << 28 | (r & 0xff) << 56;
+      else
+        src_keys[i] = 42;
+    }
+
+    for (njsp i = 0; i < num; ++i) {
+      keys64[i] = src_keys[i];
+      indices[i] = (nju32)i;
+    }
+    NJ_EXPECT(nj_radix_sort(keys64, indices, num, &g_check_allocator), "nj_radix_sort() of %ld nju64 failed", (long)num);
+    check_sort_output("nj_radix_sort<nju64>", src_keys, keys64, indices, num, seen);
+
+    // Without values, the keys must come out as they did with values.
+    memcpy(sorted_keys, keys64, num * sizeof(nju64));
+    memcpy(keys64, src_keys, num * sizeof(nju64));
+    NJ_EXPECT(nj_radix_sort(keys64, num, &g_check_allocator), "nj_radix_sort() of %ld nju64 keys failed", (long)num);
+    njsp i = 0;
+    while (i < num && keys64[i] == sorted_keys[i])
+      ++i;
+    NJ_EXPECT(i == num, "nj_radix_sort() of keys only differs at %ld", (long)i);
+
+    for (njsp j = 0; j < num; ++j) {
+      keys32[j] = (nju32)src_keys[j];
+      indices[j] = (nju32)j;
+    }
+    NJ_EXPECT(nj_radix_sort(keys32, indices, num, &g_check_allocator), "nj_radix_sort() of %ld nju32 failed", (long)num);
+    check_sort_output("nj_radix_sort<nju32>", src_keys, keys32, indices, num, seen);
+
+    for (int algo = 0; algo < 3; ++algo) {
+      for (njsp j = 0; j < num; ++j)
+        records[j] = {src_keys[j], (nju32)j};
+      if (algo == 0) {
+        if (num > 2000)
+          continue;
+        nj_insertion_sort(records, num, check_sort_less_t());
+      } else if (algo == 1) {
+        NJ_EXPECT(nj_merge_sort(records, num, &g_check_allocator, check_sort_less_t()), "nj_merge_sort() of %ld failed", (long)num);
+      } else {
+        int thread_count = 1 + (int)check_random(8);
+        NJ_EXPECT(nj_parallel_merge_sort(records, num, &g_check_allocator, thread_count, check_sort_less_t()), "nj_parallel_merge_sort() of %ld failed", (long)num);
+      }
+      for (njsp j = 0; j < num; ++j) {
+        keys64[j] = records[j].key;
+        indices[j] = records[j].index;
+      }
+      static const char* sc_names[] = {"nj_insertion_sort", "nj_merge_sort", "nj_parallel_merge_sort"};
+      check_sort_output(sc_names[algo], src_keys, keys64, indices, num, seen);
+    }
+  }
+  g_check_allocator.free(seen);
+  g_check_allocator.free(records);
+  g_check_allocator.free(indices);
+  g_check_allocator.free(keys32);
+  g_check_allocator.free(sorted_keys);
+  g_check_allocator.free(keys64);
+  g_check_allocator.free(src_keys);
+  return g_check_fail_count == fail_count;
+}
+
+#define NJ_CHECK_JOB_COUNT (10000)
+#define NJ_CHECK_JOB_PARENT_COUNT (64)
+#define NJ_CHECK_JOB_CHILD_COUNT (64)
+
+struct check_job_state_t {
+  // Times each job ran, parents then their children.
+  nju32 run_counts[NJ_CHECK_JOB_COUNT];
+  // Jobs that ran with a bad worker index or saw unfinished children.
+  nju32 error_count;
+  // Parents that didn't get a fiber because they were all taken.
+  nju32 fiberless_count;
+  // The job system isn't running, jobs run on the caller which isn't a worker.
+  bool is_inline;
+  bool is_fiber;
+};
+
+struct check_job_args_t {
+  check_job_state_t* state;
+  int index;
+};
+
+static check_job_args_t g_check_job_args[NJ_CHECK_JOB_COUNT];
+
+static void check_job_count(void* args) {
+  check_job_args_t* job = (check_job_args_t*)args;
+  int worker_index = nj_job_get_worker_index();
+  if (worker_index < (job->state->is_inline ? -1 : 0) || worker_index >= nj_job_get_worker_count())
+    nj_atomic_fetch_add(&job->state->error_count, 1u);
+  nj_atomic_fetch_add(&job->state->run_counts[job->index], 1u);
+}
+
+// Runs its children and waits for them, the worker helps with other jobs
+// meanwhile.
+static void check_job_parent(void* args) {
+  check_job_args_t* job = (check_job_args_t*)args;
+  nj_job_desc_t descs[NJ_CHECK_JOB_CHILD_COUNT];
+  int first_child = NJ_CHECK_JOB_PARENT_COUNT + job->index * NJ_CHECK_JOB_CHILD_COUNT;
+  for (int i = 0; i < NJ_CHECK_JOB_CHILD_COUNT; ++i)
+    descs[i] = {check_job_count, &g_check_job_args[first_child + i]};
+  // On a fiber, the scratch memory must survive the wait even if the job
+  // resumes on another worker.
+  nj_allocator_t* scratch = nj_job_get_scratch_allocator();
+  nju8* p = scratch ? (nju8*)scratch->alloc(256) : NULL;
+  if (p)
+    memset(p, job->index, 256);
+  if (job->state->is_fiber && !p)
+    nj_atomic_fetch_add(&job->state->fiberless_count, 1u);
+  nj_job_counter_t counter = {};
+  nj_job_run(descs, NJ_CHECK_JOB_CHILD_COUNT, &counter);
+  nj_job_wait(&counter);
+  for (int i = 0; i < NJ_CHECK_JOB_CHILD_COUNT; ++i) {
+    if (nj_atomic_load(&job->state->run_counts[first_child + i]) != 1)
+      nj_atomic_fetch_add(&job->state->error_count, 1u);
+  }
+  for (int i = 0; p && i < 256; ++i) {
+    if (p[i] != (nju8)job->index) {
+      nj_atomic_fetch_add(&job->state->error_count, 1u);
+      break;
+    }
+  }
+  check_job_count(args);
+}
+
+// Runs |job_count| jobs of |func| and checks that each ran exactly once.
+static void check_job_batch(check_job_state_t* state, nj_job_func_t func, int job_count, const char* name, bool is_fiber = false) {
+  memset(state, 0, sizeof(check_job_state_t));
+  state->is_inline = nj_job_get_worker_index() < 0;
+  state->is_fiber = is_fiber;
+  nj_job_desc_t* descs = (nj_job_desc_t*)g_check_allocator.alloc(job_count * sizeof(nj_job_desc_t));
+  NJ_CHECK_RETURN(descs);
+  for (int i = 0; i < NJ_CHECK_JOB_COUNT; ++i)
+    g_check_job_args[i] = {state, i};
+  for (int i = 0; i < job_count; ++i)
+    descs[i] = {func, &g_check_job_args[i]};
+  nj_job_counter_t counter = {};
+  nj_job_run(descs, job_count, &counter);
+  nj_job_wait(&counter);
+  NJ_EXPECT(nj_job_is_done(&counter) && !counter.value, "%s: the counter is %u after the wait", name, counter.value);
+  int total_count = func == check_job_parent ? job_count * (NJ_CHECK_JOB_CHILD_COUNT + 1) : job_count;
+  int bad_count = 0;
+  for (int i = 0; i < total_count; ++i)
+    bad_count += state->run_counts[i] != 1;
+  NJ_EXPECT(!bad_count, "%s: %d jobs didn't run exactly once", name, bad_count);
+  NJ_EXPECT(!state->error_count, "%s: %u jobs saw a bad worker index, unfinished children or lost scratch memory", name, state->error_count);
+  NJ_EXPECT(state->fiberless_count < (nju32)job_count, "%s: no job ran on a fiber", name);
+  g_check_allocator.free(descs);
+}
+
+// Fails every allocation from the |fail_at|th on, and counts the live ones.
+struct check_failing_allocator_t : nj_allocator_t {
+  int alloc_count = 0;
+  int fail_at = 0;
+  int live_count = 0;
+
+  check_failing_allocator_t() : nj_allocator_t("check_failing_allocator", 0) {}
+  void destroy() override {}
+  void* aligned_alloc(njsp size, njsp alignment) override {
+    if (alloc_count++ >= fail_at)
+      return NULL;
+    ++live_count;
+    return g_check_allocator.aligned_alloc(size, alignment);
+  }
+  void* realloc(void*, njsp) override { return NULL; }
+  void free(void* p) override {
+    --live_count;
+    g_check_allocator.free(p);
+  }
+};
+
+// Jobs run inline before the system starts and after it stops. While it runs,
+// a flat batch overflows the deques and the shared queue, and nested jobs wait
+// on their children.
+static bool check_job() {
+  static_assert(NJ_CHECK_JOB_PARENT_COUNT * (NJ_CHECK_JOB_CHILD_COUNT + 1) <= NJ_CHECK_JOB_COUNT, "Not enough job slots");
+  check_job_state_t* state = (check_job_state_t*)g_check_allocator.alloc(sizeof(check_job_state_t));
+  NJ_CHECK_RETURN_VAL(state, false);
+  int fail_count = g_check_fail_count;
+  check_job_batch(state, check_job_count, 100, "inline");
+  nj_job_system_desc_t desc;
+  desc.worker_count = 4;
+  NJ_CHECK_RETURN_VAL(nj_job_system_init(&g_check_allocator, &desc), false);
+  NJ_EXPECT(nj_job_get_worker_count() == 4 && nj_job_get_worker_index() == 0, "%d workers, caller is worker %d", nj_job_get_worker_count(), nj_job_get_worker_index());
+  for (int round = 0; round < 4; ++round) {
+    check_job_batch(state, check_job_count, NJ_CHECK_JOB_COUNT, "flat");
+    check_job_batch(state, check_job_parent, NJ_CHECK_JOB_PARENT_COUNT, "nested");
+  }
+  nj_job_system_destroy();
+  NJ_EXPECT(nj_job_get_worker_count() == 1 && nj_job_get_worker_index() == -1, "%d workers, caller is worker %d after destroy", nj_job_get_worker_count(), nj_job_get_worker_index());
+  check_job_batch(state, check_job_parent, NJ_CHECK_JOB_PARENT_COUNT, "inline nested");
+
+  // Fewer fibers than parents, the others run on their worker's stack.
+  desc.use_fibers = true;
+  desc.fiber_count = 16;
+  desc.fiber_stack_size = 64 * 1024;
+  NJ_CHECK_RETURN_VAL(nj_job_system_init(&g_check_allocator, &desc), false);
+  for (int round = 0; round < 4; ++round) {
+    check_job_batch(state, check_job_count, NJ_CHECK_JOB_COUNT, "fiber flat", true);
+    check_job_batch(state, check_job_parent, NJ_CHECK_JOB_PARENT_COUNT, "fiber nested", true);
+  }
+  nj_job_system_destroy();
+
+  // Every allocation of init fails in turn, nothing must leak and the next
+  // init must work.
+  check_failing_allocator_t failing_allocator;
+  for (int fail_at = 0;; ++fail_at) {
+    failing_allocator.alloc_count = 0;
+    failing_allocator.fail_at = fail_at;
+    bool is_ok = nj_job_system_init(&failing_allocator, &desc);
+    if (is_ok)
+      nj_job_system_destroy();
+    NJ_EXPECT(!failing_allocator.live_count, "%d allocations leaked when allocation %d failed", failing_allocator.live_count, fail_at);
+    NJ_EXPECT(nj_job_get_worker_count() == 1, "%d workers left when allocation %d failed", nj_job_get_worker_count(), fail_at);
+    if (is_ok || g_check_fail_count != fail_count)
+      break;
+  }
+  g_check_allocator.free(state);
+  return g_check_fail_count == fail_count;
+}
+
+// A reduction that only stays valid if the sub-ranges are folded in order.
+struct check_parallel_range_t {
+  njsp begin;
+  njsp end;
+  bool is_ok;
+};
+
+// Each algorithm on random sizes and grain sizes, with parallelism on and off,
+// against a serial loop.
+static bool check_parallel() {
+  const njsp max_num = 200000;
+  nju32* hit_counts = (nju32*)g_check_allocator.alloc(max_num * sizeof(nju32));
+  nju64* in = (nju64*)g_check_allocator.alloc(max_num * sizeof(nju64));
+  nju64* out = (nju64*)g_check_allocator.alloc(max_num * sizeof(nju64));
+  nju64* expected = (nju64*)g_check_allocator.alloc(max_num * sizeof(nju64));
+  NJ_CHECK_RETURN_VAL(hit_counts && in && out && expected, false);
+  int fail_count = g_check_fail_count;
+  nj_job_system_desc_t desc;
+  desc.worker_count = 4;
+  NJ_CHECK_RETURN_VAL(nj_job_system_init(&g_check_allocator, &desc), false);
+  static const njsp sc_grain_sizes[] = {0, 1, 7, 1000};
+  for (int round = 0; round < 64 && g_check_fail_count == fail_count; ++round) {
+    nj_parallel_set_enabled(round % 8 != 7);
+    njsp num = (round & 1) ? check_random(100) : check_random(max_num);
+    njsp grain_size = sc_grain_sizes[check_random(4)];
+    for (njsp i = 0; i < num; ++i)
+      in[i] = check_xorshift() % 1000;
+
+    memset(hit_counts, 0, num * sizeof(nju32));
+    njsp first = check_random(num + 1);
+    nj_parallel_for(first, num, [&](njsp b, njsp e) {
+      for (njsp i = b; i < e; ++i)
+        nj_atomic_fetch_add(&hit_counts[i], 1u);
+    }, grain_size);
+    njsp i = 0;
+    while (i < num && hit_counts[i] == (nju32)(i >= first))
+      ++i;
+    NJ_EXPECT(i == num, "nj_parallel_for(%ld, %ld) visited %ld %u times", (long)first, (long)num, (long)i, i < num ? hit_counts[i] : 0);
+
+    check_parallel_range_t range = nj_parallel_reduce(first, num, check_parallel_range_t{-1, -1, true}, [](njsp b, njsp e, const check_parallel_range_t&) {
+      return check_parallel_range_t{b, e, true};
+    }, [](const check_parallel_range_t& a, const check_parallel_range_t& b) {
+      return check_parallel_range_t{a.begin, b.end, a.is_ok && b.is_ok && a.end == b.begin};
+    }, grain_size);
+    if (first < num)
+      NJ_EXPECT(range.is_ok && range.begin == first && range.end == num, "nj_parallel_reduce(%ld, %ld) folded [%ld, %ld) out of order", (long)first, (long)num, (long)range.begin, (long)range.end);
+    else
+      NJ_EXPECT(range.begin == -1, "nj_parallel_reduce() of an empty range didn't return the identity");
+
+    auto add = [](nju64 a, nju64 b) { return a + b; };
+    nju64 sum = 0;
+    for (njsp j = 0; j < num; ++j)
+      expected[j] = sum += in[j];
+    nj_parallel_inclusive_scan(in, out, num, add, grain_size);
+    i = 0;
+    while (i < num && out[i] == expected[i])
+      ++i;
+    NJ_EXPECT(i == num, "nj_parallel_inclusive_scan() of %ld differs at %ld", (long)num, (long)i);
+    sum = 5;
+    for (njsp j = 0; j < num; ++j) {
+      expected[j] = sum;
+      sum += in[j];
+    }
+    // In place.
+    memcpy(out, in, num * sizeof(nju64));
+    nj_parallel_exclusive_scan(out, out, num, (nju64)5, add, grain_size);
+    i = 0;
+    while (i < num && out[i] == expected[i])
+      ++i;
+    NJ_EXPECT(i == num, "nj_parallel_exclusive_scan() of %ld differs at %ld", (long)num, (long)i);
+
+    // Items carry their index so the order of each side can be checked.
+    auto is_small = [](nju64 val) { return (val >> 32) < 300; };
+    njsp true_count = 0;
+    for (njsp j = 0; j < num; ++j) {
+      out[j] = in[j] << 32 | (nju64)j;
+      true_count += is_small(out[j]);
+    }
+    njsp k = 0;
+    for (njsp j = 0; j < num; ++j) {
+      if (is_small(out[j]))
+        expected[k++] = out[j];
+    }
+    for (njsp j = 0; j < num; ++j) {
+      if (!is_small(out[j]))
+        expected[k++] = out[j];
+    }
+    njsp partition_count = nj_parallel_stable_partition(out, num, is_small, &g_check_allocator, grain_size);
+    NJ_EXPECT(partition_count == true_count, "nj_parallel_stable_partition() of %ld returned %ld instead of %ld", (long)num, (long)partition_count, (long)true_count);
+    i = 0;
+    while (i < num && out[i] == expected[i])
+      ++i;
+    NJ_EXPECT(i == num, "nj_parallel_stable_partition() of %ld differs at %ld", (long)num, (long)i);
+  }
+  nj_parallel_set_enabled(true);
+  nj_job_system_destroy();
+  g_check_allocator.free(expected);
+  g_check_allocator.free(out);
+  g_check_allocator.free(in);
+  g_check_allocator.free(hit_counts);
+  return g_check_fail_count == fail_count;
+}
+
+#define NJ_CHECK_SYNC_THREADS (4)
+#define NJ_CHECK_SYNC_OPS (20000)
+#define NJ_CHECK_SYNC_SEM_OPS (2000)
+
+struct check_sync_t {
+  nj_mutex_t mutex;
+  nj_rwlock_t rwlock;
+  nj_semaphore_t semaphore;
+  nj_event_t start_event;
+  nj_seqlock_t seqlock;
+  nj_sync_stats_t stats;
+  // Only changed under |mutex|.
+  nju64 mutex_count;
+  // Written together under |rwlock| or |seqlock|, readers must see them equal.
+  nju64 rw_vals[2];
+  nju64 seq_vals[2];
+  nju64 rw_write_count;
+  nju32 error_count;
+};
+
+struct check_sync_thread_t {
+  check_sync_t* sync;
+  int index;
+};
+
+static void check_sync_run(void* args) {
+  check_sync_t* sync = ((check_sync_thread_t*)args)->sync;
+  int index = ((check_sync_thread_t*)args)->index;
+  nj_event_wait(&sync->start_event);
+  for (int i = 0; i < NJ_CHECK_SYNC_OPS; ++i) {
+    if (i & 1) {
+      nj_mutex_lock(&sync->mutex);
+    } else {
+      while (!nj_mutex_try_lock(&sync->mutex))
+        nj_cpu_relax();
+    }
+    ++*(volatile nju64*)&sync->mutex_count;
+    nj_mutex_unlock(&sync->mutex);
+
+    if (i % 8 == 0) {
+      nj_rwlock_write_lock(&sync->rwlock);
+      ++*(volatile nju64*)&sync->rw_vals[0];
+      ++*(volatile nju64*)&sync->rw_vals[1];
+      ++sync->rw_write_count;
+      nj_rwlock_write_unlock(&sync->rwlock);
+    } else {
+      nj_rwlock_read_lock(&sync->rwlock);
+      if (*(volatile nju64*)&sync->rw_vals[0] != *(volatile nju64*)&sync->rw_vals[1])
+        nj_atomic_fetch_add(&sync->error_count, 1u);
+      nj_rwlock_read_unlock(&sync->rwlock);
+    }
+
+    // A single writer for the seqlock.
+    nju64 vals[2];
+    nju32 seq;
+    do {
+      seq = nj_seqlock_read_begin(&sync->seqlock);
+      vals[0] = nj_atomic_load(&sync->seq_vals[0], NJ_MEMORY_ORDER_RELAXED);
+      vals[1] = nj_atomic_load(&sync->seq_vals[1], NJ_MEMORY_ORDER_RELAXED);
+    } while (nj_seqlock_read_retry(&sync->seqlock, seq));
+    if (vals[0] != vals[1])
+      nj_atomic_fetch_add(&sync->error_count, 1u);
+    if (index == 0) {
+      nj_seqlock_write_begin(&sync->seqlock);
+      nj_atomic_store(&sync->seq_vals[0], vals[0] + 1, NJ_MEMORY_ORDER_RELAXED);
+      nj_atomic_store(&sync->seq_vals[1], vals[1] + 1, NJ_MEMORY_ORDER_RELAXED);
+      nj_seqlock_write_end(&sync->seqlock);
+    }
+  }
+  for (int i = 0; i < NJ_CHECK_SYNC_SEM_OPS; ++i)
+    nj_semaphore_wait(&sync->semaphore);
+}
+
+// Threads released by an event hammer a mutex, a rwlock and a seqlock whose
+// data must stay consistent, then consume semaphore tokens posted in random
+// batches. The contention stats are taken and must be reset by the take.
+static bool check_sync() {
+  check_sync_t* sync = (check_sync_t*)g_check_allocator.alloc_zero(sizeof(check_sync_t));
+  NJ_CHECK_RETURN_VAL(sync, false);
+  int fail_count = g_check_fail_count;
+  nj_mutex_init(&sync->mutex);
+  nj_rwlock_init(&sync->rwlock);
+  nj_semaphore_init(&sync->semaphore, 0);
+  nj_event_init(&sync->start_event);
+  nj_seqlock_init(&sync->seqlock);
+  sync->mutex.stats = &sync->stats;
+  sync->rwlock.stats = &sync->stats;
+
+  NJ_EXPECT(!nj_semaphore_try_wait(&sync->semaphore) && !nj_semaphore_wait_for(&sync->semaphore, 1000000), "waited on an empty semaphore");
+  nj_semaphore_post(&sync->semaphore, 2);
+  NJ_EXPECT(nj_semaphore_try_wait(&sync->semaphore) && nj_semaphore_wait_for(&sync->semaphore, 1000000), "couldn't wait on a posted semaphore");
+  NJ_EXPECT(!nj_event_is_set(&sync->start_event), "the event starts set");
+
+  nj_thread_t threads[NJ_CHECK_SYNC_THREADS];
+  check_sync_thread_t args[NJ_CHECK_SYNC_THREADS];
+  for (int i = 0; i < NJ_CHECK_SYNC_THREADS; ++i) {
+    args[i] = {sync, i};
+    NJ_CHECK_RETURN_VAL(nj_thread_init(&threads[i], check_sync_run, &args[i]), false);
+  }
+  nj_event_set(&sync->start_event);
+  NJ_EXPECT(nj_event_is_set(&sync->start_event), "the event isn't set");
+  for (int posted = 0; posted < NJ_CHECK_SYNC_THREADS * NJ_CHECK_SYNC_SEM_OPS;) {
+    nju32 count = (nju32)nj_min<njsp>(1 + check_random(16), NJ_CHECK_SYNC_THREADS * NJ_CHECK_SYNC_SEM_OPS - posted);
+    nj_semaphore_post(&sync->semaphore, count);
+    posted += count;
+  }
+  for (int i = 0; i < NJ_CHECK_SYNC_THREADS; ++i)
+    nj_thread_wait_for(&threads[i]);
+  // Set events don't block.
+  nj_event_wait(&sync->start_event);
+
+  NJ_EXPECT(sync->mutex_count == NJ_CHECK_SYNC_THREADS * NJ_CHECK_SYNC_OPS, "mutex count %llu", (unsigned long long)sync->mutex_count);
+  NJ_EXPECT(sync->rw_vals[0] == sync->rw_write_count && sync->rw_vals[1] == sync->rw_write_count, "rwlock values %llu %llu after %llu writes",
+            (unsigned long long)sync->rw_vals[0], (unsigned long long)sync->rw_vals[1], (unsigned long long)sync->rw_write_count);
+  NJ_EXPECT(!sync->error_count, "%u reads saw a torn write", sync->error_count);
+  NJ_EXPECT(!nj_semaphore_try_wait(&sync->semaphore), "semaphore tokens are left");
+  nj_sync_stats_t stats;
+  nj_sync_stats_take(&sync->stats, &stats);
+  NJ_EXPECT(stats.wait_time >= 0 && (stats.contended_count || !stats.spin_count), "contended %llu, spins %llu, waited %lld",
+            (unsigned long long)stats.contended_count, (unsigned long long)stats.spin_count, (long long)stats.wait_time);
+  nj_sync_stats_take(&sync->stats, &stats);
+  NJ_EXPECT(!stats.contended_count && !stats.spin_count && !stats.wait_time, "the stats weren't reset by the take");
+  g_check_allocator.free(sync);
+  return g_check_fail_count == fail_count;
+}
+
+#define NJ_CHECK_TG_MAX_NODES (200)
+
+struct check_tg_state_t {
+  nju32 seq;
+  nju32 start_seqs[NJ_CHECK_TG_MAX_NODES];
+  nju32 end_seqs[NJ_CHECK_TG_MAX_NODES];
+  nju32 run_counts[NJ_CHECK_TG_MAX_NODES];
+};
+
+struct check_tg_node_t {
+  check_tg_state_t* state;
+  int index;
+  int work;
+};
+
+static void check_tg_run(void* args) {
+  check_tg_node_t* node = (check_tg_node_t*)args;
+  check_tg_state_t* state = node->state;
+  state->start_seqs[node->index] = nj_atomic_fetch_add(&state->seq, 1u);
+  volatile nju64 x = 0;
+  for (int i = 0; i < node->work; ++i)
+    x = x + i;
+  ++state->run_counts[node->index];
+  state->end_seqs[node->index] = nj_atomic_fetch_add(&state->seq, 1u);
+}
+
+// Random DAGs run a few times each on four workers. A node must run once per
+// execution and only after all its predecessors ended. The critical path must
+// be a chain of edges whose time is the longest one computed from the node
+// times. A cycle must make the compile fail.
+static bool check_task_graph() {
+  check_tg_state_t* state = (check_tg_state_t*)g_check_allocator.alloc(sizeof(check_tg_state_t));
+  check_tg_node_t* nodes = (check_tg_node_t*)g_check_allocator.alloc(NJ_CHECK_TG_MAX_NODES * sizeof(check_tg_node_t));
+  njs64* path_times = (njs64*)g_check_allocator.alloc(NJ_CHECK_TG_MAX_NODES * sizeof(njs64));
+  NJ_CHECK_RETURN_VAL(state && nodes && path_times, false);
+  int fail_count = g_check_fail_count;
+  nj_job_system_desc_t desc;
+  desc.worker_count = 4;
+  NJ_CHECK_RETURN_VAL(nj_job_system_init(&g_check_allocator, &desc), false);
+  for (int round = 0; round < 40 && g_check_fail_count == fail_count; ++round) {
+    nj_task_graph_t tg;
+    NJ_CHECK_RETURN_VAL(nj_tg_init(&tg, &g_check_allocator), false);
+    int node_count = 1 + (int)check_random(NJ_CHECK_TG_MAX_NODES);
+    for (int i = 0; i < node_count; ++i) {
+      nodes[i] = {state, i, (int)check_random(2000)};
+      nj_tg_add_node(&tg, "check", check_tg_run, &nodes[i]);
+    }
+    // Edges go from a lower to a higher index, which keeps the graph acyclic.
+    int edge_count = (int)check_random(node_count * 3);
+    for (int i = 0; i < edge_count && node_count > 1; ++i) {
+      int from = (int)check_random(node_count - 1);
+      nj_tg_add_edge(&tg, from, from + 1 + (int)check_random(node_count - from - 1));
+    }
+    for (int exec = 0; exec < 3; ++exec) {
+      memset(state, 0, sizeof(check_tg_state_t));
+      NJ_EXPECT(nj_tg_execute(&tg), "executing %d nodes failed", node_count);
+      int bad_count = 0;
+      for (int i = 0; i < node_count; ++i) {
+        bad_count += state->run_counts[i] != 1;
+        for (njsp j = 0; j < nj_da_len(&tg.nodes[i].successors); ++j)
+          bad_count += state->end_seqs[i] > state->start_seqs[tg.nodes[i].successors[j]];
+      }
+      NJ_EXPECT(!bad_count, "%d nodes of %d ran twice, not at all or before a predecessor", bad_count, node_count);
+
+      // Longest chain ending at each node, nodes only point to higher indices.
+      njs64 max_time = 0;
+      for (int i = 0; i < node_count; ++i)
+        path_times[i] = tg.nodes[i].end_time - tg.nodes[i].start_time;
+      for (int i = 0; i < node_count; ++i) {
+        max_time = nj_max(max_time, path_times[i]);
+        for (njsp j = 0; j < nj_da_len(&tg.nodes[i].successors); ++j) {
+          int succ = tg.nodes[i].successors[j];
+          path_times[succ] = nj_max(path_times[succ], path_times[i] + tg.nodes[succ].end_time - tg.nodes[succ].start_time);
+        }
+      }
+      njs64 chain_time = 0;
+      bool is_chain = nj_da_len(&tg.critical_path) > 0;
+      for (njsp i = 0; i < nj_da_len(&tg.critical_path); ++i) {
+        nj_task_node_t* node = &tg.nodes[tg.critical_path[i]];
+        chain_time += node->end_time - node->start_time;
+        if (i == 0)
+          continue;
+        nj_task_node_t* prev = &tg.nodes[tg.critical_path[i - 1]];
+        bool is_edge = false;
+        for (njsp j = 0; j < nj_da_len(&prev->successors); ++j)
+          is_edge |= prev->successors[j] == tg.critical_path[i];
+        is_chain &= is_edge;
+      }
+      NJ_EXPECT(is_chain, "the critical path of %ld nodes isn't a chain of edges", (long)nj_da_len(&tg.critical_path));
+      NJ_EXPECT(chain_time == tg.critical_path_time && chain_time == max_time, "critical path time %lld, chain %lld, longest %lld",
+                (long long)tg.critical_path_time, (long long)chain_time, (long long)max_time);
+    }
+    if (node_count > 1) {
+      nj_tg_add_edge(&tg, 0, node_count - 1);
+      nj_tg_add_edge(&tg, node_count - 1, 0);
+      NJ_EXPECT(!nj_tg_compile(&tg) && !nj_tg_execute(&tg), "a graph with a cycle compiled");
+    }
+    nj_tg_destroy(&tg);
+  }
+  nj_job_system_destroy();
+  g_check_allocator.free(path_times);
+  g_check_allocator.free(nodes);
+  g_check_allocator.free(state);
+  return g_check_fail_count == fail_count;
+}
+
+static void check_topology_thread(void* args) {
+  // Uses a good part of the requested stack.
+  volatile nju8 buffer[512 * 1024];
+  buffer[0] = 1;
+  buffer[sizeof(buffer) - 1] = 1;
+  *(int*)args = buffer[0] + buffer[sizeof(buffer) - 1];
+}
+
+// The topology must describe the allowed cores consistently: sorted unique
+// ids, group indices in range and each group's set covering its cores. The
+// cpu set functions are compared with a bool per core, and a thread must
+// start with a name, a stack size and an affinity.
+static bool check_topology() {
+  int fail_count = g_check_fail_count;
+  nj_cpu_topology_t* topology = (nj_cpu_topology_t*)g_check_allocator.alloc(sizeof(nj_cpu_topology_t));
+  NJ_CHECK_RETURN_VAL(topology, false);
+  NJ_EXPECT(nj_cpu_get_topology(topology), "can't get the topology");
+  int count = topology->logical_core_count;
+  NJ_EXPECT(count > 0 && count <= NJ_CPU_MAX_LOGICAL_CORES, "%d logical cores", count);
+  NJ_EXPECT(topology->physical_core_count > 0 && topology->physical_core_count <= count, "%d physical cores for %d logical", topology->physical_core_count, count);
+  int thread_count = nj_thread_get_nums();
+  NJ_EXPECT(thread_count > 0 && thread_count <= count, "%d threads for %d logical cores", thread_count, count);
+  const int group_counts[] = {topology->physical_core_count, topology->l2_group_count, topology->l3_group_count, topology->numa_node_count};
+  for (int i = 0; i < count; ++i) {
+    const nj_cpu_logical_core_t* core = &topology->logical_cores[i];
+    NJ_EXPECT(core->id >= 0 && core->id < NJ_CPU_MAX_LOGICAL_CORES && (!i || core->id > core[-1].id), "logical core %d has id %d", i, core->id);
+    const int indices[] = {core->physical_core, core->l2_group, core->l3_group, core->numa_node};
+    for (int g = 0; g < 4; ++g)
+      NJ_EXPECT(indices[g] >= -1 && indices[g] < group_counts[g], "logical core %d is in group %d of %d of kind %d", core->id, indices[g], group_counts[g], g);
+  }
+  for (int g = 0; g < 4; ++g) {
+    int covered_count = 0;
+    for (int index = 0; index < group_counts[g]; ++index) {
+      nj_cpu_set_t set;
+      nj_cpu_get_group_set(topology, (nj_cpu_group_t)g, index, &set);
+      int expected = 0;
+      for (int i = 0; i < count; ++i) {
+        const nj_cpu_logical_core_t* core = &topology->logical_cores[i];
+        const int indices[] = {core->physical_core, core->l2_group, core->l3_group, core->numa_node};
+        expected += indices[g] == index;
+        NJ_EXPECT(nj_cpu_set_has(&set, core->id) == (indices[g] == index), "core %d and group %d of kind %d", core->id, index, g);
+      }
+      NJ_EXPECT(expected > 0 && nj_cpu_set_count(&set) == expected, "group %d of kind %d has %d cores, %d expected", index, g, nj_cpu_set_count(&set), expected);
+      covered_count += expected;
+    }
+    NJ_EXPECT(!group_counts[g] || g != NJ_CPU_GROUP_PHYSICAL_CORE || covered_count == count, "physical cores cover %d of %d logical cores", covered_count, count);
+  }
+
+  nj_cpu_set_t set;
+  bool is_in[NJ_CPU_MAX_LOGICAL_CORES] = {};
+  for (int i = 0; i < 300; ++i) {
+    int id = (int)check_random(NJ_CPU_MAX_LOGICAL_CORES);
+    nj_cpu_set_add(&set, id);
+    is_in[id] = true;
+  }
+  int in_count = 0;
+  for (int id = 0; id < NJ_CPU_MAX_LOGICAL_CORES; ++id) {
+    in_count += is_in[id];
+    NJ_EXPECT(nj_cpu_set_has(&set, id) == is_in[id], "cpu set and core %d", id);
+  }
+  NJ_EXPECT(nj_cpu_set_count(&set) == in_count, "cpu set has %d cores, %d expected", nj_cpu_set_count(&set), in_count);
+
+  nj_cpu_set_t affinity;
+  nj_cpu_set_add(&affinity, topology->logical_cores[0].id);
+  nj_thread_desc_t desc;
+  desc.name = "nj_check_topology_thread";
+  desc.stack_size = 1024 * 1024;
+  desc.affinity = &affinity;
+  int result = 0;
+  nj_thread_t thread;
+  NJ_EXPECT(nj_thread_init(&thread, check_topology_thread, &result, &desc), "can't start a thread with a description");
+  nj_thread_wait_for(&thread);
+  NJ_EXPECT(result == 2, "the thread didn't run");
+  g_check_allocator.free(topology);
+  return g_check_fail_count == fail_count;
+}
+
+#define NJ_CHECK_TW_MAX_TIMERS (300)
+
+struct check_tw_timer_t {
+  nj_timer_handle_t handle;
+  njs64 deadline;
+  njs64 period;
+  bool is_active;
+  int fire_count;
+  int expected_fire_count;
+};
+
+static void check_tw_fire(void* args) {
+  ++((check_tw_timer_t*)args)->fire_count;
+}
+
+// Ticks are much longer than the check so real time never moves a tick, time
+// is moved by shifting the wheel's start back. They are short enough for the
+// shifted start to stay in range.
+static void check_tw_advance(nj_timer_wheel_t* tw, njs64 tick_count) {
+  tw->start_time -= tick_count * tw->tick_length;
+}
+
+// Random adds, cancels and time jumps from one tick to past the wheel's range
+// against a list of deadlines. Each update must fire exactly the timers whose
+// deadline passed, periodic ones once per update, and the next deadline must
+// never be after the first timer's.
+static bool check_timer_wheel() {
+  check_tw_timer_t* timers = (check_tw_timer_t*)g_check_allocator.alloc_zero(NJ_CHECK_TW_MAX_TIMERS * sizeof(check_tw_timer_t));
+  NJ_CHECK_RETURN_VAL(timers, false);
+  int fail_count = g_check_fail_count;
+  nj_timer_wheel_t tw;
+  NJ_CHECK_RETURN_VAL(nj_tw_init(&tw, &g_check_allocator, nj_s_to_mono_time(10)), false);
+  // Upper bounds of the delays and the time jumps, the last one is past the
+  // wheel's range so it uses the overflow list.
+  static const njs64 sc_scales[] = {8, 64, 4096, 262144, 3ll << (NJ_TW_SLOT_BITS * NJ_TW_LEVEL_COUNT)};
+  njs64 now_tick = 0;
+  for (int op = 0; op < 5000 && g_check_fail_count - fail_count < 10; ++op) {
+    int kind = (int)check_random(16);
+    check_tw_timer_t* timer = &timers[check_random(NJ_CHECK_TW_MAX_TIMERS)];
+    if (kind < 6) {
+      if (timer->is_active)
+        continue;
+      njs64 delay = 1 + check_random(sc_scales[check_random(5)]);
+      njs64 period = (kind & 1) ? 1 + check_random(1000) : 0;
+      timer->handle = nj_tw_add(&tw, delay * tw.tick_length, period * tw.tick_length, check_tw_fire, timer);
+      timer->deadline = tw.timers[timer->handle.index].deadline;
+      timer->period = period;
+      timer->is_active = true;
+      NJ_EXPECT(timer->deadline == now_tick + delay + 1 || timer->deadline == now_tick + delay, "delay %lld at tick %lld has deadline %lld", (long long)delay, (long long)now_tick, (long long)timer->deadline);
+    } else if (kind < 8) {
+      NJ_EXPECT(nj_tw_cancel(&tw, timer->handle) == timer->is_active, "cancel returned %d", (int)!timer->is_active);
+      timer->is_active = false;
+    } else {
+      njs64 scale = sc_scales[kind < 13 ? 0 : kind < 15 ? 1 : check_random(3) + 1];
+      njs64 advance = 1 + check_random(op % 1000 == 999 ? sc_scales[4] : scale);
+      now_tick += advance;
+      check_tw_advance(&tw, advance);
+      for (int i = 0; i < NJ_CHECK_TW_MAX_TIMERS; ++i) {
+        check_tw_timer_t* t = &timers[i];
+        if (!t->is_active || t->deadline > now_tick)
+          continue;
+        ++t->expected_fire_count;
+        if (!t->period) {
+          t->is_active = false;
+          continue;
+        }
+        t->deadline += t->period;
+        if (t->deadline <= now_tick)
+          t->deadline += ((now_tick - t->deadline) / t->period + 1) * t->period;
+      }
+      nj_tw_update(&tw);
+      int bad_count = 0;
+      for (int i = 0; i < NJ_CHECK_TW_MAX_TIMERS; ++i)
+        bad_count += timers[i].fire_count != timers[i].expected_fire_count;
+      NJ_EXPECT(!bad_count, "%d timers fired a wrong number of times at tick %lld", bad_count, (long long)now_tick);
+      NJ_EXPECT(tw.current_tick == now_tick, "the wheel is at tick %lld instead of %lld", (long long)tw.current_tick, (long long)now_tick);
+    }
+    njs64 first_deadline = -1;
+    for (int i = 0; i < NJ_CHECK_TW_MAX_TIMERS; ++i) {
+      if (timers[i].is_active && (first_deadline == -1 || timers[i].deadline < first_deadline))
+        first_deadline = timers[i].deadline;
+    }
+    njs64 next_deadline = nj_tw_get_next_deadline(&tw);
+    njs64 next_tick = next_deadline == -1 ? -1 : (next_deadline - tw.start_time) / tw.tick_length;
+    NJ_EXPECT((first_deadline == -1) == (next_tick == -1) && (next_tick == -1 || (next_tick > now_tick && next_tick <= first_deadline)),
+              "next tick %lld, first deadline %lld at tick %lld", (long long)next_tick, (long long)first_deadline, (long long)now_tick);
+  }
+  nj_tw_destroy(&tw);
+  g_check_allocator.free(timers);
+  return g_check_fail_count == fail_count;
+}
+
+// Files of the file checks are written next to the executable, like the log.
+static bool check_write_file(const nj_os_char* path, const nju8* data, njsp size) {
+  nj_file_t file;
+  NJ_CHECK_RETURN_VAL(nj_file_open(&file, path, NJ_FILE_MODE_WRITE), false);
+  njsp written = 0;
+  bool is_ok = !size || (nj_file_write(&file, data, size, &written) && written == size);
+  nj_file_close(&file);
+  return is_ok;
+}
+
+// Sizes around page boundaries are mapped with each hint, the view must hold
+// the file followed by a zero byte.
+static bool check_file_map() {
+  const njsp max_size = 3 * 65536 + 1;
+  nju8* data = (nju8*)g_check_allocator.alloc(max_size);
+  NJ_CHECK_RETURN_VAL(data, false);
+  int fail_count = g_check_fail_count;
+  nj_os_char path[NJ_MAX_PATH];
+  nj_path_from_exe_dir(NJ_OS_LIT("check_file_map.bin"), path, NJ_MAX_PATH);
+  static const njsp sc_sizes[] = {1, 100, 4095, 4096, 4097, 8192, 65536, 65537, 3 * 65536};
+  static const int sc_hints[] = {NJ_FILE_MAP_HINT_NONE, NJ_FILE_MAP_HINT_SEQUENTIAL, NJ_FILE_MAP_HINT_RANDOM | NJ_FILE_MAP_HINT_WILLNEED, NJ_FILE_MAP_HINT_POPULATE};
+  for (int i = 0; i < (int)nj_static_array_size(sc_sizes) + 8; ++i) {
+    njsp size = i < (int)nj_static_array_size(sc_sizes) ? sc_sizes[i] : 1 + check_random(max_size - 1);
+    for (njsp j = 0; j < size; ++j)
+      data[j] = (nju8)(check_xorshift() | 1);
+    NJ_CHECK_RETURN_VAL(check_write_file(path, data, size), false);
+    int hints = sc_hints[i % nj_static_array_size(sc_hints)];
+    nj_file_map_t map;
+    if (!nj_file_map(&map, path, hints)) {
+      NJ_EXPECT(false, "can't map %ld bytes with hints %d", (long)size, hints);
+      continue;
+    }
+    NJ_EXPECT(map.size == size && !memcmp(map.data, data, size) && !map.data[size], "mapping %ld bytes with hints %d", (long)size, hints);
+    nj_file_unmap(&map);
+  }
+  nj_file_map_t map;
+  nj_file_delete_path(path);
+  NJ_EXPECT(!nj_file_map(&map, path), "mapped a deleted file");
+  g_check_allocator.free(data);
+  return g_check_fail_count == fail_count;
+}
+
+// Random ranges, some past the end, are read from a file given in each way a
+// request can name it, through a queue small enough to fill up.
+static bool check_aio_backend(nj_aio_backend_t backend, const nj_os_char* path, const nju8* data, njsp size) {
+  enum { REQUEST_COUNT = 64, MAX_READ_SIZE = 20000 };
+  nj_aio_desc_t desc;
+  desc.backend = backend;
+  desc.queue_depth = 8;
+  desc.thread_count = 3;
+  nj_aio_t aio;
+  if (!nj_aio_init(&aio, &g_check_allocator, &desc))
+    return backend == NJ_AIO_BACKEND_IO_URING;
+  int fail_count = g_check_fail_count;
+  nj_file_t file;
+  NJ_CHECK_RETURN_VAL(nj_file_open(&file, path, NJ_FILE_MODE_READ, NJ_FILE_UNBUFFERED), false);
+  NJ_EXPECT(nj_aio_register_files(&aio, &file, 1), "can't register the file");
+  nj_aio_request_t* requests = (nj_aio_request_t*)g_check_allocator.alloc(REQUEST_COUNT * sizeof(nj_aio_request_t));
+  nju8* buffer = (nju8*)g_check_allocator.alloc(REQUEST_COUNT * MAX_READ_SIZE);
+  NJ_CHECK_RETURN_VAL(requests && buffer, false);
+  const nj_os_char* missing_path = NJ_OS_LIT("/nonexistent/check_aio.bin");
+  for (int round = 0; round < 8 && g_check_fail_count - fail_count < 10; ++round) {
+    for (int i = 0; i < REQUEST_COUNT; ++i) {
+      nj_aio_request_t* request = &requests[i];
+      *request = nj_aio_request_t();
+      int source = check_random(4);
+      if (source == 0)
+        request->file_index = 0;
+      else if (source == 1)
+        request->file = &file;
+      else
+        request->path = !check_random(16) ? missing_path : path;
+      request->offset = check_random(size + 100);
+      request->size = 1 + check_random(MAX_READ_SIZE);
+      request->buffer = buffer + i * MAX_READ_SIZE;
+    }
+    int submitted_count = 0;
+    int completed_count = 0;
+    while (completed_count < REQUEST_COUNT) {
+      submitted_count += nj_aio_submit(&aio, requests + submitted_count, REQUEST_COUNT - submitted_count);
+      NJ_EXPECT(aio.in_flight_count <= desc.queue_depth, "%d requests in flight", aio.in_flight_count);
+      nj_aio_request_t* completed[8];
+      int count = nj_aio_wait(&aio, completed, 8);
+      if (!count) {
+        NJ_EXPECT(false, "nothing in flight after %d of %d requests", completed_count, REQUEST_COUNT);
+        break;
+      }
+      for (int i = 0; i < count; ++i) {
+        const nj_aio_request_t* request = completed[i];
+        if (request->path == missing_path) {
+          NJ_EXPECT(!request->is_ok, "read a missing file");
+          continue;
+        }
+        njsp expected_size = nj_max((njsp)0, nj_min(request->size, size - request->offset));
+        NJ_EXPECT(request->is_ok && request->bytes_read == expected_size && !memcmp(request->buffer, data + request->offset, expected_size),
+                  "backend %d: reading %ld bytes at %ld gave %ld bytes", (int)aio.backend, (long)request->size, (long)request->offset, (long)request->bytes_read);
+      }
+      completed_count += count;
+    }
+  }
+  NJ_EXPECT(!aio.in_flight_count, "%d requests still in flight", aio.in_flight_count);
+  nj_aio_destroy(&aio);
+  nj_file_close(&file);
+  g_check_allocator.free(buffer);
+  g_check_allocator.free(requests);
+  return g_check_fail_count == fail_count;
+}
+
+static bool check_aio() {
+  const njsp size = 100000;
+  nju8* data = (nju8*)g_check_allocator.alloc(size);
+  NJ_CHECK_RETURN_VAL(data, false);
+  for (njsp i = 0; i < size; ++i)
+    data[i] = (nju8)check_xorshift();
+  nj_os_char path[NJ_MAX_PATH];
+  nj_path_from_exe_dir(NJ_OS_LIT("check_aio.bin"), path, NJ_MAX_PATH);
+  NJ_CHECK_RETURN_VAL(check_write_file(path, data, size), false);
+  bool is_ok = check_aio_backend(NJ_AIO_BACKEND_IO_URING, path, data, size);
+  is_ok = check_aio_backend(NJ_AIO_BACKEND_THREAD_POOL, path, data, size) && is_ok;
+  nj_file_delete_path(path);
+  g_check_allocator.free(data);
+  return is_ok;
+}
+
+#define NJ_CHECK_FILE_SIZE (50000)
+#define NJ_CHECK_FILE_THREADS (4)
+
+static const njsp gc_check_file_buffer_sizes[] = {NJ_FILE_UNBUFFERED, 1, 4096, 8192, NJ_FILE_DEFAULT_BUFFER_SIZE};
+
+// Reads of one size are either in the file buffer or bigger than it.
+static njsp check_file_read_size(nju64 random) {
+  return 1 + (njsp)(random % (random & 1 ? 100 : 10000));
+}
+
+// A file handle and where the model says it is.
+struct check_file_handle_t {
+  nj_file_t file;
+  njsp pos;
+};
+
+// Seek |handle| to a random position of a |size| bytes file in a random way.
+static void check_file_seek(check_file_handle_t* handle, njsp size) {
+  njsp pos = check_random(size + 1);
+  switch (check_random(3)) {
+  case 0:
+    nj_file_seek(&handle->file, NJ_FILE_FROM_BEGIN, pos);
+    break;
+  case 1:
+    // Mostly short hops that can stay in what was read ahead.
+    if (check_random(2))
+      pos = nj_max((njsp)0, nj_min(size, handle->pos + check_random(200) - 100));
+    nj_file_seek(&handle->file, NJ_FILE_FROM_CURRENT, pos - handle->pos);
+    break;
+  default:
+    nj_file_seek(&handle->file, NJ_FILE_FROM_END, pos - size);
+    break;
+  }
+  handle->pos = pos;
+}
+
+// Split |size| bytes at |data| in up to |max_count| random parts, some empty.
+static int check_file_split(nju8* data, njsp size, nj_file_iovec_t* vecs, int max_count) {
+  int count = 1 + (int)check_random(max_count);
+  for (int i = 0; i < count; ++i) {
+    njsp part_size = i == count - 1 ? size : check_random(2 * size / (count - i) + 1);
+    part_size = nj_min(part_size, size);
+    vecs[i] = {data, part_size};
+    data += part_size;
+    size -= part_size;
+  }
+  return count;
+}
+
+struct check_file_thread_t {
+  const nj_os_char* path;
+  const nju8* data;
+  // Shared by the threads for positional reads.
+  const nj_file_t* shared_file;
+  nju64 seed;
+  nju32* error_count;
+};
+
+static void check_file_run(void* args) {
+  check_file_thread_t* thread = (check_file_thread_t*)args;
+  nju8 buffer[10000];
+  for (int i = 0; i < 50; ++i) {
+    thread->seed ^= thread->seed << 13;
+    thread->seed ^= thread->seed >> 7;
+    thread->seed ^= thread->seed << 17;
+    nj_file_t file;
+    if (!nj_file_open(&file, thread->path, NJ_FILE_MODE_READ, gc_check_file_buffer_sizes[thread->seed % nj_static_array_size(gc_check_file_buffer_sizes)])) {
+      nj_atomic_fetch_add(thread->error_count, 1u);
+      continue;
+    }
+    njsp pos = 0;
+    njsp bytes_read;
+    while (nj_file_read(&file, buffer, check_file_read_size(thread->seed >> (pos & 31)), &bytes_read)) {
+      if (memcmp(buffer, thread->data + pos, bytes_read))
+        nj_atomic_fetch_add(thread->error_count, 1u);
+      pos += bytes_read;
+    }
+    if (pos != NJ_CHECK_FILE_SIZE)
+      nj_atomic_fetch_add(thread->error_count, 1u);
+    nj_file_close(&file);
+    for (int j = 0; j < 10; ++j) {
+      njsp offset = (thread->seed >> j * 4) % NJ_CHECK_FILE_SIZE;
+      njsp size = check_file_read_size(thread->seed >> j);
+      njsp expected_size = nj_min(size, NJ_CHECK_FILE_SIZE - offset);
+      if (!nj_file_pread(thread->shared_file, buffer, size, offset, &bytes_read) || bytes_read != expected_size || memcmp(buffer, thread->data + offset, expected_size))
+        nj_atomic_fetch_add(thread->error_count, 1u);
+    }
+  }
+}
+
+// More files than the pool keeps buffers for are read, seeked and written
+// with random buffer sizes and compared with a model of the file and of the
+// positions, vectored and positional I/O included. Threads then open and read
+// the file at the same time and read one handle at random offsets.
+static bool check_file() {
+  enum { HANDLE_COUNT = 20, MAX_READ_SIZE = 10000, MAX_VEC_COUNT = 100 };
+  nj_file_iovec_t vecs[MAX_VEC_COUNT];
+  nju8* data = (nju8*)g_check_allocator.alloc(NJ_CHECK_FILE_SIZE);
+  nju8* model = (nju8*)g_check_allocator.alloc(2 * NJ_CHECK_FILE_SIZE);
+  nju8* buffer = (nju8*)g_check_allocator.alloc(MAX_READ_SIZE);
+  check_file_handle_t* handles = (check_file_handle_t*)g_check_allocator.alloc(HANDLE_COUNT * sizeof(check_file_handle_t));
+  NJ_CHECK_RETURN_VAL(data && model && buffer && handles, false);
+  int fail_count = g_check_fail_count;
+  for (njsp i = 0; i < NJ_CHECK_FILE_SIZE; ++i)
+    data[i] = (nju8)check_xorshift();
+  nj_os_char path[NJ_MAX_PATH];
+  nj_path_from_exe_dir(NJ_OS_LIT("check_file.bin"), path, NJ_MAX_PATH);
+  NJ_CHECK_RETURN_VAL(check_write_file(path, data, NJ_CHECK_FILE_SIZE), false);
+
+  for (int i = 0; i < HANDLE_COUNT; ++i) {
+    handles[i] = check_file_handle_t();
+    njsp buffer_size = gc_check_file_buffer_sizes[i % nj_static_array_size(gc_check_file_buffer_sizes)];
+    NJ_CHECK_RETURN_VAL(nj_file_open(&handles[i].file, path, NJ_FILE_MODE_READ, buffer_size), false);
+  }
+  for (int i = 0; i < 4000 && g_check_fail_count - fail_count < 10; ++i) {
+    check_file_handle_t* handle = &handles[check_random(HANDLE_COUNT)];
+    if (check_random(3)) {
+      check_file_seek(handle, NJ_CHECK_FILE_SIZE);
+      continue;
+    }
+    njsp size = check_file_read_size(check_xorshift());
+    njsp expected_size = nj_min(size, NJ_CHECK_FILE_SIZE - handle->pos);
+    njsp bytes_read = -1;
+    bool is_ok = nj_file_read(&handle->file, buffer, size, &bytes_read);
+    NJ_EXPECT(is_ok == (expected_size != 0) && bytes_read == expected_size && !memcmp(buffer, data + handle->pos, expected_size),
+              "reading %ld bytes at %ld with a %ld bytes buffer gave %ld bytes", (long)size, (long)handle->pos, (long)handle->file.buffer_size, (long)bytes_read);
+    handle->pos += expected_size;
+  }
+  for (int i = 0; i < HANDLE_COUNT; ++i)
+    nj_file_close(&handles[i].file);
+
+  // Writes go over and past the end of the file, reads in between see them.
+  for (int round = 0; round < (int)nj_static_array_size(gc_check_file_buffer_sizes) && g_check_fail_count - fail_count < 10; ++round) {
+    check_file_handle_t* handle = &handles[0];
+    NJ_CHECK_RETURN_VAL(nj_file_open(&handle->file, path, NJ_FILE_MODE_WRITE, gc_check_file_buffer_sizes[round]), false);
+    handle->pos = 0;
+    njsp model_size = 0;
+    for (int i = 0; i < 500 && g_check_fail_count - fail_count < 10; ++i) {
+      int op = (int)check_random(7);
+      njsp size = check_file_read_size(check_xorshift());
+      // Positional I/O goes around the file buffer, it's synced by a seek.
+      njsp offset = check_random(model_size + 1);
+      if (op >= 5)
+        nj_file_seek(&handle->file, NJ_FILE_FROM_BEGIN, handle->pos);
+      if (op == 0) {
+        check_file_seek(handle, model_size);
+      } else if (op == 1 || op == 2 || op == 5) {
+        njsp pos = op == 5 ? offset : handle->pos;
+        njsp expected_size = nj_min(size, model_size - pos);
+        njsp bytes_read = -1;
+        bool is_ok;
+        int vec_count = 0;
+        if (op == 1) {
+          is_ok = nj_file_read(&handle->file, buffer, size, &bytes_read) == (expected_size != 0);
+        } else if (op == 2) {
+          vec_count = check_file_split(buffer, size, vecs, MAX_VEC_COUNT);
+          is_ok = nj_file_readv(&handle->file, vecs, vec_count, &bytes_read) == (expected_size != 0);
+        } else {
+          is_ok = nj_file_pread(&handle->file, buffer, size, pos, &bytes_read);
+        }
+        NJ_EXPECT(is_ok && bytes_read == expected_size && !memcmp(buffer, model + pos, expected_size),
+                  "op %d reading back %ld bytes in %d parts at %ld with a %ld bytes buffer gave %ld bytes", op, (long)size, vec_count, (long)pos,
+                  (long)handle->file.buffer_size, (long)bytes_read);
+        if (op != 5)
+          handle->pos += expected_size;
+      } else {
+        njsp pos = op == 6 ? offset : handle->pos;
+        if (pos + size > 2 * NJ_CHECK_FILE_SIZE)
+          continue;
+        memcpy(buffer, data + check_random(NJ_CHECK_FILE_SIZE - size + 1), size);
+        njsp bytes_written = -1;
+        bool is_ok;
+        int vec_count = 0;
+        if (op == 3) {
+          is_ok = nj_file_write(&handle->file, buffer, size, &bytes_written);
+        } else if (op == 4) {
+          vec_count = check_file_split(buffer, size, vecs, MAX_VEC_COUNT);
+          is_ok = nj_file_writev(&handle->file, vecs, vec_count, &bytes_written);
+        } else {
+          is_ok = nj_file_pwrite(&handle->file, buffer, size, pos, &bytes_written);
+        }
+        NJ_EXPECT(is_ok && bytes_written == size, "op %d can't write %ld bytes in %d parts", op, (long)size, vec_count);
+        memcpy(model + pos, buffer, size);
+        if (op != 6)
+          handle->pos += size;
+        model_size = nj_max(model_size, pos + size);
+      }
+    }
+    nj_file_close(&handle->file);
+    nj_file_map_t map;
+    NJ_CHECK_RETURN_VAL(nj_file_map(&map, path), false);
+    NJ_EXPECT(map.size == model_size && !memcmp(map.data, model, model_size), "wrote %ld bytes instead of %ld", (long)map.size, (long)model_size);
+    nj_file_unmap(&map);
+  }
+
+  NJ_CHECK_RETURN_VAL(check_write_file(path, data, NJ_CHECK_FILE_SIZE), false);
+  nj_file_t shared_file;
+  NJ_CHECK_RETURN_VAL(nj_file_open(&shared_file, path, NJ_FILE_MODE_READ), false);
+  nju32 error_count = 0;
+  nj_thread_t threads[NJ_CHECK_FILE_THREADS];
+  check_file_thread_t args[NJ_CHECK_FILE_THREADS];
+  for (int i = 0; i < NJ_CHECK_FILE_THREADS; ++i) {
+    args[i] = {path, data, &shared_file, check_xorshift() | 1, &error_count};
+    NJ_CHECK_RETURN_VAL(nj_thread_init(&threads[i], check_file_run, &args[i]), false);
+  }
+  for (int i = 0; i < NJ_CHECK_FILE_THREADS; ++i)
+    nj_thread_wait_for(&threads[i]);
+  NJ_EXPECT(!error_count, "%u bad reads from threads", error_count);
+  nj_file_close(&shared_file);
+
+  nj_file_delete_path(path);
+  g_check_allocator.free(handles);
+  g_check_allocator.free(buffer);
+  g_check_allocator.free(model);
+  g_check_allocator.free(data);
+  return g_check_fail_count == fail_count;
+}
+
+struct check_stream_t {
+  const nju8* data;
+  // Where the next chunk must start.
+  njsp offset;
+  int chunk_count;
+  // Stop the stream after this many chunks, -1 to read it all.
+  int stop_count;
+  bool is_ok;
+};
+
+static bool check_stream_consume(void* user_data, const nju8* data, njsp size, njsp offset) {
+  check_stream_t* stream = (check_stream_t*)user_data;
+  if (offset != stream->offset || size <= 0 || memcmp(data, stream->data + offset, size))
+    stream->is_ok = false;
+  stream->offset = offset + size;
+  return ++stream->chunk_count != stream->stop_count;
+}
+
+// Random ranges of a file opened for direct reads, buffered if the file
+// system can't, are streamed with random chunk and buffer counts through both
+// backends. Chunks must come in order and cover the range, or stop when the
+// consumer asks. Aligned positional reads go around the cache too.
+static bool check_aio_stream() {
+  const njsp max_size = 600000;
+  nju8* data = (nju8*)g_check_allocator.alloc(max_size);
+  nju8* buffer = (nju8*)g_check_allocator.aligned_alloc(4 * NJ_FILE_DIRECT_ALIGNMENT, NJ_FILE_DIRECT_ALIGNMENT);
+  NJ_CHECK_RETURN_VAL(data && buffer, false);
+  int fail_count = g_check_fail_count;
+  nj_os_char path[NJ_MAX_PATH];
+  nj_path_from_exe_dir(NJ_OS_LIT("check_aio_stream.bin"), path, NJ_MAX_PATH);
+  for (int round = 0; round < 8 && g_check_fail_count - fail_count < 10; ++round) {
+    njsp size = round ? 1 + check_random(max_size) : 3 * NJ_FILE_DIRECT_ALIGNMENT;
+    for (njsp i = 0; i < size; ++i)
+      data[i] = (nju8)check_xorshift();
+    NJ_CHECK_RETURN_VAL(check_write_file(path, data, size), false);
+    nj_file_t file;
+    if (!nj_file_open(&file, path, NJ_FILE_MODE_READ | NJ_FILE_MODE_DIRECT))
+      NJ_CHECK_RETURN_VAL(nj_file_open(&file, path, NJ_FILE_MODE_READ | NJ_FILE_MODE_SEQUENTIAL), false);
+    for (int i = 0; i < 4; ++i) {
+      njsp offset = check_random(size / NJ_FILE_DIRECT_ALIGNMENT + 1) * NJ_FILE_DIRECT_ALIGNMENT;
+      njsp expected_size = nj_max((njsp)0, nj_min((njsp)4 * NJ_FILE_DIRECT_ALIGNMENT, size - offset));
+      njsp bytes_read = -1;
+      bool is_ok = nj_file_pread(&file, buffer, 4 * NJ_FILE_DIRECT_ALIGNMENT, offset, &bytes_read);
+      NJ_EXPECT(is_ok && bytes_read == expected_size && !memcmp(buffer, data + offset, expected_size), "direct read at %ld of a %ld bytes file gave %ld bytes",
+                (long)offset, (long)size, (long)bytes_read);
+    }
+    for (int backend = NJ_AIO_BACKEND_IO_URING; backend <= NJ_AIO_BACKEND_THREAD_POOL; ++backend) {
+      nj_aio_desc_t aio_desc;
+      aio_desc.backend = (nj_aio_backend_t)backend;
+      aio_desc.queue_depth = 4;
+      nj_aio_t aio;
+      if (!nj_aio_init(&aio, &g_check_allocator, &aio_desc))
+        continue;
+      nj_aio_stream_desc_t desc;
+      desc.offset = check_random(size + 10);
+      desc.size = check_random(2) ? -1 : check_random(size);
+      desc.chunk_size = 1 + check_random(100000);
+      desc.buffer_count = 1 + (int)check_random(aio_desc.queue_depth);
+      desc.callback = check_stream_consume;
+      check_stream_t stream = {data, desc.offset, 0, check_random(4) ? -1 : 1 + (int)check_random(3), true};
+      desc.user_data = &stream;
+      bool is_ok = nj_aio_stream(&aio, &file, &g_check_allocator, &desc);
+      njsp end = desc.size < 0 ? size : nj_min(size, desc.offset + desc.size);
+      if (stream.chunk_count != stream.stop_count)
+        NJ_EXPECT(stream.offset == nj_max(end, desc.offset), "streamed %ld to %ld of %ld bytes instead of %ld", (long)desc.offset, (long)stream.offset, (long)size, (long)end);
+      NJ_EXPECT(is_ok && stream.is_ok, "backend %d: streaming %ld bytes at %ld in %ld bytes chunks", backend, (long)desc.size, (long)desc.offset, (long)desc.chunk_size);
+      NJ_EXPECT(!aio.in_flight_count, "%d requests in flight after the stream", aio.in_flight_count);
+      nj_aio_destroy(&aio);
+    }
+    nj_file_close(&file);
+  }
+  nj_file_delete_path(path);
+  g_check_allocator.free(buffer);
+  g_check_allocator.free(data);
+  return g_check_fail_count == fail_count;
+}
+
+// Files of random sizes, compressible or not, are packed with random codecs,
+// then each entry must be found by name, with either separator, aligned and
+// read back as it was. Names that aren't in the pack and names in it twice
+// are also tried.
+static bool check_pack() {
+  enum { MAX_ENTRY_COUNT = 60, MAX_ENTRY_SIZE = 20000 };
+  nju8* data = (nju8*)g_check_allocator.alloc(MAX_ENTRY_COUNT * MAX_ENTRY_SIZE);
+  nju8* buffer = (nju8*)g_check_allocator.alloc(MAX_ENTRY_SIZE);
+  njsp* sizes = (njsp*)g_check_allocator.alloc(MAX_ENTRY_COUNT * sizeof(njsp));
+  nj_os_char(*paths)[NJ_MAX_PATH] = (nj_os_char(*)[NJ_MAX_PATH])g_check_allocator.alloc(MAX_ENTRY_COUNT * NJ_MAX_PATH * sizeof(nj_os_char));
+  char(*names)[32] = (char(*)[32])g_check_allocator.alloc(MAX_ENTRY_COUNT * 32);
+  nj_pack_input_t* inputs = (nj_pack_input_t*)g_check_allocator.alloc(MAX_ENTRY_COUNT * sizeof(nj_pack_input_t));
+  NJ_CHECK_RETURN_VAL(data && buffer && sizes && paths && names && inputs, false);
+  int fail_count = g_check_fail_count;
+  nj_os_char pack_path[NJ_MAX_PATH];
+  nj_path_from_exe_dir(NJ_OS_LIT("check_pack.pack"), pack_path, NJ_MAX_PATH);
+  for (int i = 0; i < MAX_ENTRY_COUNT; ++i) {
+    // check_pack_00.bin, check_pack_01.bin...
+    nj_path_from_exe_dir(NJ_OS_LIT("check_pack_00.bin"), paths[i], NJ_MAX_PATH);
+    njsp len = nj_str_get_len(paths[i]);
+    paths[i][len - 6] = (nj_os_char)('0' + i / 10);
+    paths[i][len - 5] = (nj_os_char)('0' + i % 10);
+  }
+  for (int round = 0; round < 6 && g_check_fail_count - fail_count < 10; ++round) {
+    int count = 1 + (int)check_random(MAX_ENTRY_COUNT);
+    for (int i = 0; i < count; ++i) {
+      nju8* entry_data = data + i * MAX_ENTRY_SIZE;
+      sizes[i] = check_random(4) ? check_random(MAX_ENTRY_SIZE + 1) : check_random(3);
+      // Repeat a short pattern or not.
+      njsp period = check_random(2) ? 1 + check_random(16) : (njsp)MAX_ENTRY_SIZE;
+      for (njsp j = 0; j < sizes[i]; ++j)
+        entry_data[j] = j < period ? (nju8)check_xorshift() : entry_data[j - period];
+      NJ_CHECK_RETURN_VAL(check_write_file(paths[i], entry_data, sizes[i]), false);
+      snprintf(names[i], sizeof(names[i]), "dir%d/entry_%d_%d.bin", (int)check_random(3), i, round);
+      inputs[i] = nj_pack_input_t();
+      inputs[i].name = names[i];
+      inputs[i].path = paths[i];
+      inputs[i].codec = check_random(2) ? NJ_PACK_CODEC_LZ : NJ_PACK_CODEC_NONE;
+    }
+    if (!nj_pack_write(pack_path, inputs, count, &g_check_allocator)) {
+      NJ_EXPECT(false, "can't write a pack of %d entries", count);
+      continue;
+    }
+    nj_pack_t pack;
+    NJ_CHECK_RETURN_VAL(nj_pack_open(&pack, pack_path), false);
+    for (int i = 0; i < count && g_check_fail_count - fail_count < 10; ++i) {
+      char name[32];
+      strcpy(name, names[i]);
+      if (check_random(2))
+        name[4] = '\\';
+      const nj_pack_entry_t* entry = nj_pack_find(&pack, name);
+      if (!entry) {
+        NJ_EXPECT(false, "can't find %s", name);
+        continue;
+      }
+      const nju8* entry_data = data + i * MAX_ENTRY_SIZE;
+      NJ_EXPECT(entry->original_size == (nju64)sizes[i] && entry->offset % NJ_PACK_ALIGNMENT == 0 && (entry->codec == NJ_PACK_CODEC_NONE || entry->size < entry->original_size),
+                "%s has %ld bytes stored as %ld at %ld", name, (long)entry->original_size, (long)entry->size, (long)entry->offset);
+      NJ_EXPECT(nj_pack_read(&pack, entry, buffer, MAX_ENTRY_SIZE) && !memcmp(buffer, entry_data, sizes[i]), "can't read %s back", name);
+      const nju8* view;
+      njsp view_size;
+      if (entry->codec == NJ_PACK_CODEC_NONE)
+        NJ_EXPECT(nj_pack_get_data(&pack, name, &view, &view_size) && view_size == sizes[i] && !memcmp(view, entry_data, view_size) && !view[view_size], "bad view of %s", name);
+    }
+    NJ_EXPECT(!nj_pack_find(&pack, "dir0/missing.bin") && !nj_pack_find(&pack, ""), "found a missing entry");
+    nj_pack_close(&pack);
+    if (count > 1) {
+      inputs[0].name = names[count - 1];
+      NJ_EXPECT(!nj_pack_write(pack_path, inputs, count, &g_check_allocator), "wrote %s twice", names[count - 1]);
+    }
+  }
+  for (int i = 0; i < MAX_ENTRY_COUNT; ++i)
+    nj_file_delete_path(paths[i]);
+  nj_file_delete_path(pack_path);
+  g_check_allocator.free(inputs);
+  g_check_allocator.free(names);
+  g_check_allocator.free(paths);
+  g_check_allocator.free(sizes);
+  g_check_allocator.free(buffer);
+  g_check_allocator.free(data);
+  return g_check_fail_count == fail_count;
+}
+
+// Gives back the unconsumed bytes of |bs| and feeds them again with the next
+// random piece of the |size| bytes of |data|. |*offset| is the end of the
+// data fed so far.
+static void check_bits_feed(nj_bit_stream_t* bs, const nju8* data, njsp size, njsp* offset) {
+  nj_bs_give_back_bytes(bs);
+  *offset = nj_min(size, *offset + 1 + check_random(16));
+  nj_bs_feed(bs, bs->p, data + *offset - bs->p);
+}
+
+// Random fields written by nj_bit_writer_t read back by nj_bit_stream_t, whole
+// and fed in random pieces, then a skip past the end.
+static bool check_bits() {
+  const int field_count = 20000;
+  const njsp max_size = field_count * 32 + 16;
+  nju8* data = (nju8*)g_check_allocator.alloc(max_size);
+  nju64* values = (nju64*)g_check_allocator.alloc(field_count * sizeof(nju64));
+  int* widths = (int*)g_check_allocator.alloc(field_count * sizeof(int));
+  NJ_CHECK_RETURN_VAL(data && values && widths, false);
+  int fail_count = g_check_fail_count;
+
+  // Field i is |widths[i]| bits written lsb first if i % 3 == 0, msb first if
+  // i % 3 == 1 and if i % 3 == 2, |widths[i]| bytes from a byte boundary that
+  // repeat the bytes of |values[i]|.
+  nj_bit_writer_t bw;
+  nj_bw_init(&bw, data, max_size);
+  for (int i = 0; i < field_count; ++i) {
+    widths[i] = i % 3 == 2 ? (int)check_random(32) : 1 + (int)check_random(NJ_BS_MAX_BITS);
+    values[i] = i % 3 == 2 ? check_xorshift() : check_xorshift() & ((1ull << widths[i]) - 1);
+    if (i % 3 == 0) {
+      nj_bw_write_lsb(&bw, values[i], widths[i]);
+    } else if (i % 3 == 1) {
+      nj_bw_write_msb(&bw, values[i], widths[i]);
+    } else {
+      nj_bw_write_lsb(&bw, 0, (8 - bw.bit_count % 8) % 8);
+      for (int j = 0; j < widths[i]; ++j)
+        nj_bw_write_lsb(&bw, (nju8)(values[i] >> (j % 8 * 8)), 8);
+    }
+  }
+  njsp size = nj_bw_finish(&bw);
+  NJ_CHECK_RETURN_VAL(size > 0, false);
+
+  for (int is_split = 0; is_split < 2; ++is_split) {
+    nj_bit_stream_t bs;
+    njsp offset = is_split ? 0 : size;
+    nj_bs_init(&bs, data, offset);
+    int i = 0;
+    for (; i < field_count; ++i) {
+      bool is_ok = true;
+      if (i % 3 < 2) {
+        while (bs.bit_count < widths[i] && offset < size) {
+          check_bits_feed(&bs, data, size, &offset);
+          nj_bs_refill(&bs);
+        }
+        nju64 value = i % 3 ? nj_bs_consume_msb(&bs, widths[i]) : nj_bs_consume_lsb(&bs, widths[i]);
+        is_ok = value == values[i];
+      } else {
+        // The bit count is a multiple of 8 from the start of the data.
+        nj_bs_consume(&bs, bs.bit_count % 8);
+        nju8 copied[32];
+        njsp len = nj_bs_copy_bytes(&bs, copied, widths[i]);
+        while (len < widths[i] && offset < size) {
+          check_bits_feed(&bs, data, size, &offset);
+          len += nj_bs_copy_bytes(&bs, copied + len, widths[i] - len);
+        }
+        is_ok = len == widths[i];
+        for (njsp j = 0; is_ok && j < len; ++j)
+          is_ok = copied[j] == (nju8)(values[i] >> (j % 8 * 8));
+        nj_bs_refill(&bs);
+      }
+      if (!is_ok)
+        break;
+    }
+    NJ_EXPECT(i == field_count, "field %d of %d, split %d", i, widths[nj_min(i, field_count - 1)], is_split);
+    NJ_EXPECT(!nj_bs_is_overflow(&bs), "overflow before the end, split %d", is_split);
+    nj_bs_skip(&bs, 64);
+    NJ_EXPECT(nj_bs_is_overflow(&bs), "no overflow after the end, split %d", is_split);
+  }
+
+  g_check_allocator.free(widths);
+  g_check_allocator.free(values);
+  g_check_allocator.free(data);
+  return g_check_fail_count == fail_count;
+}
+
+// Kind 0 is random bytes, 1 zeros, 2 text-like with a small alphabet and 3+ a
+// random pattern repeated with a period of |kind| - 2.
+static void check_lz_fill(nju8* data, njsp size, int kind) {
+  for (njsp i = 0; i < size; ++i) {
+    if (kind == 0)
+      data[i] = (nju8)check_xorshift();
+    else if (kind == 1)
+      data[i] = 0;
+    else if (kind == 2)
+      data[i] = check_random(4) ? (nju8)('a' + check_random(3)) : (nju8)check_xorshift();
+    else
+      data[i] = i < kind - 2 ? (nju8)check_xorshift() : data[i - (kind - 2)];
+  }
+}
+
+static void check_lz_block(nj_lz_encoder_t* encoder, const nju8* data, njsp size, nju8* compressed, nju8* output) {
+  njsp compressed_size = nj_lz_compress(encoder, data, size, compressed, nj_lz_compress_bound(size));
+  njsp output_size = nj_lz_decompress(compressed, compressed_size, output, size);
+  NJ_EXPECT(output_size == size && !memcmp(output, data, size), "block of %ld bytes, level %d", (long)size, encoder->level);
+  if (size)
+    NJ_EXPECT(nj_lz_decompress(compressed, compressed_size, output, size - 1) == -1, "block of %ld bytes decompressed in a smaller buffer", (long)size);
+  // Truncated and corrupted blocks must be rejected or decode to garbage
+  // without reading or writing out of the buffers.
+  for (int i = 0; i < 8 && compressed_size > 1; ++i)
+    nj_lz_decompress(compressed, check_random(compressed_size), output, size);
+  for (int i = 0; i < 16 && compressed_size > 1; ++i) {
+    njsp offset = check_random(compressed_size);
+    nju8 bit = (nju8)(1 << check_random(8));
+    compressed[offset] ^= bit;
+    nj_lz_decompress(compressed, compressed_size, output, size);
+    compressed[offset] ^= bit;
+  }
+}
+
+static void check_lz_frame(nj_lz_level_t level, const nju8* data, njsp size, check_sink_t* frame, check_sink_t* output) {
+  nj_lz_writer_t writer;
+  frame->len = 0;
+  if (!nj_lz_writer_init(&writer, &g_check_allocator, level, NJ_LZ_MIN_BLOCK_SIZE_LOG2 + (int)check_random(5), check_sink_write, frame)) {
+    NJ_EXPECT(false, "nj_lz_writer_init()");
+    return;
+  }
+  bool rv = true;
+  for (njsp offset = 0; rv && offset < size;) {
+    njsp piece = nj_min(size - offset, check_random(9000));
+    rv = nj_lz_writer_write(&writer, data + offset, piece);
+    offset += piece;
+  }
+  rv = rv && nj_lz_writer_finish(&writer);
+  nj_lz_writer_destroy(&writer);
+  NJ_EXPECT(rv, "frame writer, %ld bytes", (long)size);
+  // The reader must stop at the end of the frame.
+  frame->data[frame->len++] = 0x55;
+
+  nj_lz_reader_t reader;
+  output->len = 0;
+  NJ_CHECK_RETURN(nj_lz_reader_init(&reader, &g_check_allocator, check_sink_write, output));
+  for (njsp offset = 0; rv && offset < frame->len;) {
+    njsp piece = nj_min(frame->len - offset, 1 + check_random(check_random(2) ? 7 : 20000));
+    rv = nj_lz_reader_feed(&reader, frame->data + offset, piece);
+    offset += piece;
+  }
+  NJ_EXPECT(rv && nj_lz_reader_is_done(&reader) && output->len == size && !memcmp(output->data, data, size),
+            "frame of %ld bytes, level %d", (long)size, level);
+  nj_lz_reader_destroy(&reader);
+
+  for (int i = 0; i < 8; ++i) {
+    njsp offset = check_random(frame->len);
+    nju8 bit = (nju8)(1 << check_random(8));
+    frame->data[offset] ^= bit;
+    output->len = 0;
+    NJ_CHECK_RETURN(nj_lz_reader_init(&reader, &g_check_allocator, check_sink_write, output));
+    nj_lz_reader_feed(&reader, frame->data, frame->len);
+    nj_lz_reader_destroy(&reader);
+    frame->data[offset] ^= bit;
+  }
+}
+
+// Blocks and frames at both levels round trip, a too small output buffer is
+// an error and invalid data is handled.
+static bool check_lz() {
+  const njsp max_size = 300000;
+  nju8* data = (nju8*)g_check_allocator.alloc(max_size);
+  nju8* compressed = (nju8*)g_check_allocator.alloc(2 * nj_lz_compress_bound(max_size));
+  nju8* output = (nju8*)g_check_allocator.alloc(2 * max_size);
+  NJ_CHECK_RETURN_VAL(data && compressed && output, false);
+  check_sink_t frame = {compressed, 0, 2 * nj_lz_compress_bound(max_size)};
+  check_sink_t frame_output = {output, 0, 2 * max_size};
+  nj_lz_encoder_t encoders[2];
+  NJ_CHECK_RETURN_VAL(nj_lz_encoder_init(&encoders[0], &g_check_allocator, NJ_LZ_LEVEL_FAST), false);
+  NJ_CHECK_RETURN_VAL(nj_lz_encoder_init(&encoders[1], &g_check_allocator, NJ_LZ_LEVEL_HIGH), false);
+  int fail_count = g_check_fail_count;
+  for (njsp size : gc_lz_sizes) {
+    for (int kind = 0; kind < 22; ++kind) {
+      check_lz_fill(data, size, kind);
+      for (nj_lz_encoder_t& encoder : encoders) {
+        check_lz_block(&encoder, data, size, compressed, output);
+        check_lz_frame(encoder.level, data, size, &frame, &frame_output);
+      }
+    }
+  }
+  nj_lz_encoder_destroy(&encoders[1]);
+  nj_lz_encoder_destroy(&encoders[0]);
+  g_check_allocator.free(output);
+  g_check_allocator.free(compressed);
+  g_check_allocator.free(data);
+  return g_check_fail_count == fail_count;
+}
+
+struct check_inflate_stream_t {
+  const char* name;
+  nj_inflate_format_t format;
+  const nju8* data;
+  njsp size;
+  njsp output_size;
+  nju32 output_crc;
+};
+
+// Flips |xor| bits of a valid stream at |offset|, from the end if negative.
+struct check_inflate_patch_t {
+  const char* name;
+  int stream;
+  njsp offset;
+  nju8 xor_bits;
+};
+
+#include "tools/check_inflate_streams.inl"
+
+enum check_split_t {
+  CHECK_SPLIT_NONE,
+  CHECK_SPLIT_BYTES,
+  CHECK_SPLIT_RANDOM,
+};
+
+// Decodes |size| bytes of |data| fed in pieces by |split|. The output is
+// taken whenever the window is full if |output| isn't NULL, otherwise it must
+// all fit in the window. |*in_used| is the input consumed.
+static nj_inflate_status_t check_inflate_decode(nj_inflate_format_t format, const nju8* data, njsp size, nju8* window, njsp window_size, check_split_t split, check_sink_t* output, njsp* in_used) {
+  nj_inflate_t* inflate = (nj_inflate_t*)g_check_allocator.alloc(sizeof(nj_inflate_t));
+  NJ_CHECK_RETURN_VAL(inflate, NJ_INFLATE_STATUS_ERROR);
+  nj_inflate_init(inflate, format, window, window_size);
+  nj_inflate_status_t status = NJ_INFLATE_STATUS_NEED_INPUT;
+  *in_used = 0;
+  while (true) {
+    njsp piece = size - *in_used;
+    if (split == CHECK_SPLIT_BYTES)
+      piece = nj_min(piece, (njsp)1);
+    else if (split == CHECK_SPLIT_RANDOM)
+      piece = nj_min(piece, 1 + check_random(2000));
+    njsp used = 0;
+    status = nj_inflate_decode(inflate, data + *in_used, piece, &used);
+    *in_used += used;
+    // Only a full window or the end of the stream leave input unconsumed.
+    if (status == NJ_INFLATE_STATUS_NEED_INPUT && used != piece) {
+      NJ_EXPECT(false, "%ld of %ld bytes consumed with more input needed", (long)used, (long)piece);
+      status = NJ_INFLATE_STATUS_ERROR;
+      break;
+    }
+    if (status == NJ_INFLATE_STATUS_OUTPUT_FULL && !output)
+      break;
+    if (output && (status == NJ_INFLATE_STATUS_OUTPUT_FULL || status == NJ_INFLATE_STATUS_DONE)) {
+      const nju8* taken;
+      njsp taken_size;
+      nj_inflate_take_output(inflate, &taken, &taken_size);
+      if (!check_sink_write(output, taken, taken_size)) {
+        status = NJ_INFLATE_STATUS_ERROR;
+        break;
+      }
+    }
+    if (status == NJ_INFLATE_STATUS_DONE || status == NJ_INFLATE_STATUS_ERROR)
+      break;
+    if (status == NJ_INFLATE_STATUS_NEED_INPUT && *in_used == size)
+      break;
+  }
+  g_check_allocator.free(inflate);
+  return status;
+}
+
+// The checksums match the values of their specifications and each valid
+// stream decodes to the output zlib compressed, whole in the window or
+// streamed through the smallest window, with the input split anywhere.
+// Truncated streams need more input, invalid ones are errors and corrupted
+// ones are handled.
+static bool check_inflate() {
+  const njsp max_output_size = 300000;
+  const njsp max_input_size = 2048;
+  const njsp stream_window_size = 2 * NJ_INFLATE_HISTORY_SIZE;
+  nju8* window = (nju8*)g_check_allocator.alloc(max_output_size);
+  nju8* input = (nju8*)g_check_allocator.alloc(max_input_size + 2);
+  nju8* output_data = (nju8*)g_check_allocator.alloc(max_output_size);
+  NJ_CHECK_RETURN_VAL(window && input && output_data, false);
+  int fail_count = g_check_fail_count;
+
+  const nju8* digits = (const nju8*)"123456789";
+  NJ_EXPECT(nj_crc32(0, digits, 9) == 0xcbf43926u, "CRC-32 of \"123456789\"");
+  NJ_EXPECT(nj_crc32(nj_crc32(0, digits, 4), digits + 4, 5) == 0xcbf43926u, "CRC-32 continued");
+  NJ_EXPECT(nj_adler32(1, (const nju8*)"Wikipedia", 9) == 0x11e60398u, "Adler-32 of \"Wikipedia\"");
+  NJ_EXPECT(nj_adler32(nj_adler32(1, digits, 4), digits + 4, 5) == nj_adler32(1, digits, 9), "Adler-32 continued");
+  // Up to 3 times the modulo so the sums wrap, all 0xff for the largest sums.
+  for (int i = 0; i < 200; ++i) {
+    njsp size = check_random(3 * 65521);
+    njsp split = check_random(size + 1);
+    memset(output_data, 0xff, size);
+    if (i % 2)
+      check_lz_fill(output_data, size, 0);
+    nju32 adler = nj_adler32(1, output_data, size);
+    nju32 combined = nj_adler32_combine(nj_adler32(1, output_data, split), nj_adler32(1, output_data + split, size - split), size - split);
+    NJ_EXPECT(combined == adler, "Adler-32 of %ld bytes combined at %ld", (long)size, (long)split);
+  }
+
+  for (const check_inflate_stream_t& stream : gc_inflate_streams) {
+    // Bytes after the end of the stream must not be consumed.
+    memcpy(input, stream.data, stream.size);
+    input[stream.size] = 0xaa;
+    input[stream.size + 1] = 0xbb;
+    for (int split = CHECK_SPLIT_NONE; split <= CHECK_SPLIT_RANDOM; ++split) {
+      for (int is_streamed = 0; is_streamed < 2; ++is_streamed) {
+        check_sink_t output = {output_data, 0, max_output_size};
+        njsp in_used = 0;
+        njsp window_size = is_streamed ? stream_window_size : stream.output_size;
+        nj_inflate_status_t status = check_inflate_decode(stream.format, input, stream.size + 2, window, window_size, (check_split_t)split, &output, &in_used);
+        NJ_EXPECT(status == NJ_INFLATE_STATUS_DONE && in_used == stream.size && output.len == stream.output_size &&
+                      nj_crc32(0, output.data, output.len) == stream.output_crc,
+                  "%s, split %d, window of %ld bytes, status %d", stream.name, split, (long)window_size, status);
+      }
+    }
+    njsp in_used = 0;
+    if (stream.output_size) {
+      NJ_EXPECT(check_inflate_decode(stream.format, input, stream.size, window, stream.output_size - 1, CHECK_SPLIT_NONE, NULL, &in_used) == NJ_INFLATE_STATUS_OUTPUT_FULL,
+                "%s in a window one byte too small", stream.name);
+    }
+    for (njsp size = 0; size < stream.size; size += 1 + size / 8) {
+      check_sink_t output = {output_data, 0, max_output_size};
+      NJ_EXPECT(check_inflate_decode(stream.format, input, size, window, stream_window_size, CHECK_SPLIT_NONE, &output, &in_used) == NJ_INFLATE_STATUS_NEED_INPUT,
+                "%s truncated to %ld bytes", stream.name, (long)size);
+    }
+    for (int i = 0; i < 64; ++i) {
+      njsp offset = check_random(stream.size);
+      input[offset] ^= (nju8)(1 << check_random(8));
+      check_sink_t output = {output_data, 0, max_output_size};
+      check_inflate_decode(stream.format, input, stream.size, window, stream_window_size, CHECK_SPLIT_NONE, &output, &in_used);
+      input[offset] = stream.data[offset];
+    }
+  }
+
+  for (const check_inflate_stream_t& stream : gc_inflate_invalid_streams) {
+    njsp in_used = 0;
+    NJ_EXPECT(check_inflate_decode(stream.format, stream.data, stream.size, window, max_output_size, CHECK_SPLIT_NONE, NULL, &in_used) == NJ_INFLATE_STATUS_ERROR,
+              "invalid %s", stream.name);
+  }
+  for (const check_inflate_patch_t& patch : gc_inflate_patches) {
+    const check_inflate_stream_t& stream = gc_inflate_streams[patch.stream];
+    memcpy(input, stream.data, stream.size);
+    input[patch.offset < 0 ? stream.size + patch.offset : patch.offset] ^= patch.xor_bits;
+    njsp in_used = 0;
+    NJ_EXPECT(check_inflate_decode(stream.format, input, stream.size, window, max_output_size, CHECK_SPLIT_NONE, NULL, &in_used) == NJ_INFLATE_STATUS_ERROR,
+              "invalid %s", patch.name);
+  }
+
+  g_check_allocator.free(output_data);
+  g_check_allocator.free(input);
+  g_check_allocator.free(window);
+  return g_check_fail_count == fail_count;
+}
+
+// Data of each kind compressed in up to 4 segments round trips whole in every
+// format, and each segment inflates on its own as a raw stream from the size
+// reported before it.
+static bool check_deflate() {
+  const njsp max_size = 300000;
+  const int max_segment_count = 4;
+  const njsp capacity = nj_deflate_compress_bound(max_size, max_segment_count);
+  nju8* data = (nju8*)g_check_allocator.alloc(max_size);
+  nju8* compressed = (nju8*)g_check_allocator.alloc(capacity);
+  nju8* window = (nju8*)g_check_allocator.alloc(max_size);
+  NJ_CHECK_RETURN_VAL(data && compressed && window, false);
+  int fail_count = g_check_fail_count;
+  for (njsp size : gc_lz_sizes) {
+    for (int kind = 0; kind < 22; kind += 1 + kind / 4) {
+      check_lz_fill(data, size, kind);
+      for (int format = NJ_INFLATE_FORMAT_RAW; format <= NJ_INFLATE_FORMAT_GZIP; ++format) {
+        int segment_count = 1 + (int)check_random(max_segment_count);
+        njsp data_offsets[max_segment_count + 1];
+        data_offsets[0] = 0;
+        for (int i = 1; i < segment_count; ++i)
+          data_offsets[i] = nj_max(data_offsets[i - 1], (njsp)check_random(size + 1));
+        data_offsets[segment_count] = size;
+        njsp offsets[max_segment_count + 1];
+        nj_deflate_t deflate;
+        NJ_CHECK_RETURN_VAL(nj_deflate_init(&deflate, &g_check_allocator, (nj_inflate_format_t)format, compressed, capacity), false);
+        bool rv = true;
+        for (int i = 0; rv && i < segment_count; ++i) {
+          offsets[i] = nj_deflate_get_size(&deflate);
+          rv = nj_deflate_write_segment(&deflate, data + data_offsets[i], data_offsets[i + 1] - data_offsets[i], i == segment_count - 1);
+        }
+        offsets[segment_count] = nj_deflate_get_size(&deflate);
+        nj_deflate_destroy(&deflate);
+        NJ_EXPECT(rv && offsets[segment_count] <= capacity, "%ld bytes of kind %d in %d segments, format %d", (long)size, kind, segment_count, format);
+        if (!rv)
+          continue;
+        if (kind == 1 && size >= 65536)
+          NJ_EXPECT(offsets[segment_count] < size / 32, "%ld zeros compressed to %ld bytes", (long)size, (long)offsets[segment_count]);
+
+        njsp in_used = 0;
+        nj_inflate_status_t status = check_inflate_decode((nj_inflate_format_t)format, compressed, offsets[segment_count], window, nj_max(size, (njsp)1),
+                                                          (check_split_t)check_random(3), NULL, &in_used);
+        NJ_EXPECT(status == NJ_INFLATE_STATUS_DONE && in_used == offsets[segment_count] && !memcmp(window, data, size),
+                  "%ld bytes of kind %d in %d segments, format %d, status %d", (long)size, kind, segment_count, format, status);
+        for (int i = 0; i < segment_count; ++i) {
+          njsp segment_size = data_offsets[i + 1] - data_offsets[i];
+          status = check_inflate_decode(NJ_INFLATE_FORMAT_RAW, compressed + offsets[i], offsets[i + 1] - offsets[i], window, nj_max(segment_size, (njsp)1),
+                                        CHECK_SPLIT_NONE, NULL, &in_used);
+          bool is_last = i == segment_count - 1;
+          NJ_EXPECT((is_last ? status == NJ_INFLATE_STATUS_DONE : status == NJ_INFLATE_STATUS_NEED_INPUT) && !memcmp(window, data + data_offsets[i], segment_size),
+                    "segment %d of %d, %ld bytes of kind %d, format %d, status %d", i, segment_count, (long)size, kind, format, status);
+        }
+      }
+    }
+  }
+  g_check_allocator.free(window);
+  g_check_allocator.free(compressed);
+  g_check_allocator.free(data);
+  return g_check_fail_count == fail_count;
+}
+
+// Rows of random widths unfiltered by the kernels of each CPU feature level
+// against the scalar ones, for every filter and bytes per pixel. The levels
+// the CPU doesn't have are skipped. Each row is unfiltered on top of the
+// previous one and the bytes after the row must not be written.
+static bool check_unfilter() {
+  const int bpps[] = {1, 2, 3, 4, 6, 8};
+  const njsp max_size = 1000;
+  const njsp row_count = 64;
+  nju8* src = (nju8*)g_check_allocator.alloc(max_size);
+  nju8* expected = (nju8*)g_check_allocator.alloc(2 * (max_size + 16));
+  nju8* actual = (nju8*)g_check_allocator.alloc(2 * (max_size + 16));
+  NJ_CHECK_RETURN_VAL(src && expected && actual, false);
+  int fail_count = g_check_fail_count;
+
+  nj_cpu_features_t cpu;
+  nj_cpu_get_features(&cpu);
+  nj_cpu_features_t levels[4] = {};
+  levels[1].has_sse2 = cpu.has_sse2;
+  levels[2] = levels[1];
+  levels[2].has_ssse3 = cpu.has_ssse3;
+  levels[3] = cpu;
+  nj_png_unfilter_t scalar;
+  nj_png_unfilter_t simd;
+  for (int bpp : bpps) {
+    NJ_CHECK_RETURN_VAL(nj_png_unfilter_init(&scalar, bpp, &levels[0]), false);
+    for (int level = 1; level < 4; ++level) {
+      NJ_CHECK_RETURN_VAL(nj_png_unfilter_init(&simd, bpp, &levels[level]), false);
+      for (int filter = 0; filter < NJ_PNG_FILTER_COUNT; ++filter) {
+        // The two rows are swapped after each row, the first row has a
+        // previous row of 0.
+        memset(expected, 0, 2 * (max_size + 16));
+        memset(actual, 0, 2 * (max_size + 16));
+        for (njsp row = 0; row < row_count; ++row) {
+          // Small sizes first, then up to |max_size|, all whole pixels.
+          njsp size = row < 40 ? row * bpp : check_random(max_size / bpp + 1) * bpp;
+          // Smooth rows like the deltas of a photo, then random ones.
+          for (njsp i = 0; i < size; ++i)
+            src[i] = row % 2 ? (nju8)check_xorshift() : (nju8)(check_random(5) - 2);
+          njsp cur = (row & 1) * (max_size + 16);
+          njsp prev = (max_size + 16) - cur;
+          memset(expected + cur, 0xcd, max_size + 16);
+          memset(actual + cur, 0xcd, max_size + 16);
+          // The previous row is shorter or longer, its bytes past its end are
+          // 0xcd then.
+          nj_png_unfilter_row(&scalar, filter, expected + cur, src, expected + prev, size);
+          nj_png_unfilter_row(&simd, filter, actual + cur, src, actual + prev, size);
+          if (memcmp(expected + cur, actual + cur, max_size + 16)) {
+            NJ_EXPECT(false, "filter %d, %d bytes per pixel, level %d, row %ld of %ld bytes", filter, bpp, level, (long)row, (long)size);
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  g_check_allocator.free(actual);
+  g_check_allocator.free(expected);
+  g_check_allocator.free(src);
+  return g_check_fail_count == fail_count;
+}
+
+struct check_png_image_t {
+  nju32 width;
+  nju32 height;
+  nju32 bit_depth;
+  nj_png_color_type_t color_type;
+  int channel_count;
+};
+
+static const check_png_image_t gc_png_images[] = {
+    {1, 1, 8, NJ_PNG_COLOR_TYPE_RGBA, 4},      {97, 33, 1, NJ_PNG_COLOR_TYPE_GRAY, 1},   {64, 64, 4, NJ_PNG_COLOR_TYPE_PALETTE, 1},
+    {300, 200, 8, NJ_PNG_COLOR_TYPE_RGB, 3},   {257, 129, 16, NJ_PNG_COLOR_TYPE_RGBA, 4}, {50, 400, 8, NJ_PNG_COLOR_TYPE_GRAY_ALPHA, 2},
+    {200, 150, 16, NJ_PNG_COLOR_TYPE_GRAY, 1}, {640, 480, 8, NJ_PNG_COLOR_TYPE_RGBA, 4},
+};
+
+// Images of each format encoded in up to 8 segments decode to their pixels in
+// a batch on the job system's workers and one by one serially. A copy whose
+// second segment has the wrong offset is decoded serially by the batch too.
+static bool check_png() {
+  const int image_count = sizeof(gc_png_images) / sizeof(gc_png_images[0]);
+  const int item_count = 2 * image_count;
+  nj_png_t pngs[image_count];
+  nju8* files[item_count] = {};
+  njsp file_sizes[item_count];
+  nj_png_batch_item_t items[item_count];
+  int fail_count = g_check_fail_count;
+  for (int i = 0; i < image_count; ++i) {
+    const check_png_image_t& image = gc_png_images[i];
+    nj_png_t* png = &pngs[i];
+    png->allocator = &g_check_allocator;
+    png->width = image.width;
+    png->height = image.height;
+    png->bit_depth = image.bit_depth;
+    png->bit_per_pixel = image.bit_depth * image.channel_count;
+    png->color_type = image.color_type;
+    png->row_size = (image.width * png->bit_per_pixel + 7) / 8;
+    njsp size = png->row_size * png->height;
+    png->data = (nju8*)g_check_allocator.alloc(size);
+    NJ_CHECK_RETURN_VAL(png->data, false);
+    check_lz_fill(png->data, size, i % 3 ? 2 + (int)check_random(20) : 0);
+    int segment_count = 1 + (int)check_random(8);
+    njsp capacity = nj_png_encode_bound(png, segment_count, 0);
+    files[2 * i] = (nju8*)g_check_allocator.alloc(capacity);
+    files[2 * i + 1] = (nju8*)g_check_allocator.alloc(capacity);
+    NJ_CHECK_RETURN_VAL(files[2 * i] && files[2 * i + 1], false);
+    file_sizes[2 * i] = file_sizes[2 * i + 1] = nj_png_encode(png, segment_count, NULL, 0, files[2 * i], capacity);
+    NJ_EXPECT(file_sizes[2 * i] >= 0, "encode %ux%u, color type %d, bit depth %u", image.width, image.height, image.color_type, image.bit_depth);
+    memcpy(files[2 * i + 1], files[2 * i], nj_max(file_sizes[2 * i], (njsp)0));
+    // The offset of the second segment in the "njSG" chunk after IHDR.
+    nju8* chunk = files[2 * i + 1] + 8 + 12 + 13;
+    if (file_sizes[2 * i] > 0 && !memcmp(chunk + 4, "njSG", 4))
+      ++chunk[8 + 4 + 4 + 3];
+    for (int j = 2 * i; j < 2 * i + 2; ++j) {
+      items[j].data = files[j];
+      items[j].size = file_sizes[j];
+      items[j].dst_size = size;
+      items[j].dst = (nju8*)g_check_allocator.alloc(size);
+      NJ_CHECK_RETURN_VAL(items[j].dst, false);
+    }
+  }
+
+  // Valid images with segments must be inflated by several workers, only the
+  // copies with a wrong segment offset fall back.
+  nj_png_stats_t expected_stats = {};
+  for (int i = 0; i < item_count; ++i) {
+    if (file_sizes[i] > 0 && !memcmp(files[i] + 8 + 12 + 13 + 4, "njSG", 4))
+      ++(i & 1 ? expected_stats.fallback_count : expected_stats.segmented_count);
+  }
+  nj_png_stats_t stats;
+  nj_png_stats_take(&stats);
+  nj_job_system_desc_t desc;
+  desc.worker_count = 4;
+  NJ_CHECK_RETURN_VAL(nj_job_system_init(&g_check_allocator, &desc), false);
+  for (int i = 0; i < item_count; ++i)
+    memset(items[i].dst, 0, items[i].dst_size);
+  NJ_EXPECT(nj_png_decode_batch(items, item_count, NULL, NULL), "batch of %d images", item_count);
+  for (int i = 0; i < item_count; ++i) {
+    const nj_png_t* png = &pngs[i / 2];
+    NJ_EXPECT(items[i].is_ok && items[i].png.width == png->width && items[i].png.height == png->height && !memcmp(items[i].dst, png->data, items[i].dst_size),
+              "image %d of the batch, %ux%u, color type %d, bit depth %u", i, png->width, png->height, png->color_type, png->bit_depth);
+  }
+  nj_png_stats_take(&stats);
+  NJ_EXPECT(expected_stats.segmented_count && stats.segmented_count == expected_stats.segmented_count && stats.fallback_count == expected_stats.fallback_count,
+            "%llu images segmented and %llu fell back instead of %llu and %llu", (unsigned long long)stats.segmented_count, (unsigned long long)stats.fallback_count,
+            (unsigned long long)expected_stats.segmented_count, (unsigned long long)expected_stats.fallback_count);
+  nj_parallel_set_enabled(false);
+  for (int i = 0; i < item_count; ++i) {
+    const nj_png_t* png = &pngs[i / 2];
+    nj_png_t decoded;
+    memset(items[i].dst, 0, items[i].dst_size);
+    NJ_EXPECT(nj_png_decode(&decoded, files[i], file_sizes[i], items[i].dst, items[i].dst_size, 0) && !memcmp(items[i].dst, png->data, items[i].dst_size),
+              "image %d decoded serially, %ux%u, color type %d, bit depth %u", i, png->width, png->height, png->color_type, png->bit_depth);
+  }
+  nj_png_stats_take(&stats);
+  NJ_EXPECT(!stats.segmented_count && !stats.fallback_count, "segments were inflated by several workers while disabled");
+  nj_parallel_set_enabled(true);
+  nj_job_system_destroy();
+
+  for (int i = item_count - 1; i >= 0; --i) {
+    g_check_allocator.free(items[i].dst);
+    g_check_allocator.free(files[i]);
+  }
+  for (int i = image_count - 1; i >= 0; --i)
+    g_check_allocator.free(pngs[i].data);
+  return g_check_fail_count == fail_count;
+}
+
+struct check_t {
+  const char* name;
+  bool (*func)();
+};
+
+static const check_t gc_checks[] = {
+    {"hash_table", check_hash_table},
+    {"slot_map", check_slot_map},
+    {"soa_array", check_soa_array},
+    {"queue", check_queue},
+    {"bitset", check_bitset},
+    {"sort", check_sort},
+    {"job", check_job},
+    {"parallel", check_parallel},
+    {"sync", check_sync},
+    {"task_graph", check_task_graph},
+    {"topology", check_topology},
+    {"timer_wheel", check_timer_wheel},
+    {"file_map", check_file_map},
+    {"aio", check_aio},
+    {"file", check_file},
+    {"aio_stream", check_aio_stream},
+    {"pack", check_pack},
+    {"bits", check_bits},
+    {"lz", check_lz},
+    {"inflate", check_inflate},
+    {"deflate", check_deflate},
+    {"unfilter", check_unfilter},
+    {"png", check_png},
+};
+
+int main(int argc, char** argv) {
+  nj_core_init(NJ_OS_LIT("check.log"));
+  NJ_CHECK_RETURN_VAL(g_check_allocator.init(), 1);
+  bool rv = true;
+  int run_count = 0;
+  for (const check_t& check : gc_checks) {
+    bool is_selected = argc == 1;
+    for (int i = 1; i < argc; ++i)
+      is_selected |= !strcmp(argv[i], check.name);
+    if (!is_selected)
+      continue;
+    ++run_count;
+    bool is_ok = check.func();
+    printf("%-10s %s\n", check.name, is_ok ? "ok" : "FAILED");
+    rv &= is_ok;
+  }
+  g_check_allocator.destroy();
+  if (!run_count) {
+    printf("Usage: check [name...]\n");
+    return 1;
+  }
+  return rv ? 0 : 1;
+}
@@ -0,0 +1,390 @@
+// Generated by gen_inflate_streams.py.
+
+static const nju8 gc_inflate_stored[] = {
+    0x78, 0x01, 0x01, 0x2c, 0x01, 0xd3, 0xfe, 0x6c, 0x69, 0x6e, 0x65, 0x20, 0x30, 0x3a, 0x20, 0x74,
+    0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66,
+    0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68,
+    0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x20, 0x30, 0x20, 0x74, 0x69, 0x6d,
+    0x65, 0x73, 0x0a, 0x6c, 0x69, 0x6e, 0x65, 0x20, 0x31, 0x3a, 0x20, 0x74, 0x68, 0x65, 0x20, 0x71,
+    0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20, 0x6a,
+    0x75, 0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61,
+    0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x20, 0x31, 0x20, 0x74, 0x69, 0x6d, 0x65, 0x73, 0x0a, 0x6c,
+    0x69, 0x6e, 0x65, 0x20, 0x32, 0x3a, 0x20, 0x74, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b,
+    0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73,
+    0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64,
+    0x6f, 0x67, 0x20, 0x34, 0x20, 0x74, 0x69, 0x6d, 0x65, 0x73, 0x0a, 0x6c, 0x69, 0x6e, 0x65, 0x20,
+    0x33, 0x3a, 0x20, 0x74, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f,
+    0x77, 0x6e, 0x20, 0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65,
+    0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x20, 0x39,
+    0x20, 0x74, 0x69, 0x6d, 0x65, 0x73, 0x0a, 0x6c, 0x69, 0x6e, 0x65, 0x20, 0x34, 0x3a, 0x20, 0x74,
+    0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63, 0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20, 0x66,
+    0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70, 0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74, 0x68,
+    0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20, 0x64, 0x6f, 0x67, 0x20, 0x31, 0x36, 0x20, 0x74, 0x69,
+    0x6d, 0x65, 0x73, 0x94, 0xba, 0x68, 0xc9,
+};
+static const nju8 gc_inflate_fixed[] = {
+    0x78, 0x01, 0xcb, 0xc9, 0xcc, 0x4b, 0x55, 0x30, 0xb0, 0x52, 0x28, 0xc9, 0x48, 0x55, 0x28, 0x2c,
+    0xcd, 0x4c, 0xce, 0x56, 0x48, 0x2a, 0xca, 0x2f, 0xcf, 0x53, 0x48, 0xcb, 0xaf, 0x50, 0xc8, 0x2a,
+    0xcd, 0x2d, 0x28, 0x56, 0xc8, 0x2f, 0x4b, 0x2d, 0x02, 0x4b, 0xe7, 0x24, 0x56, 0x55, 0x2a, 0xa4,
+    0xe4, 0xa7, 0x2b, 0x18, 0x28, 0x94, 0x64, 0xe6, 0xa6, 0x16, 0x73, 0xe5, 0x80, 0xf4, 0x1a, 0x92,
+    0xa6, 0xd7, 0x10, 0x59, 0xaf, 0x11, 0x69, 0x7a, 0x4d, 0x90, 0xf5, 0x1a, 0x93, 0xa6, 0xd7, 0x12,
+    0x59, 0xaf, 0x09, 0x89, 0x6e, 0x36, 0x43, 0xd6, 0x6c, 0x4a, 0x9a, 0x66, 0x23, 0x53, 0x64, 0xcd,
+    0x66, 0xa4, 0x69, 0x36, 0x46, 0xb1, 0xd9, 0x9c, 0xc4, 0xe0, 0x42, 0xf1, 0xb3, 0x05, 0x69, 0x9a,
+    0xcd, 0x50, 0x02, 0xdb, 0x92, 0x34, 0xcd, 0x16, 0x28, 0xb1, 0x6c, 0x48, 0x62, 0xf2, 0x32, 0x46,
+    0xd1, 0x4c, 0x62, 0xfa, 0x32, 0x42, 0x71, 0xb7, 0x21, 0xa9, 0x29, 0xcc, 0x1c, 0x45, 0x37, 0x89,
+    0x69, 0xcc, 0xdc, 0x08, 0x45, 0x37, 0x89, 0xa9, 0x0c, 0x55, 0x33, 0x89, 0xa9, 0xcc, 0x18, 0x35,
+    0xc4, 0x49, 0x4c, 0x66, 0x66, 0xa8, 0x76, 0x93, 0x98, 0xce, 0x2c, 0x51, 0x52, 0xb8, 0x21, 0x89,
+    0x09, 0xcd, 0x18, 0x35, 0xba, 0x49, 0x4c, 0x69, 0xe6, 0x28, 0x65, 0x91, 0x11, 0x89, 0x29, 0xcd,
+    0x10, 0xc5, 0xdf, 0x46, 0x24, 0x26, 0x35, 0x53, 0x14, 0x97, 0x1b, 0x91, 0x98, 0xd4, 0x2c, 0x51,
+    0xb2, 0xb6, 0x11, 0x89, 0x49, 0xcd, 0x04, 0x25, 0x99, 0x1b, 0x91, 0x98, 0xd4, 0x2c, 0x51, 0x4b,
+    0x61, 0x12, 0xd3, 0x9a, 0x09, 0xaa, 0xbf, 0x49, 0x4c, 0x6b, 0x96, 0xa8, 0x2e, 0x27, 0x31, 0xad,
+    0x99, 0xa2, 0xc6, 0x37, 0x89, 0x69, 0xcd, 0x02, 0x45, 0x33, 0x89, 0x49, 0xcd, 0x0c, 0x25, 0x99,
+    0x1b, 0x93, 0x98, 0xd4, 0x8c, 0x50, 0x4a, 0x16, 0x63, 0x12, 0x93, 0x9a, 0x05, 0x8a, 0xcb, 0x8d,
+    0x49, 0x4c, 0x6a, 0xa6, 0xa8, 0x15, 0x27, 0x89, 0x49, 0xcd, 0x08, 0x25, 0x93, 0x18, 0x93, 0x98,
+    0xd4, 0x2c, 0x50, 0x2a, 0x21, 0x63, 0x12, 0x93, 0x9a, 0x19, 0x4a, 0x42, 0x35, 0x26, 0xb5, 0xf6,
+    0x44, 0x8d, 0x31, 0x12, 0x93, 0x9a, 0x21, 0xaa, 0xdd, 0xa4, 0x26, 0x35, 0x94, 0xec, 0x6d, 0x4c,
+    0x6a, 0x5a, 0x43, 0xd1, 0x6d, 0x42, 0x62, 0x5a, 0x33, 0x41, 0x49, 0x2d, 0x26, 0x24, 0xa6, 0x35,
+    0x63, 0x94, 0xf8, 0x36, 0x21, 0x31, 0xad, 0x19, 0xa2, 0xda, 0x4d, 0x62, 0x5a, 0x43, 0xf5, 0x36,
+    0xa9, 0xa5, 0x1a, 0x4a, 0xb9, 0x64, 0x42, 0x62, 0x52, 0xb3, 0x40, 0x49, 0x2c, 0x26, 0x24, 0x26,
+    0x35, 0x73, 0xd4, 0xf6, 0x25, 0x89, 0x49, 0xcd, 0x1c, 0xd5, 0x6e, 0x12, 0x93, 0x9a, 0x39, 0xaa,
+    0xbf, 0x2d, 0x29, 0xd1, 0x6d, 0x6a, 0x40, 0x89, 0xcb, 0x4d, 0x0d, 0x29, 0x09, 0x35, 0x53, 0x23,
+    0x4a, 0x62, 0xcc, 0xd4, 0x98, 0x92, 0xd4, 0x62, 0x6a, 0x42, 0x41, 0x42, 0x35, 0x35, 0xa5, 0x24,
+    0x8f, 0x98, 0x9a, 0x51, 0x92, 0x3f, 0x4d, 0xcd, 0x29, 0x29, 0x1b, 0x4c, 0x2d, 0x28, 0x29, 0x97,
+    0x4c, 0x2d, 0x29, 0x29, 0x13, 0xcd, 0x0c, 0x28, 0x29, 0x8f, 0xcd, 0x0c, 0x29, 0xa9, 0x0b, 0xcc,
+    0x8c, 0x28, 0xa9, 0x87, 0xcc, 0x8c, 0x29, 0xa9, 0x03, 0xcd, 0x4c, 0x28, 0xa9, 0x7f, 0xcd, 0x4c,
+    0x29, 0xa9, 0xfb, 0xcd, 0xcc, 0x28, 0x69, 0x77, 0x98, 0x99, 0x53, 0xd2, 0xe6, 0x31, 0xb3, 0xa0,
+    0xa4, 0xbd, 0x65, 0x66, 0x49, 0x41, 0x53, 0xcf, 0xdc, 0x80, 0x92, 0x56, 0xa6, 0xb9, 0x21, 0x25,
+    0x2d, 0x5c, 0x73, 0x23, 0x4a, 0x5a, 0xd7, 0xe6, 0xc6, 0x94, 0xb4, 0xec, 0xcd, 0x4d, 0x28, 0xe9,
+    0x55, 0x98, 0x9b, 0x52, 0xd2, 0xa3, 0x31, 0x37, 0xa3, 0xa4, 0x37, 0x65, 0x6e, 0x4e, 0x49, 0x4f,
+    0xce, 0xdc, 0x82, 0x92, 0x5e, 0xa4, 0xb9, 0x25, 0x25, 0x3d, 0x58, 0x0b, 0x03, 0x4a, 0x7a, 0xcf,
+    0x16, 0x86, 0x94, 0xf4, 0xdc, 0x2d, 0x8c, 0x28, 0x19, 0x35, 0xb0, 0x30, 0xa6, 0x60, 0xc0, 0xc2,
+    0xc2, 0x84, 0x92, 0xb1, 0x12, 0x0b, 0x53, 0x4a, 0xc6, 0x69, 0x2c, 0xcc, 0x28, 0x19, 0x23, 0xb2,
+    0x30, 0xa7, 0x60, 0x78, 0xca, 0xc2, 0x82, 0x92, 0x91, 0x31, 0x0b, 0x4b, 0x8a, 0x06, 0xe5, 0x0c,
+    0x28, 0x19, 0x0f, 0xb4, 0x34, 0xa4, 0x64, 0x28, 0xd2, 0xd2, 0x88, 0x92, 0x51, 0x50, 0x4b, 0x63,
+    0x4a, 0x06, 0x60, 0x2d, 0x4d, 0x28, 0x18, 0xfa, 0xb5, 0x34, 0xa5, 0x60, 0xcc, 0xd9, 0xd2, 0x8c,
+    0x82, 0xc1, 0x6e, 0x4b, 0x73, 0x0a, 0x46, 0xd9, 0x2d, 0x2d, 0x28, 0xb1, 0xd9, 0x92, 0x02, 0x3f,
+    0x1b, 0x1a, 0x18, 0x50, 0x10, 0xdc, 0x86, 0x06, 0x86, 0x94, 0x44, 0xb5, 0xa1, 0x01, 0x45, 0xe9,
+    0xcc, 0xd0, 0xc0, 0x98, 0x92, 0x44, 0x6e, 0x68, 0x60, 0x42, 0x49, 0x0e, 0x33, 0x34, 0x30, 0xa5,
+    0x24, 0x7b, 0x1b, 0x1a, 0x98, 0x51, 0x36, 0xea, 0x4e, 0x49, 0xb9, 0x66, 0x68, 0x60, 0x41, 0xd1,
+    0xb8, 0xbb, 0x81, 0x25, 0x45, 0x03, 0xef, 0xa4, 0x4e, 0x19, 0xa0, 0x8d, 0xbc, 0x93, 0x3c, 0x69,
+    0x80, 0xaa, 0x9b, 0xa2, 0x5a, 0xd4, 0x90, 0xd4, 0x59, 0x03, 0xb4, 0xc1, 0x77, 0x52, 0xa7, 0x0d,
+    0xd0, 0x46, 0xdf, 0x49, 0x9e, 0x38, 0x40, 0x9b, 0x6d, 0x31, 0xa3, 0xa4, 0xe5, 0x64, 0x68, 0x48,
+    0x51, 0xb3, 0xcd, 0x90, 0xd4, 0xb9, 0x03, 0x53, 0x34, 0xc7, 0x5b, 0x52, 0xd2, 0x60, 0x35, 0x24,
+    0x75, 0xf6, 0xc0, 0x04, 0x6d, 0xaa, 0xc9, 0x90, 0x92, 0xa6, 0xba, 0xa1, 0x11, 0x45, 0xfd, 0x04,
+    0x43, 0x52, 0x27, 0x10, 0x2c, 0xd1, 0x1c, 0x6f, 0x42, 0x49, 0x0f, 0xc9, 0x90, 0xd4, 0x29, 0x04,
+    0x0b, 0x54, 0xdd, 0x66, 0x94, 0xf4, 0x0c, 0x0d, 0x8d, 0x28, 0xea, 0x96, 0x1a, 0x92, 0x3c, 0x89,
+    0x80, 0xe6, 0x78, 0x4b, 0x4a, 0x3a, 0xe4, 0x86, 0x24, 0xcf, 0x23, 0xa0, 0xe6, 0x18, 0x92, 0x27,
+    0x12, 0x50, 0x6b, 0x28, 0x63, 0x8a, 0xc6, 0x41, 0x0c, 0x49, 0x9d, 0x4a, 0x40, 0x1d, 0x84, 0x31,
+    0x24, 0x75, 0x2e, 0xc1, 0x10, 0xcd, 0x76, 0x53, 0x4a, 0x86, 0x9f, 0x0c, 0x49, 0x9d, 0x4d, 0x30,
+    0x43, 0xd3, 0x4e, 0xd1, 0xc0, 0x9b, 0x21, 0xa9, 0xf3, 0x09, 0xc6, 0x68, 0xf1, 0x6e, 0x49, 0xc9,
+    0x90, 0xa3, 0x21, 0xa9, 0x33, 0x0a, 0xa8, 0x5e, 0x27, 0x75, 0x46, 0x01, 0x75, 0xa8, 0xd5, 0xd0,
+    0x84, 0xa2, 0x71, 0x5e, 0x43, 0x52, 0xe7, 0x14, 0x50, 0x07, 0x99, 0x0d, 0x49, 0x9d, 0x55, 0x30,
+    0x47, 0xb3, 0xdd, 0x94, 0x92, 0xe1, 0x75, 0x43, 0x92, 0xe7, 0x15, 0xd0, 0xb4, 0x9b, 0x53, 0xe6,
+    0x78, 0x0b, 0xca, 0x82, 0xce, 0x92, 0xa2, 0x88, 0x23, 0x75, 0x6e, 0x01, 0x2d, 0xd9, 0x90, 0x3a,
+    0xb9, 0x80, 0x9a, 0x66, 0x4d, 0x29, 0x9a, 0xc7, 0x32, 0x24, 0x75, 0x76, 0x01, 0x2d, 0xbb, 0x92,
+    0x3a, 0xbd, 0x80, 0x56, 0x58, 0x90, 0x3a, 0xc1, 0x80, 0x56, 0x54, 0x91, 0x3a, 0xc3, 0x80, 0x56,
+    0x50, 0x9a, 0x52, 0x34, 0x71, 0x6a, 0x48, 0xea, 0x1c, 0x03, 0x5a, 0x25, 0x41, 0xea, 0x24, 0x03,
+    0x5a, 0x15, 0x45, 0xea, 0x2c, 0x03, 0x5a, 0x05, 0x49, 0xea, 0x34, 0x03, 0x5a, 0xf5, 0x6c, 0x46,
+    0xd1, 0x4c, 0xbd, 0x21, 0xc9, 0x13, 0x0d, 0xa8, 0xc9, 0x86, 0xe4, 0x99, 0x06, 0xd4, 0x86, 0x11,
+    0xa9, 0x53, 0x0d, 0x68, 0xcd, 0x32, 0x92, 0xe7, 0x1a, 0x50, 0x75, 0x53, 0xb4, 0x30, 0xc4, 0x90,
+    0xd4, 0xc9, 0x06, 0xb4, 0xe6, 0x30, 0xa9, 0xb3, 0x0d, 0x68, 0x8d, 0x71, 0x52, 0xe7, 0x1b, 0xd0,
+    0xba, 0x02, 0xa4, 0x4e, 0x38, 0xa0, 0x75, 0x44, 0xcc, 0x29, 0x5a, 0x89, 0x64, 0x48, 0xea, 0x94,
+    0x03, 0x5a, 0x27, 0x8c, 0xd4, 0x39, 0x07, 0xb4, 0x2e, 0x20, 0xa9, 0x93, 0x0e, 0x68, 0x1d, 0x50,
+    0x52, 0x67, 0x1d, 0xd0, 0xba, 0xbf, 0xe6, 0x94, 0x2d, 0x7d, 0x23, 0x75, 0xde, 0x01, 0x7d, 0xdd,
+    0x9d, 0x25, 0x45, 0x03, 0x0f, 0xa4, 0xce, 0x3c, 0xa0, 0x5a, 0x4e, 0xea, 0xcc, 0x03, 0xda, 0x90,
+    0x8b, 0x05, 0x65, 0x2b, 0x2d, 0x49, 0x9e, 0x7b, 0x40, 0x4d, 0xf2, 0xa4, 0xce, 0x3e, 0xa0, 0xc6,
+    0x3a, 0xa9, 0xb3, 0x0f, 0x68, 0x03, 0x6d, 0xa4, 0x4e, 0x3f, 0xa0, 0x0d, 0xf3, 0x59, 0x50, 0xb4,
+    0xac, 0xd7, 0x90, 0xd4, 0x19, 0x08, 0xb4, 0x21, 0x4e, 0x52, 0xa7, 0x20, 0xd0, 0x06, 0x58, 0x49,
+    0x9d, 0x83, 0x40, 0x1b, 0xde, 0x25, 0x75, 0x12, 0x02, 0xd5, 0xeb, 0x96, 0x94, 0xac, 0x1f, 0x37,
+    0x24, 0x79, 0x12, 0x02, 0x55, 0xb7, 0x09, 0x25, 0x6b, 0xe6, 0x49, 0x9d, 0x85, 0x40, 0xb3, 0xdb,
+    0x8c, 0x22, 0x7f, 0x9b, 0x53, 0x14, 0xe6, 0x16, 0x94, 0x45, 0x38, 0xb9, 0xc9, 0x0d, 0x00, 0x2c,
+    0xa0, 0xb9, 0x01,
+};
+static const nju8 gc_inflate_dynamic[] = {
+    0x78, 0xda, 0xa5, 0x9a, 0x4b, 0x92, 0x14, 0x31, 0x0c, 0x44, 0xf7, 0x9c, 0xa2, 0x8e, 0x60, 0xf9,
+    0x23, 0x4b, 0xdc, 0x06, 0x98, 0x06, 0x1a, 0x7a, 0xa6, 0x61, 0x3e, 0x0c, 0x70, 0x7a, 0x02, 0x56,
+    0x9d, 0xda, 0x25, 0xb9, 0xae, 0x50, 0xd8, 0x2e, 0xa7, 0x2d, 0x29, 0x9f, 0x2f, 0xe7, 0x87, 0xd3,
+    0xd1, 0xde, 0x1e, 0xcf, 0x9f, 0x4f, 0xc7, 0xf7, 0x97, 0xf3, 0x87, 0xaf, 0xc7, 0xfb, 0xc7, 0xeb,
+    0xeb, 0xc3, 0xf1, 0xf1, 0xfa, 0xf3, 0xf8, 0xf2, 0x72, 0xff, 0xed, 0xe9, 0xb8, 0xfe, 0x38, 0x3d,
+    0xfe, 0xfb, 0x7c, 0x79, 0xf7, 0xfb, 0xd7, 0x71, 0x77, 0xfd, 0x74, 0xb4, 0xe3, 0xf9, 0x7c, 0x7f,
+    0x7a, 0x7a, 0x73, 0xf9, 0x1b, 0x6b, 0x5c, 0xac, 0xdd, 0xc6, 0x76, 0x2e, 0x76, 0xde, 0xc6, 0x0e,
+    0x2e, 0x36, 0x6f, 0x63, 0x27, 0x39, 0x67, 0xbf, 0x0d, 0x5e, 0x5c, 0x70, 0x5f, 0xb7, 0xc1, 0xce,
+    0x05, 0x0f, 0x18, 0x79, 0x93, 0xbf, 0x0b, 0xd6, 0x1c, 0x5c, 0xb0, 0xc3, 0xcf, 0x4e, 0x2e, 0x38,
+    0x60, 0x97, 0x8d, 0x94, 0xd7, 0x80, 0x60, 0x52, 0x5f, 0x1d, 0xe6, 0x6d, 0xac, 0xc2, 0x36, 0x44,
+    0x93, 0x1a, 0xdb, 0x1d, 0xa2, 0x49, 0x95, 0x61, 0x30, 0xa9, 0xb2, 0x81, 0x7f, 0x9c, 0x94, 0x99,
+    0xe3, 0xd8, 0xa4, 0xce, 0x12, 0x14, 0x6e, 0xa4, 0xd0, 0x06, 0x6e, 0x37, 0xa9, 0xb4, 0x0d, 0x77,
+    0x51, 0x27, 0x95, 0x66, 0xb0, 0xee, 0x4e, 0x4a, 0x6d, 0xc1, 0xcc, 0x3b, 0x29, 0xb5, 0x84, 0xa3,
+    0xdd, 0x49, 0xa9, 0x4d, 0x90, 0x79, 0x27, 0xa5, 0x96, 0x78, 0x0b, 0x93, 0x5a, 0x9b, 0xb8, 0x6e,
+    0x52, 0x6b, 0x89, 0x33, 0x27, 0xb5, 0xb6, 0x70, 0xbf, 0x49, 0xad, 0x05, 0x04, 0x93, 0x52, 0x73,
+    0x90, 0xf9, 0x20, 0xa5, 0xd6, 0xe1, 0x66, 0x19, 0xa4, 0xd4, 0x02, 0x66, 0x3e, 0x48, 0xa9, 0x2d,
+    0x4c, 0x9c, 0xa4, 0xd4, 0x3a, 0x1c, 0x92, 0x41, 0x4a, 0x2d, 0x20, 0x09, 0x0d, 0x52, 0x6a, 0x0e,
+    0x42, 0x1d, 0x6c, 0xf6, 0xc4, 0x1d, 0x23, 0xa5, 0x66, 0x38, 0x36, 0x2b, 0x35, 0x38, 0xde, 0x83,
+    0xd5, 0x1a, 0x44, 0x4f, 0x52, 0x6b, 0x13, 0xd4, 0x32, 0x49, 0xad, 0x0d, 0xd8, 0xef, 0x49, 0x6a,
+    0xcd, 0x70, 0x6c, 0x52, 0x6b, 0xb8, 0x6c, 0xf6, 0x56, 0x83, 0x7b, 0x69, 0x92, 0x52, 0x0b, 0x10,
+    0xcb, 0x24, 0xa5, 0xb6, 0xb1, 0xbe, 0x24, 0xa5, 0xb6, 0x71, 0x6c, 0x52, 0x6a, 0x1b, 0xd7, 0x9d,
+    0x4a, 0xf4, 0x6a, 0xca, 0xcc, 0x97, 0x29, 0x7f, 0x6d, 0x75, 0x65, 0xc7, 0xd6, 0x50, 0xd4, 0xb2,
+    0xa6, 0x20, 0xd4, 0xb5, 0x94, 0x33, 0xb2, 0x5c, 0x39, 0x9f, 0x6b, 0x2b, 0x77, 0xc3, 0x0a, 0xe5,
+    0x5e, 0x5a, 0xa9, 0xdc, 0x89, 0xde, 0x94, 0xfb, 0xd8, 0x4d, 0xc9, 0x05, 0xde, 0x95, 0x3c, 0xe4,
+    0x43, 0xc9, 0x81, 0x3e, 0x95, 0xfc, 0xeb, 0x4b, 0xc9, 0xfd, 0xee, 0x4a, 0xdd, 0xe1, 0x5b, 0xa9,
+    0x79, 0x3c, 0x94, 0x7a, 0xcb, 0x53, 0x28, 0xf5, 0x76, 0x53, 0xaa, 0xcc, 0x6d, 0x4a, 0x85, 0xbb,
+    0xbb, 0x52, 0x5d, 0xef, 0xa1, 0x54, 0xf6, 0x7b, 0x2a, 0x5d, 0xc5, 0x5e, 0x4a, 0x47, 0xb3, 0x5d,
+    0xe9, 0xa6, 0xf6, 0x56, 0x3a, 0xb9, 0x1d, 0x4a, 0x17, 0xb9, 0x53, 0xe9, 0x60, 0xa3, 0x29, 0xdd,
+    0x73, 0x98, 0xd2, 0xb9, 0x47, 0x57, 0x5c, 0x83, 0x18, 0x82, 0x61, 0x11, 0x53, 0xf1, 0x4a, 0x62,
+    0x29, 0x3e, 0x4d, 0xb8, 0xe2, 0x11, 0xc5, 0x16, 0xec, 0xa9, 0x08, 0xc5, 0x19, 0x8b, 0x94, 0x4c,
+    0xb9, 0xa6, 0xf8, 0x81, 0x69, 0x8a, 0x15, 0x99, 0x5d, 0x71, 0x41, 0x73, 0x28, 0x06, 0x6c, 0x4e,
+    0xc1, 0xfa, 0xcd, 0x25, 0x78, 0xce, 0xe9, 0x82, 0xd9, 0x9d, 0x5b, 0x70, 0xd9, 0x33, 0x94, 0x91,
+    0x53, 0x58, 0xb3, 0xb5, 0x26, 0xfc, 0x6e, 0x6b, 0xa6, 0x6c, 0xb5, 0x35, 0x49, 0x67, 0xd6, 0x86,
+    0x22, 0x72, 0x6b, 0x53, 0x39, 0x61, 0xd6, 0x96, 0x72, 0xbc, 0xad, 0xb9, 0xe6, 0xba, 0x2b, 0xf7,
+    0x9a, 0xb5, 0x90, 0x7c, 0xf7, 0x96, 0x92, 0xf1, 0xce, 0x22, 0x83, 0xe2, 0xbc, 0xd3, 0xd0, 0x00,
+    0xa3, 0xa5, 0x2c, 0x6a, 0x2c, 0x35, 0x28, 0xe6, 0x3b, 0x8b, 0x0d, 0x8a, 0xfb, 0x4e, 0x83, 0x83,
+    0x42, 0x5b, 0x5c, 0xa9, 0x9c, 0xcc, 0xa4, 0xb2, 0xcd, 0x58, 0x76, 0xb0, 0xca, 0xe4, 0x53, 0x29,
+    0x58, 0x8d, 0xa5, 0x07, 0xb3, 0xa0, 0x26, 0x53, 0x4a, 0x75, 0xeb, 0x52, 0x9f, 0x60, 0x2c, 0x40,
+    0xc8, 0x32, 0xf9, 0xa9, 0x74, 0x48, 0xc6, 0x22, 0x84, 0xc0, 0x68, 0x57, 0x3a, 0x43, 0xeb, 0x52,
+    0x5b, 0x6a, 0x34, 0x44, 0x28, 0x93, 0x4f, 0xa5, 0x21, 0x37, 0x9a, 0x23, 0xe0, 0x89, 0xa1, 0x41,
+    0x02, 0x66, 0xa8, 0x21, 0xf9, 0x20, 0xc6, 0xa2, 0x04, 0x34, 0x61, 0x8c, 0x65, 0x09, 0x56, 0x46,
+    0x5f, 0x8a, 0xfd, 0x64, 0x2c, 0x4d, 0xf0, 0x12, 0x2e, 0x19, 0x6f, 0xc6, 0xf2, 0x84, 0x51, 0xf6,
+    0x3d, 0x15, 0xcb, 0xd1, 0x58, 0xa2, 0x80, 0x4b, 0x67, 0x89, 0x02, 0x5a, 0xad, 0x36, 0x25, 0x9f,
+    0xd7, 0x58, 0xa6, 0x80, 0x26, 0xb3, 0xb1, 0x54, 0x61, 0x97, 0xd1, 0x97, 0x62, 0xaf, 0x1b, 0xcd,
+    0x15, 0x4a, 0xf8, 0xd6, 0x26, 0x1f, 0xda, 0xaf, 0x4b, 0x69, 0xe3, 0x58, 0xb6, 0x50, 0x64, 0xc3,
+    0xc2, 0x05, 0xd4, 0xec, 0x92, 0x38, 0x96, 0xb1, 0x74, 0xa1, 0x1c, 0x57, 0x16, 0x2f, 0x94, 0xcb,
+    0x82, 0x05, 0x0c, 0xe5, 0xaa, 0x62, 0x09, 0x43, 0xb9, 0x28, 0x97, 0x04, 0x4e, 0x8d, 0x65, 0x0c,
+    0x25, 0x49, 0xb0, 0x90, 0xa1, 0xa4, 0x28, 0x96, 0x32, 0x94, 0x04, 0xc9, 0x62, 0x86, 0x92, 0x9e,
+    0x5d, 0x22, 0xf5, 0x46, 0x83, 0x06, 0x94, 0x0d, 0x4d, 0x1a, 0xb0, 0x30, 0x62, 0x51, 0x43, 0x29,
+    0xcb, 0x68, 0xd6, 0x80, 0xd1, 0xd2, 0xc3, 0x10, 0x63, 0x61, 0x43, 0x29, 0x87, 0x59, 0xda, 0x50,
+    0x8a, 0x71, 0x96, 0x37, 0x94, 0x56, 0x80, 0x05, 0x0e, 0xa5, 0x11, 0xd9, 0xd2, 0x4b, 0x24, 0x63,
+    0x91, 0x43, 0x69, 0xc2, 0x58, 0xe6, 0x50, 0x5a, 0x40, 0x16, 0x3a, 0x94, 0x06, 0x94, 0xa5, 0x0e,
+    0xa5, 0xfd, 0xdd, 0xda, 0xd3, 0x37, 0x96, 0x3b, 0xd4, 0x77, 0x77, 0x29, 0x19, 0x0f, 0x2c, 0x79,
+    0xc0, 0xc1, 0x59, 0xf2, 0x50, 0x2c, 0x97, 0xd0, 0x5e, 0x5a, 0xd2, 0xec, 0x01, 0x25, 0xcf, 0xd2,
+    0x07, 0xdc, 0x75, 0x96, 0x3e, 0x14, 0xa3, 0x8d, 0xc5, 0x0f, 0xc5, 0xe6, 0x0b, 0xe9, 0x59, 0xaf,
+    0xb1, 0x04, 0xa2, 0x58, 0x9c, 0x2c, 0x82, 0x28, 0x06, 0x2b, 0xcb, 0x20, 0x8a, 0xbd, 0xcb, 0x42,
+    0x08, 0x5c, 0x7a, 0x2a, 0xef, 0xc7, 0x8d, 0x86, 0x10, 0x18, 0x3d, 0x95, 0x37, 0xf3, 0x2c, 0x85,
+    0x28, 0x63, 0xbb, 0xb4, 0xee, 0x2d, 0xfd, 0xf3, 0xd0, 0x36, 0xfc, 0x7f, 0xe5, 0xf6, 0x07, 0x2c,
+    0xa0, 0xb9, 0x01,
+};
+static const nju8 gc_inflate_blocks[] = {
+    0x94, 0xd4, 0x49, 0x12, 0xc2, 0x20, 0x10, 0x85, 0xe1, 0xbd, 0xa7, 0xe8, 0x23, 0x84, 0x26, 0x40,
+    0xf0, 0x36, 0x0e, 0xa8, 0xd1, 0x24, 0x68, 0x06, 0xa7, 0xd3, 0x5b, 0xba, 0xe2, 0x55, 0xb9, 0x79,
+    0xeb, 0xd4, 0x5f, 0x34, 0xf0, 0x91, 0xae, 0x1d, 0x92, 0x54, 0x6b, 0x99, 0x4f, 0x49, 0x6e, 0x4b,
+    0xbb, 0xbb, 0xc8, 0x76, 0xcc, 0x8f, 0x41, 0x0e, 0xf9, 0x29, 0xe7, 0xa5, 0xbf, 0x4e, 0x92, 0xef,
+    0x69, 0xfc, 0x7d, 0xee, 0x36, 0xef, 0x97, 0xec, 0xf3, 0x51, 0x2a, 0x99, 0xdb, 0x3e, 0x4d, 0xab,
+    0xee, 0xdb, 0x1a, 0xae, 0x35, 0x65, 0xab, 0x5c, 0x5b, 0x97, 0xad, 0xe5, 0xda, 0x58, 0xb6, 0x35,
+    0x39, 0xb3, 0x2f, 0x63, 0xc7, 0xc5, 0xea, 0xca, 0xd8, 0x73, 0xb1, 0x85, 0x95, 0x03, 0x79, 0x5c,
+    0xb0, 0xe7, 0x86, 0x8b, 0x3d, 0x1c, 0x76, 0xe4, 0xe2, 0x06, 0x6e, 0xd9, 0x90, 0xbc, 0x2c, 0xc4,
+    0xa4, 0x2f, 0x85, 0xb9, 0x0d, 0x2b, 0x2c, 0x40, 0x4d, 0x1a, 0x0b, 0x0a, 0x35, 0xa9, 0x0c, 0x63,
+    0x52, 0x99, 0xc5, 0x13, 0x27, 0x99, 0x79, 0x5c, 0x9b, 0x74, 0x16, 0x41, 0xb8, 0x21, 0xa1, 0x59,
+    0xbc, 0x6e, 0x52, 0x5a, 0x80, 0x7f, 0x91, 0x92, 0xd2, 0x0c, 0xec, 0x5b, 0x49, 0x6a, 0x0e, 0x26,
+    0x57, 0x92, 0x5a, 0x84, 0xa7, 0xad, 0x24, 0xb5, 0x1a, 0x98, 0xeb, 0x7f, 0x6a, 0x1f, 0x00, 0x00,
+    0x00, 0xff, 0xff, 0x94, 0xd6, 0xcb, 0x0d, 0xc0, 0x30, 0x08, 0x04, 0xd1, 0x9a, 0xec, 0x5d, 0x7f,
+    0xd2, 0x7f, 0x63, 0x39, 0xcf, 0x21, 0x52, 0xa6, 0x00, 0x84, 0x11, 0x0f, 0xf0, 0x77, 0x6e, 0x6e,
+    0x61, 0x69, 0xad, 0xac, 0x5b, 0x5a, 0x7b, 0xf8, 0x72, 0x69, 0x6d, 0xb1, 0xdf, 0xd2, 0xda, 0x45,
+    0xb0, 0xa4, 0xb6, 0xc1, 0x3c, 0x92, 0xda, 0xc4, 0x66, 0x89, 0xa4, 0x76, 0xf1, 0xf2, 0x48, 0x6a,
+    0x8b, 0x87, 0x53, 0x52, 0x9b, 0x18, 0x92, 0x48, 0x6a, 0x17, 0x47, 0x28, 0x92, 0xda, 0x06, 0xd4,
+    0xd8, 0xeb, 0xc9, 0x8e, 0x49, 0x6a, 0x83, 0xb9, 0x2d, 0x35, 0x8c, 0x77, 0xac, 0x35, 0x44, 0x57,
+    0x5a, 0x2b, 0xb4, 0x54, 0x5a, 0x0b, 0xfa, 0x5d, 0x69, 0x6d, 0x30, 0xb7, 0xb4, 0xc6, 0xb2, 0xed,
+    0x56, 0xc3, 0x5e, 0xaa, 0xa4, 0x76, 0x81, 0xa5, 0x92, 0xda, 0xe1, 0xff, 0x52, 0x52, 0x3b, 0xcc,
+    0xfd, 0x87, 0xda, 0x0b, 0x00, 0x00, 0xff, 0xff, 0x94, 0xd5, 0x49, 0x52, 0xc3, 0x30, 0x14, 0x00,
+    0xd1, 0x3d, 0xa7, 0xd0, 0x11, 0x62, 0x4b, 0x96, 0xbe, 0xb8, 0x0d, 0x04, 0x03, 0x86, 0x24, 0x86,
+    0x0c, 0x4c, 0xa7, 0xa7, 0x2a, 0x2b, 0x7a, 0xc1, 0xa2, 0xd7, 0xae, 0x2e, 0xe9, 0x5b, 0x4f, 0xf6,
+    0x9c, 0x76, 0x77, 0x3f, 0xdf, 0xe9, 0x61, 0x7d, 0x4a, 0x2d, 0xa7, 0xf3, 0xb2, 0x9f, 0x4f, 0x37,
+    0xbb, 0xe5, 0x30, 0xa7, 0xd2, 0x6f, 0xd3, 0xf9, 0x79, 0x4e, 0xef, 0x97, 0x65, 0xfb, 0x9a, 0xee,
+    0x8f, 0xeb, 0xe7, 0x21, 0x3d, 0xae, 0x5f, 0xe9, 0xe5, 0xb2, 0x7f, 0x3b, 0xa5, 0xf5, 0x63, 0x3e,
+    0x5e, 0x1f, 0xff, 0x53, 0x4f, 0x1b, 0x59, 0x4f, 0xa8, 0x07, 0x59, 0x77, 0xd4, 0xa3, 0xab, 0x83,
+    0x6b, 0x67, 0x57, 0x77, 0xce, 0x5d, 0x5c, 0x5d, 0x11, 0x4f, 0x2e, 0x1e, 0x02, 0x75, 0x75, 0x75,
+    0x1e, 0x51, 0x37, 0x57, 0x17, 0xae, 0x1d, 0x72, 0x6c, 0xce, 0x2d, 0xa9, 0x05, 0xea, 0x2a, 0xa9,
+    0x0d, 0x03, 0x6a, 0x49, 0x2d, 0x03, 0x4b, 0x95, 0xd4, 0x2a, 0xd7, 0x96, 0xd4, 0x02, 0xcc, 0xab,
+    0xa4, 0x36, 0xe2, 0xbc, 0xab, 0xb4, 0x36, 0x15, 0xd4, 0xd2, 0x5a, 0x40, 0x4b, 0x95, 0xd6, 0xc6,
+    0x86, 0xda, 0x5a, 0xe3, 0x89, 0x59, 0x6b, 0x7f, 0xe3, 0x26, 0xa9, 0x4d, 0x1b, 0xd4, 0x92, 0x5a,
+    0xc7, 0x2b, 0x6f, 0x92, 0x5a, 0xc1, 0x77, 0xa9, 0xd9, 0xaf, 0x1a, 0xa0, 0x36, 0x49, 0xad, 0x70,
+    0xe7, 0x92, 0x5a, 0xc7, 0xf5, 0x6e, 0x92, 0xda, 0xc4, 0xb9, 0x25, 0xb5, 0x01, 0x97, 0xa4, 0x49,
+    0x6a, 0x8d, 0xe7, 0x2d, 0xa9, 0x65, 0xec, 0x3c, 0xa4, 0xb5, 0x0e, 0xe6, 0x21, 0xad, 0x55, 0xcc,
+    0x1d, 0xd2, 0x5a, 0x86, 0x96, 0x90, 0xd6, 0xb8, 0xb4, 0xa4, 0xd6, 0x58, 0x4b, 0x6a, 0x05, 0x5f,
+    0x96, 0x90, 0xd4, 0x46, 0x30, 0x0f, 0x49, 0x8d, 0xa7, 0x2d, 0xa5, 0x05, 0xdf, 0xb8, 0x94, 0x56,
+    0xb1, 0xf1, 0x2e, 0xa5, 0x15, 0xfc, 0x86, 0xba, 0xfd, 0x81, 0xe2, 0x76, 0x77, 0x29, 0x6d, 0x84,
+    0xf2, 0x2e, 0xa5, 0x0d, 0x5c, 0x5b, 0x52, 0xe3, 0xd8, 0x56, 0x1a, 0x62, 0x09, 0x0d, 0x87, 0xdd,
+    0xaf, 0xce, 0x7e, 0x01, 0x00, 0x00, 0xff, 0xff, 0xa4, 0x97, 0xc1, 0x0d, 0xc0, 0x30, 0x08, 0x03,
+    0x57, 0xe2, 0xa8, 0x1a, 0xa9, 0xfb, 0x2f, 0x96, 0xb7, 0x79, 0xf5, 0xc4, 0x00, 0x16, 0x90, 0x9c,
+    0x8c, 0xf9, 0x2f, 0x0e, 0x4f, 0xfa, 0x24, 0x67, 0x59, 0x59, 0x62, 0x16, 0x33, 0x53, 0xd6, 0xd0,
+    0x52, 0x2d, 0x31, 0xcb, 0xaf, 0xa6, 0x56, 0x9c, 0x51, 0x12, 0xb4, 0x67, 0x54, 0xb7, 0xfb, 0x73,
+    0xcc, 0x2e, 0x59, 0x3b, 0xe3, 0xe1, 0x6d, 0x58, 0x23, 0xe5, 0x1b, 0x5f, 0xa3, 0x24, 0x70, 0x3d,
+    0x7a, 0xb7, 0xc8, 0x85, 0xa1, 0x83, 0x3d, 0x43, 0x3b, 0xe5, 0x12, 0xba, 0xa1, 0x5e, 0x6d, 0x51,
+    0x90, 0xcc, 0x9d, 0x51, 0xdd, 0xba, 0x5b, 0x12, 0x8f, 0x64, 0x2e, 0xc3, 0x0b, 0x48, 0xe6, 0x32,
+    0x39, 0xc1, 0x2a, 0xb6, 0x81, 0x84, 0xee, 0x1d, 0xcd, 0x4b, 0xe8, 0x32, 0xb0, 0xd2, 0x76, 0x9f,
+    0x26, 0xf2, 0xcd, 0x05, 0x00, 0x00, 0xff, 0xff, 0x94, 0xd6, 0x4b, 0x52, 0xc3, 0x30, 0x10, 0x84,
+    0xe1, 0x3d, 0xa7, 0xd0, 0x11, 0x62, 0x4b, 0x33, 0xb6, 0x73, 0x1b, 0x48, 0x0c, 0x18, 0x92, 0x18,
+    0xf2, 0xe2, 0x71, 0x7a, 0xaa, 0xd8, 0x75, 0xef, 0xfe, 0xb5, 0xab, 0x4b, 0x63, 0xe9, 0xd3, 0x68,
+    0xb6, 0xe5, 0xfa, 0x3a, 0x97, 0xcf, 0xdb, 0xb2, 0x7b, 0x2f, 0x4f, 0xe7, 0xf5, 0xeb, 0x54, 0x9e,
+    0xd7, 0xef, 0xf2, 0x76, 0x3b, 0x7e, 0x5c, 0xca, 0x7a, 0x9f, 0xcf, 0xff, 0x9f, 0x0f, 0x8f, 0xbf,
+    0x3f, 0x65, 0xbf, 0xbe, 0x94, 0xa9, 0x2b, 0xd7, 0xe5, 0x38, 0x5f, 0x1e, 0x0e, 0xcb, 0x69, 0x2e,
+    0x5d, 0xdf, 0x6f, 0x51, 0xbc, 0x55, 0x8d, 0x57, 0x16, 0x9f, 0x9a, 0xc6, 0x1b, 0x8b, 0xc7, 0x46,
+    0xe3, 0xc1, 0xe2, 0xa3, 0xa6, 0x93, 0xa5, 0x33, 0x34, 0x3e, 0xb0, 0x78, 0x3f, 0x68, 0x7c, 0x84,
+    0xb5, 0x5b, 0xf1, 0x13, 0xdc, 0x39, 0xdd, 0xf8, 0xba, 0x81, 0xc5, 0xf7, 0x1a, 0xef, 0x60, 0xf1,
+    0x93, 0xc6, 0x21, 0xba, 0x54, 0xb3, 0x15, 0xa2, 0xab, 0x7a, 0x70, 0x15, 0xa2, 0xeb, 0x6c, 0x75,
+    0x8a, 0x2e, 0x35, 0x4e, 0xd5, 0x59, 0x1c, 0xaa, 0x6b, 0xca, 0xa6, 0x42, 0x75, 0xd5, 0xce, 0x1d,
+    0xaa, 0xeb, 0x74, 0xf5, 0x06, 0xd5, 0xe9, 0xaf, 0x37, 0x88, 0x6e, 0xd2, 0x56, 0xd5, 0x20, 0xba,
+    0x51, 0xd5, 0x34, 0x88, 0x6e, 0x50, 0xf2, 0x0d, 0xa2, 0x1b, 0x6c, 0x75, 0x88, 0x6e, 0xb0, 0x7f,
+    0x87, 0xe8, 0x3c, 0x0e, 0xd1, 0x79, 0xf1, 0x10, 0x9d, 0x6f, 0x1d, 0x44, 0x67, 0x07, 0x17, 0x10,
+    0x9d, 0xb1, 0x09, 0xa8, 0x4e, 0xcd, 0x06, 0x44, 0x67, 0x17, 0x26, 0x68, 0xa7, 0xd3, 0xeb, 0x1a,
+    0x10, 0x9d, 0x35, 0x8b, 0x80, 0xe8, 0xac, 0x55, 0x05, 0x44, 0x67, 0x8d, 0x32, 0x20, 0x3a, 0x6b,
+    0xd3, 0x41, 0x3b, 0x9d, 0xa9, 0x81, 0xe8, 0xec, 0x89, 0x4a, 0x88, 0xce, 0x1e, 0xc8, 0x84, 0xe8,
+    0xec, 0x79, 0x4e, 0xa8, 0xce, 0x86, 0x83, 0x84, 0xea, 0x6c, 0x34, 0x49, 0xa8, 0xce, 0x06, 0xa3,
+    0xa4, 0xea, 0xf4, 0xe0, 0x92, 0xaa, 0xd3, 0x34, 0x44, 0x67, 0x03, 0x69, 0x12, 0x74, 0x7f, 0x00,
+    0x00, 0x00, 0xff, 0xff, 0x94, 0xd7, 0xc1, 0x15, 0x80, 0x30, 0x08, 0x04, 0xd1, 0x9a, 0x4c, 0x34,
+    0x0b, 0xfd, 0x37, 0xe6, 0x79, 0xf0, 0xe2, 0x14, 0xc0, 0x93, 0x98, 0x4f, 0x80, 0xef, 0x38, 0x7c,
+    0x24, 0xba, 0x31, 0x8c, 0xc7, 0xbe, 0x74, 0x34, 0x1b, 0x89, 0xee, 0x66, 0xf2, 0x91, 0xe8, 0x9a,
+    0xe5, 0x1e, 0x89, 0xee, 0x19, 0x67, 0xb7, 0x43, 0x1d, 0x2b, 0x26, 0xb6, 0xbf, 0xf2, 0xde, 0x23,
+    0xd1, 0xed, 0x91, 0xbc, 0x54, 0xd7, 0x24, 0x1f, 0xa9, 0xee, 0x8c, 0xb3, 0x4b, 0x75, 0x9b, 0x6c,
+    0xca, 0xae, 0x12, 0x8c, 0x96, 0xe8, 0x32, 0xc2, 0xed, 0xfa, 0xca, 0xb7, 0xa6, 0x24, 0xba, 0x45,
+    0xf2, 0x25, 0xd1, 0xf1, 0xd6, 0xcb, 0x2e, 0x12, 0xe3, 0xbf, 0xdb, 0x45, 0x62, 0xe4, 0x6e, 0x17,
+    0x09, 0x76, 0xa8, 0xb2, 0xed, 0x95, 0xd5, 0x5e, 0xd2, 0xdc, 0xa2, 0xf8, 0x96, 0xe6, 0x2e, 0x7e,
+    0xbd, 0xed, 0x26, 0xc1, 0xe8, 0x1f, 0xe6, 0x5e, 0x00, 0x00, 0x00, 0xff, 0xff, 0xa5, 0xcf, 0x47,
+    0x0a, 0x80, 0x40, 0x14, 0x03, 0xd0, 0xbd, 0xa7, 0xc8, 0x11, 0xec, 0x3a, 0xde, 0xc6, 0xf2, 0xd5,
+    0xb1, 0x8d, 0xbd, 0x9d, 0x5e, 0x10, 0x11, 0xc6, 0xdd, 0xc7, 0x75, 0x78, 0x24, 0x29, 0x09, 0x4d,
+    0x7c, 0x1e, 0xc8, 0x54, 0x01, 0x17, 0xb3, 0x6c, 0x69, 0x32, 0x1a, 0xd9, 0x11, 0x2c, 0xe1, 0x44,
+    0x98, 0x4b, 0xc2, 0xb0, 0xc8, 0xb4, 0x46, 0x32, 0xaa, 0xad, 0x43, 0xae, 0x76, 0x54, 0x4b, 0xdb,
+    0x4f, 0x50, 0x2b, 0x8d, 0x77, 0xfc, 0x6a, 0x4b, 0xd7, 0x2e, 0x4f, 0x9b, 0xba, 0xf6, 0x7e, 0x75,
+    0xfb, 0x3c, 0xfd, 0xf9, 0x1d, 0xf0, 0xb4, 0xd0, 0x75, 0xc8, 0x5c, 0xee, 0xeb, 0x5c, 0xf0, 0xb8,
+    0xed, 0x3d, 0xfc, 0x02,
+};
+static const nju8 gc_inflate_gzip[] = {
+    0x1f, 0x8b, 0x08, 0x1e, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x05, 0x00, 0x65, 0x78, 0x74, 0x72,
+    0x61, 0x6e, 0x61, 0x6d, 0x65, 0x2e, 0x74, 0x78, 0x74, 0x00, 0x63, 0x6f, 0x6d, 0x6d, 0x65, 0x6e,
+    0x74, 0x00, 0x97, 0xcf, 0xa5, 0x9a, 0x4b, 0x92, 0x14, 0x31, 0x0c, 0x44, 0xf7, 0x9c, 0xa2, 0x8e,
+    0x60, 0xf9, 0x23, 0x4b, 0xdc, 0x06, 0x98, 0x06, 0x1a, 0x7a, 0xa6, 0x61, 0x3e, 0x0c, 0x70, 0x7a,
+    0x02, 0x56, 0x9d, 0xda, 0x25, 0xb9, 0xae, 0x50, 0xd8, 0x2e, 0xa7, 0x2d, 0x29, 0x9f, 0x2f, 0xe7,
+    0x87, 0xd3, 0xd1, 0xde, 0x1e, 0xcf, 0x9f, 0x4f, 0xc7, 0xf7, 0x97, 0xf3, 0x87, 0xaf, 0xc7, 0xfb,
+    0xc7, 0xeb, 0xeb, 0xc3, 0xf1, 0xf1, 0xfa, 0xf3, 0xf8, 0xf2, 0x72, 0xff, 0xed, 0xe9, 0xb8, 0xfe,
+    0x38, 0x3d, 0xfe, 0xfb, 0x7c, 0x79, 0xf7, 0xfb, 0xd7, 0x71, 0x77, 0xfd, 0x74, 0xb4, 0xe3, 0xf9,
+    0x7c, 0x7f, 0x7a, 0x7a, 0x73, 0xf9, 0x1b, 0x6b, 0x5c, 0xac, 0xdd, 0xc6, 0x76, 0x2e, 0x76, 0xde,
+    0xc6, 0x0e, 0x2e, 0x36, 0x6f, 0x63, 0x27, 0x39, 0x67, 0xbf, 0x0d, 0x5e, 0x5c, 0x70, 0x5f, 0xb7,
+    0xc1, 0xce, 0x05, 0x0f, 0x18, 0x79, 0x93, 0xbf, 0x0b, 0xd6, 0x1c, 0x5c, 0xb0, 0xc3, 0xcf, 0x4e,
+    0x2e, 0x38, 0x60, 0x97, 0x8d, 0x94, 0xd7, 0x80, 0x60, 0x52, 0x5f, 0x1d, 0xe6, 0x6d, 0xac, 0xc2,
+    0x36, 0x44, 0x93, 0x1a, 0xdb, 0x1d, 0xa2, 0x49, 0x95, 0x61, 0x30, 0xa9, 0xb2, 0x81, 0x7f, 0x9c,
+    0x94, 0x99, 0xe3, 0xd8, 0xa4, 0xce, 0x12, 0x14, 0x6e, 0xa4, 0xd0, 0x06, 0x6e, 0x37, 0xa9, 0xb4,
+    0x0d, 0x77, 0x51, 0x27, 0x95, 0x66, 0xb0, 0xee, 0x4e, 0x4a, 0x6d, 0xc1, 0xcc, 0x3b, 0x29, 0xb5,
+    0x84, 0xa3, 0xdd, 0x49, 0xa9, 0x4d, 0x90, 0x79, 0x27, 0xa5, 0x96, 0x78, 0x0b, 0x93, 0x5a, 0x9b,
+    0xb8, 0x6e, 0x52, 0x6b, 0x89, 0x33, 0x27, 0xb5, 0xb6, 0x70, 0xbf, 0x49, 0xad, 0x05, 0x04, 0x93,
+    0x52, 0x73, 0x90, 0xf9, 0x20, 0xa5, 0xd6, 0xe1, 0x66, 0x19, 0xa4, 0xd4, 0x02, 0x66, 0x3e, 0x48,
+    0xa9, 0x2d, 0x4c, 0x9c, 0xa4, 0xd4, 0x3a, 0x1c, 0x92, 0x41, 0x4a, 0x2d, 0x20, 0x09, 0x0d, 0x52,
+    0x6a, 0x0e, 0x42, 0x1d, 0x6c, 0xf6, 0xc4, 0x1d, 0x23, 0xa5, 0x66, 0x38, 0x36, 0x2b, 0x35, 0x38,
+    0xde, 0x83, 0xd5, 0x1a, 0x44, 0x4f, 0x52, 0x6b, 0x13, 0xd4, 0x32, 0x49, 0xad, 0x0d, 0xd8, 0xef,
+    0x49, 0x6a, 0xcd, 0x70, 0x6c, 0x52, 0x6b, 0xb8, 0x6c, 0xf6, 0x56, 0x83, 0x7b, 0x69, 0x92, 0x52,
+    0x0b, 0x10, 0xcb, 0x24, 0xa5, 0xb6, 0xb1, 0xbe, 0x24, 0xa5, 0xb6, 0x71, 0x6c, 0x52, 0x6a, 0x1b,
+    0xd7, 0x9d, 0x4a, 0xf4, 0x6a, 0xca, 0xcc, 0x97, 0x29, 0x7f, 0x6d, 0x75, 0x65, 0xc7, 0xd6, 0x50,
+    0xd4, 0xb2, 0xa6, 0x20, 0xd4, 0xb5, 0x94, 0x33, 0xb2, 0x5c, 0x39, 0x9f, 0x6b, 0x2b, 0x77, 0xc3,
+    0x0a, 0xe5, 0x5e, 0x5a, 0xa9, 0xdc, 0x89, 0xde, 0x94, 0xfb, 0xd8, 0x4d, 0xc9, 0x05, 0xde, 0x95,
+    0x3c, 0xe4, 0x43, 0xc9, 0x81, 0x3e, 0x95, 0xfc, 0xeb, 0x4b, 0xc9, 0xfd, 0xee, 0x4a, 0xdd, 0xe1,
+    0x5b, 0xa9, 0x79, 0x3c, 0x94, 0x7a, 0xcb, 0x53, 0x28, 0xf5, 0x76, 0x53, 0xaa, 0xcc, 0x6d, 0x4a,
+    0x85, 0xbb, 0xbb, 0x52, 0x5d, 0xef, 0xa1, 0x54, 0xf6, 0x7b, 0x2a, 0x5d, 0xc5, 0x5e, 0x4a, 0x47,
+    0xb3, 0x5d, 0xe9, 0xa6, 0xf6, 0x56, 0x3a, 0xb9, 0x1d, 0x4a, 0x17, 0xb9, 0x53, 0xe9, 0x60, 0xa3,
+    0x29, 0xdd, 0x73, 0x98, 0xd2, 0xb9, 0x47, 0x57, 0x5c, 0x83, 0x18, 0x82, 0x61, 0x11, 0x53, 0xf1,
+    0x4a, 0x62, 0x29, 0x3e, 0x4d, 0xb8, 0xe2, 0x11, 0xc5, 0x16, 0xec, 0xa9, 0x08, 0xc5, 0x19, 0x8b,
+    0x94, 0x4c, 0xb9, 0xa6, 0xf8, 0x81, 0x69, 0x8a, 0x15, 0x99, 0x5d, 0x71, 0x41, 0x73, 0x28, 0x06,
+    0x6c, 0x4e, 0xc1, 0xfa, 0xcd, 0x25, 0x78, 0xce, 0xe9, 0x82, 0xd9, 0x9d, 0x5b, 0x70, 0xd9, 0x33,
+    0x94, 0x91, 0x53, 0x58, 0xb3, 0xb5, 0x26, 0xfc, 0x6e, 0x6b, 0xa6, 0x6c, 0xb5, 0x35, 0x49, 0x67,
+    0xd6, 0x86, 0x22, 0x72, 0x6b, 0x53, 0x39, 0x61, 0xd6, 0x96, 0x72, 0xbc, 0xad, 0xb9, 0xe6, 0xba,
+    0x2b, 0xf7, 0x9a, 0xb5, 0x90, 0x7c, 0xf7, 0x96, 0x92, 0xf1, 0xce, 0x22, 0x83, 0xe2, 0xbc, 0xd3,
+    0xd0, 0x00, 0xa3, 0xa5, 0x2c, 0x6a, 0x2c, 0x35, 0x28, 0xe6, 0x3b, 0x8b, 0x0d, 0x8a, 0xfb, 0x4e,
+    0x83, 0x83, 0x42, 0x5b, 0x5c, 0xa9, 0x9c, 0xcc, 0xa4, 0xb2, 0xcd, 0x58, 0x76, 0xb0, 0xca, 0xe4,
+    0x53, 0x29, 0x58, 0x8d, 0xa5, 0x07, 0xb3, 0xa0, 0x26, 0x53, 0x4a, 0x75, 0xeb, 0x52, 0x9f, 0x60,
+    0x2c, 0x40, 0xc8, 0x32, 0xf9, 0xa9, 0x74, 0x48, 0xc6, 0x22, 0x84, 0xc0, 0x68, 0x57, 0x3a, 0x43,
+    0xeb, 0x52, 0x5b, 0x6a, 0x34, 0x44, 0x28, 0x93, 0x4f, 0xa5, 0x21, 0x37, 0x9a, 0x23, 0xe0, 0x89,
+    0xa1, 0x41, 0x02, 0x66, 0xa8, 0x21, 0xf9, 0x20, 0xc6, 0xa2, 0x04, 0x34, 0x61, 0x8c, 0x65, 0x09,
+    0x56, 0x46, 0x5f, 0x8a, 0xfd, 0x64, 0x2c, 0x4d, 0xf0, 0x12, 0x2e, 0x19, 0x6f, 0xc6, 0xf2, 0x84,
+    0x51, 0xf6, 0x3d, 0x15, 0xcb, 0xd1, 0x58, 0xa2, 0x80, 0x4b, 0x67, 0x89, 0x02, 0x5a, 0xad, 0x36,
+    0x25, 0x9f, 0xd7, 0x58, 0xa6, 0x80, 0x26, 0xb3, 0xb1, 0x54, 0x61, 0x97, 0xd1, 0x97, 0x62, 0xaf,
+    0x1b, 0xcd, 0x15, 0x4a, 0xf8, 0xd6, 0x26, 0x1f, 0xda, 0xaf, 0x4b, 0x69, 0xe3, 0x58, 0xb6, 0x50,
+    0x64, 0xc3, 0xc2, 0x05, 0xd4, 0xec, 0x92, 0x38, 0x96, 0xb1, 0x74, 0xa1, 0x1c, 0x57, 0x16, 0x2f,
+    0x94, 0xcb, 0x82, 0x05, 0x0c, 0xe5, 0xaa, 0x62, 0x09, 0x43, 0xb9, 0x28, 0x97, 0x04, 0x4e, 0x8d,
+    0x65, 0x0c, 0x25, 0x49, 0xb0, 0x90, 0xa1, 0xa4, 0x28, 0x96, 0x32, 0x94, 0x04, 0xc9, 0x62, 0x86,
+    0x92, 0x9e, 0x5d, 0x22, 0xf5, 0x46, 0x83, 0x06, 0x94, 0x0d, 0x4d, 0x1a, 0xb0, 0x30, 0x62, 0x51,
+    0x43, 0x29, 0xcb, 0x68, 0xd6, 0x80, 0xd1, 0xd2, 0xc3, 0x10, 0x63, 0x61, 0x43, 0x29, 0x87, 0x59,
+    0xda, 0x50, 0x8a, 0x71, 0x96, 0x37, 0x94, 0x56, 0x80, 0x05, 0x0e, 0xa5, 0x11, 0xd9, 0xd2, 0x4b,
+    0x24, 0x63, 0x91, 0x43, 0x69, 0xc2, 0x58, 0xe6, 0x50, 0x5a, 0x40, 0x16, 0x3a, 0x94, 0x06, 0x94,
+    0xa5, 0x0e, 0xa5, 0xfd, 0xdd, 0xda, 0xd3, 0x37, 0x96, 0x3b, 0xd4, 0x77, 0x77, 0x29, 0x19, 0x0f,
+    0x2c, 0x79, 0xc0, 0xc1, 0x59, 0xf2, 0x50, 0x2c, 0x97, 0xd0, 0x5e, 0x5a, 0xd2, 0xec, 0x01, 0x25,
+    0xcf, 0xd2, 0x07, 0xdc, 0x75, 0x96, 0x3e, 0x14, 0xa3, 0x8d, 0xc5, 0x0f, 0xc5, 0xe6, 0x0b, 0xe9,
+    0x59, 0xaf, 0xb1, 0x04, 0xa2, 0x58, 0x9c, 0x2c, 0x82, 0x28, 0x06, 0x2b, 0xcb, 0x20, 0x8a, 0xbd,
+    0xcb, 0x42, 0x08, 0x5c, 0x7a, 0x2a, 0xef, 0xc7, 0x8d, 0x86, 0x10, 0x18, 0x3d, 0x95, 0x37, 0xf3,
+    0x2c, 0x85, 0x28, 0x63, 0xbb, 0xb4, 0xee, 0x2d, 0xfd, 0xf3, 0xd0, 0x36, 0xfc, 0x7f, 0xe5, 0xf6,
+    0x07, 0x0d, 0x97, 0x05, 0x63, 0xa8, 0x30, 0x00, 0x00,
+};
+static const nju8 gc_inflate_zeros[] = {
+    0x78, 0xda, 0xed, 0xc1, 0x01, 0x0d, 0x00, 0x00, 0x00, 0xc2, 0xa0, 0xf7, 0x4f, 0x6d, 0x0f, 0x07,
+    0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0xfc, 0x18, 0x94, 0x1c, 0x00, 0x01,
+};
+static const nju8 gc_inflate_far[] = {
+    0xab, 0xa8, 0x1c, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18,
+    0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60,
+    0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82,
+    0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a,
+    0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28,
+    0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3,
+    0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c,
+    0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30,
+    0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1,
+    0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05,
+    0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14,
+    0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51,
+    0x30, 0x0a, 0x46, 0xc1, 0x28, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46,
+    0x01, 0xf0, 0xfe, 0x7f, 0x00,
+};
+static const nju8 gc_inflate_empty[] = {
+    0x78, 0xda, 0x03, 0x00, 0x00, 0x00, 0x00, 0x01,
+};
+static const nju8 gc_inflate_block_type[] = {
+    0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+static const nju8 gc_inflate_stored_length[] = {
+    0x01, 0x05, 0x00, 0xfa, 0xfe, 0x68, 0x65, 0x6c, 0x6c, 0x6f,
+};
+static const nju8 gc_inflate_oversubscribed[] = {
+    0x05, 0xe0, 0x93, 0x24, 0x49, 0x92, 0x24, 0x49, 0x92, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00,
+};
+static const nju8 gc_inflate_distance[] = {
+    0xab, 0xa8, 0xa4, 0x03, 0x00, 0xda, 0x02, 0x00,
+};
+
+static const check_inflate_stream_t gc_inflate_streams[] = {
+    {"stored", NJ_INFLATE_FORMAT_ZLIB, gc_inflate_stored, 311, 300, 0xb83a3c2du},
+    {"fixed", NJ_INFLATE_FORMAT_ZLIB, gc_inflate_fixed, 1203, 12456, 0x6305970du},
+    {"dynamic", NJ_INFLATE_FORMAT_ZLIB, gc_inflate_dynamic, 931, 12456, 0x6305970du},
+    {"blocks", NJ_INFLATE_FORMAT_RAW, gc_inflate_blocks, 1300, 12456, 0x6305970du},
+    {"gzip", NJ_INFLATE_FORMAT_GZIP, gc_inflate_gzip, 969, 12456, 0x6305970du},
+    {"zeros", NJ_INFLATE_FORMAT_ZLIB, gc_inflate_zeros, 313, 300000, 0xf6b2e2fbu},
+    {"far", NJ_INFLATE_FORMAT_RAW, gc_inflate_far, 213, 32771, 0x822698a3u},
+    {"empty", NJ_INFLATE_FORMAT_ZLIB, gc_inflate_empty, 8, 0, 0x00000000u},
+};
+
+static const check_inflate_stream_t gc_inflate_invalid_streams[] = {
+    {"block type", NJ_INFLATE_FORMAT_RAW, gc_inflate_block_type, 9, 0, 0},
+    {"stored length", NJ_INFLATE_FORMAT_RAW, gc_inflate_stored_length, 10, 0, 0},
+    {"oversubscribed", NJ_INFLATE_FORMAT_RAW, gc_inflate_oversubscribed, 18, 0, 0},
+    {"distance", NJ_INFLATE_FORMAT_RAW, gc_inflate_distance, 8, 0, 0},
+};
+
+static const check_inflate_patch_t gc_inflate_patches[] = {
+    {"fcheck", 2, 1, 0x01},
+    {"dictionary", 2, 1, 0x61},
+    {"adler", 2, -1, 0x01},
+    {"crc", 4, -8, 0x01},
+    {"size", 4, -4, 0x01},
+};
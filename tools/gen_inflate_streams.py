@@ -0,0 +1,201 @@
+# Writes check_inflate_streams.inl, the known deflate streams of the inflate
+# checks in check.cpp. The valid streams are made by zlib and checked against
+# it, "far" and the invalid streams are built bit by bit.
+# Usage: python3 gen_inflate_streams.py
+import os
+import struct
+import zlib
+
+WBITS = {"ZLIB": 15, "RAW": -15, "GZIP": 31}
+LEN_BASE = [3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195,
+            227, 258]
+LEN_EXTRA = [0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0]
+DIST_BASE = [1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+             4097, 6145, 8193, 12289, 16385, 24577]
+DIST_EXTRA = [0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13]
+
+
+class BitWriter:
+    """Deflate bit order: values from the least significant bit, Huffman
+    codes from the most significant one."""
+
+    def __init__(self):
+        self.bits = 0
+        self.count = 0
+        self.out = bytearray()
+
+    def put(self, value, count):
+        self.bits |= value << self.count
+        self.count += count
+        while self.count >= 8:
+            self.out.append(self.bits & 255)
+            self.bits >>= 8
+            self.count -= 8
+
+    def put_code(self, code, count):
+        reversed_code = 0
+        for i in range(count):
+            reversed_code = reversed_code << 1 | (code >> i & 1)
+        self.put(reversed_code, count)
+
+    def finish(self):
+        if self.count:
+            self.out.append(self.bits & 255)
+        return bytes(self.out)
+
+
+def put_fixed_symbol(writer, symbol):
+    if symbol < 144:
+        writer.put_code(0x30 + symbol, 8)
+    elif symbol < 256:
+        writer.put_code(0x190 + symbol - 144, 9)
+    elif symbol < 280:
+        writer.put_code(symbol - 256, 7)
+    else:
+        writer.put_code(0xc0 + symbol - 280, 8)
+
+
+def put_fixed_match(writer, length, dist):
+    i = 28 if length == 258 else max(k for k in range(28) if LEN_BASE[k] <= length)
+    put_fixed_symbol(writer, 257 + i)
+    writer.put(length - LEN_BASE[i], LEN_EXTRA[i])
+    j = max(k for k in range(30) if DIST_BASE[k] <= dist)
+    writer.put_code(j, 5)
+    writer.put(dist - DIST_BASE[j], DIST_EXTRA[j])
+
+
+def far_stream(y_count, dist):
+    """A fixed block of 'x', |y_count| 'y' as matches of distance 1 then a
+    match of 3 bytes at |dist|."""
+    writer = BitWriter()
+    writer.put(1, 1)
+    writer.put(1, 2)
+    put_fixed_symbol(writer, ord("x"))
+    put_fixed_symbol(writer, ord("y"))
+    left = y_count - 1
+    while left:
+        length = min(258, left)
+        if left - length in (1, 2):
+            length -= 3
+        put_fixed_match(writer, length, 1)
+        left -= length
+    put_fixed_match(writer, 3, dist)
+    put_fixed_symbol(writer, 256)
+    return writer.finish()
+
+
+def zlib_stream(level, strategy, data):
+    compressor = zlib.compressobj(level, zlib.DEFLATED, 15, 9, strategy)
+    return compressor.compress(data) + compressor.flush()
+
+
+def raw_blocks_stream(data):
+    """Sync and full flushes every 1500 bytes, so there are empty stored
+    blocks between the compressed ones."""
+    compressor = zlib.compressobj(6, zlib.DEFLATED, -15)
+    flushes = [zlib.Z_SYNC_FLUSH, zlib.Z_FULL_FLUSH, zlib.Z_NO_FLUSH]
+    out = b""
+    for i, offset in enumerate(range(0, len(data), 1500)):
+        out += compressor.compress(data[offset:offset + 1500]) + compressor.flush(flushes[i % 3])
+    return out + compressor.flush()
+
+
+def gzip_stream(data):
+    """gzip with the extra field, the name, the comment and the header CRC."""
+    compressor = zlib.compressobj(9, zlib.DEFLATED, -15)
+    body = compressor.compress(data) + compressor.flush()
+    header = bytes([31, 139, 8, 2 | 4 | 8 | 16]) + bytes([0, 0, 0, 0, 2, 3])
+    header += struct.pack("<H", 5) + b"extra" + b"name.txt\0" + b"comment\0"
+    header += struct.pack("<H", zlib.crc32(header) & 0xffff)
+    return header + body + struct.pack("<II", zlib.crc32(data), len(data))
+
+
+def oversubscribed_stream():
+    """A dynamic block whose 19 code length codes all have 1 bit."""
+    writer = BitWriter()
+    writer.put(1, 1)
+    writer.put(2, 2)
+    writer.put(0, 5)
+    writer.put(0, 5)
+    writer.put(15, 4)
+    for _ in range(19):
+        writer.put(1, 3)
+    return writer.finish() + bytes(8)
+
+
+def c_array(name, data):
+    lines = ["    " + " ".join("0x%02x," % b for b in data[i:i + 16]) for i in range(0, len(data), 16)]
+    return "static const nju8 %s[] = {\n%s\n};\n" % (name, "\n".join(lines))
+
+
+def c_name(name):
+    return "gc_inflate_" + name.replace(" ", "_")
+
+
+def main():
+    text = b"".join(b"line %d: the quick brown fox jumps over the lazy dog %d times\n" % (i, i * i % 97)
+                    for i in range(200))
+    zeros = bytes(300000)
+    valid = [
+        ("stored", "ZLIB", zlib.compress(text[:300], 0), text[:300]),
+        ("fixed", "ZLIB", zlib_stream(9, zlib.Z_FIXED, text), text),
+        ("dynamic", "ZLIB", zlib_stream(9, zlib.Z_DEFAULT_STRATEGY, text), text),
+        ("blocks", "RAW", raw_blocks_stream(text), text),
+        ("gzip", "GZIP", gzip_stream(text), text),
+        ("zeros", "ZLIB", zlib.compress(zeros, 9), zeros),
+        # The last match reaches back the whole 32 KB history.
+        ("far", "RAW", far_stream(32767, 32768), b"x" + b"y" * 32767 + b"xyy"),
+        ("empty", "ZLIB", zlib.compress(b"", 9), b""),
+    ]
+    invalid = [
+        ("block type", "RAW", bytes([0x07]) + bytes(8)),
+        ("stored length", "RAW", bytes([0x01, 0x05, 0x00, 0xfa, 0xfe]) + b"hello"),
+        ("oversubscribed", "RAW", oversubscribed_stream()),
+        ("distance", "RAW", far_stream(100, 102)),
+    ]
+    # Name, valid stream, offset from the start or from the end if negative and
+    # the bits to flip.
+    patches = [
+        ("fcheck", "dynamic", 1, 0x01),
+        ("dictionary", "dynamic", 1, 0xda ^ 0xbb),
+        ("adler", "dynamic", -1, 0x01),
+        ("crc", "gzip", -8, 0x01),
+        ("size", "gzip", -4, 0x01),
+    ]
+
+    for name, fmt, data, expected in valid:
+        assert zlib.decompress(data, WBITS[fmt]) == expected, name
+    names = [name for name, _, _, _ in valid]
+    corrupted = [(name, valid[names.index(stream)][1], valid[names.index(stream)][2], offset, xor)
+                 for name, stream, offset, xor in patches]
+    for name, fmt, data, offset, xor in [(n, f, d, 0, 0) for n, f, d in invalid] + corrupted:
+        data = bytearray(data)
+        data[offset] ^= xor
+        try:
+            zlib.decompress(bytes(data), WBITS[fmt])
+        except zlib.error:
+            continue
+        raise AssertionError(name + " is valid")
+
+    out = "// Generated by gen_inflate_streams.py.\n\n"
+    for name, _, data, _ in valid:
+        out += c_array(c_name(name), data)
+    for name, _, data in invalid:
+        out += c_array(c_name(name), data)
+    out += "\nstatic const check_inflate_stream_t gc_inflate_streams[] = {\n"
+    for name, fmt, data, expected in valid:
+        out += '    {"%s", NJ_INFLATE_FORMAT_%s, %s, %d, %d, 0x%08xu},\n' % (
+            name, fmt, c_name(name), len(data), len(expected), zlib.crc32(expected))
+    out += "};\n\nstatic const check_inflate_stream_t gc_inflate_invalid_streams[] = {\n"
+    for name, fmt, data in invalid:
+        out += '    {"%s", NJ_INFLATE_FORMAT_%s, %s, %d, 0, 0},\n' % (name, fmt, c_name(name), len(data))
+    out += "};\n\nstatic const check_inflate_patch_t gc_inflate_patches[] = {\n"
+    for name, stream, offset, xor in patches:
+        out += '    {"%s", %d, %d, 0x%02x},\n' % (name, names.index(stream), offset, xor)
+    out += "};\n"
+    with open(os.path.join(os.path.dirname(os.path.abspath(__file__)), "check_inflate_streams.inl"), "w") as f:
+        f.write(out)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,149 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Bundle every file under a directory into a pack, entries are named by their
+// path relative to the directory.
+// Usage: pack [-c] <asset_dir> <output>
+// -c compresses the entries with NJ_PACK_CODEC_LZ.
+
+#include "core/allocator.h"
+#include "core/core_allocators.h"
+#include "core/core_init.h"
+#include "core/dynamic_array.inl"
+#include "core/log.h"
+#include "core/os.h"
+#include "core/pack.h"
+#include "core/path_utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if NJ_OS_WIN()
+#  include <Windows.h>
+#elif NJ_OS_LINUX()
+#  include <dirent.h>
+#  include <sys/stat.h>
+#endif
+
+// Names are UTF-8, paths are nj_os_char.
+static bool pack_add_file(nj_dynamic_array_t<nj_pack_input_t>* inputs, const nj_os_char* path, njsz dir_len) {
+  njsz path_len = nj_str_get_len(path);
+  nj_os_char* path_copy = (nj_os_char*)g_persistent_allocator->alloc((path_len + 1) * sizeof(nj_os_char));
+  NJ_CHECK_RETURN_VAL(path_copy, false);
+  memcpy(path_copy, path, (path_len + 1) * sizeof(nj_os_char));
+  const nj_os_char* sub_path = path + dir_len + 1;
+#if NJ_OS_WIN()
+  int name_size = WideCharToMultiByte(CP_UTF8, 0, sub_path, -1, NULL, 0, NULL, NULL);
+  char* name = (char*)g_persistent_allocator->alloc(name_size);
+  NJ_CHECK_RETURN_VAL(name, false);
+  WideCharToMultiByte(CP_UTF8, 0, sub_path, -1, name, name_size, NULL, NULL);
+#else
+  njsz name_size = path_len - dir_len;
+  char* name = (char*)g_persistent_allocator->alloc(name_size);
+  NJ_CHECK_RETURN_VAL(name, false);
+  memcpy(name, sub_path, name_size);
+#endif
+  nj_pack_input_t input;
+  input.name = name;
+  input.path = path_copy;
+  nj_da_append(inputs, input);
+  return true;
+}
+
+// |path| has room for NJ_MAX_PATH characters, sub directories are appended to
+// it while they are listed.
+static bool pack_add_dir(nj_dynamic_array_t<nj_pack_input_t>* inputs, nj_os_char* path, njsz dir_len) {
+  njsz path_len = nj_str_get_len(path);
+#if NJ_OS_WIN()
+  NJ_CHECK_LOG_RETURN_VAL(path_len + 2 < NJ_MAX_PATH, false, "%ls is too long", path);
+  wcscpy(path + path_len, L"\\*");
+  WIN32_FIND_DATAW data;
+  HANDLE find = FindFirstFileW(path, &data);
+  path[path_len] = 0;
+  NJ_CHECK_LOG_RETURN_VAL(find != INVALID_HANDLE_VALUE, false, "Can't list %ls", path);
+  bool rv = true;
+  do {
+    if (!wcscmp(data.cFileName, L".") || !wcscmp(data.cFileName, L".."))
+      continue;
+    njsz name_len = wcslen(data.cFileName);
+    if (path_len + 1 + name_len >= NJ_MAX_PATH) {
+      NJ_LOGW("%ls\\%ls is too long", path, data.cFileName);
+      rv = false;
+      break;
+    }
+    path[path_len] = L'\\';
+    memcpy(path + path_len + 1, data.cFileName, (name_len + 1) * sizeof(wchar_t));
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+      rv = pack_add_dir(inputs, path, dir_len);
+    else
+      rv = pack_add_file(inputs, path, dir_len);
+    path[path_len] = 0;
+  } while (rv && FindNextFileW(find, &data));
+  FindClose(find);
+  return rv;
+#else
+  DIR* dir = opendir(path);
+  NJ_CHECK_LOG_RETURN_VAL(dir, false, "Can't list %s", path);
+  bool rv = true;
+  while (dirent* ent = readdir(dir)) {
+    if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, ".."))
+      continue;
+    njsz name_len = strlen(ent->d_name);
+    if (path_len + 1 + name_len >= NJ_MAX_PATH) {
+      NJ_LOGW("%s/%s is too long", path, ent->d_name);
+      rv = false;
+      break;
+    }
+    path[path_len] = '/';
+    memcpy(path + path_len + 1, ent->d_name, name_len + 1);
+    struct stat st;
+    if (stat(path, &st) != 0)
+      NJ_LOGW("Can't stat %s", path);
+    else if (S_ISDIR(st.st_mode))
+      rv = pack_add_dir(inputs, path, dir_len);
+    else if (S_ISREG(st.st_mode))
+      rv = pack_add_file(inputs, path, dir_len);
+    path[path_len] = 0;
+    if (!rv)
+      break;
+  }
+  closedir(dir);
+  return rv;
+#endif
+}
+
+#if NJ_OS_WIN()
+int wmain(int argc, wchar_t** argv) {
+#else
+int main(int argc, char** argv) {
+#endif
+  bool is_compressed = argc == 4 && nj_str_compare(argv[1], NJ_OS_LIT("-c"));
+  if (argc != 3 && !is_compressed) {
+    printf("Usage: pack [-c] <asset_dir> <output>\n");
+    return 1;
+  }
+  const nj_os_char* asset_dir = argv[argc - 2];
+  const nj_os_char* output = argv[argc - 1];
+  nj_core_init(NJ_OS_LIT("pack.log"));
+  nj_os_char dir[NJ_MAX_PATH];
+  njsz dir_len = nj_str_get_len(asset_dir);
+  NJ_CHECK_LOG_RETURN_VAL(dir_len < NJ_MAX_PATH, 1, "The asset directory is too long");
+  memcpy(dir, asset_dir, (dir_len + 1) * sizeof(nj_os_char));
+  while (dir_len > 1 && (dir[dir_len - 1] == '/' || dir[dir_len - 1] == '\\'))
+    dir[--dir_len] = 0;
+
+  nj_dynamic_array_t<nj_pack_input_t> inputs;
+  nj_da_init(&inputs, g_general_allocator);
+  bool rv = pack_add_dir(&inputs, dir, dir_len);
+  NJ_CHECK_LOG(!rv || nj_da_len(&inputs), NJ_OS_PCT " is empty", asset_dir);
+  for (njsp i = 0; is_compressed && i < nj_da_len(&inputs); ++i)
+    inputs[i].codec = NJ_PACK_CODEC_LZ;
+  rv = rv && nj_da_len(&inputs) && nj_pack_write(output, &inputs[0], (int)nj_da_len(&inputs), g_general_allocator);
+  if (rv)
+    printf("Packed %d files\n", (int)nj_da_len(&inputs));
+  nj_da_destroy(&inputs);
+  return rv ? 0 : 1;
+}
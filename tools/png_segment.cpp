@@ -0,0 +1,138 @@
+//----------------------------------------------------------------------------//
+// This file is distributed under the MIT License.                            //
+// See LICENSE.txt for details.                                               //
+// Copyright (C) Tran Tuan Nghia <trantuannghia95@gmail.com> 2021             //
+//----------------------------------------------------------------------------//
+
+// Re-encodes a PNG file in independent deflate segments listed in a "njSG"
+// chunk (see core/loader/png.h) so its rows are inflated by several workers.
+// The other chunks are kept before the image data. The output is decoded in
+// parallel and serially, best of 5 runs, and both must match the input image.
+// Usage: png_segment <input> <output> [segment_count]
+
+#include "core/core_init.h"
+#include "core/file.h"
+#include "core/free_list_allocator.h"
+#include "core/job.h"
+#include "core/loader/png.h"
+#include "core/log.h"
+#include "core/mono_time.h"
+#include "core/os_string.h"
+#include "core/parallel.h"
+#include "core/thread.h"
+#include "core/utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NJ_PNG_SEGMENT_DEFAULT_COUNT (8)
+#define NJ_PNG_SEGMENT_RUN_COUNT (5)
+
+static nju32 png_segment_read_u32(const nju8* p) {
+  return (nju32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+// Copies the chunks between IHDR and IEND except the image data and the old
+// segments to |dst|, returns their size.
+static njsp png_segment_copy_chunks(const nju8* data, njsp size, nju8* dst) {
+  njsp len = 0;
+  // Signature and IHDR.
+  for (njsp i = 8 + 12 + 13; i + 12 <= size;) {
+    njsp chunk_size = 12 + (njsp)png_segment_read_u32(data + i);
+    const nju8* type = data + i + 4;
+    if (chunk_size > size - i || !memcmp(type, "IEND", 4))
+      break;
+    if (memcmp(type, "IDAT", 4) && memcmp(type, "njSG", 4)) {
+      memcpy(dst + len, data + i, chunk_size);
+      len += chunk_size;
+    }
+    i += chunk_size;
+  }
+  return len;
+}
+
+// Decodes |data| and compares it with |png|, returns the best time of the
+// runs or -1 if they don't match.
+static njs64 png_segment_decode(const nj_png_t* png, const nju8* data, njsp size, nju8* dst) {
+  njsp dst_size = png->row_size * png->height;
+  njs64 best = -1;
+  for (int i = 0; i < NJ_PNG_SEGMENT_RUN_COUNT; ++i) {
+    nj_png_t decoded;
+    memset(dst, 0, dst_size);
+    njs64 start = nj_mono_time_now();
+    bool rv = nj_png_decode(&decoded, data, size, dst, dst_size, 0);
+    njs64 time = nj_mono_time_now() - start;
+    if (!rv || decoded.width != png->width || decoded.height != png->height || memcmp(dst, png->data, dst_size))
+      return -1;
+    best = i ? nj_min(best, time) : time;
+  }
+  return best;
+}
+
+#if NJ_OS_WIN()
+int wmain(int argc, wchar_t** argv) {
+  int segment_count = argc == 4 ? _wtoi(argv[3]) : NJ_PNG_SEGMENT_DEFAULT_COUNT;
+#else
+int main(int argc, char** argv) {
+  int segment_count = argc == 4 ? atoi(argv[3]) : NJ_PNG_SEGMENT_DEFAULT_COUNT;
+#endif
+  if ((argc != 3 && argc != 4) || segment_count < 1 || segment_count > NJ_PNG_MAX_SEGMENTS) {
+    printf("Usage: png_segment <input> <output> [segment_count]\n");
+    return 1;
+  }
+  nj_core_init(NJ_OS_LIT("png_segment.log"));
+  nj_file_map_t map;
+  NJ_CHECK_LOG_RETURN_VAL(nj_file_map(&map, argv[1]), 1, "Can't read " NJ_OS_PCT, argv[1]);
+  nj_png_t png;
+  NJ_CHECK_LOG_RETURN_VAL(nj_png_read_info(&png, map.data, map.size), 1, "Can't read " NJ_OS_PCT, argv[1]);
+  // The image, its decoded copy, the output and the chunks, and the job system.
+  njsp image_size = png.row_size * png.height;
+  nj_free_list_allocator_t allocator("png_segment_allocator", 3 * image_size + 2 * map.size + 64 * 1024 * 1024);
+  NJ_CHECK_RETURN_VAL(allocator.init(), 1);
+  NJ_CHECK_LOG_RETURN_VAL(nj_png_init(&png, map.data, map.size, &allocator), 1, "Can't decode " NJ_OS_PCT, argv[1]);
+  nju8* chunks = (nju8*)allocator.alloc(map.size);
+  NJ_CHECK_RETURN_VAL(chunks, 1);
+  njsp chunks_size = png_segment_copy_chunks(map.data, map.size, chunks);
+  njsp capacity = nj_png_encode_bound(&png, segment_count, chunks_size);
+  nju8* output = (nju8*)allocator.alloc(capacity);
+  nju8* decoded = (nju8*)allocator.alloc(image_size);
+  NJ_CHECK_RETURN_VAL(output && decoded, 1);
+  njsp output_size = nj_png_encode(&png, segment_count, chunks, chunks_size, output, capacity);
+  NJ_CHECK_LOG_RETURN_VAL(output_size >= 0, 1, "Can't encode " NJ_OS_PCT, argv[1]);
+
+  // At least 2 workers, the segments are inflated serially otherwise.
+  nj_job_system_desc_t desc;
+  desc.worker_count = nj_max(nj_thread_get_nums(), 2);
+  NJ_CHECK_RETURN_VAL(nj_job_system_init(&allocator, &desc), 1);
+  njs64 parallel_time = png_segment_decode(&png, output, output_size, decoded);
+  nj_parallel_set_enabled(false);
+  njs64 serial_time = png_segment_decode(&png, output, output_size, decoded);
+  nj_parallel_set_enabled(true);
+  nj_job_system_destroy();
+  bool rv = parallel_time >= 0 && serial_time >= 0;
+  NJ_CHECK_LOG(rv, "The output doesn't decode to the input image");
+
+  if (rv) {
+    nj_file_t f;
+    rv = nj_file_open(&f, argv[2], NJ_FILE_MODE_WRITE, NJ_FILE_UNBUFFERED);
+    NJ_CHECK_LOG(rv, "Can't open " NJ_OS_PCT " to write", argv[2]);
+    if (rv) {
+      rv = nj_file_write(&f, output, output_size, NULL);
+      nj_file_close(&f);
+      NJ_CHECK_LOG(rv, "Can't write " NJ_OS_PCT, argv[2]);
+    }
+  }
+  if (rv) {
+    printf("%ux%u, %d segments, %ld bytes to %ld bytes, decoded in %.2f ms in parallel, %.2f ms serially\n", png.width, png.height,
+           nj_min<int>(segment_count, png.height), (long)map.size, (long)output_size, nj_mono_time_to_ms(parallel_time), nj_mono_time_to_ms(serial_time));
+  }
+
+  allocator.free(decoded);
+  allocator.free(output);
+  allocator.free(chunks);
+  nj_png_destroy(&png);
+  allocator.destroy();
+  nj_file_unmap(&map);
+  return rv ? 0 : 1;
+}